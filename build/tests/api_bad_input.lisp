@@ -0,0 +1,2 @@
+
+  "unterminated
\ No newline at end of file
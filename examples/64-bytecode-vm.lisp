@@ -8,12 +8,13 @@
 ;   (vm-eval expr)       — compile and execute on the VM
 ;   (disassemble expr)   — show the compiled bytecode
 ;
-; The compiler handles: constants, arithmetic, comparisons,
-; variables, if/else, define, lambda, function calls, begin,
-; cons/car/cdr, display/newline.
+; The compiler handles the core language after macro expansion:
+; constants, variables, if/cond, define, set!, lambda (with rest
+; parameters), function calls, begin, and/or, and call/cc as an
+; escape.
 ;
-; Forms not supported by the compiler (macros, call/cc, type
-; theory nodes) fall back to being stored as constants.
+; Forms it does not compile (quasiquote, type theory nodes) are
+; run by the tree-walking evaluator instead.
 
 (display "=== Arithmetic ===") (newline)
 (display "  (vm-eval '(+ 2 3)): ")
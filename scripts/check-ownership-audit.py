@@ -37,6 +37,7 @@ C_OWNED_MODULES = {
     "primitives.c",
     "repl.c",
     "runtime.c",
+    "symbol.c",
     "syntax_expansion_report.c",
     "tt_equality.c",
     "tt_logic.c",
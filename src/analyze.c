@@ -0,0 +1,458 @@
+/* src/analyze.c — closure-compiled lambda bodies (see analyze.h). */
+
+#include "analyze.h"
+
+#include "env.h"
+#include "gc.h"
+#include "lang.h"
+#include "lexical.h"
+#include "mem.h"
+#include "primitives.h"
+
+#include <string.h>
+
+/* Where a handler in tail position leaves the next step: a resolved closure
+ * and its bound frame, or a form for lizard_eval in `env`. */
+typedef struct {
+  lizard_frame_layout_t *layout;
+  lizard_env_t *frame;
+  lizard_ast_node_t *node;
+  lizard_env_t *env;
+} analyze_tail_t;
+
+/* `tail` is NULL unless the handler is in tail position of the body. */
+typedef lizard_ast_node_t *(*analyze_fn_t)(const lizard_code_t *code,
+                                           lizard_env_t *env,
+                                           lizard_heap_t *heap,
+                                           analyze_tail_t *tail);
+
+struct lizard_code {
+  analyze_fn_t run;
+  lizard_ast_node_t *node; /* source form; the value of a constant */
+  const char *name;        /* define / set! target */
+  lizard_code_t **kids;
+  size_t nkids;
+};
+
+/* Returned by a handler in tail position once it has filled in `tail`. */
+static lizard_ast_node_t analyze_tail_marker;
+
+static lizard_code_t *compile_expr(lizard_ast_node_t *node, lizard_heap_t *heap);
+
+static lizard_ast_node_t *run_value(const lizard_code_t *code,
+                                    lizard_env_t *env, lizard_heap_t *heap) {
+  return code->run(code, env, heap, NULL);
+}
+
+/* ---- handlers ---------------------------------------------------------- */
+
+static lizard_ast_node_t *run_constant(const lizard_code_t *code,
+                                       lizard_env_t *env, lizard_heap_t *heap,
+                                       analyze_tail_t *tail) {
+  (void)env;
+  (void)heap;
+  (void)tail;
+  return code->node;
+}
+
+static lizard_ast_node_t *run_nil(const lizard_code_t *code, lizard_env_t *env,
+                                  lizard_heap_t *heap, analyze_tail_t *tail) {
+  (void)code;
+  (void)env;
+  (void)tail;
+  return lizard_make_nil(heap);
+}
+
+static lizard_ast_node_t *run_local(const lizard_code_t *code,
+                                    lizard_env_t *env, lizard_heap_t *heap,
+                                    analyze_tail_t *tail) {
+  lizard_ast_node_t *val = lizard_lexical_lookup(env, code->node);
+  (void)tail;
+  if (val == NULL) {
+    return lizard_make_error_at(heap, LIZARD_ERROR_UNBOUND_SYMBOL,
+                                code->node->span);
+  }
+  return lizard_force(val, heap);
+}
+
+static lizard_ast_node_t *run_global(const lizard_code_t *code,
+                                     lizard_env_t *env, lizard_heap_t *heap,
+                                     analyze_tail_t *tail) {
+  lizard_ast_node_t *val = lizard_env_lookup_site(env, code->node);
+  (void)tail;
+  if (val == NULL) {
+    return lizard_make_error_at(heap, LIZARD_ERROR_UNBOUND_SYMBOL,
+                                code->node->span);
+  }
+  return lizard_force(val, heap);
+}
+
+/* Any form without a handler of its own: the walker evaluates it, or, in
+ * tail position, the caller's trampoline does. */
+static lizard_ast_node_t *run_fallback(const lizard_code_t *code,
+                                       lizard_env_t *env, lizard_heap_t *heap,
+                                       analyze_tail_t *tail) {
+  if (tail != NULL) {
+    tail->node = code->node;
+    tail->env = env;
+    return &analyze_tail_marker;
+  }
+  return lizard_eval(code->node, env, heap, lizard_identity_cont);
+}
+
+static lizard_ast_node_t *run_if(const lizard_code_t *code, lizard_env_t *env,
+                                 lizard_heap_t *heap, analyze_tail_t *tail) {
+  lizard_ast_node_t *pred = lizard_force(run_value(code->kids[0], env, heap), heap);
+  const lizard_code_t *next;
+  if (pred && pred->type == AST_ERROR) {
+    return pred;
+  }
+  next = lizard_is_false(pred) ? code->kids[2] : code->kids[1];
+  if (next == NULL) {
+    return lizard_make_nil(heap);
+  }
+  return next->run(next, env, heap, tail);
+}
+
+/* begin and bodies: an error in a non-tail expression is the result. */
+static lizard_ast_node_t *run_seq(const lizard_code_t *code, lizard_env_t *env,
+                                  lizard_heap_t *heap, analyze_tail_t *tail) {
+  size_t i;
+  for (i = 0; i + 1U < code->nkids; i++) {
+    lizard_ast_node_t *side = run_value(code->kids[i], env, heap);
+    if (side && side->type == AST_ERROR) {
+      return side;
+    }
+  }
+  return code->kids[i]->run(code->kids[i], env, heap, tail);
+}
+
+/* One cond clause: kids are the test (NULL for else), the body (NULL when
+ * the clause has none) and the next clause (NULL after the last). */
+static lizard_ast_node_t *run_cond(const lizard_code_t *code, lizard_env_t *env,
+                                   lizard_heap_t *heap, analyze_tail_t *tail) {
+  for (;;) {
+    lizard_ast_node_t *test;
+    if (code->kids[0] == NULL) {
+      test = lizard_make_bool(heap, true);
+    } else {
+      test = lizard_force(run_value(code->kids[0], env, heap), heap);
+      if (test && test->type == AST_ERROR) {
+        return test;
+      }
+    }
+    if (lizard_is_true(test)) {
+      if (code->kids[1] == NULL) {
+        return test;
+      }
+      return code->kids[1]->run(code->kids[1], env, heap, tail);
+    }
+    code = code->kids[2];
+    if (code == NULL) {
+      return lizard_make_nil(heap);
+    }
+  }
+}
+
+static lizard_ast_node_t *run_define(const lizard_code_t *code,
+                                     lizard_env_t *env, lizard_heap_t *heap,
+                                     analyze_tail_t *tail) {
+  (void)tail;
+  lizard_env_define(heap, env, code->name, run_value(code->kids[0], env, heap));
+  return lizard_make_nil(heap);
+}
+
+static lizard_ast_node_t *run_assign(const lizard_code_t *code,
+                                     lizard_env_t *env, lizard_heap_t *heap,
+                                     analyze_tail_t *tail) {
+  (void)tail;
+  if (!lizard_env_set(env, code->name, run_value(code->kids[0], env, heap))) {
+    return lizard_make_error_at(heap, LIZARD_ERROR_ASSIGNMENT_UNBOUND,
+                                code->node->span);
+  }
+  return lizard_make_nil(heap);
+}
+
+static lizard_ast_node_t *run_lambda(const lizard_code_t *code,
+                                     lizard_env_t *env, lizard_heap_t *heap,
+                                     analyze_tail_t *tail) {
+  lizard_ast_node_t *closure = lizard_heap_alloc_tagged(
+      sizeof(lizard_ast_node_t), LIZARD_GC_OBJECT_AST_NODE,
+      LIZARD_OBJECT_TRACE_AST);
+  (void)tail;
+  closure->type = AST_LAMBDA;
+  closure->data.lambda.parameters = code->node->data.lambda.parameters;
+  closure->data.lambda.layout = lizard_lexical_resolve(code->node, heap);
+  closure->data.lambda.closure_env =
+      lizard_lexical_closure_env(closure->data.lambda.layout, env, heap);
+  return closure;
+}
+
+/* Allocate the frame of resolved `func` and evaluate the call's arguments
+ * straight into its slots, collecting any beyond the required ones into
+ * the rest list.  As on the walker's binding path, an argument that
+ * evaluates to an error is bound like any other value. */
+static lizard_env_t *bind_frame(lizard_ast_node_t *func,
+                                const lizard_code_t *code, lizard_env_t *env,
+                                lizard_heap_t *heap) {
+  const lizard_frame_layout_t *layout = func->data.lambda.layout;
+  lizard_env_t *frame =
+      lizard_env_create_frame(heap, func->data.lambda.closure_env, layout);
+  size_t i;
+  /* Evaluating an argument may collect, leaving the frame old. */
+  for (i = 0; i < layout->nparams; i++) {
+    frame->slots[i] = run_value(code->kids[i + 1U], env, heap);
+    lizard_gc_write_barrier(&frame->slots[i]);
+  }
+  if (layout->rest) {
+    lizard_ast_node_t *nil = lizard_make_nil(heap);
+    lizard_ast_node_t *xs = nil;
+    lizard_ast_node_t *last = NULL;
+    for (i = layout->nparams + 1U; i < code->nkids; i++) {
+      lizard_ast_node_t *pair = lizard_heap_alloc_tagged(
+          sizeof(lizard_ast_node_t), LIZARD_GC_OBJECT_AST_NODE,
+          LIZARD_OBJECT_TRACE_AST);
+      pair->type = AST_PAIR;
+      pair->data.pair.car = run_value(code->kids[i], env, heap);
+      lizard_gc_write_barrier(&pair->data.pair.car);
+      pair->data.pair.cdr = nil;
+      if (last != NULL) {
+        last->data.pair.cdr = pair;
+        lizard_gc_write_barrier(&last->data.pair.cdr);
+      } else {
+        xs = pair;
+      }
+      last = pair;
+    }
+    frame->slots[layout->nparams] = xs;
+    lizard_gc_write_barrier(&frame->slots[layout->nparams]);
+  }
+  return frame;
+}
+
+static lizard_ast_node_t *call_closure(lizard_frame_layout_t *layout,
+                                       lizard_env_t *frame,
+                                       lizard_heap_t *heap) {
+  lizard_ast_node_t *out;
+  lizard_env_t *env;
+  if (lizard_analyze_run(layout, frame, heap, &out, &env)) {
+    return out;
+  }
+  return lizard_eval(out, env, heap, lizard_identity_cont);
+}
+
+/* kids[0] is the operator (a variable or lambda expression, so evaluating
+ * it again on the fallback path is harmless), the rest the arguments. */
+static lizard_ast_node_t *run_call(const lizard_code_t *code, lizard_env_t *env,
+                                   lizard_heap_t *heap, analyze_tail_t *tail) {
+  lizard_ast_node_t *func = lizard_force(run_value(code->kids[0], env, heap), heap);
+  size_t argc = code->nkids - 1U;
+  if (func->type == AST_ERROR) {
+    return func;
+  }
+  if (func->type == AST_PRIMITIVE && func->data.primitive.argv != NULL &&
+      argc <= LIZARD_PRIMITIVE_ARGV_MAX) {
+    lizard_ast_node_t *argv[LIZARD_PRIMITIVE_ARGV_MAX];
+    size_t i;
+    for (i = 0; i < argc; i++) {
+      lizard_ast_node_t *value = run_value(code->kids[i + 1U], env, heap);
+      if (value && value->type == AST_ERROR) {
+        return value;
+      }
+      argv[i] = value;
+    }
+    return func->data.primitive.argv((int)argc, argv, env, heap);
+  }
+  if (func->type == AST_LAMBDA) {
+    lizard_frame_layout_t *layout = func->data.lambda.layout;
+    if (layout != NULL && layout->resolved &&
+        (argc == layout->nparams || (layout->rest && argc > layout->nparams))) {
+      lizard_env_t *frame = bind_frame(func, code, env, heap);
+      if (tail != NULL) {
+        tail->layout = layout;
+        tail->frame = frame;
+        return &analyze_tail_marker;
+      }
+      return call_closure(layout, frame, heap);
+    }
+  }
+  return run_fallback(code, env, heap, tail);
+}
+
+/* ---- compilation ------------------------------------------------------- */
+
+static lizard_code_t *make_code(analyze_fn_t run, lizard_ast_node_t *node,
+                                size_t nkids) {
+  lizard_code_t *code = lizard_heap_alloc(sizeof(lizard_code_t));
+  code->run = run;
+  code->node = node;
+  code->nkids = nkids;
+  if (nkids > 0U) {
+    code->kids = lizard_heap_alloc(nkids * sizeof(lizard_code_t *));
+  }
+  return code;
+}
+
+/* The expressions [first, nil) in sequence. */
+static lizard_code_t *compile_seq(lz_list_node_t *first, lz_list_node_t *nil,
+                                  lizard_heap_t *heap) {
+  lizard_code_t *code;
+  lz_list_node_t *it;
+  size_t n = 0;
+  for (it = first; it != nil; it = it->next) {
+    n++;
+  }
+  if (n == 0U) {
+    return make_code(run_nil, NULL, 0U);
+  }
+  if (n == 1U) {
+    return compile_expr(((lizard_ast_list_node_t *)first)->ast, heap);
+  }
+  code = make_code(run_seq, NULL, n);
+  n = 0;
+  for (it = first; it != nil; it = it->next) {
+    code->kids[n++] = compile_expr(((lizard_ast_list_node_t *)it)->ast, heap);
+  }
+  return code;
+}
+
+/* Clauses from `it` on, skipping malformed ones as the walker does. */
+static lizard_code_t *compile_cond(lz_list_node_t *it, lz_list_node_t *nil,
+                                   lizard_heap_t *heap) {
+  for (; it != nil; it = it->next) {
+    lizard_ast_node_t *clause = ((lizard_ast_list_node_t *)it)->ast;
+    lz_list_t *parts;
+    lizard_ast_node_t *test;
+    lizard_code_t *code;
+    if (clause->type != AST_APPLICATION ||
+        clause->data.application_arguments->head ==
+            clause->data.application_arguments->nil) {
+      continue;
+    }
+    parts = clause->data.application_arguments;
+    test = ((lizard_ast_list_node_t *)parts->head)->ast;
+    code = make_code(run_cond, clause, 3U);
+    if (!(test->type == AST_SYMBOL && strcmp(test->data.variable, "else") == 0)) {
+      code->kids[0] = compile_expr(test, heap);
+    }
+    if (parts->head->next != parts->nil) {
+      code->kids[1] = compile_seq(parts->head->next, parts->nil, heap);
+    }
+    code->kids[2] = compile_cond(it->next, nil, heap);
+    return code;
+  }
+  return NULL;
+}
+
+static lizard_code_t *compile_expr(lizard_ast_node_t *node, lizard_heap_t *heap) {
+  lizard_code_t *code;
+  switch (node->type) {
+  case AST_BOOL:
+  case AST_NIL:
+  case AST_NUMBER:
+  case AST_RATIONAL:
+  case AST_REAL:
+  case AST_STRING:
+  case AST_PAIR:
+  case AST_PRIMITIVE:
+  case AST_SYNTAX_RULES:
+    return make_code(run_constant, node, 0U);
+  case AST_SYMBOL:
+    return make_code(run_global, node, 0U);
+  case AST_LOCAL_REF:
+    return make_code(run_local, node, 0U);
+  case AST_QUOTE:
+    /* A quoted list is rebuilt on every evaluation; leave it to the walker. */
+    if (node->data.quoted->type != AST_APPLICATION) {
+      return make_code(run_constant, node->data.quoted, 0U);
+    }
+    break;
+  case AST_IF:
+    code = make_code(run_if, node, 3U);
+    code->kids[0] = compile_expr(node->data.if_clause.pred, heap);
+    code->kids[1] = compile_expr(node->data.if_clause.cons, heap);
+    if (node->data.if_clause.alt != NULL) {
+      code->kids[2] = compile_expr(node->data.if_clause.alt, heap);
+    }
+    return code;
+  case AST_BEGIN:
+    return compile_seq(node->data.begin_expressions->head,
+                       node->data.begin_expressions->nil, heap);
+  case AST_COND:
+    code = compile_cond(node->data.cond_clauses->head,
+                        node->data.cond_clauses->nil, heap);
+    return code != NULL ? code : make_code(run_nil, node, 0U);
+  case AST_DEFINITION:
+    if (node->data.definition.variable->type != AST_SYMBOL) {
+      break;
+    }
+    code = make_code(run_define, node, 1U);
+    code->name = node->data.definition.variable->data.variable;
+    code->kids[0] = compile_expr(node->data.definition.value, heap);
+    return code;
+  case AST_ASSIGNMENT:
+    if (node->data.assignment.variable->type != AST_SYMBOL) {
+      break;
+    }
+    code = make_code(run_assign, node, 1U);
+    code->name = node->data.assignment.variable->data.variable;
+    code->kids[0] = compile_expr(node->data.assignment.value, heap);
+    return code;
+  case AST_LAMBDA:
+    return make_code(run_lambda, node, 0U);
+  case AST_APPLICATION: {
+    lz_list_t *parts = node->data.application_arguments;
+    lizard_ast_node_t *op;
+    lz_list_node_t *it;
+    size_t n = 0;
+    if (parts->head == parts->nil) {
+      break;
+    }
+    op = ((lizard_ast_list_node_t *)parts->head)->ast;
+    if (op->type != AST_SYMBOL && op->type != AST_LOCAL_REF &&
+        op->type != AST_LAMBDA) {
+      break;
+    }
+    for (it = parts->head; it != parts->nil; it = it->next) {
+      n++;
+    }
+    code = make_code(run_call, node, n);
+    n = 0;
+    for (it = parts->head; it != parts->nil; it = it->next) {
+      code->kids[n++] = compile_expr(((lizard_ast_list_node_t *)it)->ast, heap);
+    }
+    return code;
+  }
+  default:
+    break;
+  }
+  return make_code(run_fallback, node, 0U);
+}
+
+/* ---- driver ------------------------------------------------------------ */
+
+int lizard_analyze_run(lizard_frame_layout_t *layout, lizard_env_t *frame,
+                       lizard_heap_t *heap, lizard_ast_node_t **out,
+                       lizard_env_t **tail_env) {
+  analyze_tail_t tail;
+  for (;;) {
+    lizard_ast_node_t *value;
+    if (layout->code == NULL) {
+      layout->code = compile_seq(layout->body->head, layout->body->nil, heap);
+      lizard_gc_write_barrier(&layout->code);
+    }
+    tail.layout = NULL;
+    value = layout->code->run(layout->code, frame, heap, &tail);
+    if (value != &analyze_tail_marker) {
+      *out = value;
+      return 1;
+    }
+    if (tail.layout == NULL) {
+      *out = tail.node;
+      *tail_env = tail.env;
+      return 0;
+    }
+    layout = tail.layout;
+    frame = tail.frame;
+  }
+}
@@ -0,0 +1,32 @@
+/* src/analyze.h — closure-compiled lambda bodies.
+ *
+ * The first time a resolved closure runs, its body (lexical.h) is converted
+ * once into a tree of lizard_code_t handlers: constants, a local reference
+ * at a known (depth, slot), a global by name, if, cond, begin, define, set!,
+ * lambda, and calls whose operator is a variable or a lambda expression.  A
+ * call checks the operator it finds at run time: an argv primitive gets its
+ * arguments in a C buffer and a resolved closure called with an arity it
+ * accepts gets them straight in its frame.  Any other form, and any call
+ * that takes neither route, is handed to lizard_eval unchanged, so the
+ * tree only ever short-cuts what the walker would do.
+ *
+ * Calls in tail position do not grow the C stack: a tail call to a resolved
+ * closure loops inside lizard_analyze_run, and a tail form handed back to
+ * the walker is returned to the caller to continue its own trampoline.
+ */
+#ifndef LIZARD_ANALYZE_H
+#define LIZARD_ANALYZE_H
+
+#include "lizard_internal.h"
+
+typedef struct lizard_code lizard_code_t;
+
+/* Run the body of resolved `layout` in `frame`, compiling it on first use.
+ * Returns 1 with the body's value in *out, or 0 when the body ends in a
+ * form the caller must evaluate next, in tail position: the form is in
+ * *out and its environment in *tail_env. */
+int lizard_analyze_run(lizard_frame_layout_t *layout, lizard_env_t *frame,
+                       lizard_heap_t *heap, lizard_ast_node_t **out,
+                       lizard_env_t **tail_env);
+
+#endif /* LIZARD_ANALYZE_H */
@@ -6,9 +6,13 @@
  */
 #include "bytecode.h"
 #include "errors.h"
+#include "gc.h"
 #include "mem.h"
 #include "primitives.h"
 #include "printer.h"
+#include "runtime.h"
+#include "symbol.h"
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,7 +26,7 @@ const char *lizard_bc_opcode_name(lizard_opcode_t op) {
   case OP_NIL: return "NIL";
   case OP_TRUE: return "TRUE";
   case OP_FALSE: return "FALSE";
-  case OP_LOAD: return "LOAD";
+  case OP_LOAD_GLOBAL: return "LOADG";
   case OP_STORE: return "STORE";
   case OP_SET: return "SET";
   case OP_POP: return "POP";
@@ -47,77 +51,857 @@ const char *lizard_bc_opcode_name(lizard_opcode_t op) {
   case OP_DISPLAY: return "DISPLAY";
   case OP_NEWLINE: return "NEWLINE";
   case OP_HALT: return "HALT";
+  case OP_LOAD_LOCAL: return "LOADL";
+  case OP_STORE_LOCAL: return "STOREL";
+  case OP_LOAD_UPVAL: return "LOADU";
+  case OP_BOX: return "BOX";
+  case OP_UNBOX: return "UNBOX";
+  case OP_SET_BOX: return "SETBOX";
+  case OP_ADD_IMM: return "ADDI";
+  case OP_JUMP_UNLESS_EQ: return "JNEQ";
+  case OP_JUMP_UNLESS_LT: return "JNLT";
+  case OP_JUMP_UNLESS_GT: return "JNGT";
+  case OP_JUMP_IF_FALSE_OR_POP: return "JIFOP";
+  case OP_JUMP_IF_TRUE_OR_POP: return "JITOP";
+  case OP_VECTOR_REF: return "VREF";
+  case OP_VECTOR_SET: return "VSET";
+  case OP_VECTOR_LENGTH: return "VLEN";
+  case OP_STRING_REF: return "SREF";
+  case OP_STRING_LENGTH: return "SLEN";
+  case OP_CALLCC: return "CALLCC";
+  case OP_JUMP_IF_TRUE: return "JIT";
+  case OP_RETURN_LOCAL: return "RETL";
+  case OP_LOAD_UPVAL_UNBOX: return "LOADUB";
+  case OP_STORE_LOCAL_POP: return "STORELP";
+  case OP_LOAD_LOCAL2: return "LOADL2";
+  case OP_LOAD_LOCAL_ADD_IMM: return "LOADLAI";
+  case OP_CALL_PRIM: return "CALLP";
   }
   return "???";
 }
 
 /* ---- chunk helpers ---- */
 
+void lizard_bc_chunk_track(lizard_bc_chunk_t *chunk, lizard_heap_t *heap) {
+  lizard_runtime_t *rt = heap->runtime;
+  if (rt == NULL) return;
+  chunk->heap = heap;
+  chunk->newer = NULL;
+  chunk->older = rt->chunks;
+  if (rt->chunks != NULL) rt->chunks->newer = chunk;
+  rt->chunks = chunk;
+}
+
+void lizard_bc_chunk_free(lizard_bc_chunk_t *chunk) {
+  if (chunk->heap != NULL) {
+    if (chunk->newer != NULL) {
+      chunk->newer->older = chunk->older;
+    } else {
+      chunk->heap->runtime->chunks = chunk->older;
+    }
+    if (chunk->older != NULL) chunk->older->newer = chunk->newer;
+  }
+  free(chunk->code);
+  free(chunk->constants);
+  free(chunk->const_is_name);
+  free(chunk->upval_is_local);
+  free(chunk->upval_index);
+  free(chunk);
+}
+
 static lizard_bc_chunk_t *chunk_create(lizard_heap_t *heap) {
   lizard_bc_chunk_t *c;
   c = (lizard_bc_chunk_t *)malloc(sizeof(lizard_bc_chunk_t));
   if (c == NULL) return NULL;
   memset(c, 0, sizeof(*c));
+  lizard_bc_chunk_track(c, heap);
+  c->code = (lizard_instruction_t *)malloc(LIZARD_BC_INITIAL_CODE *
+                                           sizeof(lizard_instruction_t));
+  c->constants = (lizard_ast_node_t **)malloc(LIZARD_BC_INITIAL_CONSTANTS *
+                                              sizeof(lizard_ast_node_t *));
+  c->const_is_name = (unsigned char *)malloc(LIZARD_BC_INITIAL_CONSTANTS);
+  if (c->code == NULL || c->constants == NULL || c->const_is_name == NULL) {
+    lizard_bc_chunk_free(c);
+    return NULL;
+  }
+  c->code_cap = LIZARD_BC_INITIAL_CODE;
+  c->const_cap = LIZARD_BC_INITIAL_CONSTANTS;
   return c;
 }
 
 static int chunk_emit(lizard_bc_chunk_t *c, lizard_opcode_t op, int arg) {
-  if (c->code_count >= LIZARD_BC_MAX_CODE) return -1;
+  if (c->code_count == c->code_cap) {
+    int cap = c->code_cap * 2;
+    lizard_instruction_t *grown = (lizard_instruction_t *)realloc(
+        c->code, (size_t)cap * sizeof(lizard_instruction_t));
+    if (grown == NULL) {
+      c->oom = 1;
+      return -1;
+    }
+    c->code = grown;
+    c->code_cap = cap;
+  }
   c->code[c->code_count].op = op;
   c->code[c->code_count].arg = arg;
   return c->code_count++;
 }
 
-static int chunk_add_const(lizard_bc_chunk_t *c, lizard_ast_node_t *val) {
-  if (c->const_count >= LIZARD_BC_MAX_CONSTANTS) return -1;
+/* Append `val` to the constant pool. */
+static int chunk_push_const(lizard_bc_chunk_t *c, lizard_ast_node_t *val,
+                            int is_name) {
+  if (c->const_count == c->const_cap) {
+    int cap = c->const_cap * 2;
+    lizard_ast_node_t **grown = (lizard_ast_node_t **)realloc(
+        c->constants, (size_t)cap * sizeof(lizard_ast_node_t *));
+    unsigned char *kinds;
+    if (grown == NULL) {
+      c->oom = 1;
+      return -1;
+    }
+    c->constants = grown;
+    kinds = (unsigned char *)realloc(c->const_is_name, (size_t)cap);
+    if (kinds == NULL) {
+      c->oom = 1;
+      return -1;
+    }
+    c->const_is_name = kinds;
+    c->const_cap = cap;
+  }
   c->constants[c->const_count] = val;
+  c->const_is_name[c->const_count] = (unsigned char)is_name;
   return c->const_count++;
 }
 
-/* ---- compiler ---- */
+/* Whether literals `a` and `b` are the same number, of the same
+ * exactness.  Numeric nodes are never written in place, so one can stand
+ * for the other; strings are mutable and never match. */
+static int same_number(const lizard_ast_node_t *a, const lizard_ast_node_t *b) {
+  if (a->type != b->type) return 0;
+  switch (a->type) {
+  case AST_NUMBER:
+    return mpz_cmp(a->data.number, b->data.number) == 0;
+  case AST_RATIONAL:
+    return mpq_equal(a->data.rational, b->data.rational);
+  case AST_REAL:
+    return memcmp(&a->data.real, &b->data.real, sizeof(double)) == 0;
+  default:
+    return 0;
+  }
+}
 
-/* Forward declaration. */
-static int compile_expr(lizard_bc_chunk_t *c, lizard_ast_node_t *expr,
-                        lizard_heap_t *heap, int tail_position);
+static int chunk_add_const(lizard_bc_chunk_t *c, lizard_ast_node_t *val) {
+  int i;
+  for (i = 0; i < c->const_count; i++) {
+    if (!c->const_is_name[i] &&
+        (c->constants[i] == val || same_number(c->constants[i], val))) {
+      return i;
+    }
+  }
+  return chunk_push_const(c, val, 0);
+}
 
-/* Get list length from an AST list (lz_list_t). */
-static int list_len(lz_list_t *list) {
-  int n = 0;
-  lz_list_node_t *iter;
-  if (list == NULL) return 0;
-  for (iter = list->head; iter != list->nil; iter = iter->next) n++;
-  return n;
+/* Slot of the node naming variable `name`, shared by every OP_LOAD,
+ * OP_STORE and OP_SET of the chunk; OP_LOAD caches its lookup in it. */
+static int chunk_add_name(lizard_bc_chunk_t *c, const char *name,
+                          lizard_heap_t *heap) {
+  lizard_ast_node_t *name_node;
+  int i;
+  name = lizard_intern(name);
+  for (i = 0; i < c->const_count; i++) {
+    if (c->const_is_name[i] && c->constants[i]->data.string == name) return i;
+  }
+  name_node = lizard_heap_alloc_tagged(sizeof(lizard_ast_node_t),
+                                       LIZARD_GC_OBJECT_AST_NODE,
+                                       LIZARD_OBJECT_TRACE_AST);
+  name_node->type = AST_STRING;
+  name_node->data.string = name;
+  return chunk_push_const(c, name_node, 1);
+}
+
+/* ---- peephole optimiser ---- */
+
+static int is_jump(lizard_opcode_t op) {
+  return op == OP_JUMP || op == OP_JUMP_IF_FALSE || op == OP_JUMP_IF_TRUE ||
+         op == OP_JUMP_UNLESS_EQ || op == OP_JUMP_UNLESS_LT ||
+         op == OP_JUMP_UNLESS_GT || op == OP_JUMP_IF_FALSE_OR_POP ||
+         op == OP_JUMP_IF_TRUE_OR_POP;
+}
+
+/* Instructions whose only effect is a push, which a POP undoes. */
+static int is_pure_push(lizard_opcode_t op) {
+  return op == OP_CONST || op == OP_NIL || op == OP_TRUE || op == OP_FALSE ||
+         op == OP_LOAD_LOCAL || op == OP_LOAD_UPVAL;
+}
+
+/* Flags the instructions some jump of `c` lands on; NULL when out of
+ * memory. */
+static unsigned char *jump_targets(const lizard_bc_chunk_t *c) {
+  unsigned char *target = (unsigned char *)calloc((size_t)c->code_count + 1U, 1U);
+  int i;
+  if (target == NULL) return NULL;
+  for (i = 0; i < c->code_count; i++) {
+    if (is_jump(c->code[i].op)) target[c->code[i].arg] = 1;
+  }
+  return target;
+}
+
+/* The single instruction doing what `a; b` does, in *out; 0 if none. */
+static int fuse_pair(lizard_instruction_t a, lizard_instruction_t b,
+                     lizard_instruction_t *out) {
+  out->arg = a.arg;
+  switch (a.op) {
+  case OP_EQ: case OP_LT: case OP_GT: case OP_NOT:
+    if (b.op != OP_JUMP_IF_FALSE) return 0;
+    out->op = a.op == OP_EQ   ? OP_JUMP_UNLESS_EQ
+              : a.op == OP_LT ? OP_JUMP_UNLESS_LT
+              : a.op == OP_GT ? OP_JUMP_UNLESS_GT
+                              : OP_JUMP_IF_TRUE;
+    out->arg = b.arg;
+    return 1;
+  case OP_LOAD_LOCAL:
+    out->op = OP_RETURN_LOCAL;
+    return b.op == OP_RETURN;
+  case OP_LOAD_UPVAL:
+    out->op = OP_LOAD_UPVAL_UNBOX;
+    return b.op == OP_UNBOX;
+  case OP_STORE_LOCAL:
+    out->op = OP_STORE_LOCAL_POP;
+    return b.op == OP_POP;
+  default:
+    return 0;
+  }
+}
+
+/* Rewrite the finished code of `c` to do the same in fewer dispatches:
+ *
+ *   - a jump to an unconditional jump goes to where that one leads, and
+ *     one to a RETURN or HALT is replaced by it;
+ *   - a pure push followed by POP, and a jump to the next instruction,
+ *     are dropped;
+ *   - the pairs fuse_pair knows become one instruction;
+ *   - LOAD_LOCAL followed by LOAD_LOCAL or ADD_IMM becomes a
+ *     superinstruction that takes its second operand from the instruction
+ *     after it and skips it.
+ *
+ * The superinstructions are the adjacent pairs lizard_vm_profile_t counts
+ * most often on recursive and looping code.  Nothing is merged across a
+ * jump target.  Out of memory, the code is left as it is. */
+static void chunk_optimize(lizard_bc_chunk_t *c) {
+  unsigned char *target;
+  int *map;
+  int i, n = 0;
+
+  for (i = 0; i < c->code_count; i++) {
+    lizard_instruction_t *in = &c->code[i];
+    int hops = 0;
+    if (!is_jump(in->op)) continue;
+    while (in->arg < c->code_count && c->code[in->arg].op == OP_JUMP &&
+           hops++ < c->code_count) {
+      in->arg = c->code[in->arg].arg;
+    }
+    if (in->op == OP_JUMP && in->arg < c->code_count &&
+        (c->code[in->arg].op == OP_RETURN || c->code[in->arg].op == OP_HALT)) {
+      *in = c->code[in->arg];
+    }
+  }
+
+  target = jump_targets(c);
+  map = (int *)malloc(((size_t)c->code_count + 1U) * sizeof(int));
+  if (target == NULL || map == NULL) {
+    free(target);
+    free(map);
+    return;
+  }
+  for (i = 0; i < c->code_count; i++) {
+    lizard_instruction_t in = c->code[i], fused;
+    map[i] = n;
+    if (i + 1 < c->code_count && !target[i + 1]) {
+      if (is_pure_push(in.op) && c->code[i + 1].op == OP_POP) {
+        map[++i] = n;
+        continue;
+      }
+      if (fuse_pair(in, c->code[i + 1], &fused)) {
+        in = fused;
+        map[++i] = n;
+      }
+    }
+    if (in.op == OP_JUMP && in.arg == i + 1) continue;
+    c->code[n++] = in;
+  }
+  map[c->code_count] = n;
+  c->code_count = n;
+  for (i = 0; i < n; i++) {
+    if (is_jump(c->code[i].op)) c->code[i].arg = map[c->code[i].arg];
+  }
+  free(map);
+  free(target);
+
+  target = jump_targets(c);
+  if (target == NULL) return;
+  for (i = 0; i + 1 < c->code_count; i++) {
+    if (c->code[i].op != OP_LOAD_LOCAL || target[i + 1]) continue;
+    if (c->code[i + 1].op == OP_LOAD_LOCAL) {
+      c->code[i++].op = OP_LOAD_LOCAL2;
+    } else if (c->code[i + 1].op == OP_ADD_IMM) {
+      c->code[i++].op = OP_LOAD_LOCAL_ADD_IMM;
+    }
+  }
+  free(target);
+}
+
+/* ---- compile-time scopes ---- */
+
+/* A set of interned names. */
+typedef struct {
+  const char **v;
+  int n, cap;
+} bc_names_t;
+
+static int names_index(const bc_names_t *ns, const char *name) {
+  int i;
+  for (i = 0; i < ns->n; i++) {
+    if (ns->v[i] == name) return i;
+  }
+  return -1;
+}
+
+/* Add `name` unless present; its index, or -1 when out of memory. */
+static int names_add(bc_names_t *ns, const char *name) {
+  int i = names_index(ns, name);
+  if (i >= 0) return i;
+  if (ns->n == ns->cap) {
+    int cap = ns->cap ? ns->cap * 2 : 8;
+    const char **grown =
+        (const char **)realloc((void *)ns->v, (size_t)cap * sizeof(char *));
+    if (grown == NULL) return -1;
+    ns->v = grown;
+    ns->cap = cap;
+  }
+  ns->v[ns->n] = name;
+  return ns->n++;
+}
+
+/* The lambda being compiled: its frame slots and the upvalues its chunk
+ * has asked for so far. */
+typedef struct bc_scope {
+  bc_names_t locals;
+  unsigned char *boxed;      /* per local */
+  bc_names_t upvals;
+  unsigned char *upval_boxed; /* per upvalue, upvals.cap long */
+  lizard_bc_chunk_t *chunk;
+  struct bc_scope *outer;
+} bc_scope_t;
+
+static void scope_free(bc_scope_t *s) {
+  free((void *)s->locals.v);
+  free(s->boxed);
+  free((void *)s->upvals.v);
+  free(s->upval_boxed);
+}
+
+/* Names defined by a lambda body, outside nested lambdas. */
+static int collect_defines(lizard_ast_node_t *node, bc_names_t *ns) {
+  lz_list_node_t *it;
+  lz_list_t *list = NULL;
+  if (node == NULL) return 0;
+  switch (node->type) {
+  case AST_DEFINITION:
+    if (node->data.definition.variable->type == AST_SYMBOL &&
+        names_add(ns, lizard_intern(
+                          node->data.definition.variable->data.variable)) < 0) {
+      return -1;
+    }
+    return collect_defines(node->data.definition.value, ns);
+  case AST_ASSIGNMENT:
+    return collect_defines(node->data.assignment.value, ns);
+  case AST_IF:
+    if (collect_defines(node->data.if_clause.pred, ns) < 0 ||
+        collect_defines(node->data.if_clause.cons, ns) < 0) {
+      return -1;
+    }
+    return collect_defines(node->data.if_clause.alt, ns);
+  case AST_BEGIN:
+    list = node->data.begin_expressions;
+    break;
+  case AST_COND:
+    list = node->data.cond_clauses;
+    break;
+  case AST_APPLICATION:
+  case AST_CALLCC:
+    list = node->data.application_arguments;
+    break;
+  default:
+    return 0;
+  }
+  for (it = list->head; it != list->nil; it = it->next) {
+    if (collect_defines(((lizard_ast_list_node_t *)it)->ast, ns) < 0) return -1;
+  }
+  return 0;
+}
+
+/* Names a lambda body assigns (set! or define, at any depth) and names
+ * used inside lambdas nested in it.  Shadowing is ignored: a name in both
+ * sets is boxed, which only costs speed when the guess is wrong. */
+static int scan_uses(lizard_ast_node_t *node, bc_names_t *assigned,
+                     bc_names_t *captured, int nested) {
+  lz_list_node_t *it;
+  lz_list_t *list = NULL;
+  lizard_ast_node_t *target = NULL;
+  lizard_ast_node_t *value = NULL;
+  if (node == NULL) return 0;
+  switch (node->type) {
+  case AST_SYMBOL:
+    if (nested && names_add(captured, lizard_intern(node->data.variable)) < 0) {
+      return -1;
+    }
+    return 0;
+  case AST_DEFINITION:
+    target = node->data.definition.variable;
+    value = node->data.definition.value;
+    break;
+  case AST_ASSIGNMENT:
+    target = node->data.assignment.variable;
+    value = node->data.assignment.value;
+    break;
+  case AST_IF:
+    if (scan_uses(node->data.if_clause.pred, assigned, captured, nested) < 0 ||
+        scan_uses(node->data.if_clause.cons, assigned, captured, nested) < 0) {
+      return -1;
+    }
+    return scan_uses(node->data.if_clause.alt, assigned, captured, nested);
+  case AST_BEGIN:
+    list = node->data.begin_expressions;
+    break;
+  case AST_COND:
+    list = node->data.cond_clauses;
+    break;
+  case AST_APPLICATION:
+  case AST_CALLCC:
+    list = node->data.application_arguments;
+    break;
+  case AST_LAMBDA:
+    list = node->data.lambda.parameters;
+    if (list == NULL || list->head == list->nil) return 0;
+    for (it = list->head->next; it != list->nil; it = it->next) {
+      if (scan_uses(((lizard_ast_list_node_t *)it)->ast, assigned, captured,
+                    1) < 0) {
+        return -1;
+      }
+    }
+    return 0;
+  default:
+    return 0;
+  }
+  if (target != NULL) {
+    if (target->type == AST_SYMBOL) {
+      const char *name = lizard_intern(target->data.variable);
+      if (names_add(assigned, name) < 0 ||
+          (nested && names_add(captured, name) < 0)) {
+        return -1;
+      }
+    }
+    return scan_uses(value, assigned, captured, nested);
+  }
+  for (it = list->head; it != list->nil; it = it->next) {
+    if (scan_uses(((lizard_ast_list_node_t *)it)->ast, assigned, captured,
+                  nested) < 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* Upvalue index of `name` in scope `s`, adding it (and, further out, the
+ * upvalues it comes through) on first use; -1 when `name` is global.
+ * *boxed says whether the upvalue holds a box. */
+static int scope_upval(bc_scope_t *s, const char *name, int *boxed) {
+  int i, from, is_local;
+  lizard_bc_chunk_t *c = s->chunk;
+  if (s->outer == NULL) return -1;
+  if ((i = names_index(&s->upvals, name)) >= 0) {
+    *boxed = s->upval_boxed[i];
+    return i;
+  }
+  if ((from = names_index(&s->outer->locals, name)) >= 0) {
+    is_local = 1;
+    *boxed = s->outer->boxed[from];
+  } else if ((from = scope_upval(s->outer, name, boxed)) >= 0) {
+    is_local = 0;
+  } else {
+    return -1;
+  }
+  if (s->upvals.n == s->upvals.cap) {
+    int cap = s->upvals.cap ? s->upvals.cap * 2 : 8;
+    unsigned char *b = (unsigned char *)realloc(s->upval_boxed, (size_t)cap);
+    unsigned char *l;
+    int *x;
+    if (b == NULL) return -2;
+    s->upval_boxed = b;
+    l = (unsigned char *)realloc(c->upval_is_local, (size_t)cap);
+    if (l == NULL) return -2;
+    c->upval_is_local = l;
+    x = (int *)realloc(c->upval_index, (size_t)cap * sizeof(int));
+    if (x == NULL) return -2;
+    c->upval_index = x;
+  }
+  i = names_add(&s->upvals, name);
+  if (i < 0) return -2;
+  s->upval_boxed[i] = (unsigned char)*boxed;
+  c->upval_is_local[i] = (unsigned char)is_local;
+  c->upval_index[i] = from;
+  c->upval_count = s->upvals.n;
+  return i;
+}
+
+/* Where variable `name` lives, seen from scope `s`. */
+typedef enum { BC_VAR_GLOBAL, BC_VAR_LOCAL, BC_VAR_UPVAL } bc_var_kind_t;
+
+static bc_var_kind_t resolve_var(bc_scope_t *s, const char *name, int *index,
+                                 int *boxed) {
+  if (s == NULL) return BC_VAR_GLOBAL;
+  name = lizard_intern(name);
+  if ((*index = names_index(&s->locals, name)) >= 0) {
+    *boxed = s->boxed[*index];
+    return BC_VAR_LOCAL;
+  }
+  if ((*index = scope_upval(s, name, boxed)) >= 0) return BC_VAR_UPVAL;
+  if (*index < -1) s->chunk->oom = 1;
+  return BC_VAR_GLOBAL;
+}
+
+/* Push the value of `name`. */
+static int compile_ref(bc_scope_t *s, lizard_bc_chunk_t *c, const char *name,
+                       lizard_heap_t *heap) {
+  int index = 0, boxed = 0, idx;
+  switch (resolve_var(s, name, &index, &boxed)) {
+  case BC_VAR_LOCAL:
+    chunk_emit(c, OP_LOAD_LOCAL, index);
+    break;
+  case BC_VAR_UPVAL:
+    chunk_emit(c, OP_LOAD_UPVAL, index);
+    break;
+  default:
+    idx = chunk_add_name(c, name, heap);
+    if (idx < 0) return -1;
+    chunk_emit(c, OP_LOAD_GLOBAL, idx);
+    return 0;
+  }
+  if (boxed) chunk_emit(c, OP_UNBOX, 0);
+  return 0;
 }
 
-/* Compile the body of a begin/sequence: compile each expr, pop
- * intermediates, keep the last. */
-static int compile_sequence(lizard_bc_chunk_t *c, lz_list_t *exprs,
-                             lizard_heap_t *heap, int tail_position) {
+/* Store the value on top of the stack into `name`, leaving it pushed;
+ * `global_op` is OP_STORE (define) or OP_SET (set!) for a global. */
+static int compile_assign(bc_scope_t *s, lizard_bc_chunk_t *c,
+                          const char *name, lizard_opcode_t global_op,
+                          lizard_heap_t *heap) {
+  int index = 0, boxed = 0, idx;
+  switch (resolve_var(s, name, &index, &boxed)) {
+  case BC_VAR_LOCAL:
+    if (!boxed) {
+      chunk_emit(c, OP_STORE_LOCAL, index);
+      return 0;
+    }
+    chunk_emit(c, OP_LOAD_LOCAL, index);
+    break;
+  case BC_VAR_UPVAL:
+    if (!boxed) return -1; /* the scan saw no assignment: cannot happen */
+    chunk_emit(c, OP_LOAD_UPVAL, index);
+    break;
+  default:
+    idx = chunk_add_name(c, name, heap);
+    if (idx < 0) return -1;
+    chunk_emit(c, global_op, idx);
+    return 0;
+  }
+  chunk_emit(c, OP_SET_BOX, 0);
+  return 0;
+}
+
+/* Whether `name` in operator position is the global of that name, so a
+ * built-in may be open-coded for it. */
+static int is_global(bc_scope_t *s, const char *name) {
+  int index = 0, boxed = 0;
+  return resolve_var(s, name, &index, &boxed) == BC_VAR_GLOBAL;
+}
+
+/* ---- compiler ---- */
+
+/* Forward declaration. */
+static int compile_expr(bc_scope_t *s, lizard_bc_chunk_t *c,
+                        lizard_ast_node_t *expr, lizard_heap_t *heap,
+                        int tail_position);
+
+/* Compile the expressions from `first` up to `nil` in sequence: pop
+ * intermediates, keep the last (nil when there are none). */
+static int compile_body(bc_scope_t *s, lizard_bc_chunk_t *c,
+                        lz_list_node_t *first, lz_list_node_t *nil,
+                        lizard_heap_t *heap, int tail_position) {
   lz_list_node_t *iter;
-  int count = 0;
-  if (exprs == NULL) {
+  if (first == nil) {
     chunk_emit(c, OP_NIL, 0);
     return 0;
   }
-  for (iter = exprs->head; iter != exprs->nil; iter = iter->next) {
-    int is_last = (iter->next == exprs->nil);
-    if (compile_expr(c, ((lizard_ast_list_node_t *)iter)->ast, heap,
+  for (iter = first; iter != nil; iter = iter->next) {
+    int is_last = (iter->next == nil);
+    if (compile_expr(s, c, ((lizard_ast_list_node_t *)iter)->ast, heap,
                      is_last && tail_position) < 0) {
       return -1;
     }
     if (!is_last) {
       chunk_emit(c, OP_POP, 0);
     }
-    count++;
   }
-  if (count == 0) {
+  return 0;
+}
+
+/* Compile the body of a begin/sequence. */
+static int compile_sequence(bc_scope_t *s, lizard_bc_chunk_t *c,
+                            lz_list_t *exprs, lizard_heap_t *heap,
+                            int tail_position) {
+  if (exprs == NULL) {
     chunk_emit(c, OP_NIL, 0);
+    return 0;
   }
+  return compile_body(s, c, exprs->head, exprs->nil, heap, tail_position);
+}
+
+/* Forward jumps to a place not yet compiled are chained through their
+ * operands, -1 ending the chain.  Emit one more onto `*chain`. */
+static int emit_chained(lizard_bc_chunk_t *c, lizard_opcode_t op, int *chain) {
+  int at = chunk_emit(c, op, *chain);
+  if (at < 0) return -1;
+  *chain = at;
   return 0;
 }
 
-static int compile_expr(lizard_bc_chunk_t *c, lizard_ast_node_t *expr,
-                        lizard_heap_t *heap, int tail_position) {
+/* Point every jump on `chain` at the next instruction. */
+static void patch_chain(lizard_bc_chunk_t *c, int chain) {
+  while (chain >= 0) {
+    int next = c->code[chain].arg;
+    c->code[chain].arg = c->code_count;
+    chain = next;
+  }
+}
+
+/* Lay out the frame of the lambda whose parameter list and body are
+ * `parts` and compile its body into inner->chunk. */
+static int compile_lambda_body(bc_scope_t *inner, lz_list_t *parts,
+                               lizard_heap_t *heap) {
+  lizard_bc_chunk_t *sub = inner->chunk;
+  lizard_ast_node_t *spec = ((lizard_ast_list_node_t *)parts->head)->ast;
+  lz_list_node_t *iter;
+  bc_names_t assigned, captured;
+  int i, rc = 0;
+
+  /* Slots: the parameters, the rest parameter (`args` in (lambda args
+   * ...), `r` in (lambda (a . r) ...)), then the names the body defines. */
+  if (spec->type == AST_APPLICATION) {
+    for (iter = spec->data.application_arguments->head;
+         iter != spec->data.application_arguments->nil; iter = iter->next) {
+      lizard_ast_node_t *p = ((lizard_ast_list_node_t *)iter)->ast;
+      const char *name;
+      if (p->type != AST_SYMBOL) return -1;
+      if (strcmp(p->data.variable, ".") == 0) {
+        /* exactly one name after the dot */
+        if (sub->rest || iter->next == spec->data.application_arguments->nil ||
+            iter->next->next != spec->data.application_arguments->nil) {
+          return -1;
+        }
+        sub->rest = 1;
+        continue;
+      }
+      name = lizard_intern(p->data.variable);
+      if (names_index(&inner->locals, name) >= 0 ||
+          names_add(&inner->locals, name) < 0) {
+        return -1;
+      }
+    }
+  } else if (spec->type == AST_SYMBOL) {
+    if (names_add(&inner->locals, lizard_intern(spec->data.variable)) < 0) {
+      return -1;
+    }
+    sub->rest = 1;
+  } else if (spec->type != AST_NIL) {
+    return -1;
+  }
+  sub->arity = inner->locals.n - sub->rest;
+  for (iter = parts->head->next; iter != parts->nil; iter = iter->next) {
+    if (collect_defines(((lizard_ast_list_node_t *)iter)->ast,
+                        &inner->locals) < 0) {
+      return -1;
+    }
+  }
+  sub->nlocals = inner->locals.n;
+
+  /* Box the slots that are assigned and captured. */
+  inner->boxed = (unsigned char *)calloc((size_t)sub->nlocals + 1U, 1U);
+  if (inner->boxed == NULL) return -1;
+  memset(&assigned, 0, sizeof(assigned));
+  memset(&captured, 0, sizeof(captured));
+  for (iter = parts->head->next; iter != parts->nil && rc == 0;
+       iter = iter->next) {
+    rc = scan_uses(((lizard_ast_list_node_t *)iter)->ast, &assigned,
+                   &captured, 0);
+  }
+  for (i = 0; i < sub->nlocals; i++) {
+    inner->boxed[i] = (unsigned char)(names_index(&assigned, inner->locals.v[i]) >= 0 &&
+                                      names_index(&captured, inner->locals.v[i]) >= 0);
+  }
+  free((void *)assigned.v);
+  free((void *)captured.v);
+  if (rc < 0) return -1;
+  for (i = 0; i < sub->nlocals; i++) {
+    if (inner->boxed[i]) {
+      if (i < sub->arity + sub->rest) {
+        chunk_emit(sub, OP_LOAD_LOCAL, i);
+      } else {
+        chunk_emit(sub, OP_NIL, 0);
+      }
+      chunk_emit(sub, OP_BOX, 0);
+      chunk_emit(sub, OP_STORE_LOCAL, i);
+      chunk_emit(sub, OP_POP, 0);
+    }
+  }
+
+  /* The body forms, the last in tail position. */
+  if (parts->head->next == parts->nil) {
+    chunk_emit(sub, OP_NIL, 0);
+  }
+  for (iter = parts->head->next; iter != parts->nil; iter = iter->next) {
+    int is_last = (iter->next == parts->nil);
+    if (compile_expr(inner, sub, ((lizard_ast_list_node_t *)iter)->ast, heap,
+                     is_last) < 0) {
+      return -1;
+    }
+    if (!is_last) {
+      chunk_emit(sub, OP_POP, 0);
+    }
+  }
+  if (chunk_emit(sub, OP_RETURN, 0) < 0 || sub->oom) return -1;
+  chunk_optimize(sub);
+  return 0;
+}
+
+/* Compile the lambda body to a sub-chunk, emit OP_CLOSURE. */
+static int compile_lambda(bc_scope_t *s, lizard_bc_chunk_t *c,
+                          lizard_ast_node_t *expr, lizard_heap_t *heap) {
+  lz_list_t *parts = expr->data.lambda.parameters;
+  lizard_ast_node_t *chunk_holder;
+  bc_scope_t inner;
+  int rc, idx;
+
+  /* parts: the parameter list, then the body forms. */
+  if (parts == NULL || parts->head == parts->nil) return -1;
+  memset(&inner, 0, sizeof(inner));
+  inner.outer = s;
+  inner.chunk = chunk_create(heap);
+  if (inner.chunk == NULL) return -1;
+  inner.chunk->span = expr->span;
+  rc = compile_lambda_body(&inner, parts, heap);
+  scope_free(&inner);
+  /* An upvalue added to an enclosing chunk may have run it out of memory. */
+  if (rc < 0 || c->oom) {
+    lizard_bc_chunk_free(inner.chunk);
+    return -1;
+  }
+
+  /* Store the sub-chunk as a constant. We wrap it in an AST node
+   * for storage (using a string with a magic prefix). */
+  chunk_holder = lizard_heap_alloc_tagged(sizeof(lizard_ast_node_t),
+                                          LIZARD_GC_OBJECT_AST_NODE,
+                                          LIZARD_OBJECT_TRACE_AST);
+  chunk_holder->type = AST_STRING;  /* store chunk pointer via memcpy (C89 safe) */
+  memcpy(&chunk_holder->data.string, &inner.chunk, sizeof(inner.chunk));
+  idx = chunk_add_const(c, chunk_holder);
+  if (idx < 0) {
+    lizard_bc_chunk_free(inner.chunk);
+    return -1;
+  }
+  chunk_emit(c, OP_CLOSURE, idx);
+  return 0;
+}
+
+/* Name the chunk of the closure just emitted after `name`, the variable a
+ * define or set! binds it to, unless it has one. */
+static void name_closure(lizard_bc_chunk_t *c, const char *name) {
+  lizard_bc_chunk_t *sub;
+  if (c->code_count == 0 || c->code[c->code_count - 1].op != OP_CLOSURE) {
+    return;
+  }
+  memcpy(&sub, &c->constants[c->code[c->code_count - 1].arg]->data.string,
+         sizeof(sub));
+  if (sub->name == NULL) sub->name = lizard_intern(name);
+}
+
+/* Whether `node` is an integer literal whose value and negation fit an
+ * instruction operand; the value in *k. */
+static int small_int_literal(lizard_ast_node_t *node, int *k) {
+  long v;
+  if (node == NULL || node->type != AST_NUMBER ||
+      !mpz_fits_slong_p(node->data.number)) {
+    return 0;
+  }
+  v = mpz_get_si(node->data.number);
+  if (v <= INT_MIN || v > INT_MAX) return 0;
+  *k = (int)v;
+  return 1;
+}
+
+/* The compare-and-branch opcode for an `if` test that is a two-argument
+ * global =, < or >, with its operands; OP_HALT for any other test. */
+static lizard_opcode_t compare_branch(bc_scope_t *s, lizard_ast_node_t *pred,
+                                      lizard_ast_node_t **lhs,
+                                      lizard_ast_node_t **rhs) {
+  lz_list_t *args;
+  lz_list_node_t *it;
+  lizard_ast_node_t *fn;
+  const char *name;
+  if (pred == NULL || pred->type != AST_APPLICATION) return OP_HALT;
+  args = pred->data.application_arguments;
+  if (args == NULL || args->head == args->nil) return OP_HALT;
+  it = args->head;
+  fn = ((lizard_ast_list_node_t *)it)->ast;
+  if (fn->type != AST_SYMBOL || !is_global(s, fn->data.variable)) {
+    return OP_HALT;
+  }
+  if (it->next == args->nil || it->next->next == args->nil ||
+      it->next->next->next != args->nil) {
+    return OP_HALT;
+  }
+  *lhs = ((lizard_ast_list_node_t *)it->next)->ast;
+  *rhs = ((lizard_ast_list_node_t *)it->next->next)->ast;
+  name = fn->data.variable;
+  if (strcmp(name, "=") == 0) return OP_JUMP_UNLESS_EQ;
+  if (strcmp(name, "<") == 0) return OP_JUMP_UNLESS_LT;
+  if (strcmp(name, ">") == 0) return OP_JUMP_UNLESS_GT;
+  return OP_HALT;
+}
+
+/* The opcode for a call of the global vector or string accessor `name`
+ * on `argc` arguments; OP_HALT for any other call. */
+static lizard_opcode_t accessor_op(const char *name, int argc) {
+  static const struct {
+    const char *name;
+    int argc;
+    lizard_opcode_t op;
+  } accessors[] = {{"vector-ref", 2, OP_VECTOR_REF},
+                   {"vector-set!", 3, OP_VECTOR_SET},
+                   {"vector-length", 1, OP_VECTOR_LENGTH},
+                   {"string-ref", 2, OP_STRING_REF},
+                   {"string-length", 1, OP_STRING_LENGTH}};
+  size_t i;
+  for (i = 0; i < sizeof(accessors) / sizeof(accessors[0]); i++) {
+    if (accessors[i].argc == argc && strcmp(accessors[i].name, name) == 0) {
+      return accessors[i].op;
+    }
+  }
+  return OP_HALT;
+}
+
+static int compile_expr(bc_scope_t *s, lizard_bc_chunk_t *c,
+                        lizard_ast_node_t *expr, lizard_heap_t *heap,
+                        int tail_position) {
   if (expr == NULL) {
     chunk_emit(c, OP_NIL, 0);
     return 0;
@@ -126,7 +910,11 @@ static int compile_expr(lizard_bc_chunk_t *c, lizard_ast_node_t *expr,
   switch (expr->type) {
   case AST_NUMBER:
   case AST_RATIONAL:
-  case AST_STRING: {
+  case AST_REAL:
+  case AST_STRING:
+  case AST_PAIR:
+  case AST_PRIMITIVE: {
+    /* Self-evaluating. */
     int idx = chunk_add_const(c, expr);
     if (idx < 0) return -1;
     chunk_emit(c, OP_CONST, idx);
@@ -139,20 +927,19 @@ static int compile_expr(lizard_bc_chunk_t *c, lizard_ast_node_t *expr,
     chunk_emit(c, OP_NIL, 0);
     return 0;
   case AST_SYMBOL: {
-    /* Variable reference. Store the symbol name as a constant. */
-    lizard_ast_node_t *name_node = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-    int idx;
-    name_node->type = AST_STRING;
-    name_node->data.string = expr->data.variable;
-    idx = chunk_add_const(c, name_node);
-    if (idx < 0) return -1;
-    chunk_emit(c, OP_LOAD, idx);
-    return 0;
+    /* Variable reference: a frame slot, an upvalue or a global. */
+    return compile_ref(s, c, expr->data.variable, heap);
   }
   case AST_QUOTE:
-    /* Quoted datum: push as constant. */
+    /* Quoted datum: push as constant, a list as the pairs the evaluator
+     * would make of it. */
     {
-      int idx = chunk_add_const(c, expr->data.quoted);
+      lizard_ast_node_t *datum = expr->data.quoted;
+      int idx;
+      if (datum->type == AST_APPLICATION) {
+        datum = lizard_convert_list_literal(datum, heap);
+      }
+      idx = chunk_add_const(c, datum);
       if (idx < 0) return -1;
       chunk_emit(c, OP_CONST, idx);
       return 0;
@@ -162,14 +949,23 @@ static int compile_expr(lizard_bc_chunk_t *c, lizard_ast_node_t *expr,
     /* (if pred cons alt) */
     {
       int jump_false, jump_end, after_cons;
-      if (compile_expr(c, expr->data.if_clause.pred, heap, 0) < 0) return -1;
-      jump_false = chunk_emit(c, OP_JUMP_IF_FALSE, 0);  /* patch later */
-      if (compile_expr(c, expr->data.if_clause.cons, heap, tail_position) < 0) return -1;
+      lizard_ast_node_t *lhs, *rhs;
+      lizard_opcode_t branch = compare_branch(s, expr->data.if_clause.pred,
+                                              &lhs, &rhs);
+      if (branch != OP_HALT) {
+        if (compile_expr(s, c, lhs, heap, 0) < 0) return -1;
+        if (compile_expr(s, c, rhs, heap, 0) < 0) return -1;
+      } else {
+        if (compile_expr(s, c, expr->data.if_clause.pred, heap, 0) < 0) return -1;
+        branch = OP_JUMP_IF_FALSE;
+      }
+      jump_false = chunk_emit(c, branch, 0);  /* patch later */
+      if (compile_expr(s, c, expr->data.if_clause.cons, heap, tail_position) < 0) return -1;
       jump_end = chunk_emit(c, OP_JUMP, 0);  /* patch later */
       after_cons = c->code_count;
       c->code[jump_false].arg = after_cons;
       if (expr->data.if_clause.alt != NULL) {
-        if (compile_expr(c, expr->data.if_clause.alt, heap, tail_position) < 0) return -1;
+        if (compile_expr(s, c, expr->data.if_clause.alt, heap, tail_position) < 0) return -1;
       } else {
         chunk_emit(c, OP_NIL, 0);
       }
@@ -180,145 +976,109 @@ static int compile_expr(lizard_bc_chunk_t *c, lizard_ast_node_t *expr,
   case AST_DEFINITION:
     /* (define var val) */
     {
-      lizard_ast_node_t *name_node;
-      int idx;
-      if (compile_expr(c, expr->data.definition.value, heap, 0) < 0) return -1;
-      name_node = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-      name_node->type = AST_STRING;
-      name_node->data.string = expr->data.definition.variable->data.variable;
-      idx = chunk_add_const(c, name_node);
-      if (idx < 0) return -1;
-      chunk_emit(c, OP_STORE, idx);
+      if (expr->data.definition.variable->type != AST_SYMBOL) return -1;
+      if (compile_expr(s, c, expr->data.definition.value, heap, 0) < 0) return -1;
+      name_closure(c, expr->data.definition.variable->data.variable);
+      if (compile_assign(s, c, expr->data.definition.variable->data.variable,
+                         OP_STORE, heap) < 0) {
+        return -1;
+      }
+      /* the result is nil, as in the evaluator; the peephole pass drops
+       * the NIL again when the value is discarded */
+      chunk_emit(c, OP_POP, 0);
+      chunk_emit(c, OP_NIL, 0);
       return 0;
     }
 
   case AST_ASSIGNMENT:
     /* (set! var val) */
     {
-      lizard_ast_node_t *name_node;
-      int idx;
-      if (compile_expr(c, expr->data.assignment.value, heap, 0) < 0) return -1;
-      name_node = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-      name_node->type = AST_STRING;
-      name_node->data.string = expr->data.assignment.variable->data.variable;
-      idx = chunk_add_const(c, name_node);
-      if (idx < 0) return -1;
-      chunk_emit(c, OP_SET, idx);
+      if (expr->data.assignment.variable->type != AST_SYMBOL) return -1;
+      if (compile_expr(s, c, expr->data.assignment.value, heap, 0) < 0) return -1;
+      name_closure(c, expr->data.assignment.variable->data.variable);
+      if (compile_assign(s, c, expr->data.assignment.variable->data.variable,
+                         OP_SET, heap) < 0) {
+        return -1;
+      }
+      chunk_emit(c, OP_POP, 0);
+      chunk_emit(c, OP_NIL, 0);
       return 0;
     }
 
   case AST_BEGIN:
-    return compile_sequence(c, expr->data.begin_expressions, heap,
+    return compile_sequence(s, c, expr->data.begin_expressions, heap,
                             tail_position);
 
   case AST_COND:
-    /* Compile cond as a chain of if-then-else. */
+    /* (cond (test body...) ... (else body...)), each clause an
+     * AST_APPLICATION as the evaluator reads it; a clause with no body
+     * gives the value of its test, and no clause holding gives nil. */
     {
       lz_list_node_t *clause;
-      int end_patches[32];
-      int n_patches = 0;
+      int end = -1;
+      int has_else = 0;
       if (expr->data.cond_clauses == NULL) {
-        chunk_emit(c, OP_CONST, chunk_add_const(c, lizard_make_nil(heap)));
+        chunk_emit(c, OP_NIL, 0);
         return 0;
       }
       for (clause = expr->data.cond_clauses->head;
-           clause != expr->data.cond_clauses->nil;
+           clause != expr->data.cond_clauses->nil && !has_else;
            clause = clause->next) {
         lizard_ast_node_t *cl = ((lizard_ast_list_node_t *)clause)->ast;
+        lz_list_node_t *first, *nil;
+        lizard_ast_node_t *test;
         int skip;
-        if (cl == NULL || cl->type != AST_PAIR) continue;
-        /* Check for 'else' clause. */
-        if (cl->data.pair.car->type == AST_SYMBOL &&
-            strcmp(cl->data.pair.car->data.variable, "else") == 0) {
-          if (compile_expr(c, cl->data.pair.cdr, heap, tail_position) < 0)
-            return -1;
-          break;
+        if (cl == NULL || cl->type != AST_APPLICATION ||
+            cl->data.application_arguments->head ==
+                cl->data.application_arguments->nil) {
+          continue;
         }
-        /* Compile test. */
-        if (compile_expr(c, cl->data.pair.car, heap, 0) < 0) return -1;
-        skip = chunk_emit(c, OP_JUMP_IF_FALSE, 0);
-        /* Compile body. */
-        if (compile_expr(c, cl->data.pair.cdr, heap, tail_position) < 0)
-          return -1;
-        if (n_patches < 32) {
-          end_patches[n_patches++] = chunk_emit(c, OP_JUMP, 0);
+        first = cl->data.application_arguments->head;
+        nil = cl->data.application_arguments->nil;
+        test = ((lizard_ast_list_node_t *)first)->ast;
+        if (test->type == AST_SYMBOL && strcmp(test->data.variable, "else") == 0) {
+          if (compile_body(s, c, first->next, nil, heap, tail_position) < 0) return -1;
+          has_else = 1;
+          continue;
+        }
+        if (compile_expr(s, c, test, heap, 0) < 0) return -1;
+        if (first->next == nil) {
+          if (emit_chained(c, OP_JUMP_IF_TRUE_OR_POP, &end) < 0) return -1;
+          continue;
         }
-        /* Patch the skip to jump past this clause's body. */
+        skip = chunk_emit(c, OP_JUMP_IF_FALSE, 0);
+        if (skip < 0) return -1;
+        if (compile_body(s, c, first->next, nil, heap, tail_position) < 0) return -1;
+        if (emit_chained(c, OP_JUMP, &end) < 0) return -1;
         c->code[skip].arg = c->code_count;
       }
-      /* Patch all end jumps to here. */
-      {
-        int j;
-        for (j = 0; j < n_patches; j++) {
-          c->code[end_patches[j]].arg = c->code_count;
-        }
+      if (!has_else) {
+        chunk_emit(c, OP_NIL, 0);
       }
+      patch_chain(c, end);
       return 0;
     }
 
-  case AST_LAMBDA:
-    /* Compile lambda body to a sub-chunk, emit OP_CLOSURE. */
+  case AST_CALLCC:
+    /* (call/cc f) */
     {
-      lizard_bc_chunk_t *sub;
-      lz_list_node_t *iter;
-      int param_count, i, idx;
-      lizard_ast_node_t *chunk_holder;
-
-      sub = chunk_create(heap);
-      if (sub == NULL) return -1;
-
-      /* Count and record parameter names. */
-      param_count = list_len(expr->data.lambda.parameters);
-      /* The last element of the parameter list is the body. */
-      if (param_count > 0) param_count--;
-      sub->arity = param_count;
-      if (param_count > 0) {
-        sub->param_names = (const char **)malloc(
-            (size_t)param_count * sizeof(const char *));
-        i = 0;
-        for (iter = expr->data.lambda.parameters->head;
-             iter != expr->data.lambda.parameters->nil && i < param_count;
-             iter = iter->next) {
-          lizard_ast_node_t *p = ((lizard_ast_list_node_t *)iter)->ast;
-          if (p->type == AST_SYMBOL) {
-            sub->param_names[i] = p->data.variable;
-          } else {
-            sub->param_names[i] = "?";
-          }
-          i++;
-        }
+      lz_list_t *args = expr->data.application_arguments;
+      if (args == NULL || args->head == args->nil ||
+          args->head->next == args->nil ||
+          args->head->next->next != args->nil) {
+        return -1;
       }
-
-      /* The body is the last element of the parameter list. */
-      {
-        lz_list_node_t *last = NULL;
-        for (iter = expr->data.lambda.parameters->head;
-             iter != expr->data.lambda.parameters->nil;
-             iter = iter->next) {
-          last = iter;
-        }
-        if (last != NULL) {
-          if (compile_expr(sub, ((lizard_ast_list_node_t *)last)->ast,
-                           heap, 1) < 0) {
-            return -1;
-          }
-        } else {
-          chunk_emit(sub, OP_NIL, 0);
-        }
+      if (compile_expr(s, c, ((lizard_ast_list_node_t *)args->head->next)->ast,
+                       heap, 0) < 0) {
+        return -1;
       }
-      chunk_emit(sub, OP_RETURN, 0);
-
-      /* Store the sub-chunk as a constant. We wrap it in an AST node
-       * for storage (using a string with a magic prefix). */
-      chunk_holder = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-      chunk_holder->type = AST_STRING;  /* store chunk pointer via memcpy (C89 safe) */
-      memcpy(&chunk_holder->data.string, &sub, sizeof(sub));
-      idx = chunk_add_const(c, chunk_holder);
-      if (idx < 0) return -1;
-      chunk_emit(c, OP_CLOSURE, idx);
+      chunk_emit(c, OP_CALLCC, 0);
       return 0;
     }
 
+  case AST_LAMBDA:
+    return compile_lambda(s, c, expr, heap);
+
   case AST_APPLICATION:
     /* (f arg1 arg2 ...) — general function call. */
     {
@@ -337,11 +1097,51 @@ static int compile_expr(lizard_bc_chunk_t *c, lizard_ast_node_t *expr,
       /* Check for known built-in operators. */
       {
         lizard_ast_node_t *fn_expr = ((lizard_ast_list_node_t *)iter)->ast;
-        if (fn_expr->type == AST_SYMBOL) {
+        if (fn_expr->type == AST_SYMBOL && is_global(s, fn_expr->data.variable)) {
           const char *name = fn_expr->data.variable;
-          lz_list_node_t *a1, *a2;
+          lz_list_node_t *nil = expr->data.application_arguments->nil;
+          lz_list_node_t *a1, *a2, *it;
+          lizard_opcode_t access;
+          int n = 0;
           a1 = iter->next;
 
+          /* and/or: each operand but the last leaves its value and jumps
+           * to the end when it decides the result. */
+          if (strcmp(name, "and") == 0 || strcmp(name, "or") == 0) {
+            int is_and = name[0] == 'a';
+            int end = -1;
+            if (a1 == nil) {
+              chunk_emit(c, is_and ? OP_TRUE : OP_FALSE, 0);
+              return 0;
+            }
+            for (it = a1; it != nil; it = it->next) {
+              int is_last = (it->next == nil);
+              if (compile_expr(s, c, ((lizard_ast_list_node_t *)it)->ast, heap,
+                               is_last && tail_position) < 0) {
+                return -1;
+              }
+              if (!is_last &&
+                  emit_chained(c, is_and ? OP_JUMP_IF_FALSE_OR_POP
+                                         : OP_JUMP_IF_TRUE_OR_POP,
+                               &end) < 0) {
+                return -1;
+              }
+            }
+            patch_chain(c, end);
+            return 0;
+          }
+
+          /* Vector and string accessors. */
+          for (it = a1; it != nil; it = it->next) n++;
+          access = accessor_op(name, n);
+          if (access != OP_HALT) {
+            for (it = a1; it != nil; it = it->next) {
+              if (compile_expr(s, c, ((lizard_ast_list_node_t *)it)->ast, heap, 0) < 0) return -1;
+            }
+            chunk_emit(c, access, n);
+            return 0;
+          }
+
           /* Binary arithmetic/comparison. */
           if (a1 != expr->data.application_arguments->nil) {
             a2 = a1->next;
@@ -353,14 +1153,31 @@ static int compile_expr(lizard_bc_chunk_t *c, lizard_ast_node_t *expr,
               else if (strcmp(name, "-") == 0) binop = OP_SUB;
               else if (strcmp(name, "*") == 0) binop = OP_MUL;
               else if (strcmp(name, "/") == 0) binop = OP_DIV;
-              else if (strcmp(name, "modulo") == 0) binop = OP_MOD;
+              else if (strcmp(name, "%") == 0) binop = OP_MOD;
               else if (strcmp(name, "=") == 0) binop = OP_EQ;
               else if (strcmp(name, "<") == 0) binop = OP_LT;
               else if (strcmp(name, ">") == 0) binop = OP_GT;
               else if (strcmp(name, "cons") == 0) binop = OP_CONS;
+              if (binop == OP_ADD || binop == OP_SUB) {
+                /* (+ x k), (+ k x), (- x k) with k a small literal. */
+                lizard_ast_node_t *x = NULL;
+                int k = 0;
+                if (small_int_literal(((lizard_ast_list_node_t *)a2)->ast, &k)) {
+                  x = ((lizard_ast_list_node_t *)a1)->ast;
+                  if (binop == OP_SUB) k = -k;
+                } else if (binop == OP_ADD &&
+                           small_int_literal(((lizard_ast_list_node_t *)a1)->ast, &k)) {
+                  x = ((lizard_ast_list_node_t *)a2)->ast;
+                }
+                if (x != NULL) {
+                  if (compile_expr(s, c, x, heap, 0) < 0) return -1;
+                  chunk_emit(c, OP_ADD_IMM, k);
+                  return 0;
+                }
+              }
               if (binop != OP_HALT) {
-                if (compile_expr(c, ((lizard_ast_list_node_t *)a1)->ast, heap, 0) < 0) return -1;
-                if (compile_expr(c, ((lizard_ast_list_node_t *)a2)->ast, heap, 0) < 0) return -1;
+                if (compile_expr(s, c, ((lizard_ast_list_node_t *)a1)->ast, heap, 0) < 0) return -1;
+                if (compile_expr(s, c, ((lizard_ast_list_node_t *)a2)->ast, heap, 0) < 0) return -1;
                 chunk_emit(c, binop, 0);
                 return 0;
               }
@@ -373,7 +1190,7 @@ static int compile_expr(lizard_bc_chunk_t *c, lizard_ast_node_t *expr,
               else if (strcmp(name, "cdr") == 0) unop = OP_CDR;
               else if (strcmp(name, "display") == 0) unop = OP_DISPLAY;
               if (unop != OP_HALT) {
-                if (compile_expr(c, ((lizard_ast_list_node_t *)a1)->ast, heap, 0) < 0) return -1;
+                if (compile_expr(s, c, ((lizard_ast_list_node_t *)a1)->ast, heap, 0) < 0) return -1;
                 chunk_emit(c, unop, 0);
                 return 0;
               }
@@ -389,12 +1206,32 @@ static int compile_expr(lizard_bc_chunk_t *c, lizard_ast_node_t *expr,
         }
       }
 
+      /* A call of a global: args, then CALL_PRIM with the name, which runs
+       * a primitive without pushing it, then the call a plain call ends in
+       * for when the name is bound to anything else. */
+      {
+        lizard_ast_node_t *fn_expr = ((lizard_ast_list_node_t *)iter)->ast;
+        if (fn_expr->type == AST_SYMBOL && is_global(s, fn_expr->data.variable)) {
+          int idx = chunk_add_name(c, fn_expr->data.variable, heap);
+          if (idx < 0) return -1;
+          for (iter = iter->next;
+               iter != expr->data.application_arguments->nil;
+               iter = iter->next) {
+            if (compile_expr(s, c, ((lizard_ast_list_node_t *)iter)->ast, heap, 0) < 0) return -1;
+            argc++;
+          }
+          chunk_emit(c, OP_CALL_PRIM, idx);
+          chunk_emit(c, tail_position ? OP_TAIL_CALL : OP_CALL, argc);
+          return 0;
+        }
+      }
+
       /* General call: compile function, then args, then OP_CALL. */
-      if (compile_expr(c, ((lizard_ast_list_node_t *)iter)->ast, heap, 0) < 0) return -1;
+      if (compile_expr(s, c, ((lizard_ast_list_node_t *)iter)->ast, heap, 0) < 0) return -1;
       for (iter = iter->next;
            iter != expr->data.application_arguments->nil;
            iter = iter->next) {
-        if (compile_expr(c, ((lizard_ast_list_node_t *)iter)->ast, heap, 0) < 0) return -1;
+        if (compile_expr(s, c, ((lizard_ast_list_node_t *)iter)->ast, heap, 0) < 0) return -1;
         argc++;
       }
       chunk_emit(c, tail_position ? OP_TAIL_CALL : OP_CALL, argc);
@@ -402,14 +1239,8 @@ static int compile_expr(lizard_bc_chunk_t *c, lizard_ast_node_t *expr,
     }
 
   default:
-    /* Unsupported form: store it as a constant and push it.
-     * The VM will return it as-is (no evaluation). */
-    {
-      int idx = chunk_add_const(c, expr);
-      if (idx < 0) return -1;
-      chunk_emit(c, OP_CONST, idx);
-      return 0;
-    }
+    /* Quasiquote, macro and type-theory nodes: left to the evaluator. */
+    return -1;
   }
 }
 
@@ -419,42 +1250,90 @@ lizard_bc_chunk_t *lizard_compile(lizard_ast_node_t *expr,
                                    lizard_heap_t *heap) {
   lizard_bc_chunk_t *c = chunk_create(heap);
   if (c == NULL) return NULL;
-  if (compile_expr(c, expr, heap, 0) < 0) {
-    free(c);
+  c->name = lizard_intern("<toplevel>");
+  c->span = expr->span;
+  if (compile_expr(NULL, c, expr, heap, 0) < 0 ||
+      chunk_emit(c, OP_HALT, 0) < 0 || c->oom) {
+    lizard_bc_chunk_free(c);
     return NULL;
   }
-  chunk_emit(c, OP_HALT, 0);
+  chunk_optimize(c);
   return c;
 }
 
 /* ---- VM execution ---- */
 
 /* Bytecode closure: a chunk + captured environment. */
+/* Bytecode closure: a chunk, the env its globals resolve in, and its
+ * upvalues.  Heap-allocated, so the collector traces what it holds. */
 typedef struct {
   lizard_bc_chunk_t *chunk;
   lizard_env_t *env;
+  lizard_ast_node_t **upvals;
 } bc_closure_t;
 
-/* Tag for identifying bytecode closures stored in AST_PRIMITIVE nodes. */
-#define BC_CLOSURE_TAG ((lizard_primitive_func_t)(void *)0xBC01)
-
+/* A bytecode closure is an AST_PROMISE node, forced, whose value is the
+ * node itself, so lizard_force hands it back unchanged; the closure
+ * pointer is kept in data.promise.expr via memcpy. */
 static lizard_ast_node_t *make_bc_closure(lizard_bc_chunk_t *chunk,
-                                           lizard_env_t *env,
+                                           lizard_vm_t *vm,
                                            lizard_heap_t *heap) {
   lizard_ast_node_t *node = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  bc_closure_t *cl = (bc_closure_t *)malloc(sizeof(bc_closure_t));
+  bc_closure_t *cl = (bc_closure_t *)lizard_heap_alloc(sizeof(bc_closure_t));
+  int i;
   cl->chunk = chunk;
-  cl->env = env;
+  cl->env = vm->env;
+  if (chunk->upval_count > 0) {
+    cl->upvals = (lizard_ast_node_t **)lizard_heap_alloc(
+        (size_t)chunk->upval_count * sizeof(lizard_ast_node_t *));
+    for (i = 0; i < chunk->upval_count; i++) {
+      cl->upvals[i] = chunk->upval_is_local[i]
+                          ? vm->stack[vm->base + chunk->upval_index[i]]
+                          : vm->upvals[chunk->upval_index[i]];
+    }
+  }
   node->type = AST_PROMISE;
-  node->data.promise.forced = 1;  /* tag: this is a BC closure, not a real promise */
-  memcpy(&node->data.promise.value, &cl, sizeof(cl));
+  node->data.promise.forced = 1;
+  node->data.promise.value = node;
+  node->data.promise.env = NULL;
+  memcpy(&node->data.promise.expr, &cl, sizeof(cl));
   return node;
 }
 
-/* BC closures are stored as AST_PROMISE nodes with forced=1 as a tag.
- * The closure pointer is stored in data.promise.value via memcpy. */
-static int is_bc_closure(lizard_ast_node_t *node) {
-  return node != NULL && node->type == AST_PROMISE && node->data.promise.forced;
+/* lizard_ast_deep_copy copies the data of a promise as is, so a copy of
+ * a closure is a forced promise whose value is the original. */
+static int is_bc_closure(const lizard_ast_node_t *node) {
+  const lizard_ast_node_t *value;
+  if (node == NULL || node->type != AST_PROMISE || !node->data.promise.forced) {
+    return 0;
+  }
+  value = node->data.promise.value;
+  return value != NULL && value->type == AST_PROMISE &&
+         value->data.promise.forced && value->data.promise.value == value;
+}
+
+static bc_closure_t *bc_closure_of(const lizard_ast_node_t *node) {
+  bc_closure_t *cl;
+  memcpy(&cl, &node->data.promise.value->data.promise.expr, sizeof(cl));
+  return cl;
+}
+
+int lizard_vm_is_closure(const lizard_ast_node_t *node) {
+  return is_bc_closure(node);
+}
+
+void lizard_vm_unwind(lizard_heap_t *heap, lizard_vm_t *to) {
+  lizard_vm_t *vm;
+  if (heap->runtime == NULL) return;
+  for (vm = heap->runtime->vm_top; vm != NULL && vm != to; vm = vm->prev) {
+    free(vm->stack);
+    free(vm->frames);
+    free(vm->escapes);
+    vm->stack = NULL;
+    vm->frames = NULL;
+    vm->escapes = NULL;
+  }
+  heap->runtime->vm_top = to;
 }
 
 /* Internal VM runner — shared by exec and exec_profiled. */
@@ -476,266 +1355,280 @@ lizard_ast_node_t *lizard_vm_exec_profiled(lizard_bc_chunk_t *chunk,
   return vm_run(chunk, env, heap, profile);
 }
 
+lizard_ast_node_t *lizard_vm_apply(lizard_ast_node_t *fn, lz_list_t *args,
+                                    lizard_heap_t *heap) {
+  /* A throwaway chunk that pushes the closure and the arguments and calls
+   * it: CONST 0, CONST 1 .. CONST n, CALL n, HALT. */
+  lizard_bc_chunk_t *c = chunk_create(heap);
+  lizard_ast_node_t *result;
+  lz_list_node_t *it;
+  int argc = 0;
+  if (c == NULL) return lizard_make_error(heap, LIZARD_ERROR_USER);
+  c->name = lizard_intern("<primitive>");
+  chunk_emit(c, OP_CONST, chunk_push_const(c, fn, 0));
+  for (it = args->head; it != args->nil; it = it->next) {
+    lizard_ast_node_t *arg =
+        lizard_force(((lizard_ast_list_node_t *)it)->ast, heap);
+    chunk_emit(c, OP_CONST, chunk_push_const(c, arg, 0));
+    argc++;
+  }
+  chunk_emit(c, OP_CALL, argc);
+  chunk_emit(c, OP_HALT, 0);
+  result = c->oom ? lizard_make_error(heap, LIZARD_ERROR_USER)
+                  : vm_run(c, bc_closure_of(fn)->env, heap, NULL);
+  lizard_bc_chunk_free(c);
+  return result;
+}
+
+/* Double the value stack; 0 when out of memory. */
+static int vm_grow_stack(lizard_vm_t *vm) {
+  int cap = vm->stack_cap * 2;
+  lizard_ast_node_t **grown = (lizard_ast_node_t **)realloc(
+      vm->stack, (size_t)cap * sizeof(lizard_ast_node_t *));
+  if (grown == NULL) return 0;
+  vm->stack = grown;
+  vm->stack_cap = cap;
+  return 1;
+}
+
+/* Suspend the running frame so a callee can run; 0 when out of memory. */
+static int vm_push_frame(lizard_vm_t *vm) {
+  lizard_vm_frame_t *f;
+  if (vm->frame_count == vm->frame_cap) {
+    int cap = vm->frame_cap * 2;
+    lizard_vm_frame_t *grown = (lizard_vm_frame_t *)realloc(
+        vm->frames, (size_t)cap * sizeof(lizard_vm_frame_t));
+    if (grown == NULL) return 0;
+    vm->frames = grown;
+    vm->frame_cap = cap;
+  }
+  f = &vm->frames[vm->frame_count++];
+  f->chunk = vm->chunk;
+  f->ip = vm->ip;
+  f->base = vm->base;
+  f->env = vm->env;
+  f->upvals = vm->upvals;
+  return 1;
+}
+
+/* Value of the running frame: its top of stack, or nil. */
+static lizard_ast_node_t *vm_frame_result(lizard_vm_t *vm) {
+  if (vm->sp > vm->base) return vm->stack[vm->sp - 1];
+  return lizard_make_nil(vm->heap);
+}
+
+/* `a` op `b` by the primitive the opcode stands for, over the whole
+ * numeric tower. */
+static lizard_ast_node_t *vm_arith(lizard_opcode_t op, lizard_ast_node_t *a,
+                                   lizard_ast_node_t *b, lizard_env_t *env,
+                                   lizard_heap_t *heap) {
+  lizard_ast_node_t *argv[2];
+  argv[0] = a;
+  argv[1] = b;
+  switch (op) {
+  case OP_ADD: return lizard_primitive_plus_argv(2, argv, env, heap);
+  case OP_SUB: return lizard_primitive_minus_argv(2, argv, env, heap);
+  case OP_MUL: return lizard_primitive_multiply_argv(2, argv, env, heap);
+  case OP_DIV: return lizard_primitive_divide_argv(2, argv, env, heap);
+  case OP_MOD: return lizard_primitive_mod_argv(2, argv, env, heap);
+  case OP_EQ: case OP_JUMP_UNLESS_EQ:
+    return lizard_primitive_equal_argv(2, argv, env, heap);
+  case OP_LT: case OP_JUMP_UNLESS_LT:
+    return lizard_primitive_lt_argv(2, argv, env, heap);
+  default:
+    return lizard_primitive_gt_argv(2, argv, env, heap);
+  }
+}
+
+/* Whether `a` op `b` holds for a comparison opcode: 1 or 0, or -1 with
+ * the primitive's error in *err when it rejects the operands. */
+static int vm_compare(lizard_opcode_t op, lizard_ast_node_t *a,
+                      lizard_ast_node_t *b, lizard_env_t *env,
+                      lizard_heap_t *heap, lizard_ast_node_t **err) {
+  lizard_ast_node_t *r;
+  if (LIZARD_IS_FIXNUM(a) && LIZARD_IS_FIXNUM(b)) {
+    long x = LIZARD_FIXNUM_VALUE(a), y = LIZARD_FIXNUM_VALUE(b);
+    switch (op) {
+    case OP_EQ: case OP_JUMP_UNLESS_EQ: return x == y;
+    case OP_LT: case OP_JUMP_UNLESS_LT: return x < y;
+    default: return x > y;
+    }
+  }
+  r = vm_arith(op, a, b, env, heap);
+  if (r->type == AST_ERROR) {
+    *err = r;
+    return -1;
+  }
+  return !(r->type == AST_BOOL && !r->data.boolean);
+}
+
+/* The vector or string accessor `op` on the `argc` operands at argv. */
+static lizard_ast_node_t *vm_access(lizard_opcode_t op, int argc,
+                                    lizard_ast_node_t **argv,
+                                    lizard_env_t *env, lizard_heap_t *heap) {
+  switch (op) {
+  case OP_VECTOR_REF: return lizard_primitive_vec_ref_argv(argc, argv, env, heap);
+  case OP_VECTOR_SET: return lizard_primitive_vec_set_argv(argc, argv, env, heap);
+  case OP_VECTOR_LENGTH:
+    return lizard_primitive_vec_length_argv(argc, argv, env, heap);
+  case OP_STRING_REF:
+    return lizard_primitive_string_ref_argv(argc, argv, env, heap);
+  default:
+    return lizard_primitive_str_length_argv(argc, argv, env, heap);
+  }
+}
+
+/* Record the call/cc about to call the receiver on top of the stack with
+ * continuation `id`; 0 when out of memory. */
+static int vm_push_escape(lizard_vm_t *vm, unsigned long id) {
+  lizard_vm_escape_t *e;
+  if (vm->escape_count == vm->escape_cap) {
+    int cap = vm->escape_cap ? vm->escape_cap * 2 : 8;
+    lizard_vm_escape_t *grown = (lizard_vm_escape_t *)realloc(
+        vm->escapes, (size_t)cap * sizeof(lizard_vm_escape_t));
+    if (grown == NULL) return 0;
+    vm->escapes = grown;
+    vm->escape_cap = cap;
+  }
+  e = &vm->escapes[vm->escape_count++];
+  e->id = id;
+  e->frame_count = vm->frame_count;
+  e->sp = vm->sp - 1;  /* the receiver's slot, where its value goes */
+  e->chunk = vm->chunk;
+  e->ip = vm->ip;
+  e->base = vm->base;
+  e->env = vm->env;
+  e->upvals = vm->upvals;
+  return 1;
+}
+
+/* Return `value` from the call/cc continuation `k` was made by, unwinding
+ * the frames above it; 0 when that call/cc is not live in this VM. */
+static int vm_escape(lizard_vm_t *vm, lizard_ast_node_t *k,
+                     lizard_ast_node_t *value) {
+  int i;
+  for (i = vm->escape_count - 1; i >= 0; i--) {
+    lizard_vm_escape_t *e = &vm->escapes[i];
+    if (e->id != k->data.continuation.escape_id) continue;
+    vm->frame_count = e->frame_count;
+    vm->chunk = e->chunk;
+    vm->ip = e->ip;
+    vm->base = e->base;
+    vm->env = e->env;
+    vm->upvals = e->upvals;
+    vm->sp = e->sp;
+    vm->stack[vm->sp++] = value;
+    vm->escape_count = i;
+    return 1;
+  }
+  return 0;
+}
+
+/* The previous instruction the profiled loop counted. */
+typedef struct {
+  lizard_bc_chunk_t *chunk;
+  int ip;
+  int op;
+} vm_pair_t;
+
+/* Count `instr`, about to run at vm->ip - 1, into vm->profile, and trace
+ * it when asked to. */
+static void vm_profile_step(lizard_vm_t *vm, lizard_instruction_t instr,
+                            vm_pair_t *last) {
+  lizard_vm_profile_t *profile = vm->profile;
+  lizard_opcode_t call;
+  lizard_vm_profile_track(vm);
+  profile->total_instructions++;
+  if ((int)instr.op < LIZARD_OPCODE_COUNT) {
+    profile->opcode_counts[(int)instr.op]++;
+    if (vm->chunk == last->chunk && vm->ip - 1 == last->ip + 1) {
+      profile->pair_counts[last->op][(int)instr.op]++;
+    }
+    last->chunk = vm->chunk;
+    last->ip = vm->ip - 1;
+    last->op = (int)instr.op;
+  }
+  /* CALL_PRIM makes the call it skips. */
+  call = instr.op == OP_CALL_PRIM ? vm->chunk->code[vm->ip].op : instr.op;
+  if (call == OP_CALL || call == OP_CALLCC) profile->total_calls++;
+  if (call == OP_TAIL_CALL) {
+    profile->total_calls++;
+    profile->tail_calls++;
+  }
+  /* Trace: print each instruction + stack. */
+  if (profile->trace) {
+    int si;
+    printf("  [%04d] %-8s %d  | stack(%d):",
+           vm->ip - 1,
+           lizard_bc_opcode_name(instr.op),
+           instr.arg, vm->sp);
+    for (si = 0; si < vm->sp && si < 6; si++) {
+      printf(" ");
+      lizard_fprint_value(stdout, vm->stack[si]);
+    }
+    if (vm->sp > 6) printf(" ...");
+    printf("\n");
+  }
+}
+
+/* The dispatch loops, vm_loop for plain runs and vm_loop_profiled. */
+#define VM_LOOP vm_loop
+#define VM_PROFILED 0
+#include "bytecode_loop.h"
+#undef VM_LOOP
+#undef VM_PROFILED
+
+#define VM_LOOP vm_loop_profiled
+#define VM_PROFILED 1
+#include "bytecode_loop.h"
+#undef VM_LOOP
+#undef VM_PROFILED
+
 static lizard_ast_node_t *vm_run(lizard_bc_chunk_t *chunk,
                                   lizard_env_t *env,
                                   lizard_heap_t *heap,
                                   lizard_vm_profile_t *profile) {
   lizard_vm_t vm;
+  lizard_ast_node_t *result;
+  vm.stack = (lizard_ast_node_t **)malloc(LIZARD_VM_STACK_SIZE *
+                                          sizeof(lizard_ast_node_t *));
+  vm.frames = (lizard_vm_frame_t *)malloc(LIZARD_VM_FRAMES_SIZE *
+                                          sizeof(lizard_vm_frame_t));
+  if (vm.stack == NULL || vm.frames == NULL) {
+    free(vm.stack);
+    free(vm.frames);
+    return lizard_make_error(heap, LIZARD_ERROR_USER);
+  }
+  vm.sp = 0;
+  vm.stack_cap = LIZARD_VM_STACK_SIZE;
+  vm.base = 0;
+  vm.frame_count = 0;
+  vm.frame_cap = LIZARD_VM_FRAMES_SIZE;
+  vm.escapes = NULL;
+  vm.escape_count = 0;
+  vm.escape_cap = 0;
   vm.chunk = chunk;
   vm.ip = 0;
-  vm.sp = 0;
   vm.env = env;
+  vm.upvals = NULL;
   vm.heap = heap;
   vm.profile = profile;
-
-  for (;;) {
-    lizard_instruction_t instr;
-    if (vm.ip >= vm.chunk->code_count) break;
-    instr = vm.chunk->code[vm.ip++];
-
-    /* Profiling: count each instruction. */
-    if (profile != NULL) {
-      profile->total_instructions++;
-      if ((int)instr.op < LIZARD_OPCODE_COUNT) {
-        profile->opcode_counts[(int)instr.op]++;
-      }
-      if (instr.op == OP_CALL) profile->total_calls++;
-      if (instr.op == OP_TAIL_CALL) {
-        profile->total_calls++;
-        profile->tail_calls++;
-      }
-      /* Trace: print each instruction + stack. */
-      if (profile->trace) {
-        int si;
-        printf("  [%04d] %-8s %d  | stack(%d):",
-               vm.ip - 1,
-               lizard_bc_opcode_name(instr.op),
-               instr.arg, vm.sp);
-        for (si = 0; si < vm.sp && si < 6; si++) {
-          printf(" ");
-          lizard_fprint_value(stdout, vm.stack[si]);
-        }
-        if (vm.sp > 6) printf(" ...");
-        printf("\n");
-      }
-    }
-
-    switch (instr.op) {
-    case OP_CONST:
-      vm.stack[vm.sp++] = vm.chunk->constants[instr.arg];
-      break;
-    case OP_NIL:
-      vm.stack[vm.sp++] = lizard_make_nil(heap);
-      break;
-    case OP_TRUE:
-      vm.stack[vm.sp++] = lizard_make_bool(heap, 1);
-      break;
-    case OP_FALSE:
-      vm.stack[vm.sp++] = lizard_make_bool(heap, 0);
-      break;
-    case OP_LOAD: {
-      const char *name = vm.chunk->constants[instr.arg]->data.string;
-      lizard_ast_node_t *val = lizard_env_lookup(vm.env, name);
-      if (val == NULL) {
-        vm.stack[vm.sp++] = lizard_make_error(heap, LIZARD_ERROR_UNBOUND_SYMBOL);
-        return vm.stack[vm.sp - 1];
-      }
-      vm.stack[vm.sp++] = val;
-      break;
-    }
-    case OP_STORE: {
-      const char *name = vm.chunk->constants[instr.arg]->data.string;
-      lizard_ast_node_t *val = vm.stack[--vm.sp];
-      lizard_env_define(heap, vm.env, name, val);
-      vm.stack[vm.sp++] = val;
-      break;
-    }
-    case OP_SET: {
-      const char *name = vm.chunk->constants[instr.arg]->data.string;
-      lizard_ast_node_t *val = vm.stack[--vm.sp];
-      lizard_env_set(vm.env, name, val);
-      vm.stack[vm.sp++] = val;
-      break;
-    }
-    case OP_POP:
-      if (vm.sp > 0) vm.sp--;
-      break;
-    case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD: {
-      lizard_ast_node_t *b = vm.stack[--vm.sp];
-      lizard_ast_node_t *a = vm.stack[--vm.sp];
-      lizard_ast_node_t *r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-      r->type = AST_NUMBER;
-      mpz_init(r->data.number);
-      if (a->type == AST_NUMBER && b->type == AST_NUMBER) {
-        switch (instr.op) {
-        case OP_ADD: mpz_add(r->data.number, a->data.number, b->data.number); break;
-        case OP_SUB: mpz_sub(r->data.number, a->data.number, b->data.number); break;
-        case OP_MUL: mpz_mul(r->data.number, a->data.number, b->data.number); break;
-        case OP_DIV:
-          if (mpz_sgn(b->data.number) == 0) {
-            return lizard_make_error(heap, LIZARD_ERROR_DIV_ZERO);
-          }
-          mpz_tdiv_q(r->data.number, a->data.number, b->data.number);
-          break;
-        case OP_MOD:
-          if (mpz_sgn(b->data.number) == 0) {
-            return lizard_make_error(heap, LIZARD_ERROR_DIV_ZERO);
-          }
-          mpz_mod(r->data.number, a->data.number, b->data.number);
-          break;
-        default: break;
-        }
-      }
-      vm.stack[vm.sp++] = r;
-      break;
-    }
-    case OP_EQ: {
-      lizard_ast_node_t *b = vm.stack[--vm.sp];
-      lizard_ast_node_t *a = vm.stack[--vm.sp];
-      int eq = 0;
-      if (a->type == AST_NUMBER && b->type == AST_NUMBER) {
-        eq = (mpz_cmp(a->data.number, b->data.number) == 0);
-      } else if (a->type == AST_BOOL && b->type == AST_BOOL) {
-        eq = (a->data.boolean == b->data.boolean);
-      } else if (a->type == AST_NIL && b->type == AST_NIL) {
-        eq = 1;
-      }
-      vm.stack[vm.sp++] = lizard_make_bool(heap, eq);
-      break;
-    }
-    case OP_LT: case OP_GT: {
-      lizard_ast_node_t *b = vm.stack[--vm.sp];
-      lizard_ast_node_t *a = vm.stack[--vm.sp];
-      int cmp = 0;
-      if (a->type == AST_NUMBER && b->type == AST_NUMBER) {
-        cmp = mpz_cmp(a->data.number, b->data.number);
-      }
-      vm.stack[vm.sp++] = lizard_make_bool(heap,
-          instr.op == OP_LT ? cmp < 0 : cmp > 0);
-      break;
-    }
-    case OP_NOT: {
-      lizard_ast_node_t *a = vm.stack[--vm.sp];
-      int falsy = (a->type == AST_BOOL && !a->data.boolean) ||
-                  a->type == AST_NIL;
-      vm.stack[vm.sp++] = lizard_make_bool(heap, falsy);
-      break;
-    }
-    case OP_CONS: {
-      lizard_ast_node_t *b = vm.stack[--vm.sp];
-      lizard_ast_node_t *a = vm.stack[--vm.sp];
-      lizard_ast_node_t *p = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-      p->type = AST_PAIR;
-      p->data.pair.car = a;
-      p->data.pair.cdr = b;
-      vm.stack[vm.sp++] = p;
-      break;
-    }
-    case OP_CAR: {
-      lizard_ast_node_t *a = vm.stack[--vm.sp];
-      if (a->type != AST_PAIR) {
-        return lizard_make_error(heap, LIZARD_ERROR_CAR_ARGT);
-      }
-      vm.stack[vm.sp++] = a->data.pair.car;
-      break;
-    }
-    case OP_CDR: {
-      lizard_ast_node_t *a = vm.stack[--vm.sp];
-      if (a->type != AST_PAIR) {
-        return lizard_make_error(heap, LIZARD_ERROR_CDR_ARGT);
-      }
-      vm.stack[vm.sp++] = a->data.pair.cdr;
-      break;
-    }
-    case OP_JUMP:
-      vm.ip = instr.arg;
-      break;
-    case OP_JUMP_IF_FALSE: {
-      lizard_ast_node_t *a = vm.stack[--vm.sp];
-      if ((a->type == AST_BOOL && !a->data.boolean) ||
-          a->type == AST_NIL) {
-        vm.ip = instr.arg;
-      }
-      break;
-    }
-    case OP_CLOSURE: {
-      /* Create a bytecode closure capturing the current env. */
-      lizard_bc_chunk_t *sub;
-      memcpy(&sub, &vm.chunk->constants[instr.arg]->data.string, sizeof(sub));
-      vm.stack[vm.sp++] = make_bc_closure(sub, vm.env, heap);
-      break;
-    }
-    case OP_CALL:
-    case OP_TAIL_CALL: {
-      int argc = instr.arg;
-      lizard_ast_node_t *fn;
-      lizard_ast_node_t *args_arr[64];
-      int i;
-      int is_tail = (instr.op == OP_TAIL_CALL);
-      /* Pop args (in reverse). */
-      for (i = argc - 1; i >= 0; i--) {
-        args_arr[i] = vm.stack[--vm.sp];
-      }
-      fn = vm.stack[--vm.sp];
-
-      if (is_bc_closure(fn)) {
-        /* Execute bytecode closure. */
-        bc_closure_t *cl;
-        lizard_env_t *call_env;
-        memcpy(&cl, &fn->data.promise.value, sizeof(cl));
-        call_env = lizard_env_create(heap, cl->env);
-        /* Bind parameters. */
-        for (i = 0; i < cl->chunk->arity && i < argc; i++) {
-          lizard_env_define(heap, call_env, cl->chunk->param_names[i],
-                            args_arr[i]);
-        }
-        if (is_tail) {
-          /* TCO: replace the current frame — no recursion, no stack
-           * growth. The VM loop restarts with the callee's chunk. */
-          vm.chunk = cl->chunk;
-          vm.env = call_env;
-          vm.ip = 0;
-          vm.sp = 0;
-          continue;  /* restart the dispatch loop */
-        }
-        /* Non-tail call: recurse (pushes a C stack frame). */
-        vm.stack[vm.sp++] = vm_run(cl->chunk, call_env, heap, profile);
-      } else if (fn->type == AST_PRIMITIVE) {
-        /* Call native primitive. Build an lz_list_t of args. */
-        lz_list_t *arg_list;
-        arg_list = list_create_alloc(lizard_heap_alloc,
-                                     lizard_heap_free);
-        for (i = 0; i < argc; i++) {
-          lizard_ast_list_node_t *n;
-          n = lizard_heap_alloc(sizeof(lizard_ast_list_node_t));
-          n->ast = args_arr[i];
-          list_append(arg_list, &n->node);
-        }
-        vm.stack[vm.sp++] = fn->data.primitive(arg_list, vm.env, heap);
-      } else {
-        /* Unsupported callable — error. */
-        return lizard_make_error(heap, LIZARD_ERROR_INVALID_APPLY);
-      }
-      break;
-    }
-    case OP_RETURN:
-      if (vm.sp > 0) return vm.stack[vm.sp - 1];
-      return lizard_make_nil(heap);
-    case OP_DISPLAY: {
-      lizard_ast_node_t *a = vm.stack[--vm.sp];
-      lizard_fprint_value(stdout, a);
-      vm.stack[vm.sp++] = a;
-      break;
-    }
-    case OP_NEWLINE:
-      printf("\n");
-      vm.stack[vm.sp++] = lizard_make_nil(heap);
-      break;
-    case OP_HALT:
-      if (vm.sp > 0) return vm.stack[vm.sp - 1];
-      return lizard_make_nil(heap);
-    }
-  }
-  if (vm.sp > 0) return vm.stack[vm.sp - 1];
-  return lizard_make_nil(heap);
+  vm.prev = NULL;
+  if (heap->runtime != NULL) {
+    vm.prev = heap->runtime->vm_top;
+    heap->runtime->vm_top = &vm;
+    /* A closure called back from a primitive of a profiled run is part
+     * of that run. */
+    if (vm.profile == NULL && vm.prev != NULL) vm.profile = vm.prev->profile;
+  }
+  vm.profile_depth = vm.profile != NULL ? vm.profile->depth : 0;
+  result = vm.profile != NULL ? vm_loop_profiled(&vm) : vm_loop(&vm);
+  if (vm.profile != NULL) lizard_vm_profile_leave(vm.profile, vm.profile_depth);
+  if (heap->runtime != NULL) {
+    heap->runtime->vm_top = vm.prev;
+  }
+  free(vm.stack);
+  free(vm.frames);
+  free(vm.escapes);
+  return result;
 }
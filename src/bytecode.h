@@ -4,14 +4,42 @@
  * then executes it on a stack machine. This avoids the overhead of
  * recursive tree-walking for hot paths.
  *
- * The instruction set is intentionally small. Complex forms (macros,
- * call/cc, type-theory nodes) fall back to the tree-walking evaluator.
+ * The compiler covers the core language left once macros are expanded:
+ * constants, quote, variables, define, set!, if, cond, begin, lambda
+ * (with rest parameters), application, and/or, and call/cc as an escape
+ * continuation.  For anything else (quasiquote, macro and type-theory
+ * nodes) lizard_compile fails, and vm-eval hands the form to the
+ * tree-walking evaluator instead.
+ *
+ * Variables are resolved when a lambda is compiled.  Its parameters and
+ * the names its body defines live in stack slots of the call frame; a
+ * variable of an enclosing lambda is an upvalue, copied into the closure
+ * when it is made; anything else is global, looked up by name through an
+ * inline cache.  A local that is both assigned (set! or define) and
+ * captured by a nested lambda is kept in a box, which the slot and every
+ * upvalue share.  Lambda bodies therefore do not allocate an environment
+ * per call, and by-name operations inside them (eval) see only globals.
+ *
+ * Arithmetic and comparison opcodes work directly on two fixnums and hand
+ * anything else (bignums, rationals, reals, overflow, inexact division,
+ * type errors) to the primitive the opcode stands for.  `(+ x k)` and
+ * `(- x k)` with a small literal k compile to OP_ADD_IMM, and an `if` whose
+ * test is a two-argument `=`, `<` or `>` to a compare-and-branch.  The
+ * vector and string accessors have opcodes of their own in the same way.
+ * A call of any other global is OP_CALL_PRIM, which runs a primitive on
+ * the stacked arguments without pushing it.
+ *
+ * Each finished chunk goes through a peephole pass that threads jumps,
+ * drops pushes that are popped straight away and fuses common adjacent
+ * pairs into superinstructions (see chunk_optimize in bytecode.c).
  */
 #ifndef LIZARD_BYTECODE_H
 #define LIZARD_BYTECODE_H
 
 #include "lizard_internal.h"
 #include "env.h"
+#include <stdio.h>
+#include <time.h>
 
 /* ---- opcodes ---- */
 
@@ -20,7 +48,7 @@ typedef enum {
   OP_NIL,            /* push nil */
   OP_TRUE,           /* push #t */
   OP_FALSE,          /* push #f */
-  OP_LOAD,           /* push env-lookup(constants[arg]) where arg indexes a symbol name */
+  OP_LOAD_GLOBAL,    /* push env-lookup(constants[arg]), a cached name node */
   OP_STORE,          /* pop value, define constants[arg] = value in env */
   OP_SET,            /* pop value, set! constants[arg] = value in env */
   OP_POP,            /* discard top of stack */
@@ -44,7 +72,39 @@ typedef enum {
   OP_CLOSURE,        /* create closure from chunk constants[arg] */
   OP_DISPLAY,        /* pop, display, push result */
   OP_NEWLINE,        /* print newline, push nil */
-  OP_HALT            /* stop VM */
+  OP_HALT,           /* stop VM */
+  OP_LOAD_LOCAL,     /* push frame slot arg */
+  OP_STORE_LOCAL,    /* frame slot arg = top of stack (left pushed) */
+  OP_LOAD_UPVAL,     /* push the closure's upvalue arg */
+  OP_BOX,            /* replace top of stack by a box holding it */
+  OP_UNBOX,          /* replace the box on top of stack by its value */
+  OP_SET_BOX,        /* pop box, store value below it into it (left pushed) */
+  OP_ADD_IMM,        /* replace top of stack x by (+ x arg) */
+  OP_JUMP_UNLESS_EQ, /* pop two, jump to arg unless (= a b) */
+  OP_JUMP_UNLESS_LT, /* pop two, jump to arg unless (< a b) */
+  OP_JUMP_UNLESS_GT, /* pop two, jump to arg unless (> a b) */
+  OP_JUMP_IF_FALSE_OR_POP, /* jump to arg if top is #f or nil, else pop */
+  OP_JUMP_IF_TRUE_OR_POP,  /* jump to arg unless top is #f or nil, else pop */
+  /* The accessors pop their arg operands and push the result. */
+  OP_VECTOR_REF,     /* (vector-ref v i) */
+  OP_VECTOR_SET,     /* (vector-set! v i x) */
+  OP_VECTOR_LENGTH,  /* (vector-length v) */
+  OP_STRING_REF,     /* (string-ref s i) */
+  OP_STRING_LENGTH,  /* (string-length s) */
+  OP_CALLCC,         /* call top of stack with an escape continuation */
+  /* Superinstructions, made by the peephole pass only.  The last two take
+   * their second operand from the instruction after them and skip it. */
+  OP_JUMP_IF_TRUE,      /* pop, jump to arg unless #f or nil */
+  OP_RETURN_LOCAL,      /* return frame slot arg */
+  OP_LOAD_UPVAL_UNBOX,  /* push the value in the box upvalue arg */
+  OP_STORE_LOCAL_POP,   /* pop into frame slot arg */
+  OP_LOAD_LOCAL2,       /* push frame slots arg and next.arg */
+  OP_LOAD_LOCAL_ADD_IMM, /* push (+ slot arg, next.arg) */
+  /* Call of the global constants[arg] with the arguments on the stack; the
+   * CALL or TAIL_CALL after it, which it skips, has the count.  A
+   * primitive runs on the stacked arguments; anything else is pushed below
+   * them and that instruction makes the call. */
+  OP_CALL_PRIM
 } lizard_opcode_t;
 
 /* ---- bytecode instruction ---- */
@@ -56,40 +116,161 @@ typedef struct {
 
 /* ---- bytecode chunk ---- */
 
-#define LIZARD_BC_MAX_CODE      4096
-#define LIZARD_BC_MAX_CONSTANTS 256
+/* Code and constants are malloc'd and grow by doubling from these sizes.
+ * A constant is added once per chunk: the same node, or the same variable
+ * name for OP_LOAD/OP_STORE/OP_SET, reuses its slot. */
+#define LIZARD_BC_INITIAL_CODE      16
+#define LIZARD_BC_INITIAL_CONSTANTS 8
 
 typedef struct lizard_bc_chunk {
-  lizard_instruction_t code[LIZARD_BC_MAX_CODE];
+  lizard_instruction_t *code;
   int code_count;
-  lizard_ast_node_t *constants[LIZARD_BC_MAX_CONSTANTS];
+  int code_cap;
+  lizard_ast_node_t **constants;
+  unsigned char *const_is_name; /* per constant: a variable-name node */
   int const_count;
+  int const_cap;
+  int oom;           /* an emit or constant failed to allocate */
   int arity;         /* for lambda chunks: number of parameters */
-  const char **param_names;  /* parameter names (arity-length array) */
+  int rest;          /* ...and a rest parameter in slot arity, holding the
+                        list of arguments past the first arity */
+  int nlocals;       /* frame slots: the parameters, then body defines */
+  /* Upvalue i of a closure is copied from the creating frame's slot
+   * upval_index[i] when upval_is_local[i], else from its upvalue. */
+  int upval_count;
+  unsigned char *upval_is_local;
+  int *upval_index;
+  /* For the profiler: the variable a lambda chunk was defined as (NULL if
+   * anonymous, "<toplevel>" for a compiled form) and the span of its
+   * source.  The name is interned. */
+  const char *name;
+  lizard_source_span_t span;
+  /* Tracked chunks are chained from their runtime, newest first, so the
+   * collector scans their constants: nothing on the heap points there. */
+  lizard_heap_t *heap;
+  struct lizard_bc_chunk *newer;
+  struct lizard_bc_chunk *older;
 } lizard_bc_chunk_t;
 
 /* ---- VM state ---- */
 
-#define LIZARD_VM_STACK_SIZE 1024
-#define LIZARD_OPCODE_COUNT 30
+#define LIZARD_VM_STACK_SIZE 1024  /* initial value-stack slots; grows */
+#define LIZARD_VM_FRAMES_SIZE 64   /* initial call frames; grows */
+#define LIZARD_OPCODE_COUNT 54
+
+/* What a profiled run spent in one chunk.  Self counts its own
+ * instructions and the time until it called or returned; inclusive adds
+ * its callees', counted once however deep the chunk recurses.  Times are
+ * clock() time, as elapsed_seconds is. */
+typedef struct {
+  /* The chunk, or for one with no source span its name: the trampolines
+   * of lizard_vm_apply, say, are one function however many there are. */
+  const void *key;
+  const char *name;          /* the chunk's, which may be gone by the report */
+  lizard_source_span_t span;
+  size_t calls;
+  size_t self_instructions;
+  size_t inclusive_instructions;
+  double self_seconds;
+  double inclusive_seconds;
+  int active;                /* activations on the stack now */
+  size_t entered_at;         /* total_instructions when the outermost one began */
+  clock_t entered_clock;
+} lizard_vm_fn_profile_t;
+
+/* A call stack the profiled run has been in, as a path from the outermost
+ * chunk, for the collapsed-stack output; direct recursion folds into one
+ * node. */
+typedef struct {
+  int fn;                    /* index into fns */
+  int parent;                /* -1 for the outermost */
+  int first_child;
+  int next_sibling;
+  size_t self_instructions;
+} lizard_vm_stack_node_t;
+
+/* A frame as the profiler sees it. */
+typedef struct {
+  int fn;
+  int node;
+} lizard_vm_activation_t;
 
 typedef struct {
   size_t total_instructions;
   size_t opcode_counts[LIZARD_OPCODE_COUNT];
+  /* pair_counts[a][b]: b ran straight after a, at the next address of the
+   * same chunk — the candidates for a superinstruction. */
+  size_t pair_counts[LIZARD_OPCODE_COUNT][LIZARD_OPCODE_COUNT];
   size_t total_calls;
   size_t tail_calls;
   double elapsed_seconds;
   int trace;  /* if nonzero, print each instruction + stack */
+  /* Per-chunk totals, the stacks they ran on and a shadow of the VM's
+   * frames, kept by bytecode_profile.c.  Zeroed with the rest; released
+   * by lizard_vm_profile_free. */
+  lizard_vm_fn_profile_t *fns;
+  int fn_count;
+  int fn_cap;
+  int *fn_slots;             /* open hash of chunk to fns index, -1 empty */
+  int fn_slot_cap;
+  lizard_vm_stack_node_t *nodes;
+  int node_count;
+  int node_cap;
+  lizard_vm_activation_t *stack;
+  int depth;
+  int depth_cap;
+  clock_t mark;              /* when self time was last charged */
 } lizard_vm_profile_t;
 
+/* A suspended caller: where to resume once the callee returns. */
+typedef struct {
+  lizard_bc_chunk_t *chunk;
+  int ip;            /* return address */
+  int base;          /* caller's first stack slot */
+  lizard_env_t *env;
+  lizard_ast_node_t **upvals;
+} lizard_vm_frame_t;
+
+/* A call/cc whose receiver is still running: invoking its continuation
+ * drops the frames above frame_count and resumes at ip with the value in
+ * stack slot sp.  Records are popped when the receiver returns, so a
+ * continuation only escapes while its call/cc is live (as in the
+ * evaluator, see lizard_escape_frame_t). */
 typedef struct {
-  lizard_ast_node_t *stack[LIZARD_VM_STACK_SIZE];
+  unsigned long id;  /* escape_id of the continuation */
+  int frame_count;
+  int sp;
+  lizard_bc_chunk_t *chunk;
+  int ip;
+  int base;
+  lizard_env_t *env;
+  lizard_ast_node_t **upvals;
+} lizard_vm_escape_t;
+
+/* Calls between bytecode closures push a frame instead of re-entering
+ * vm_run, and every frame shares one value stack; both grow by doubling
+ * (malloc), so recursion depth is bounded by memory, not the C stack.
+ * The running VMs are chained from the runtime so the collector can scan
+ * their stacks. */
+typedef struct lizard_vm {
+  lizard_ast_node_t **stack;
   int sp;            /* stack pointer (index of next free slot) */
+  int stack_cap;
+  int base;          /* first stack slot (frame slot 0) of the running frame */
+  lizard_vm_frame_t *frames;
+  int frame_count;
+  int frame_cap;
+  lizard_vm_escape_t *escapes;  /* live call/cc records, innermost last */
+  int escape_count;
+  int escape_cap;
   lizard_bc_chunk_t *chunk;
   int ip;            /* instruction pointer */
-  lizard_env_t *env;
+  lizard_env_t *env;               /* globals of the running closure */
+  lizard_ast_node_t **upvals;      /* upvalues of the running closure */
   lizard_heap_t *heap;
   lizard_vm_profile_t *profile;  /* NULL = no profiling */
+  int profile_depth;             /* profile->depth when this VM began */
+  struct lizard_vm *prev;        /* VM this one runs inside of, if any */
 } lizard_vm_t;
 
 /* ---- public API ---- */
@@ -105,12 +286,83 @@ lizard_ast_node_t *lizard_vm_exec(lizard_bc_chunk_t *chunk,
                                    lizard_env_t *env,
                                    lizard_heap_t *heap);
 
-/* Execute with profiling. Fills the profile struct with counters. */
+/* Execute with profiling. Fills the profile struct with counters, and the
+ * per-chunk totals (closures called back from primitives included): zero
+ * it first, and release it with lizard_vm_profile_free. */
 lizard_ast_node_t *lizard_vm_exec_profiled(lizard_bc_chunk_t *chunk,
                                             lizard_env_t *env,
                                             lizard_heap_t *heap,
                                             lizard_vm_profile_t *profile);
 
+/* ---- per-function profile, see bytecode_profile.c ---- */
+
+/* Account the instruction the profiled `vm` is about to run to the chunk
+ * running it, entering and leaving chunks as the frames changed. */
+void lizard_vm_profile_track(lizard_vm_t *vm);
+
+/* Leave the activations above `depth`, when the VM that pushed them ends. */
+void lizard_vm_profile_leave(lizard_vm_profile_t *profile, int depth);
+
+/* Print the chunks of `profile`, most self instructions first: at most
+ * `limit` of them, all if `limit` is 0. */
+void lizard_vm_profile_report(FILE *out, const lizard_vm_profile_t *profile,
+                              int limit);
+
+/* Write the stacks of `profile` as collapsed stacks, one "outer;...;inner
+ * count" line each, weighted by self instructions: the input format of
+ * flamegraph.pl and the tools that read it.  Returns -1 on an I/O error. */
+int lizard_vm_profile_write_collapsed(FILE *out,
+                                      const lizard_vm_profile_t *profile);
+
+/* Free what a profiled run allocated in `profile`. */
+void lizard_vm_profile_free(lizard_vm_profile_t *profile);
+
+/* Whether `node` is a closure made by the VM. */
+int lizard_vm_is_closure(const lizard_ast_node_t *node);
+
+/* Call VM closure `fn` with `args` (forced first) from outside the VM —
+ * the evaluator's entry into bytecode. */
+lizard_ast_node_t *lizard_vm_apply(lizard_ast_node_t *fn, lz_list_t *args,
+                                    lizard_heap_t *heap);
+
+/* Chain `chunk` from the runtime of `heap` (if any) until it is freed, so
+ * the collector keeps its constants. */
+void lizard_bc_chunk_track(lizard_bc_chunk_t *chunk, lizard_heap_t *heap);
+
+/* Free `chunk` and unchain it; not the chunks nested in it. */
+void lizard_bc_chunk_free(lizard_bc_chunk_t *chunk);
+
+/* Free and unchain the VMs entered since `to` was the innermost, which a
+ * longjmp out of them is about to abandon. */
+void lizard_vm_unwind(lizard_heap_t *heap, lizard_vm_t *to);
+
+/* ---- compiled files (.lzc), see bytecode_file.c ---- */
+
+/* Bump whenever the layout changes or opcodes are renumbered or change
+ * meaning; files of another version are refused. */
+#define LIZARD_LZC_VERSION 2
+
+/* Write `chunk` and the chunks nested in it to `fp`.  Returns -1, having
+ * written nothing, when a constant has no encoding (a primitive, say), or
+ * on an I/O error. */
+int lizard_bc_write(FILE *fp, const lizard_bc_chunk_t *chunk);
+
+/* Read a top-level chunk written by lizard_bc_write; NULL when malformed,
+ * or when an operand is out of the range the VM may index. */
+lizard_bc_chunk_t *lizard_bc_read(FILE *fp, lizard_heap_t *heap);
+
+/* Run the forms of `source` in `env` as import does, writing the .lzc of
+ * them to `out` as they go; each form runs the way the file will run it.
+ * Returns the last value or the first error. */
+lizard_ast_node_t *lizard_lzc_compile(const char *source, FILE *out,
+                                      lizard_env_t *env, lizard_heap_t *heap);
+
+/* Run the forms of a .lzc in `env`.  Returns NULL, having run nothing, when
+ * `fp` is not a .lzc this build can read; else the last value or the first
+ * error. */
+lizard_ast_node_t *lizard_lzc_load(FILE *fp, lizard_env_t *env,
+                                   lizard_heap_t *heap);
+
 /* Return the human-readable name of an opcode. */
 const char *lizard_bc_opcode_name(lizard_opcode_t op);
 
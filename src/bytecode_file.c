@@ -0,0 +1,604 @@
+/* src/bytecode_file.c — compiled files (.lzc).
+ *
+ * A .lzc holds the top-level forms of one source file, in order, as
+ * lizard_lzc_compile ran them: each is either a chunk or, when the
+ * compiler left the form to the evaluator (or a constant of its chunk has
+ * no encoding), the form's source text.  Loading one runs the chunks on
+ * the VM and hands the text to the evaluator, so a file whose forms mostly
+ * compile skips tokenizing, parsing, macro expansion and compilation.
+ *
+ * Layout; u32 and i32 are four bytes, least significant first:
+ *
+ *   file      "LZC\0"  u32 LIZARD_LZC_VERSION  u32 LIZARD_OPCODE_COUNT
+ *             then records until the end:
+ *               'C' chunk                a compiled form
+ *               'S' u32 n, n bytes       the text of an uncompiled form
+ *   chunk     i32 arity, rest, nlocals
+ *             text name (empty if anonymous)
+ *             i32 start line, start column, end line, end column
+ *             u32 n, then n times  u8 op, i32 arg
+ *             u32 n, then n values                      (constants)
+ *             u32 n, then n times  u8 is_local, i32 index (upvalues)
+ *   value     'N' text   a variable name of OP_LOAD_GLOBAL/STORE/SET
+ *             'K' chunk  the body of an OP_CLOSURE
+ *             'i' text   an integer in base 16;  'q' text  a rational
+ *             'r' 8 bytes, the double in host order
+ *             's' text   a string;  'y' text  a symbol
+ *             't' 'f' '0'  #t, #f and ()
+ *             'l' u32 n, n values, value   a list: elements, then tail
+ *             'v' u32 n, n values          a vector
+ *   text      u32 n, n bytes
+ *
+ * The opcode count in the header stands in for the instruction set: a
+ * file written by a build with other opcodes is refused, and import
+ * falls back to the source.
+ */
+#include "bytecode.h"
+#include "errors.h"
+#include "mem.h"
+#include "optimize.h"
+#include "parser.h"
+#include "primitives.h"
+#include "symbol.h"
+#include "tokenizer.h"
+#include <gmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Sanity bound on any count read from a file. */
+#define LZC_MAX_COUNT 0x1000000UL
+
+/* ---- writing ----
+ * Every writer takes a NULL `fp` as a dry run: it only reports whether
+ * the value or chunk has an encoding, so nothing half-written reaches the
+ * file. */
+
+static int put_byte(FILE *fp, int b) {
+  return fp == NULL || fputc(b, fp) != EOF ? 0 : -1;
+}
+
+static int put_u32(FILE *fp, unsigned long v) {
+  int i;
+  for (i = 0; i < 4; i++) {
+    if (put_byte(fp, (int)((v >> (8 * i)) & 0xFFUL)) < 0) return -1;
+  }
+  return 0;
+}
+
+static int put_i32(FILE *fp, int v) {
+  return put_u32(fp, (unsigned long)(long)v & 0xFFFFFFFFUL);
+}
+
+static int put_text(FILE *fp, const char *s, size_t n) {
+  if (put_u32(fp, (unsigned long)n) < 0) return -1;
+  return fp == NULL || fwrite(s, 1, n, fp) == n ? 0 : -1;
+}
+
+static int put_mp_text(FILE *fp, int tag, char *digits) {
+  int r = put_byte(fp, tag) < 0 ? -1 : put_text(fp, digits, strlen(digits));
+  void (*release)(void *, size_t);
+  mp_get_memory_functions(NULL, NULL, &release);
+  release(digits, strlen(digits) + 1);
+  return r;
+}
+
+static int put_chunk(FILE *fp, const lizard_bc_chunk_t *c);
+
+static int put_value(FILE *fp, const lizard_ast_node_t *v) {
+  switch (v->type) {
+  case AST_NUMBER:
+    return put_mp_text(fp, 'i', mpz_get_str(NULL, 16, v->data.number));
+  case AST_RATIONAL:
+    return put_mp_text(fp, 'q', mpq_get_str(NULL, 16, v->data.rational));
+  case AST_REAL:
+    if (put_byte(fp, 'r') < 0) return -1;
+    return fp == NULL || fwrite(&v->data.real, sizeof(double), 1, fp) == 1
+               ? 0
+               : -1;
+  case AST_STRING:
+    if (put_byte(fp, 's') < 0) return -1;
+    return put_text(fp, v->data.string, strlen(v->data.string));
+  case AST_SYMBOL:
+    if (put_byte(fp, 'y') < 0) return -1;
+    return put_text(fp, v->data.variable, strlen(v->data.variable));
+  case AST_BOOL:
+    return put_byte(fp, v->data.boolean ? 't' : 'f');
+  case AST_NIL:
+    return put_byte(fp, '0');
+  case AST_PAIR: {
+    const lizard_ast_node_t *it;
+    unsigned long n = 0;
+    for (it = v; it->type == AST_PAIR; it = it->data.pair.cdr) n++;
+    if (put_byte(fp, 'l') < 0 || put_u32(fp, n) < 0) return -1;
+    for (it = v; it->type == AST_PAIR; it = it->data.pair.cdr) {
+      if (put_value(fp, it->data.pair.car) < 0) return -1;
+    }
+    return put_value(fp, it);
+  }
+  case AST_VECTOR: {
+    size_t i;
+    if (put_byte(fp, 'v') < 0 ||
+        put_u32(fp, (unsigned long)v->data.vector.size) < 0) {
+      return -1;
+    }
+    for (i = 0; i < v->data.vector.size; i++) {
+      if (put_value(fp, v->data.vector.elements[i]) < 0) return -1;
+    }
+    return 0;
+  }
+  default:
+    return -1; /* primitives, closures, promises, ...: no encoding */
+  }
+}
+
+/* Whether constant `k` of `c` holds the chunk of an OP_CLOSURE. */
+static int is_chunk_const(const lizard_bc_chunk_t *c, int k) {
+  int i;
+  for (i = 0; i < c->code_count; i++) {
+    if (c->code[i].op == OP_CLOSURE && c->code[i].arg == k) return 1;
+  }
+  return 0;
+}
+
+static int put_chunk(FILE *fp, const lizard_bc_chunk_t *c) {
+  int i;
+  const char *name = c->name != NULL ? c->name : "";
+  if (put_i32(fp, c->arity) < 0 || put_i32(fp, c->rest) < 0 ||
+      put_i32(fp, c->nlocals) < 0 || put_text(fp, name, strlen(name)) < 0 ||
+      put_i32(fp, c->span.start_line) < 0 ||
+      put_i32(fp, c->span.start_column) < 0 ||
+      put_i32(fp, c->span.end_line) < 0 ||
+      put_i32(fp, c->span.end_column) < 0 ||
+      put_u32(fp, (unsigned long)c->code_count) < 0) {
+    return -1;
+  }
+  for (i = 0; i < c->code_count; i++) {
+    if (put_byte(fp, (int)c->code[i].op) < 0 ||
+        put_i32(fp, c->code[i].arg) < 0) {
+      return -1;
+    }
+  }
+  if (put_u32(fp, (unsigned long)c->const_count) < 0) return -1;
+  for (i = 0; i < c->const_count; i++) {
+    const lizard_ast_node_t *k = c->constants[i];
+    int r;
+    if (c->const_is_name[i]) {
+      r = put_byte(fp, 'N') < 0
+              ? -1
+              : put_text(fp, k->data.string, strlen(k->data.string));
+    } else if (is_chunk_const(c, i)) {
+      lizard_bc_chunk_t *sub;
+      memcpy(&sub, &k->data.string, sizeof(sub));
+      r = put_byte(fp, 'K') < 0 ? -1 : put_chunk(fp, sub);
+    } else {
+      r = put_value(fp, k);
+    }
+    if (r < 0) return -1;
+  }
+  if (put_u32(fp, (unsigned long)c->upval_count) < 0) return -1;
+  for (i = 0; i < c->upval_count; i++) {
+    if (put_byte(fp, c->upval_is_local[i]) < 0 ||
+        put_i32(fp, c->upval_index[i]) < 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int lizard_bc_write(FILE *fp, const lizard_bc_chunk_t *chunk) {
+  if (put_chunk(NULL, chunk) < 0) return -1;
+  return put_chunk(fp, chunk);
+}
+
+/* ---- reading ---- */
+
+static int get_byte(FILE *fp, int *out) {
+  *out = fgetc(fp);
+  return *out == EOF ? -1 : 0;
+}
+
+static int get_u32(FILE *fp, unsigned long *out) {
+  int i, b;
+  *out = 0;
+  for (i = 0; i < 4; i++) {
+    if (get_byte(fp, &b) < 0) return -1;
+    *out |= (unsigned long)b << (8 * i);
+  }
+  return 0;
+}
+
+static int get_i32(FILE *fp, int *out) {
+  unsigned long v;
+  if (get_u32(fp, &v) < 0) return -1;
+  *out = v & 0x80000000UL ? -(int)(0xFFFFFFFFUL - v) - 1 : (int)v;
+  return 0;
+}
+
+static int get_count(FILE *fp, unsigned long *out) {
+  return get_u32(fp, out) < 0 || *out > LZC_MAX_COUNT ? -1 : 0;
+}
+
+/* A NUL-terminated copy, on the lizard heap, of the next text. */
+static char *get_text(FILE *fp) {
+  unsigned long n;
+  char *s;
+  if (get_count(fp, &n) < 0) return NULL;
+  s = (char *)lizard_heap_alloc_atomic((size_t)n + 1);
+  if (fread(s, 1, (size_t)n, fp) != (size_t)n) return NULL;
+  s[n] = '\0';
+  return s;
+}
+
+static lizard_bc_chunk_t *get_chunk(FILE *fp, lizard_heap_t *heap);
+
+static lizard_ast_node_t *new_node(lizard_ast_node_type_t type) {
+  lizard_ast_node_t *node = lizard_heap_alloc_tagged(
+      sizeof(lizard_ast_node_t), LIZARD_GC_OBJECT_AST_NODE,
+      LIZARD_OBJECT_TRACE_AST);
+  memset(node, 0, sizeof(*node));
+  node->type = type;
+  return node;
+}
+
+static lizard_ast_node_t *get_value(FILE *fp, lizard_heap_t *heap);
+
+/* The value after tag `tag`; NULL when malformed. */
+static lizard_ast_node_t *get_tagged(FILE *fp, int tag, lizard_heap_t *heap) {
+  lizard_ast_node_t *node;
+  char *text;
+  switch (tag) {
+  case 'i':
+  case 'q': {
+    int bad;
+    if ((text = get_text(fp)) == NULL) return NULL;
+    node = lizard_make_number_node(heap);
+    node->type = tag == 'i' ? AST_NUMBER : AST_RATIONAL;
+    if (tag == 'i') {
+      bad = mpz_init_set_str(node->data.number, text, 16);
+      if (!bad) lizard_number_normalize(node);
+    } else {
+      mpq_init(node->data.rational);
+      bad = mpq_set_str(node->data.rational, text, 16);
+      if (!bad) mpq_canonicalize(node->data.rational);
+    }
+    return bad ? NULL : node;
+  }
+  case 'r': {
+    double d;
+    if (fread(&d, sizeof(double), 1, fp) != 1) return NULL;
+    return lizard_make_real(heap, d);
+  }
+  case 's':
+    if ((text = get_text(fp)) == NULL) return NULL;
+    node = new_node(AST_STRING);
+    node->data.string = text;
+    return node;
+  case 'y':
+    if ((text = get_text(fp)) == NULL) return NULL;
+    node = new_node(AST_SYMBOL);
+    node->data.variable = lizard_intern(text);
+    return node;
+  case 't':
+  case 'f':
+    return lizard_make_bool(heap, tag == 't');
+  case '0':
+    return lizard_make_nil(heap);
+  case 'l': {
+    unsigned long n, i;
+    lizard_ast_node_t *head = NULL, **tail = &head;
+    if (get_count(fp, &n) < 0) return NULL;
+    for (i = 0; i < n; i++) {
+      lizard_ast_node_t *pair = new_node(AST_PAIR);
+      if ((pair->data.pair.car = get_value(fp, heap)) == NULL) return NULL;
+      *tail = pair;
+      tail = &pair->data.pair.cdr;
+    }
+    if ((*tail = get_value(fp, heap)) == NULL) return NULL;
+    return head;
+  }
+  case 'v': {
+    unsigned long n, i;
+    if (get_count(fp, &n) < 0) return NULL;
+    node = new_node(AST_VECTOR);
+    node->data.vector.size = (size_t)n;
+    node->data.vector.elements = (lizard_ast_node_t **)lizard_heap_alloc(
+        ((size_t)n + 1) * sizeof(lizard_ast_node_t *));
+    for (i = 0; i < n; i++) {
+      node->data.vector.elements[i] = get_value(fp, heap);
+      if (node->data.vector.elements[i] == NULL) return NULL;
+    }
+    return node;
+  }
+  default:
+    return NULL;
+  }
+}
+
+static lizard_ast_node_t *get_value(FILE *fp, lizard_heap_t *heap) {
+  int tag;
+  return get_byte(fp, &tag) < 0 ? NULL : get_tagged(fp, tag, heap);
+}
+
+/* Whether `op` takes a constant index, a code address or neither. */
+static int op_takes_const(lizard_opcode_t op) {
+  return op == OP_CONST || op == OP_LOAD_GLOBAL || op == OP_STORE ||
+         op == OP_SET || op == OP_CLOSURE || op == OP_CALL_PRIM;
+}
+
+static int op_takes_address(lizard_opcode_t op) {
+  return op == OP_JUMP || op == OP_JUMP_IF_FALSE || op == OP_JUMP_IF_TRUE ||
+         op == OP_JUMP_UNLESS_EQ || op == OP_JUMP_UNLESS_LT ||
+         op == OP_JUMP_UNLESS_GT || op == OP_JUMP_IF_FALSE_OR_POP ||
+         op == OP_JUMP_IF_TRUE_OR_POP;
+}
+
+static int op_takes_local(lizard_opcode_t op) {
+  return op == OP_LOAD_LOCAL || op == OP_STORE_LOCAL ||
+         op == OP_STORE_LOCAL_POP || op == OP_LOAD_LOCAL2 ||
+         op == OP_LOAD_LOCAL_ADD_IMM || op == OP_RETURN_LOCAL;
+}
+
+static int op_takes_upval(lizard_opcode_t op) {
+  return op == OP_LOAD_UPVAL || op == OP_LOAD_UPVAL_UNBOX;
+}
+
+/* Whether every constant, jump, frame slot and upvalue operand of `c` is
+ * in range, every name and closure instruction refers to a constant of its
+ * kind, and the closures it makes capture slots and upvalues it has.  The
+ * VM trusts its chunks; this is what a damaged file could break. */
+static int chunk_consistent(const lizard_bc_chunk_t *c,
+                            const unsigned char *kind) {
+  int i;
+  int j;
+  if (c->arity < 0 || (c->rest != 0 && c->rest != 1) ||
+      c->arity + c->rest > c->nlocals) {
+    return 0;
+  }
+  for (i = 0; i < c->code_count; i++) {
+    lizard_instruction_t in = c->code[i];
+    if (op_takes_const(in.op)) {
+      if (in.arg < 0 || in.arg >= c->const_count) return 0;
+      if ((in.op == OP_CLOSURE) != (kind[in.arg] == 'K')) return 0;
+      if ((in.op == OP_LOAD_GLOBAL || in.op == OP_STORE || in.op == OP_SET ||
+           in.op == OP_CALL_PRIM) != (kind[in.arg] == 'N')) {
+        return 0;
+      }
+    } else if (op_takes_address(in.op)) {
+      if (in.arg < 0 || in.arg > c->code_count) return 0;
+    } else if (op_takes_local(in.op)) {
+      if (in.arg < 0 || in.arg >= c->nlocals) return 0;
+    } else if (op_takes_upval(in.op)) {
+      if (in.arg < 0 || in.arg >= c->upval_count) return 0;
+    }
+    /* The instructions that read the one after them need one there. */
+    if (in.op == OP_CALL_PRIM &&
+        (i + 1 >= c->code_count || (c->code[i + 1].op != OP_CALL &&
+                                    c->code[i + 1].op != OP_TAIL_CALL))) {
+      return 0;
+    }
+    if (in.op == OP_LOAD_LOCAL2 || in.op == OP_LOAD_LOCAL_ADD_IMM) {
+      if (i + 1 >= c->code_count) return 0;
+      if (in.op == OP_LOAD_LOCAL2 &&
+          (c->code[i + 1].arg < 0 || c->code[i + 1].arg >= c->nlocals)) {
+        return 0;
+      }
+    }
+  }
+  for (i = 0; i < c->const_count; i++) {
+    lizard_bc_chunk_t *sub;
+    if (kind[i] != 'K') continue;
+    memcpy(&sub, &c->constants[i]->data.string, sizeof(sub));
+    for (j = 0; j < sub->upval_count; j++) {
+      int limit = sub->upval_is_local[j] ? c->nlocals : c->upval_count;
+      if (sub->upval_index[j] < 0 || sub->upval_index[j] >= limit) return 0;
+    }
+  }
+  return c->code_count > 0;
+}
+
+/* Read the fields of a chunk into zeroed `c`; `kind` gets each constant's
+ * tag.  Whatever was allocated stays in `c` (and `kind`) on failure. */
+static int get_chunk_fields(FILE *fp, lizard_bc_chunk_t *c,
+                            unsigned char **kind, lizard_heap_t *heap) {
+  unsigned long n, i;
+  char *name;
+  if (get_i32(fp, &c->arity) < 0 || get_i32(fp, &c->rest) < 0 ||
+      get_i32(fp, &c->nlocals) < 0 || (name = get_text(fp)) == NULL ||
+      get_i32(fp, &c->span.start_line) < 0 ||
+      get_i32(fp, &c->span.start_column) < 0 ||
+      get_i32(fp, &c->span.end_line) < 0 ||
+      get_i32(fp, &c->span.end_column) < 0 || get_count(fp, &n) < 0) {
+    return -1;
+  }
+  c->name = name[0] != '\0' ? lizard_intern(name) : NULL;
+  c->code_cap = n > 0 ? (int)n : 1;
+  c->code = (lizard_instruction_t *)malloc((size_t)c->code_cap *
+                                           sizeof(lizard_instruction_t));
+  if (c->code == NULL) return -1;
+  for (i = 0; i < n; i++) {
+    int op;
+    if (get_byte(fp, &op) < 0 || op >= LIZARD_OPCODE_COUNT ||
+        get_i32(fp, &c->code[i].arg) < 0) {
+      return -1;
+    }
+    c->code[i].op = (lizard_opcode_t)op;
+  }
+  c->code_count = (int)n;
+
+  if (get_count(fp, &n) < 0) return -1;
+  c->const_cap = n > 0 ? (int)n : 1;
+  c->constants = (lizard_ast_node_t **)malloc((size_t)c->const_cap *
+                                              sizeof(lizard_ast_node_t *));
+  c->const_is_name = (unsigned char *)malloc((size_t)c->const_cap);
+  *kind = (unsigned char *)malloc((size_t)c->const_cap);
+  if (c->constants == NULL || c->const_is_name == NULL || *kind == NULL) {
+    return -1;
+  }
+  for (i = 0; i < n; i++) {
+    int tag;
+    lizard_ast_node_t *k = NULL;
+    if (get_byte(fp, &tag) < 0) return -1;
+    if (tag == 'N') {
+      char *name = get_text(fp);
+      if (name != NULL) {
+        /* As chunk_add_name makes them: OP_LOAD_GLOBAL caches in it. */
+        k = new_node(AST_STRING);
+        k->data.string = lizard_intern(name);
+      }
+    } else if (tag == 'K') {
+      lizard_bc_chunk_t *sub = get_chunk(fp, heap);
+      if (sub != NULL) {
+        k = new_node(AST_STRING);
+        memcpy(&k->data.string, &sub, sizeof(sub));
+      }
+    } else {
+      k = get_tagged(fp, tag, heap);
+    }
+    if (k == NULL) return -1;
+    c->constants[i] = k;
+    c->const_is_name[i] = (unsigned char)(tag == 'N');
+    (*kind)[i] = (unsigned char)tag;
+    c->const_count = (int)i + 1;
+  }
+
+  if (get_count(fp, &n) < 0) return -1;
+  if (n > 0) {
+    c->upval_is_local = (unsigned char *)malloc((size_t)n);
+    c->upval_index = (int *)malloc((size_t)n * sizeof(int));
+    if (c->upval_is_local == NULL || c->upval_index == NULL) return -1;
+  }
+  for (i = 0; i < n; i++) {
+    int local;
+    if (get_byte(fp, &local) < 0 || get_i32(fp, &c->upval_index[i]) < 0) {
+      return -1;
+    }
+    c->upval_is_local[i] = (unsigned char)(local != 0);
+  }
+  c->upval_count = (int)n;
+  return chunk_consistent(c, *kind) ? 0 : -1;
+}
+
+static lizard_bc_chunk_t *get_chunk(FILE *fp, lizard_heap_t *heap) {
+  lizard_bc_chunk_t *c;
+  unsigned char *kind = NULL;
+  int ok;
+  c = (lizard_bc_chunk_t *)malloc(sizeof(lizard_bc_chunk_t));
+  if (c == NULL) return NULL;
+  memset(c, 0, sizeof(*c));
+  lizard_bc_chunk_track(c, heap);
+  ok = get_chunk_fields(fp, c, &kind, heap) == 0;
+  free(kind);
+  if (!ok) {
+    lizard_bc_chunk_free(c);
+    return NULL;
+  }
+  return c;
+}
+
+/* A chunk run by itself: it has no enclosing frame or closure to take
+ * slots or upvalues from. */
+static lizard_bc_chunk_t *get_top_chunk(FILE *fp, lizard_heap_t *heap) {
+  lizard_bc_chunk_t *c = get_chunk(fp, heap);
+  if (c != NULL && (c->nlocals != 0 || c->upval_count != 0)) {
+    lizard_bc_chunk_free(c);
+    return NULL;
+  }
+  return c;
+}
+
+lizard_bc_chunk_t *lizard_bc_read(FILE *fp, lizard_heap_t *heap) {
+  return get_top_chunk(fp, heap);
+}
+
+/* ---- files of forms ---- */
+
+static const char lzc_magic[4] = {'L', 'Z', 'C', '\0'};
+
+/* Expand and optimise a top-level form as load and import do. */
+static lizard_ast_node_t *prepare_form(lizard_ast_node_t *form,
+                                       lizard_env_t *env,
+                                       lizard_heap_t *heap) {
+  return lizard_optimize(lizard_expand_macros(form, env, heap), env, heap);
+}
+
+/* Run the forms of source `text` with the evaluator. */
+static lizard_ast_node_t *eval_text(const char *text, lizard_env_t *env,
+                                    lizard_heap_t *heap) {
+  lz_list_t *tokens = lizard_tokenize(text);
+  lz_list_t *forms = tokens != NULL ? lizard_parse(tokens, heap) : NULL;
+  lz_list_node_t *it;
+  lizard_ast_node_t *result = lizard_make_nil(heap);
+  if (forms == NULL) return lizard_make_error(heap, LIZARD_ERROR_LOAD_READ);
+  for (it = forms->head; it != forms->nil; it = it->next) {
+    result = lizard_eval(
+        prepare_form(((lizard_ast_list_node_t *)it)->ast, env, heap), env,
+        heap, lizard_identity_cont);
+    if (result != NULL && result->type == AST_ERROR) break;
+  }
+  return result;
+}
+
+lizard_ast_node_t *lizard_lzc_compile(const char *source, FILE *out,
+                                      lizard_env_t *env, lizard_heap_t *heap) {
+  lz_list_t *tokens = lizard_tokenize(source);
+  lz_list_t *forms;
+  lz_list_node_t *it;
+  int *starts = NULL;
+  int i = 0;
+  lizard_ast_node_t *result = lizard_make_nil(heap);
+  forms = tokens != NULL ? lizard_parse_located(tokens, heap, &starts) : NULL;
+  if (forms == NULL) return lizard_make_error(heap, LIZARD_ERROR_LOAD_READ);
+  if (fwrite(lzc_magic, 1, sizeof(lzc_magic), out) != sizeof(lzc_magic) ||
+      put_u32(out, LIZARD_LZC_VERSION) < 0 ||
+      put_u32(out, LIZARD_OPCODE_COUNT) < 0) {
+    return lizard_make_error(heap, LIZARD_ERROR_LOAD_WRITE);
+  }
+  for (it = forms->head; it != forms->nil; it = it->next, i++) {
+    lizard_ast_node_t *form =
+        prepare_form(((lizard_ast_list_node_t *)it)->ast, env, heap);
+    lizard_bc_chunk_t *chunk = lizard_compile(form, heap);
+    int w;
+    if (chunk != NULL && put_chunk(NULL, chunk) == 0) {
+      w = put_byte(out, 'C') < 0 ? -1 : put_chunk(out, chunk);
+      result = lizard_vm_exec(chunk, env, heap);
+    } else {
+      size_t end = starts[i + 1] >= 0 ? (size_t)starts[i + 1] : strlen(source);
+      w = put_byte(out, 'S') < 0
+              ? -1
+              : put_text(out, source + starts[i], end - (size_t)starts[i]);
+      result = lizard_eval(form, env, heap, lizard_identity_cont);
+    }
+    if (w < 0) return lizard_make_error(heap, LIZARD_ERROR_LOAD_WRITE);
+    if (result != NULL && result->type == AST_ERROR) break;
+  }
+  return result;
+}
+
+lizard_ast_node_t *lizard_lzc_load(FILE *fp, lizard_env_t *env,
+                                   lizard_heap_t *heap) {
+  char magic[sizeof(lzc_magic)];
+  unsigned long version, opcodes;
+  lizard_ast_node_t *result = lizard_make_nil(heap);
+  int tag;
+  if (fread(magic, 1, sizeof(magic), fp) != sizeof(magic) ||
+      memcmp(magic, lzc_magic, sizeof(magic)) != 0 ||
+      get_u32(fp, &version) < 0 || version != LIZARD_LZC_VERSION ||
+      get_u32(fp, &opcodes) < 0 || opcodes != LIZARD_OPCODE_COUNT) {
+    return NULL;
+  }
+  while (get_byte(fp, &tag) == 0) {
+    if (tag == 'C') {
+      lizard_bc_chunk_t *chunk = get_top_chunk(fp, heap);
+      if (chunk == NULL) return lizard_make_error(heap, LIZARD_ERROR_LOAD_READ);
+      result = lizard_vm_exec(chunk, env, heap);
+    } else if (tag == 'S') {
+      char *text = get_text(fp);
+      if (text == NULL) return lizard_make_error(heap, LIZARD_ERROR_LOAD_READ);
+      result = eval_text(text, env, heap);
+    } else {
+      return lizard_make_error(heap, LIZARD_ERROR_LOAD_READ);
+    }
+    if (result != NULL && result->type == AST_ERROR) break;
+  }
+  return result;
+}
@@ -0,0 +1,535 @@
+/* src/bytecode_loop.h — the VM dispatch loop.
+ *
+ * Not an ordinary header: bytecode.c includes it once per loop it needs,
+ * with VM_LOOP naming the function and VM_PROFILED 1 for the loop that
+ * fills vm->profile, 0 for the one that carries no instrumentation.  The
+ * instruction bodies are written once, between VM_CASE and VM_NEXT.
+ *
+ * With LIZARD_VM_THREADED (make VM_DISPATCH=threaded) the loop dispatches
+ * through a table of label addresses, and every handler ends in its own
+ * indirect jump to the next one, so the branch predictor sees one jump
+ * per opcode instead of the shared one of a switch.  That needs GNU C;
+ * without it the loop is a portable switch.
+ *
+ * Returns the value of the outermost frame, or the first error any frame
+ * raises.  Every chunk ends in RETURN or HALT; running off the end of one
+ * returns like HALT.
+ */
+
+#if defined(LIZARD_VM_THREADED) && !defined(__GNUC__)
+#error "threaded VM dispatch needs GNU C label addresses"
+#endif
+
+#if VM_PROFILED
+#define VM_PROFILE_STEP() vm_profile_step(vm, instr, &last)
+#else
+#define VM_PROFILE_STEP() ((void)0)
+#endif
+
+/* Fetch the next instruction into `instr`.  No instruction grows the
+ * stack by more than two slots. */
+#define VM_FETCH()                                                         \
+  do {                                                                     \
+    if (vm->ip >= vm->chunk->code_count) return vm_frame_result(vm);       \
+    instr = vm->chunk->code[vm->ip++];                                     \
+    if (vm->sp + 2 > vm->stack_cap && !vm_grow_stack(vm)) {                \
+      return lizard_make_error(heap, LIZARD_ERROR_USER);                   \
+    }                                                                      \
+    VM_PROFILE_STEP();                                                     \
+  } while (0)
+
+#ifdef LIZARD_VM_THREADED
+#define VM_CASE(op) L_##op:
+#define VM_NEXT                                                            \
+  do {                                                                     \
+    VM_FETCH();                                                            \
+    goto *labels[instr.op];                                                \
+  } while (0)
+#else
+#define VM_CASE(op) case op:
+#define VM_NEXT break
+#endif
+
+static lizard_ast_node_t *VM_LOOP(lizard_vm_t *vm) {
+  lizard_heap_t *heap = vm->heap;
+  lizard_instruction_t instr;
+#if VM_PROFILED
+  vm_pair_t last;
+#endif
+#ifdef LIZARD_VM_THREADED
+  static void *const labels[LIZARD_OPCODE_COUNT] = {
+      [OP_CONST] = &&L_OP_CONST,
+      [OP_NIL] = &&L_OP_NIL,
+      [OP_TRUE] = &&L_OP_TRUE,
+      [OP_FALSE] = &&L_OP_FALSE,
+      [OP_LOAD_GLOBAL] = &&L_OP_LOAD_GLOBAL,
+      [OP_STORE] = &&L_OP_STORE,
+      [OP_SET] = &&L_OP_SET,
+      [OP_POP] = &&L_OP_POP,
+      [OP_ADD] = &&L_OP_ADD,
+      [OP_SUB] = &&L_OP_SUB,
+      [OP_MUL] = &&L_OP_MUL,
+      [OP_DIV] = &&L_OP_DIV,
+      [OP_MOD] = &&L_OP_MOD,
+      [OP_EQ] = &&L_OP_EQ,
+      [OP_LT] = &&L_OP_LT,
+      [OP_GT] = &&L_OP_GT,
+      [OP_NOT] = &&L_OP_NOT,
+      [OP_CONS] = &&L_OP_CONS,
+      [OP_CAR] = &&L_OP_CAR,
+      [OP_CDR] = &&L_OP_CDR,
+      [OP_JUMP] = &&L_OP_JUMP,
+      [OP_JUMP_IF_FALSE] = &&L_OP_JUMP_IF_FALSE,
+      [OP_CALL] = &&L_OP_CALL,
+      [OP_TAIL_CALL] = &&L_OP_TAIL_CALL,
+      [OP_RETURN] = &&L_OP_RETURN,
+      [OP_CLOSURE] = &&L_OP_CLOSURE,
+      [OP_DISPLAY] = &&L_OP_DISPLAY,
+      [OP_NEWLINE] = &&L_OP_NEWLINE,
+      [OP_HALT] = &&L_OP_HALT,
+      [OP_LOAD_LOCAL] = &&L_OP_LOAD_LOCAL,
+      [OP_STORE_LOCAL] = &&L_OP_STORE_LOCAL,
+      [OP_LOAD_UPVAL] = &&L_OP_LOAD_UPVAL,
+      [OP_BOX] = &&L_OP_BOX,
+      [OP_UNBOX] = &&L_OP_UNBOX,
+      [OP_SET_BOX] = &&L_OP_SET_BOX,
+      [OP_ADD_IMM] = &&L_OP_ADD_IMM,
+      [OP_JUMP_UNLESS_EQ] = &&L_OP_JUMP_UNLESS_EQ,
+      [OP_JUMP_UNLESS_LT] = &&L_OP_JUMP_UNLESS_LT,
+      [OP_JUMP_UNLESS_GT] = &&L_OP_JUMP_UNLESS_GT,
+      [OP_JUMP_IF_FALSE_OR_POP] = &&L_OP_JUMP_IF_FALSE_OR_POP,
+      [OP_JUMP_IF_TRUE_OR_POP] = &&L_OP_JUMP_IF_TRUE_OR_POP,
+      [OP_VECTOR_REF] = &&L_OP_VECTOR_REF,
+      [OP_VECTOR_SET] = &&L_OP_VECTOR_SET,
+      [OP_VECTOR_LENGTH] = &&L_OP_VECTOR_LENGTH,
+      [OP_STRING_REF] = &&L_OP_STRING_REF,
+      [OP_STRING_LENGTH] = &&L_OP_STRING_LENGTH,
+      [OP_CALLCC] = &&L_OP_CALLCC,
+      [OP_JUMP_IF_TRUE] = &&L_OP_JUMP_IF_TRUE,
+      [OP_RETURN_LOCAL] = &&L_OP_RETURN_LOCAL,
+      [OP_LOAD_UPVAL_UNBOX] = &&L_OP_LOAD_UPVAL_UNBOX,
+      [OP_STORE_LOCAL_POP] = &&L_OP_STORE_LOCAL_POP,
+      [OP_LOAD_LOCAL2] = &&L_OP_LOAD_LOCAL2,
+      [OP_LOAD_LOCAL_ADD_IMM] = &&L_OP_LOAD_LOCAL_ADD_IMM,
+      [OP_CALL_PRIM] = &&L_OP_CALL_PRIM
+  };
+#endif
+#if VM_PROFILED
+  last.chunk = NULL;
+  last.ip = -1;
+  last.op = 0;
+#endif
+
+#ifdef LIZARD_VM_THREADED
+  VM_NEXT;
+  {
+#else
+  for (;;) {
+    VM_FETCH();
+    switch (instr.op) {
+#endif
+    VM_CASE(OP_CONST)
+      vm->stack[vm->sp++] = vm->chunk->constants[instr.arg];
+      VM_NEXT;
+    VM_CASE(OP_NIL)
+      vm->stack[vm->sp++] = lizard_make_nil(heap);
+      VM_NEXT;
+    VM_CASE(OP_TRUE)
+      vm->stack[vm->sp++] = lizard_make_bool(heap, 1);
+      VM_NEXT;
+    VM_CASE(OP_FALSE)
+      vm->stack[vm->sp++] = lizard_make_bool(heap, 0);
+      VM_NEXT;
+    VM_CASE(OP_LOAD_GLOBAL) {
+      lizard_ast_node_t *val =
+          lizard_env_lookup_site(vm->env, vm->chunk->constants[instr.arg]);
+      if (val == NULL) {
+        vm->stack[vm->sp++] = lizard_make_error(heap, LIZARD_ERROR_UNBOUND_SYMBOL);
+        return vm->stack[vm->sp - 1];
+      }
+      vm->stack[vm->sp++] = val;
+      VM_NEXT;
+    }
+    VM_CASE(OP_STORE) {
+      const char *name = vm->chunk->constants[instr.arg]->data.string;
+      lizard_ast_node_t *val = vm->stack[--vm->sp];
+      lizard_env_define(heap, vm->env, name, val);
+      vm->stack[vm->sp++] = val;
+      VM_NEXT;
+    }
+    VM_CASE(OP_SET) {
+      const char *name = vm->chunk->constants[instr.arg]->data.string;
+      lizard_ast_node_t *val = vm->stack[--vm->sp];
+      lizard_env_set(vm->env, name, val);
+      vm->stack[vm->sp++] = val;
+      VM_NEXT;
+    }
+    VM_CASE(OP_POP)
+      if (vm->sp > 0) vm->sp--;
+      VM_NEXT;
+    VM_CASE(OP_ADD) VM_CASE(OP_SUB) VM_CASE(OP_MUL) VM_CASE(OP_DIV) VM_CASE(OP_MOD) {
+      lizard_ast_node_t *b = vm->stack[--vm->sp];
+      lizard_ast_node_t *a = vm->stack[--vm->sp];
+      lizard_ast_node_t *r;
+      if (LIZARD_IS_FIXNUM(a) && LIZARD_IS_FIXNUM(b)) {
+        long x = LIZARD_FIXNUM_VALUE(a), y = LIZARD_FIXNUM_VALUE(b), z;
+        int ok = 0;
+        switch (instr.op) {
+        case OP_ADD: ok = lizard_fixnum_add(x, y, &z); break;
+        case OP_SUB: ok = lizard_fixnum_sub(x, y, &z); break;
+        case OP_MUL: ok = lizard_fixnum_mul(x, y, &z); break;
+        case OP_DIV:
+        case OP_MOD:
+          /* zero divisors, LONG_MIN and inexact quotients (7/2) take the
+           * primitive */
+          if (y != 0 && x != LONG_MIN && y != LONG_MIN) {
+            z = x % y;
+            if (instr.op == OP_DIV) {
+              ok = z == 0;
+              z = x / y;
+            } else {
+              if (z < 0) {
+                z += y < 0 ? -y : y; /* mpz_mod: result in [0, |y|) */
+              }
+              ok = 1;
+            }
+          }
+          break;
+        default: break;
+        }
+        if (ok) {
+          vm->stack[vm->sp++] = lizard_make_fixnum(heap, z);
+          VM_NEXT;
+        }
+      }
+      r = vm_arith(instr.op, a, b, vm->env, heap);
+      if (r->type == AST_ERROR) return r;
+      vm->stack[vm->sp++] = r;
+      VM_NEXT;
+    }
+    VM_CASE(OP_ADD_IMM) {
+      lizard_ast_node_t *a = vm->stack[vm->sp - 1];
+      long z;
+      if (LIZARD_IS_FIXNUM(a) &&
+          lizard_fixnum_add(LIZARD_FIXNUM_VALUE(a), (long)instr.arg, &z)) {
+        vm->stack[vm->sp - 1] = lizard_make_fixnum(heap, z);
+      } else {
+        lizard_ast_node_t *r = vm_arith(
+            OP_ADD, a, lizard_make_fixnum(heap, (long)instr.arg), vm->env, heap);
+        if (r->type == AST_ERROR) return r;
+        vm->stack[vm->sp - 1] = r;
+      }
+      VM_NEXT;
+    }
+    VM_CASE(OP_EQ) VM_CASE(OP_LT) VM_CASE(OP_GT) {
+      lizard_ast_node_t *b = vm->stack[--vm->sp];
+      lizard_ast_node_t *a = vm->stack[--vm->sp];
+      lizard_ast_node_t *err = NULL;
+      int holds = vm_compare(instr.op, a, b, vm->env, heap, &err);
+      if (holds < 0) return err;
+      vm->stack[vm->sp++] = lizard_make_bool(heap, holds);
+      VM_NEXT;
+    }
+    VM_CASE(OP_JUMP_UNLESS_EQ) VM_CASE(OP_JUMP_UNLESS_LT) VM_CASE(OP_JUMP_UNLESS_GT) {
+      lizard_ast_node_t *b = vm->stack[--vm->sp];
+      lizard_ast_node_t *a = vm->stack[--vm->sp];
+      lizard_ast_node_t *err = NULL;
+      int holds = vm_compare(instr.op, a, b, vm->env, heap, &err);
+      if (holds < 0) return err;
+      if (!holds) {
+        vm->ip = instr.arg;
+      }
+      VM_NEXT;
+    }
+    VM_CASE(OP_NOT) {
+      lizard_ast_node_t *a = vm->stack[--vm->sp];
+      int falsy = (a->type == AST_BOOL && !a->data.boolean) ||
+                  a->type == AST_NIL;
+      vm->stack[vm->sp++] = lizard_make_bool(heap, falsy);
+      VM_NEXT;
+    }
+    VM_CASE(OP_CONS) {
+      lizard_ast_node_t *b = vm->stack[--vm->sp];
+      lizard_ast_node_t *a = vm->stack[--vm->sp];
+      vm->stack[vm->sp++] = lizard_make_pair(heap, a, b);
+      VM_NEXT;
+    }
+    VM_CASE(OP_CAR) {
+      lizard_ast_node_t *a = vm->stack[--vm->sp];
+      if (a->type != AST_PAIR) {
+        return lizard_make_error(heap, LIZARD_ERROR_CAR_ARGT);
+      }
+      vm->stack[vm->sp++] = a->data.pair.car;
+      VM_NEXT;
+    }
+    VM_CASE(OP_CDR) {
+      lizard_ast_node_t *a = vm->stack[--vm->sp];
+      if (a->type != AST_PAIR) {
+        return lizard_make_error(heap, LIZARD_ERROR_CDR_ARGT);
+      }
+      vm->stack[vm->sp++] = a->data.pair.cdr;
+      VM_NEXT;
+    }
+    VM_CASE(OP_JUMP)
+      vm->ip = instr.arg;
+      VM_NEXT;
+    VM_CASE(OP_JUMP_IF_FALSE) {
+      lizard_ast_node_t *a = vm->stack[--vm->sp];
+      if ((a->type == AST_BOOL && !a->data.boolean) ||
+          a->type == AST_NIL) {
+        vm->ip = instr.arg;
+      }
+      VM_NEXT;
+    }
+    VM_CASE(OP_JUMP_IF_TRUE) {
+      lizard_ast_node_t *a = vm->stack[--vm->sp];
+      if (!((a->type == AST_BOOL && !a->data.boolean) ||
+            a->type == AST_NIL)) {
+        vm->ip = instr.arg;
+      }
+      VM_NEXT;
+    }
+    VM_CASE(OP_JUMP_IF_FALSE_OR_POP) VM_CASE(OP_JUMP_IF_TRUE_OR_POP) {
+      lizard_ast_node_t *a = vm->stack[vm->sp - 1];
+      int falsy = (a->type == AST_BOOL && !a->data.boolean) ||
+                  a->type == AST_NIL;
+      if (falsy == (instr.op == OP_JUMP_IF_FALSE_OR_POP)) {
+        vm->ip = instr.arg;
+      } else {
+        vm->sp--;
+      }
+      VM_NEXT;
+    }
+    VM_CASE(OP_VECTOR_REF) VM_CASE(OP_VECTOR_SET) VM_CASE(OP_VECTOR_LENGTH)
+    VM_CASE(OP_STRING_REF) VM_CASE(OP_STRING_LENGTH) {
+      /* arg: the operand count */
+      lizard_ast_node_t *r = vm_access(instr.op, instr.arg,
+                                       &vm->stack[vm->sp - instr.arg],
+                                       vm->env, heap);
+      if (r->type == AST_ERROR) return r;
+      vm->sp -= instr.arg;
+      vm->stack[vm->sp++] = r;
+      VM_NEXT;
+    }
+    VM_CASE(OP_CLOSURE) {
+      /* Create a bytecode closure capturing the current env. */
+      lizard_bc_chunk_t *sub;
+      memcpy(&sub, &vm->chunk->constants[instr.arg]->data.string, sizeof(sub));
+      vm->stack[vm->sp++] = make_bc_closure(sub, vm, heap);
+      VM_NEXT;
+    }
+    VM_CASE(OP_CALL_PRIM) VM_CASE(OP_CALL) VM_CASE(OP_TAIL_CALL) VM_CASE(OP_CALLCC) {
+      int argc;
+      lizard_ast_node_t *fn;
+      lizard_ast_node_t **args_arr;
+      int i;
+      int is_tail;
+      if (instr.op == OP_CALL_PRIM) {
+        fn = lizard_env_lookup_site(vm->env, vm->chunk->constants[instr.arg]);
+        instr = vm->chunk->code[vm->ip++];
+        if (fn == NULL) {
+          return lizard_make_error(heap, LIZARD_ERROR_UNBOUND_SYMBOL);
+        }
+        if (fn->type == AST_PRIMITIVE) {
+          /* Straight from the stacked arguments; no callee slot to drop. */
+          lizard_ast_node_t *r = lizard_primitive_call(
+              fn, instr.arg, &vm->stack[vm->sp - instr.arg], vm->env, heap);
+          vm->sp -= instr.arg;
+          vm->stack[vm->sp++] = r;
+          VM_NEXT;
+        }
+        /* Bound to something else: slot it in below the arguments, as a
+         * plain call has it, and make the call that follows. */
+        for (i = 0; i < instr.arg; i++) {
+          vm->stack[vm->sp - i] = vm->stack[vm->sp - i - 1];
+        }
+        vm->stack[vm->sp++ - instr.arg] = fn;
+      }
+      argc = instr.arg;
+      is_tail = (instr.op == OP_TAIL_CALL);
+      if (instr.op == OP_CALLCC) {
+        /* Call the receiver on top of the stack with a continuation that,
+         * while the receiver runs, returns from here. */
+        lizard_ast_node_t *k = lizard_make_continuation(lizard_identity_cont, heap);
+        k->data.continuation.escape_id = lizard_escape_next_id(heap);
+        if (is_bc_closure(vm->stack[vm->sp - 1]) &&
+            !vm_push_escape(vm, k->data.continuation.escape_id)) {
+          return lizard_make_error(heap, LIZARD_ERROR_USER);
+        }
+        vm->stack[vm->sp++] = k;
+        argc = 1;
+      }
+      /* Callee and args stay on the stack, where the collector sees
+       * them, until they are bound. */
+      args_arr = &vm->stack[vm->sp - argc];
+      fn = vm->stack[vm->sp - argc - 1];
+
+      if (is_bc_closure(fn)) {
+        /* Execute bytecode closure: the arguments become its first frame
+         * slots where they are, below the slots its body defines. */
+        bc_closure_t *cl = bc_closure_of(fn);
+        if (argc < cl->chunk->arity ||
+            (argc > cl->chunk->arity && !cl->chunk->rest)) {
+          return lizard_make_error(heap, argc < cl->chunk->arity
+                                             ? LIZARD_ERROR_LAMBDA_ARITY_LESS
+                                             : LIZARD_ERROR_LAMBDA_ARITY_MORE);
+        }
+        if (cl->chunk->rest) {
+          /* The arguments past arity become a list in the rest slot. */
+          lizard_ast_node_t *xs = lizard_make_nil(heap);
+          for (; argc > cl->chunk->arity; argc--) {
+            xs = lizard_make_pair(heap, vm->stack[--vm->sp], xs);
+          }
+          vm->stack[vm->sp++] = xs;
+          argc++;
+        }
+        if (is_tail) {
+          /* TCO: slide callee and args over the current frame — no frame
+           * push, no stack growth. The VM loop restarts with the callee's
+           * chunk. */
+          memmove(&vm->stack[vm->base - 1], &vm->stack[vm->sp - argc - 1],
+                  (size_t)(argc + 1) * sizeof(lizard_ast_node_t *));
+          vm->sp = vm->base + argc;
+        } else if (!vm_push_frame(vm)) {
+          return lizard_make_error(heap, LIZARD_ERROR_USER);
+        } else {
+          vm->base = vm->sp - argc;
+        }
+        for (i = argc; i < cl->chunk->nlocals; i++) {
+          if (vm->sp == vm->stack_cap && !vm_grow_stack(vm)) {
+            return lizard_make_error(heap, LIZARD_ERROR_USER);
+          }
+          vm->stack[vm->sp++] = lizard_make_nil(heap);
+        }
+        vm->chunk = cl->chunk;
+        vm->env = cl->env;
+        vm->upvals = cl->upvals;
+        vm->ip = 0;
+        VM_NEXT;
+      } else if (fn->type == AST_PRIMITIVE) {
+        /* Call native primitive straight from the stacked arguments. */
+        lizard_ast_node_t *r =
+            lizard_primitive_call(fn, argc, args_arr, vm->env, heap);
+        vm->sp -= argc + 1;
+        vm->stack[vm->sp++] = r;
+      } else if (fn->type == AST_CONTINUATION) {
+        /* Unwind to its call/cc when that is live here; otherwise, as in
+         * the evaluator, the call just returns the value. */
+        lizard_ast_node_t *v = argc > 0 ? args_arr[0] : lizard_make_nil(heap);
+        if (!vm_escape(vm, fn, v)) {
+          vm->sp -= argc + 1;
+          vm->stack[vm->sp++] = v;
+        }
+      } else if (fn->type == AST_LAMBDA) {
+        /* A closure of the evaluator (the prelude's, say): apply it to a
+         * list of the arguments. */
+        lz_list_t *list = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+        lizard_ast_node_t *r;
+        for (i = 0; i < argc; i++) {
+          lizard_ast_list_node_t *cell =
+              lizard_heap_alloc(sizeof(lizard_ast_list_node_t));
+          cell->ast = args_arr[i];
+          list_append(list, &cell->node);
+        }
+        r = lizard_apply(fn, list, vm->env, heap, lizard_identity_cont);
+        vm->sp -= argc + 1;
+        vm->stack[vm->sp++] = r;
+      } else {
+        /* Unsupported callable — error. */
+        return lizard_make_error(heap, LIZARD_ERROR_INVALID_APPLY);
+      }
+      VM_NEXT;
+    }
+    VM_CASE(OP_RETURN) VM_CASE(OP_RETURN_LOCAL) {
+      lizard_vm_frame_t *f;
+      lizard_ast_node_t *r = instr.op == OP_RETURN
+                                 ? vm_frame_result(vm)
+                                 : vm->stack[vm->base + instr.arg];
+      if (vm->frame_count == 0) return r;
+      f = &vm->frames[--vm->frame_count];
+      /* A call/cc made in the frame returned to has returned too. */
+      while (vm->escape_count > 0 &&
+             vm->escapes[vm->escape_count - 1].frame_count >= vm->frame_count) {
+        vm->escape_count--;
+      }
+      vm->sp = vm->base - 1;  /* the callee's slots and the callee */
+      vm->chunk = f->chunk;
+      vm->ip = f->ip;
+      vm->base = f->base;
+      vm->env = f->env;
+      vm->upvals = f->upvals;
+      vm->stack[vm->sp++] = r;
+      VM_NEXT;
+    }
+    VM_CASE(OP_DISPLAY) {
+      lizard_ast_node_t *a = vm->stack[--vm->sp];
+      lizard_fprint_value(stdout, a);
+      vm->stack[vm->sp++] = a;
+      VM_NEXT;
+    }
+    VM_CASE(OP_NEWLINE)
+      printf("\n");
+      vm->stack[vm->sp++] = lizard_make_nil(heap);
+      VM_NEXT;
+    VM_CASE(OP_HALT)
+      return vm_frame_result(vm);
+    VM_CASE(OP_LOAD_LOCAL)
+      vm->stack[vm->sp++] = vm->stack[vm->base + instr.arg];
+      VM_NEXT;
+    VM_CASE(OP_STORE_LOCAL)
+      vm->stack[vm->base + instr.arg] = vm->stack[vm->sp - 1];
+      VM_NEXT;
+    VM_CASE(OP_LOAD_UPVAL)
+      vm->stack[vm->sp++] = vm->upvals[instr.arg];
+      VM_NEXT;
+    VM_CASE(OP_LOAD_UPVAL_UNBOX)
+      vm->stack[vm->sp++] = vm->upvals[instr.arg]->data.pair.car;
+      VM_NEXT;
+    VM_CASE(OP_STORE_LOCAL_POP)
+      vm->stack[vm->base + instr.arg] = vm->stack[--vm->sp];
+      VM_NEXT;
+    VM_CASE(OP_LOAD_LOCAL2)
+      vm->stack[vm->sp++] = vm->stack[vm->base + instr.arg];
+      vm->stack[vm->sp++] = vm->stack[vm->base + vm->chunk->code[vm->ip++].arg];
+      VM_NEXT;
+    VM_CASE(OP_LOAD_LOCAL_ADD_IMM) {
+      lizard_ast_node_t *a = vm->stack[vm->base + instr.arg];
+      long k = (long)vm->chunk->code[vm->ip++].arg;
+      long z;
+      if (LIZARD_IS_FIXNUM(a) && lizard_fixnum_add(LIZARD_FIXNUM_VALUE(a), k, &z)) {
+        vm->stack[vm->sp++] = lizard_make_fixnum(heap, z);
+      } else {
+        lizard_ast_node_t *r =
+            vm_arith(OP_ADD, a, lizard_make_fixnum(heap, k), vm->env, heap);
+        if (r->type == AST_ERROR) return r;
+        vm->stack[vm->sp++] = r;
+      }
+      VM_NEXT;
+    }
+    VM_CASE(OP_BOX) {
+      /* A box is a pair only the VM sees: the value in its car. */
+      vm->stack[vm->sp - 1] =
+          lizard_make_pair(heap, vm->stack[vm->sp - 1], lizard_make_nil(heap));
+      VM_NEXT;
+    }
+    VM_CASE(OP_UNBOX)
+      vm->stack[vm->sp - 1] = vm->stack[vm->sp - 1]->data.pair.car;
+      VM_NEXT;
+    VM_CASE(OP_SET_BOX) {
+      lizard_ast_node_t *box = vm->stack[--vm->sp];
+      box->data.pair.car = vm->stack[vm->sp - 1];
+      lizard_gc_write_barrier(&box->data.pair.car);
+      VM_NEXT;
+    }
+#ifdef LIZARD_VM_THREADED
+  }
+#else
+    }
+  }
+#endif
+}
+
+#undef VM_PROFILE_STEP
+#undef VM_FETCH
+#undef VM_CASE
+#undef VM_NEXT
@@ -0,0 +1,276 @@
+/* src/bytecode_profile.c — per-function totals of a profiled VM run.
+ *
+ * The profiled loop hands every instruction to lizard_vm_profile_track
+ * before running it.  That keeps a shadow of the frames: one activation
+ * per frame of the running VMs, outermost first, each naming the chunk
+ * that runs in it.  A frame that appeared since the last instruction is
+ * entered, one that went is left.  Return, tail call and escape are all
+ * seen the same way, as a change of frames, and nothing in the
+ * instruction bodies knows about the profiler.
+ *
+ * Self time is charged to the innermost activation whenever one is
+ * entered or left, so the clock is read per call, not per instruction.
+ * Each activation also sits on a node of a tree of call paths, which
+ * lizard_vm_profile_write_collapsed prints for flame graphs.
+ */
+#include "bytecode.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* `items`, or it grown, with room for item `count` of `size` bytes; NULL
+ * when out of memory, `items` left as it is. */
+static void *room(void *items, int *cap, int count, size_t size) {
+  int n;
+  void *grown;
+  if (count < *cap) return items;
+  n = *cap > 0 ? *cap * 2 : 16;
+  grown = realloc(items, (size_t)n * size);
+  if (grown != NULL) *cap = n;
+  return grown;
+}
+
+/* What tells the function of `chunk` apart; see lizard_vm_fn_profile_t. */
+static const void *fn_key(const lizard_bc_chunk_t *chunk) {
+  if (chunk->span.start_line == 0 && chunk->name != NULL) return chunk->name;
+  return chunk;
+}
+
+static size_t key_hash(const void *key, int cap) {
+  return ((size_t)key >> 4) & (size_t)(cap - 1);
+}
+
+/* Rebuild the hash of chunks at twice the size. */
+static int rehash(lizard_vm_profile_t *p) {
+  int cap = p->fn_slot_cap > 0 ? p->fn_slot_cap * 2 : 64;
+  int *slots = (int *)malloc((size_t)cap * sizeof(int));
+  int i;
+  if (slots == NULL) return -1;
+  for (i = 0; i < cap; i++) slots[i] = -1;
+  for (i = 0; i < p->fn_count; i++) {
+    size_t h = key_hash(p->fns[i].key, cap);
+    while (slots[h] >= 0) h = (h + 1) & (size_t)(cap - 1);
+    slots[h] = i;
+  }
+  free(p->fn_slots);
+  p->fn_slots = slots;
+  p->fn_slot_cap = cap;
+  return 0;
+}
+
+/* The index in fns of the function of `chunk`, added if new; -1 when out
+ * of memory. */
+static int fn_index(lizard_vm_profile_t *p, lizard_bc_chunk_t *chunk) {
+  lizard_vm_fn_profile_t *f;
+  const void *key = fn_key(chunk);
+  void *m;
+  size_t h;
+  if (2 * (p->fn_count + 1) > p->fn_slot_cap && rehash(p) < 0) return -1;
+  h = key_hash(key, p->fn_slot_cap);
+  while (p->fn_slots[h] >= 0) {
+    if (p->fns[p->fn_slots[h]].key == key) return p->fn_slots[h];
+    h = (h + 1) & (size_t)(p->fn_slot_cap - 1);
+  }
+  m = room(p->fns, &p->fn_cap, p->fn_count, sizeof(*p->fns));
+  if (m == NULL) return -1;
+  p->fns = (lizard_vm_fn_profile_t *)m;
+  f = &p->fns[p->fn_count];
+  memset(f, 0, sizeof(*f));
+  f->key = key;
+  f->name = chunk->name;
+  f->span = chunk->span;
+  p->fn_slots[h] = p->fn_count;
+  return p->fn_count++;
+}
+
+/* The node of the path `parent` (-1: none) then `fn`, added if new; -1
+ * when out of memory. */
+static int path_node(lizard_vm_profile_t *p, int parent, int fn) {
+  lizard_vm_stack_node_t *n;
+  void *m;
+  int i;
+  if (parent >= 0) {
+    for (i = p->nodes[parent].first_child; i >= 0; i = p->nodes[i].next_sibling) {
+      if (p->nodes[i].fn == fn) return i;
+    }
+  } else {
+    for (i = 0; i < p->node_count; i++) {
+      if (p->nodes[i].parent < 0 && p->nodes[i].fn == fn) return i;
+    }
+  }
+  m = room(p->nodes, &p->node_cap, p->node_count, sizeof(*p->nodes));
+  if (m == NULL) return -1;
+  p->nodes = (lizard_vm_stack_node_t *)m;
+  n = &p->nodes[p->node_count];
+  n->fn = fn;
+  n->parent = parent;
+  n->first_child = -1;
+  n->next_sibling = -1;
+  n->self_instructions = 0;
+  if (parent >= 0) {
+    n->next_sibling = p->nodes[parent].first_child;
+    p->nodes[parent].first_child = p->node_count;
+  }
+  return p->node_count++;
+}
+
+/* Charge the time since the last charge to the innermost activation. */
+static void charge(lizard_vm_profile_t *p) {
+  clock_t now = clock();
+  if (p->depth > 0) {
+    p->fns[p->stack[p->depth - 1].fn].self_seconds +=
+        (double)(now - p->mark) / (double)CLOCKS_PER_SEC;
+  }
+  p->mark = now;
+}
+
+/* Push an activation of `chunk`; -1 when out of memory. */
+static int enter(lizard_vm_profile_t *p, lizard_bc_chunk_t *chunk) {
+  lizard_vm_activation_t *top = p->depth > 0 ? &p->stack[p->depth - 1] : NULL;
+  lizard_vm_fn_profile_t *f;
+  int fn = fn_index(p, chunk);
+  int node;
+  void *m;
+  if (fn < 0) return -1;
+  /* Direct recursion stays on its caller's path. */
+  node = top != NULL && top->fn == fn ? top->node
+                                      : path_node(p, top != NULL ? top->node : -1, fn);
+  if (node < 0) return -1;
+  m = room(p->stack, &p->depth_cap, p->depth, sizeof(*p->stack));
+  if (m == NULL) return -1;
+  p->stack = (lizard_vm_activation_t *)m;
+  charge(p);
+  f = &p->fns[fn];
+  if (f->active++ == 0) {
+    f->entered_at = p->total_instructions;
+    f->entered_clock = p->mark;
+  }
+  p->stack[p->depth].fn = fn;
+  p->stack[p->depth].node = node;
+  p->depth++;
+  return 0;
+}
+
+/* Pop the innermost activation. */
+static void leave(lizard_vm_profile_t *p) {
+  lizard_vm_fn_profile_t *f;
+  charge(p);
+  f = &p->fns[p->stack[--p->depth].fn];
+  if (--f->active == 0) {
+    f->inclusive_instructions += p->total_instructions - f->entered_at;
+    f->inclusive_seconds +=
+        (double)(p->mark - f->entered_clock) / (double)CLOCKS_PER_SEC;
+  }
+}
+
+void lizard_vm_profile_track(lizard_vm_t *vm) {
+  lizard_vm_profile_t *p = vm->profile;
+  int want = vm->profile_depth + vm->frame_count + 1;
+  lizard_vm_activation_t *top;
+  while (p->depth > want) leave(p);
+  if (p->depth == want && p->fns[p->stack[want - 1].fn].key != fn_key(vm->chunk)) {
+    leave(p);
+  }
+  while (p->depth < want - 1) {
+    if (enter(p, vm->frames[p->depth - vm->profile_depth].chunk) < 0) return;
+  }
+  if (p->depth < want && enter(p, vm->chunk) < 0) return;
+  top = &p->stack[want - 1];
+  if (vm->ip == 1) p->fns[top->fn].calls++;
+  p->fns[top->fn].self_instructions++;
+  p->nodes[top->node].self_instructions++;
+}
+
+void lizard_vm_profile_leave(lizard_vm_profile_t *profile, int depth) {
+  while (profile->depth > depth) leave(profile);
+}
+
+/* ---- output ---- */
+
+/* A chunk by name, or an anonymous lambda by where it starts. */
+static void put_label(FILE *out, const lizard_vm_fn_profile_t *f) {
+  if (f->name != NULL) {
+    fputs(f->name, out);
+  } else if (f->span.start_line > 0) {
+    fprintf(out, "lambda@%d:%d", f->span.start_line, f->span.start_column);
+  } else {
+    fputs("<lambda>", out);
+  }
+}
+
+/* Most self instructions first, then in the order first entered. */
+static int by_self(const void *a, const void *b) {
+  const lizard_vm_fn_profile_t *x = *(const lizard_vm_fn_profile_t *const *)a;
+  const lizard_vm_fn_profile_t *y = *(const lizard_vm_fn_profile_t *const *)b;
+  if (x->self_instructions != y->self_instructions) {
+    return x->self_instructions > y->self_instructions ? -1 : 1;
+  }
+  return x < y ? -1 : x > y;
+}
+
+void lizard_vm_profile_report(FILE *out, const lizard_vm_profile_t *profile,
+                              int limit) {
+  const lizard_vm_fn_profile_t **order;
+  int i, n = profile->fn_count;
+  if (n == 0) return;
+  order = (const lizard_vm_fn_profile_t **)malloc((size_t)n * sizeof(*order));
+  if (order == NULL) return;
+  for (i = 0; i < n; i++) order[i] = &profile->fns[i];
+  qsort((void *)order, (size_t)n, sizeof(*order), by_self);
+  if (limit > 0 && limit < n) n = limit;
+  fprintf(out, "    %6s %10s %10s %8s %10s %10s  %s\n", "self%", "self",
+          "inclusive", "calls", "self s", "incl s", "function");
+  for (i = 0; i < n; i++) {
+    const lizard_vm_fn_profile_t *f = order[i];
+    fprintf(out, "    %5.1f%% %10lu %10lu %8lu %10.6f %10.6f  ",
+            profile->total_instructions > 0
+                ? 100.0 * (double)f->self_instructions /
+                      (double)profile->total_instructions
+                : 0.0,
+            (unsigned long)f->self_instructions,
+            (unsigned long)f->inclusive_instructions, (unsigned long)f->calls,
+            f->self_seconds, f->inclusive_seconds);
+    put_label(out, f);
+    if (f->name != NULL && f->span.start_line > 0) {
+      fprintf(out, "  %s%s%d:%d", f->span.filename != NULL ? f->span.filename : "",
+              f->span.filename != NULL ? ":" : "", f->span.start_line,
+              f->span.start_column);
+    }
+    fputc('\n', out);
+  }
+  free((void *)order);
+}
+
+int lizard_vm_profile_write_collapsed(FILE *out,
+                                      const lizard_vm_profile_t *profile) {
+  int *path;
+  int i, len, k;
+  if (profile->node_count == 0) return 0;
+  path = (int *)malloc((size_t)profile->node_count * sizeof(int));
+  if (path == NULL) return -1;
+  for (i = 0; i < profile->node_count; i++) {
+    if (profile->nodes[i].self_instructions == 0) continue;
+    len = 0;
+    for (k = i; k >= 0; k = profile->nodes[k].parent) path[len++] = k;
+    while (len-- > 0) {
+      put_label(out, &profile->fns[profile->nodes[path[len]].fn]);
+      fputc(len > 0 ? ';' : ' ', out);
+    }
+    fprintf(out, "%lu\n", (unsigned long)profile->nodes[i].self_instructions);
+  }
+  free(path);
+  return ferror(out) ? -1 : 0;
+}
+
+void lizard_vm_profile_free(lizard_vm_profile_t *profile) {
+  free(profile->fns);
+  free(profile->fn_slots);
+  free(profile->nodes);
+  free(profile->stack);
+  profile->fns = NULL;
+  profile->fn_slots = NULL;
+  profile->nodes = NULL;
+  profile->stack = NULL;
+  profile->fn_count = profile->fn_cap = profile->fn_slot_cap = 0;
+  profile->node_count = profile->node_cap = 0;
+  profile->depth = profile->depth_cap = 0;
+}
@@ -108,6 +108,8 @@
   X(LIZARD_ERROR_LOAD_ARGT, "Error: 'load' expects a string path.")            \
   X(LIZARD_ERROR_LOAD_OPEN, "Error: 'load' could not open file.")              \
   X(LIZARD_ERROR_LOAD_READ, "Error: 'load' failed reading file.")              \
+  X(LIZARD_ERROR_LOAD_WRITE, "Error: could not write the compiled file.")      \
+  X(LIZARD_ERROR_GC_ARGT, "Error: 'gc' expects 'full or 'minor.")              \
   X(LIZARD_ERROR_USER, "Error: user-raised")
 
 #define LIZARD_ERROR_MESSAGES                                                  \
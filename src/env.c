@@ -1,49 +1,303 @@
 #include "env.h"
+#include "gc.h"
+#include "lexical.h"
 #include "lizard_internal.h"
 #include "mem.h"
+#include "symbol.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#define LIZARD_ENV_INDEX_THRESHOLD 16U
+
+/* Bumped whenever a new binding appears in a frame global reference caches
+ * may look through (env_frame_stable), so a cached cell is stale as soon as
+ * a name could resolve elsewhere.  Redefinitions and set! write through the
+ * existing cell and leave it alone.  Never 0, which marks an empty cache. */
+static unsigned long env_epoch = 1UL;
 
 lizard_env_t *lizard_env_create(lizard_heap_t *heap, lizard_env_t *parent) {
   lizard_env_t *env = lizard_heap_alloc(sizeof(lizard_env_t));
   env->entries = NULL;
   env->parent = parent;
+  env->layout = NULL;
+  env->slots = NULL;
+  env->index = NULL;
+  env->index_cap = 0U;
+  env->count = 0U;
+  return env;
+}
+
+lizard_env_t *lizard_env_create_frame(lizard_heap_t *heap,
+                                      lizard_env_t *parent,
+                                      const lizard_frame_layout_t *layout) {
+  /* One object: the env header followed by its slot vector. */
+  size_t size = sizeof(lizard_env_t) + layout->nslots * sizeof(lizard_ast_node_t *);
+  lizard_env_t *env = lizard_heap_alloc_tagged(
+      size, LIZARD_GC_OBJECT_ENV, LIZARD_OBJECT_TRACE_ENV);
+  env->entries = NULL;
+  env->parent = parent;
+  env->layout = layout;
+  env->index = NULL;
+  env->index_cap = 0U;
+  env->count = 0U;
+  env->slots = (lizard_ast_node_t **)(void *)(env + 1);
+  memset(env->slots, 0, layout->nslots * sizeof(lizard_ast_node_t *));
   return env;
 }
 
+static size_t env_hash(const char *symbol, size_t mask) {
+  return (((size_t)(const void *)symbol >> 4) * 2654435761U) & mask;
+}
+
+/* Slot of `symbol` in an indexed frame: its entry, or the empty slot where it
+ * would go. */
+static lizard_env_entry_t **env_index_probe(const lizard_env_t *env,
+                                            const char *symbol) {
+  size_t mask = env->index_cap - 1U;
+  size_t i = env_hash(symbol, mask);
+  while (env->index[i] != NULL && env->index[i]->symbol != symbol) {
+    i = (i + 1U) & mask;
+  }
+  return &env->index[i];
+}
+
+/* (Re)build the index at twice the entry count.  Entries are newest first,
+ * so the first one seen for a name is the visible binding. */
+static void env_index_rebuild(lizard_env_t *env) {
+  lizard_env_entry_t *entry;
+  size_t cap = 32U;
+  while (cap < env->count * 2U) {
+    cap *= 2U;
+  }
+  env->index = lizard_heap_alloc(cap * sizeof(lizard_env_entry_t *));
+  env->index_cap = cap;
+  for (entry = env->entries; entry != NULL; entry = entry->next) {
+    lizard_env_entry_t **slot = env_index_probe(env, entry->symbol);
+    if (*slot == NULL) {
+      *slot = entry;
+    }
+  }
+  lizard_gc_write_barrier(&env->index);
+}
+
 void lizard_env_define(lizard_heap_t *heap, lizard_env_t *env,
                        const char *symbol, lizard_ast_node_t *value) {
-  lizard_env_entry_t *entry = lizard_heap_alloc(sizeof(lizard_env_entry_t));
+  lizard_env_entry_t *entry;
+  lizard_env_entry_t **slot = NULL;
+  symbol = lizard_intern(symbol);
+  if (env->layout != NULL) {
+    size_t i;
+    for (i = 0; i < env->layout->nslots; i++) {
+      if (env->layout->names[i] == symbol) {
+        env->slots[i] = value;
+        lizard_gc_write_barrier(&env->slots[i]);
+        return;
+      }
+    }
+  }
+  if (env->index != NULL) {
+    slot = env_index_probe(env, symbol);
+    if (*slot != NULL) {
+      /* Redefinition: update the visible binding in place. */
+      (*slot)->value = value;
+      lizard_gc_write_barrier(&(*slot)->value);
+      return;
+    }
+  }
+  entry = lizard_heap_alloc(sizeof(lizard_env_entry_t));
   entry->symbol = symbol;
   entry->value = value;
   entry->next = env->entries;
   env->entries = entry;
+  lizard_gc_write_barrier(&env->entries);
+  env->count++;
+  if (slot != NULL && env->count * 2U <= env->index_cap) {
+    *slot = entry;
+    lizard_gc_write_barrier(slot);
+  } else if (env->count >= LIZARD_ENV_INDEX_THRESHOLD) {
+    env_index_rebuild(env);
+  }
+  if (env->parent == NULL || env->index != NULL || env->layout != NULL) {
+    env_epoch++;
+  }
 }
 
-lizard_ast_node_t *lizard_env_lookup(lizard_env_t *env, const char *symbol) {
+/* Entry and slot names are always interned (lizard_env_define, the
+ * resolver), so a binding is found by pointer comparison alone when the
+ * caller passes an interned name, as the reader and the evaluators do.  Any
+ * other spelling of the name is canonicalised once and the chain walked
+ * again; a name that was never interned can only match an entry whose
+ * interning failed, which is handled by the strcmp walk.  A slot that has not
+ * been assigned yet (an internal define still to run) is skipped, so the name
+ * falls through to the enclosing frames as it did before frames had slots. */
+static lizard_ast_node_t **env_find_ptr(lizard_env_t *env, const char *symbol) {
   lizard_env_t *e;
   lizard_env_entry_t *entry;
   for (e = env; e != NULL; e = e->parent) {
+    if (e->layout != NULL) {
+      size_t i;
+      for (i = 0; i < e->layout->nslots; i++) {
+        if (e->layout->names[i] == symbol && e->slots[i] != NULL) {
+          return &e->slots[i];
+        }
+      }
+    }
+    if (e->index != NULL) {
+      entry = *env_index_probe(e, symbol);
+      if (entry != NULL) {
+        return &entry->value;
+      }
+      continue;
+    }
     for (entry = e->entries; entry != NULL; entry = entry->next) {
-      if (strcmp(entry->symbol, symbol) == 0) {
-        return entry->value;
+      if (entry->symbol == symbol) {
+        return &entry->value;
       }
     }
   }
   return NULL;
 }
 
-int lizard_env_set(lizard_env_t *env, const char *symbol,
-                   lizard_ast_node_t *value) {
+static lizard_ast_node_t **env_find_str(lizard_env_t *env, const char *symbol) {
   lizard_env_t *e;
   lizard_env_entry_t *entry;
   for (e = env; e != NULL; e = e->parent) {
+    if (e->layout != NULL) {
+      size_t i;
+      for (i = 0; i < e->layout->nslots; i++) {
+        if (e->slots[i] != NULL && strcmp(e->layout->names[i], symbol) == 0) {
+          return &e->slots[i];
+        }
+      }
+    }
     for (entry = e->entries; entry != NULL; entry = entry->next) {
       if (strcmp(entry->symbol, symbol) == 0) {
-        entry->value = value;
-        return 1;
+        return &entry->value;
+      }
+    }
+  }
+  return NULL;
+}
+
+static lizard_ast_node_t **env_find(lizard_env_t *env, const char *symbol) {
+  lizard_ast_node_t **cell = env_find_ptr(env, symbol);
+  const char *canonical;
+  if (cell != NULL) {
+    return cell;
+  }
+  canonical = lizard_symbol_find(symbol);
+  if (canonical == symbol) {
+    return NULL;
+  }
+  if (canonical != NULL) {
+    return env_find_ptr(env, canonical);
+  }
+  return env_find_str(env, symbol);
+}
+
+lizard_ast_node_t *lizard_env_lookup(lizard_env_t *env, const char *symbol) {
+  lizard_ast_node_t **cell = env_find(env, symbol);
+  return cell != NULL ? *cell : NULL;
+}
+
+/* Whether a new binding of interned `symbol` in `e` would bump the epoch:
+ * a root or indexed frame, or a slot frame whose layout does not name it
+ * (a name it does is filled in without a new entry). */
+static int env_frame_stable(const lizard_env_t *e, const char *symbol) {
+  if (e->layout != NULL) {
+    size_t i;
+    for (i = 0; i < e->layout->nslots; i++) {
+      if (e->layout->names[i] == symbol) {
+        return 0;
+      }
+    }
+    return 1;
+  }
+  return e->parent == NULL || e->index != NULL;
+}
+
+/* Whether a cached path may pass through `e`: a frame that has grown
+ * by-name entries is trusted only when it is a by-name indexed one. */
+static int env_frame_passable(const lizard_env_t *e) {
+  return e->entries == NULL || (e->index != NULL && e->layout == NULL);
+}
+
+/* Binding of interned `symbol` in `e` alone, as env_find_ptr sees it. */
+static lizard_ast_node_t **env_frame_find(lizard_env_t *e, const char *symbol) {
+  lizard_env_entry_t *entry;
+  if (e->layout != NULL) {
+    size_t i;
+    for (i = 0; i < e->layout->nslots; i++) {
+      if (e->layout->names[i] == symbol && e->slots[i] != NULL) {
+        return &e->slots[i];
+      }
+    }
+  }
+  if (e->index != NULL) {
+    entry = *env_index_probe(e, symbol);
+    return entry != NULL ? &entry->value : NULL;
+  }
+  for (entry = e->entries; entry != NULL; entry = entry->next) {
+    if (entry->symbol == symbol) {
+      return &entry->value;
+    }
+  }
+  return NULL;
+}
+
+/* A hit costs the epoch compare and `depth` parent loads.  The innermost
+ * layout pins which lambdas the frames on the way belong to, and each of
+ * them is checked to be passable.  Only a binding in a root or indexed
+ * by-name frame, reached through stable frames, is cached: those are the
+ * frames a new binding bumps the epoch for.  A name that is not interned
+ * finds nothing by pointer and goes the lizard_env_lookup way. */
+lizard_ast_node_t *lizard_env_lookup_site(lizard_env_t *env,
+                                          lizard_ast_node_t *site) {
+  const char *name = site->data.global_ref.name;
+  lizard_env_t *e = env;
+  unsigned int depth;
+  int stable = 1;
+  if (site->data.global_ref.epoch == env_epoch &&
+      env->layout == site->data.global_ref.layout) {
+    for (depth = 0; depth < site->data.global_ref.depth; depth++) {
+      if (!env_frame_passable(e)) {
+        break;
       }
+      e = e->parent;
     }
+    if (depth == site->data.global_ref.depth &&
+        e == site->data.global_ref.home) {
+      return *site->data.global_ref.cell;
+    }
+  }
+  for (e = env, depth = 0; e != NULL; e = e->parent, depth++) {
+    lizard_ast_node_t **cell = env_frame_find(e, name);
+    if (cell != NULL) {
+      if (stable && e->layout == NULL && env_frame_stable(e, name)) {
+        site->data.global_ref.epoch = env_epoch;
+        site->data.global_ref.depth = depth;
+        site->data.global_ref.layout = env->layout;
+        site->data.global_ref.home = e;
+        site->data.global_ref.cell = cell;
+        lizard_gc_write_barrier(&site->data.global_ref.layout);
+        lizard_gc_write_barrier(&site->data.global_ref.home);
+        lizard_gc_write_barrier(&site->data.global_ref.cell);
+      }
+      return *cell;
+    }
+    stable = stable && env_frame_passable(e) && env_frame_stable(e, name);
+  }
+  return lizard_env_lookup(env, name);
+}
+
+int lizard_env_set(lizard_env_t *env, const char *symbol,
+                   lizard_ast_node_t *value) {
+  lizard_ast_node_t **cell = env_find(env, symbol);
+  if (cell == NULL) {
+    return 0;
   }
-  return 0;
+  *cell = value;
+  lizard_gc_write_barrier(cell);
+  return 1;
 }
@@ -6,9 +6,17 @@
 #include <stdlib.h>
 
 lizard_env_t *lizard_env_create(lizard_heap_t *heap, lizard_env_t *parent);
+/* Slot frame for a resolved lambda (see lexical.h); slots start unbound. */
+lizard_env_t *lizard_env_create_frame(lizard_heap_t *heap,
+                                      lizard_env_t *parent,
+                                      const lizard_frame_layout_t *layout);
 void lizard_env_define(lizard_heap_t *heap, lizard_env_t *env,
                        const char *symbol, lizard_ast_node_t *value);
 lizard_ast_node_t *lizard_env_lookup(lizard_env_t *env, const char *symbol);
+/* lizard_env_lookup of `site`'s name through the site's inline cache (the
+ * global_ref member); `site` is an AST_SYMBOL or an AST_STRING name. */
+lizard_ast_node_t *lizard_env_lookup_site(lizard_env_t *env,
+                                          lizard_ast_node_t *site);
 int lizard_env_set(lizard_env_t *env, const char *symbol,
                    lizard_ast_node_t *value);
 
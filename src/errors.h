@@ -85,6 +85,8 @@
   X(LIZARD_ERROR_LOAD_ARGT)                                                    \
   X(LIZARD_ERROR_LOAD_OPEN)                                                    \
   X(LIZARD_ERROR_LOAD_READ)                                                    \
+  X(LIZARD_ERROR_LOAD_WRITE)                                                   \
+  X(LIZARD_ERROR_GC_ARGT)                                                      \
   X(LIZARD_ERROR_USER)
 
 typedef enum lizard_error_code {
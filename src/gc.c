@@ -4,8 +4,10 @@
  * type pattern used throughout the codebase.
  */
 #include "gc.h"
+#include "bytecode.h"
 #include "pvector.h"
 #include "env.h"
+#include "lexical.h"
 #include "mem.h"
 #include "runtime.h"
 #include <stdlib.h>
@@ -13,11 +15,32 @@
 
 /* ---- mark traversal ---- */
 
+/* Every node the current mark pass has marked.  The heap interleaves nodes
+ * with frames, list cells and strings, so it cannot be walked as an array
+ * of nodes; marks are counted and cleared through this log instead.  When
+ * it cannot grow, marks past its end stay set and only the counts suffer. */
+static lizard_ast_node_t **gc_marked = NULL;
+static size_t gc_marked_count = 0U;
+static size_t gc_marked_cap = 0U;
+
+static void gc_marked_push(lizard_ast_node_t *node) {
+  if (gc_marked_count == gc_marked_cap) {
+    size_t cap = gc_marked_cap ? gc_marked_cap * 2U : 1024U;
+    lizard_ast_node_t **grown =
+        realloc(gc_marked, cap * sizeof(lizard_ast_node_t *));
+    if (grown == NULL) return;
+    gc_marked = grown;
+    gc_marked_cap = cap;
+  }
+  gc_marked[gc_marked_count++] = node;
+}
+
 void lizard_gc_mark_node(lizard_ast_node_t *node) {
   lz_list_node_t *iter;
   if (node == NULL) return;
   if (node->gc_mark) return;
   node->gc_mark = 1;
+  gc_marked_push(node);
 
   switch (node->type) {
   /* Leaf nodes. */
@@ -41,6 +64,7 @@ void lizard_gc_mark_node(lizard_ast_node_t *node) {
   case AST_TT_TT:
   case AST_PRIMITIVE:
   case AST_CONTINUATION:
+  case AST_LOCAL_REF:
     break;
 
   /* Bare pointer (no struct wrapper). */
@@ -78,9 +102,13 @@ void lizard_gc_mark_node(lizard_ast_node_t *node) {
     lizard_gc_mark_node(node->data.if_clause.alt);
     break;
 
+  case AST_MACRO:
+    lizard_gc_mark_node(node->data.macro_def.variable);
+    lizard_gc_mark_node(node->data.macro_def.transformer);
+    break;
+
   /* Lambda: parameters list + closure env. */
   case AST_LAMBDA:
-  case AST_MACRO:
     if (node->data.lambda.parameters != NULL) {
       for (iter = node->data.lambda.parameters->head;
            iter != node->data.lambda.parameters->nil;
@@ -90,6 +118,23 @@ void lizard_gc_mark_node(lizard_ast_node_t *node) {
     }
     /* Mark the captured closure environment. */
     lizard_gc_mark_env(node->data.lambda.closure_env);
+    /* And the resolved body the evaluator runs instead of the source one. */
+    if (node->data.lambda.layout != NULL &&
+        node->data.lambda.layout->body != NULL) {
+      for (iter = node->data.lambda.layout->body->head;
+           iter != node->data.lambda.layout->body->nil;
+           iter = iter->next) {
+        lizard_gc_mark_node(((lizard_ast_list_node_t *)iter)->ast);
+      }
+    }
+    /* And the references a flat closure copies its captures through. */
+    if (node->data.lambda.layout != NULL &&
+        node->data.lambda.layout->captures != NULL) {
+      size_t j;
+      for (j = 0; j < node->data.lambda.layout->captures->nslots; j++) {
+        lizard_gc_mark_node(node->data.lambda.layout->captured_from[j]);
+      }
+    }
     break;
 
   /* List-only nodes. */
@@ -347,10 +392,16 @@ void lizard_gc_mark_node(lizard_ast_node_t *node) {
 
 void lizard_gc_mark_env(lizard_env_t *env) {
   lizard_env_entry_t *entry;
+  size_t i;
   while (env != NULL) {
     for (entry = env->entries; entry != NULL; entry = entry->next) {
       lizard_gc_mark_node(entry->value);
     }
+    if (env->layout != NULL) {
+      for (i = 0; i < env->layout->nslots; i++) {
+        lizard_gc_mark_node(env->slots[i]);
+      }
+    }
     env = env->parent;
   }
 }
@@ -364,7 +415,7 @@ static void walk_heap_nodes(lizard_heap_t *h,
     char *ptr = seg->start;
     while (ptr + sizeof(lizard_ast_node_t) <= seg->top) {
       lizard_ast_node_t *node = (lizard_ast_node_t *)ptr;
-      if (node->type >= AST_NIL && node->type <= AST_HAMT) {
+      if (node->type >= AST_NIL && node->type <= AST_LOCAL_REF) {
         fn(node);
       }
       ptr += sizeof(lizard_ast_node_t);
@@ -372,23 +423,18 @@ static void walk_heap_nodes(lizard_heap_t *h,
   }
 }
 
-static void clear_mark_fn(lizard_ast_node_t *node) {
-  node->gc_mark = 0;
-}
-
 void lizard_gc_clear_marks(lizard_heap_t *h) {
-  walk_heap_nodes(h, clear_mark_fn);
-}
-
-static size_t gc_count;
-static void count_marked_fn(lizard_ast_node_t *node) {
-  if (node->gc_mark) gc_count++;
+  size_t i;
+  (void)h;
+  for (i = 0; i < gc_marked_count; i++) {
+    gc_marked[i]->gc_mark = 0;
+  }
+  gc_marked_count = 0U;
 }
 
 size_t lizard_gc_count_marked(lizard_heap_t *h) {
-  gc_count = 0;
-  walk_heap_nodes(h, count_marked_fn);
-  return gc_count;
+  (void)h;
+  return gc_marked_count;
 }
 
 static size_t gc_total;
@@ -413,6 +459,7 @@ void lizard_gc_collect_stats(lizard_heap_t *h, lizard_env_t *env,
     out->total_segments++;
     out->total_bytes_allocated += (size_t)(seg->top - seg->start);
   }
+  out->total_bytes_allocated += h->large_bytes;
   out->nodes_total = count_total_nodes(h);
   if (do_mark && env != NULL) {
     lizard_gc_clear_marks(h);
@@ -425,7 +472,12 @@ void lizard_gc_collect_stats(lizard_heap_t *h, lizard_env_t *env,
       }
     }
     out->nodes_marked = lizard_gc_count_marked(h);
-    out->nodes_garbage = out->nodes_total - out->nodes_marked;
+    out->nodes_garbage = out->nodes_total > out->nodes_marked
+                             ? out->nodes_total - out->nodes_marked
+                             : 0U;
+    /* Nodes may be reclaimed before the next pass; no mark outlives this
+     * one. */
+    lizard_gc_clear_marks(h);
   }
 }
 
@@ -433,19 +485,17 @@ void lizard_gc_collect_stats(lizard_heap_t *h, lizard_env_t *env,
 
 /* Check if a segment has any marked (live) AST nodes. */
 static int segment_has_live(lizard_heap_segment_t *seg) {
-  char *ptr = seg->start;
-  while (ptr + sizeof(lizard_ast_node_t) <= seg->top) {
-    lizard_ast_node_t *node = (lizard_ast_node_t *)ptr;
-    if (node->type >= AST_NIL && node->type <= AST_HAMT) {
-      if (node->gc_mark) return 1;
-    }
-    ptr += sizeof(lizard_ast_node_t);
+  size_t i;
+  for (i = 0; i < gc_marked_count; i++) {
+    char *p = (char *)gc_marked[i];
+    if (p >= seg->start && p < seg->top) return 1;
   }
   return 0;
 }
 
 size_t lizard_gc_collect(lizard_heap_t *h, lizard_env_t *env) {
   lizard_heap_segment_t *seg, *prev, *next;
+  lizard_heap_segment_t *dead = NULL;
   size_t freed = 0;
 
   /* Phase 1: mark from roots. */
@@ -486,8 +536,8 @@ size_t lizard_gc_collect(lizard_heap_t *h, lizard_env_t *env) {
       } else {
         h->head = next;
       }
-      free(seg->start);
-      free(seg);
+      seg->next = dead;
+      dead = seg;
       /* Don't advance prev — it stays the same. */
       seg = next;
     } else {
@@ -495,6 +545,15 @@ size_t lizard_gc_collect(lizard_heap_t *h, lizard_env_t *env) {
       seg = next;
     }
   }
+
+  /* Clear the marks while every marked node is still mapped. */
+  lizard_gc_clear_marks(h);
+  while (dead != NULL) {
+    next = dead->next;
+    free(dead->start);
+    free(dead);
+    dead = next;
+  }
   return freed;
 }
 
@@ -519,17 +578,30 @@ int lizard_gc_metadata_lookup_object(
 }
 
 /* ===================================================================
- * Phase 5 — per-object, non-moving, fully-conservative mark & sweep.
+ * Phase 5 — per-object, non-moving mark & sweep.
  *
  * Roots are discovered conservatively from the C stack, the spilled
  * registers, and the program's data/BSS segment; the runtime's env and
  * module results are additionally marked explicitly as insurance.  Live
- * objects are traced by scanning their own bytes for anything that looks
- * like a pointer into a tracked object.  Because the collector never
+ * objects are traced by their trace policy: an AST node by its type, an
+ * env by its fields, a kernel term by the tracer registered for it, and
+ * atomic memory (string bytes, GMP limbs) not at all.  Only an object
+ * whose allocator did not say what it is -- its kind was inferred from
+ * its size -- has its bytes scanned for anything that looks like a
+ * pointer, as every object was before.  Because the collector never
  * moves objects, treating non-pointers as pointers is harmless (it can
  * only retain garbage, never corrupt), which is what makes the
- * conservative approach sound here.  Unmarked objects are returned to
- * per-size free lists for reuse; addresses of survivors never change.
+ * conservative parts sound here.  Unmarked objects are finalised if
+ * their kind has a finaliser (a number clears its GMP payload) and
+ * returned to their size class (or the large-object space) for reuse;
+ * addresses of survivors never change.
+ *
+ * What a collection keeps is old.  A minor collection traces and sweeps
+ * only what was allocated since the last collection: an old object is
+ * traced just when a root points at it or a slot of it was stored into
+ * since (the write barrier remembers the slot), and is never freed.
+ * Objects cannot move, so the young generation is not a separate space,
+ * only the list of objects registered since the last collection.
  * ================================================================== */
 #include <setjmp.h>
 #include <stdint.h>
@@ -540,51 +612,200 @@ extern char __data_start[];
 extern char __bss_start[];
 extern char _end[];
 
-typedef struct { void *base; size_t size; } gc_obj_t;
-typedef struct { gc_obj_t *items; size_t count, cap; int oom; } gc_worklist_t;
-
-static void gc_wl_push(gc_worklist_t *w, void *base, size_t size) {
+typedef struct {
+  void *base;
+  size_t size;
+  lizard_gc_object_kind_t kind;
+  lizard_object_trace_policy_t trace;
+} gc_obj_t;
+typedef struct {
+  gc_obj_t *items;
+  size_t count, cap;
+  int oom;
+  int minor; /* old objects are traced only as roots */
+} gc_worklist_t;
+
+static gc_obj_t *gc_wl_push(gc_worklist_t *w) {
   if (w->count == w->cap) {
     size_t ncap = w->cap ? w->cap * 2U : 4096U;
     gc_obj_t *p = (gc_obj_t *)realloc(w->items, ncap * sizeof(gc_obj_t));
-    if (p == NULL) { w->oom = 1; return; }
+    if (p == NULL) { w->oom = 1; return NULL; }
     w->items = p;
     w->cap = ncap;
   }
-  w->items[w->count].base = base;
-  w->items[w->count].size = size;
-  w->count++;
+  return &w->items[w->count++];
 }
 
-/* Scan [lo,hi) for word-aligned values that point into a tracked object;
- * mark each newly found object and enqueue it for tracing. */
-static void gc_scan_range(lizard_heap_t *h, char *lo, char *hi,
-                          gc_worklist_t *wl) {
+/* Mark the tracked object `word` points into, if it is not marked yet, and
+ * enqueue it unless there is nothing in it to trace.  In a minor collection
+ * an old object is enqueued only as a `root`: everything else it points at
+ * is old too, unless it was stored there since (the write barrier). */
+static void gc_mark_word(lizard_heap_t *h, const void *word,
+                         gc_worklist_t *wl, int root) {
+  gc_obj_t o, *slot;
+  int old;
+  if (word == NULL) return;
+  if (!lizard_gc_metadata_mark_object(h->gc_metadata, word, &o.base, &o.size,
+                                      &o.kind, &o.trace, &old) ||
+      o.trace == LIZARD_OBJECT_TRACE_NONE || (old && wl->minor && !root)) {
+    return;
+  }
+  slot = gc_wl_push(wl);
+  if (slot != NULL) *slot = o;
+}
+
+static void gc_mark_ref(lizard_heap_t *h, const void *word,
+                        gc_worklist_t *wl) {
+  gc_mark_word(h, word, wl, 0);
+}
+
+static void gc_scan_words(lizard_heap_t *h, char *lo, char *hi,
+                          gc_worklist_t *wl, int root) {
   char *p;
   if (lo == NULL || hi == NULL) return;
   if (lo > hi) { char *t = lo; lo = hi; hi = t; }
   while (((uintptr_t)lo % sizeof(void *)) != 0U) lo++;
   for (p = lo; p + sizeof(void *) <= hi; p += sizeof(void *)) {
-    void *word = *(void **)p;
-    void *base;
-    size_t size;
-    if (word == NULL) continue;
-    if (lizard_gc_metadata_mark_addr(h->gc_metadata, word, &base, &size)) {
-      gc_wl_push(wl, base, size);
-    }
+    gc_mark_word(h, *(void **)p, wl, root);
   }
 }
 
+/* Scan [lo,hi) for word-aligned values that point into a tracked object;
+ * mark each newly found object and enqueue it for tracing. */
+static void gc_scan_range(lizard_heap_t *h, char *lo, char *hi,
+                          gc_worklist_t *wl) {
+  gc_scan_words(h, lo, hi, wl, 0);
+}
+
+/* The same for a range of roots. */
+static void gc_scan_roots(lizard_heap_t *h, char *lo, char *hi,
+                          gc_worklist_t *wl) {
+  gc_scan_words(h, lo, hi, wl, 1);
+}
+
 /* Mark a single known root object (and enqueue it) if it is tracked. */
 static void gc_mark_root_ptr(lizard_heap_t *h, void *obj, gc_worklist_t *wl) {
-  void *base;
-  size_t size;
-  if (obj == NULL) return;
-  if (lizard_gc_metadata_mark_addr(h->gc_metadata, obj, &base, &size)) {
-    gc_wl_push(wl, base, size);
+  gc_mark_word(h, obj, wl, 1);
+}
+
+/* ---- tracing by trace policy ---- */
+
+static lizard_gc_trace_fn gc_tracers[LIZARD_GC_OBJECT_NUMBER + 1];
+static lizard_gc_finalize_fn gc_finalizers[LIZARD_GC_OBJECT_NUMBER + 1];
+
+void lizard_gc_set_tracer(lizard_gc_object_kind_t kind,
+                          lizard_gc_trace_fn trace) {
+  gc_tracers[kind] = trace;
+}
+
+void lizard_gc_set_finalizer(lizard_gc_object_kind_t kind,
+                             lizard_gc_finalize_fn finalize) {
+  gc_finalizers[kind] = finalize;
+}
+
+typedef struct {
+  lizard_heap_t *heap;
+  gc_worklist_t *wl;
+} gc_visit_ctx_t;
+
+static void gc_visit(const void *ptr, void *ctx) {
+  gc_visit_ctx_t *v = (gc_visit_ctx_t *)ctx;
+  gc_mark_ref(v->heap, ptr, v->wl);
+}
+
+/* The nodes most of the heap is made of are traced field by field; any
+ * other type, whose union member may be put to other uses, is scanned
+ * whole. */
+static void gc_trace_node(lizard_heap_t *h, const gc_obj_t *o,
+                          gc_worklist_t *wl) {
+  lizard_ast_node_t *node = (lizard_ast_node_t *)o->base;
+  gc_mark_ref(h, node->span.filename, wl);
+  switch (node->type) {
+  case AST_NIL:
+  case AST_BOOL:
+  case AST_REAL:
+    break;
+  case AST_NUMBER:
+    /* A fixnum's limb is in the node itself. */
+    gc_mark_ref(h, node->data.number->_mp_d, wl);
+    break;
+  case AST_RATIONAL:
+    gc_mark_ref(h, mpq_numref(node->data.rational)->_mp_d, wl);
+    gc_mark_ref(h, mpq_denref(node->data.rational)->_mp_d, wl);
+    break;
+  case AST_STRING:
+  case AST_SYMBOL:
+    /* A name may carry a global reference's cache; a chunk constant holds
+     * its sub-chunk where a string's bytes would be. */
+    gc_mark_ref(h, node->data.global_ref.name, wl);
+    gc_mark_ref(h, node->data.global_ref.layout, wl);
+    gc_mark_ref(h, node->data.global_ref.home, wl);
+    gc_mark_ref(h, node->data.global_ref.cell, wl);
+    break;
+  case AST_PAIR:
+    gc_mark_ref(h, node->data.pair.car, wl);
+    gc_mark_ref(h, node->data.pair.cdr, wl);
+    break;
+  default:
+    gc_scan_range(h, (char *)o->base, (char *)o->base + o->size, wl);
+    break;
   }
 }
 
+/* A frame's fields, then the slot vector that follows its header. */
+static void gc_trace_env(lizard_heap_t *h, const gc_obj_t *o,
+                         gc_worklist_t *wl) {
+  lizard_env_t *env = (lizard_env_t *)o->base;
+  gc_mark_ref(h, env->entries, wl);
+  gc_mark_ref(h, env->parent, wl);
+  gc_mark_ref(h, env->layout, wl);
+  gc_mark_ref(h, env->slots, wl);
+  gc_mark_ref(h, env->index, wl);
+  gc_scan_range(h, (char *)(env + 1), (char *)o->base + o->size, wl);
+}
+
+/* Whether the collection under way keeps what `ptr` points into: it is
+ * marked, old in a minor collection, or not the collector's at all. */
+static int gc_live(const void *ptr, void *ctx) {
+  gc_visit_ctx_t *v = (gc_visit_ctx_t *)ctx;
+  lizard_gc_metadata_table_t *t = v->heap->gc_metadata;
+  if (lizard_gc_metadata_is_marked(t, ptr)) return 1;
+  if (v->wl->minor && lizard_gc_metadata_is_old(t, ptr)) return 1;
+  return !lizard_gc_metadata_lookup_object(v->heap, ptr, NULL, NULL, NULL);
+}
+
+static void gc_trace_object(lizard_heap_t *h, const gc_obj_t *o,
+                            gc_worklist_t *wl) {
+  gc_visit_ctx_t v;
+  switch (o->trace) {
+  case LIZARD_OBJECT_TRACE_AST:
+    gc_trace_node(h, o, wl);
+    return;
+  case LIZARD_OBJECT_TRACE_ENV:
+    if (o->kind == LIZARD_GC_OBJECT_ENV) {
+      gc_trace_env(h, o, wl);
+      return;
+    }
+    break;
+  case LIZARD_OBJECT_TRACE_CUSTOM:
+    if (gc_tracers[o->kind] != NULL) {
+      v.heap = h;
+      v.wl = wl;
+      gc_tracers[o->kind](o->base, o->size, gc_visit, &v);
+      return;
+    }
+    break;
+  case LIZARD_OBJECT_TRACE_NONE:
+    return;
+  case LIZARD_OBJECT_TRACE_LIST:
+  case LIZARD_OBJECT_TRACE_CONSERVATIVE:
+    break;
+  }
+  /* List cells and env entries are nothing but pointers, so scanning them
+   * is tracing them. */
+  gc_scan_range(h, (char *)o->base, (char *)o->base + o->size, wl);
+}
+
 /* The top (highest address) of the main thread's stack.  glibc sets
  * __libc_stack_end to the client's initial stack pointer at startup, which is
  * both correct and always within the committed/mapped stack — unlike parsing
@@ -599,18 +820,63 @@ static char *gc_stack_base(void) {
 static void gc_reclaim_cb(void *ptr, size_t size, lizard_gc_object_kind_t kind,
                           void *ctx) {
   size_t *bytes = (size_t *)ctx;
-  (void)kind; /* GMP limbs of swept numbers are intentionally not freed here:
-               * the inferred kind is not exact enough to safely call
-               * mpz_clear/mpq_clear, so we only reclaim the object chunk. */
+  /* Only kinds given at allocation have finalisers: an object whose kind
+   * was inferred from its size is registered as one of the others. */
+  if (gc_finalizers[kind] != NULL) {
+    gc_finalizers[kind](ptr, size);
+  }
   lizard_heap_reclaim(ptr, size);
   if (bytes) *bytes += size;
 }
 
-size_t lizard_gc_collect_objects(lizard_heap_t *h, lizard_env_t *env) {
+/* ---- the remembered set ---- */
+
+static int gc_slot_cmp(const void *a, const void *b) {
+  uintptr_t x = (uintptr_t)*(const void *const *)a;
+  uintptr_t y = (uintptr_t)*(const void *const *)b;
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+void lizard_gc_write_barrier(const void *slot) {
+  lizard_heap_t *h = heap;
+  /* Only slots of old objects: a young one is traced anyway. */
+  if (h == NULL || !lizard_gc_metadata_is_old(h->gc_metadata, slot)) {
+    return;
+  }
+  if (h->remembered_count == h->remembered_cap) {
+    size_t i, n = 0U, cap;
+    const void **grown;
+    /* A slot stored into over and over is remembered once. */
+    qsort(h->remembered, h->remembered_count, sizeof(const void *),
+          gc_slot_cmp);
+    for (i = 0U; i < h->remembered_count; i++) {
+      if (n == 0U || h->remembered[n - 1U] != h->remembered[i]) {
+        h->remembered[n++] = h->remembered[i];
+      }
+    }
+    h->remembered_count = n;
+    if (2U * n > h->remembered_cap || h->remembered_cap == 0U) {
+      cap = h->remembered_cap ? h->remembered_cap * 2U : 1024U;
+      grown = (const void **)realloc((void *)h->remembered,
+                                     cap * sizeof(const void *));
+      if (grown == NULL) {
+        h->remembered_lost = 1;
+        return;
+      }
+      h->remembered = grown;
+      h->remembered_cap = cap;
+    }
+  }
+  h->remembered[h->remembered_count++] = slot;
+}
+
+static size_t gc_collect(lizard_heap_t *h, lizard_env_t *env, int minor) {
   jmp_buf regs;
   gc_worklist_t wl;
+  gc_visit_ctx_t live;
   volatile char *sp;
   size_t freed_bytes = 0U;
+  size_t i;
 
   if (h == NULL || h->gc_metadata == NULL) return 0U;
 
@@ -618,38 +884,72 @@ size_t lizard_gc_collect_objects(lizard_heap_t *h, lizard_env_t *env) {
   wl.count = 0U;
   wl.cap = 0U;
   wl.oom = 0;
+  wl.minor = minor && !h->remembered_lost;
 
   lizard_gc_metadata_prepare_marking(h->gc_metadata);
 
+  /* Old objects stored into since the last collection, whole. */
+  if (wl.minor) {
+    for (i = 0U; i < h->remembered_count; i++) {
+      gc_mark_root_ptr(h, (void *)(uintptr_t)h->remembered[i], &wl);
+    }
+  }
+
   /* Explicit roots: the call-site env (chains to the global env), the module
-   * base env and namespace frames, callcc state, and module results. */
+   * base env and namespace frames, and module results; the run-time macro
+   * expansions are weak, below.  Values in flight to a call/cc live in its
+   * C frame. */
   gc_mark_root_ptr(h, env, &wl);
+  gc_mark_root_ptr(h, h->expansion_memo, &wl);
   if (h->runtime != NULL) {
     lizard_module_entry_t *mod;
     lizard_namespace_t *ns;
+    lizard_vm_t *vm;
+    lizard_bc_chunk_t *chunk;
     gc_mark_root_ptr(h, h->runtime->module_base_env, &wl);
-    gc_mark_root_ptr(h, h->runtime->callcc_value, &wl);
+    gc_mark_root_ptr(h, h->runtime->optimize_state, &wl);
     for (mod = h->runtime->modules_head; mod != NULL; mod = mod->next) {
       gc_mark_root_ptr(h, mod->result, &wl);
     }
     for (ns = h->runtime->namespaces_head; ns != NULL; ns = ns->next) {
       gc_mark_root_ptr(h, ns->env, &wl);
     }
+    /* Running VMs keep their value stacks and suspended frames off-heap. */
+    for (vm = h->runtime->vm_top; vm != NULL; vm = vm->prev) {
+      gc_scan_roots(h, (char *)vm->stack, (char *)(vm->stack + vm->sp), &wl);
+      gc_scan_roots(h, (char *)vm->frames,
+                    (char *)(vm->frames + vm->frame_count), &wl);
+    }
+    /* So do the constant pools of bytecode chunks. */
+    for (chunk = h->runtime->chunks; chunk != NULL; chunk = chunk->older) {
+      gc_scan_roots(h, (char *)chunk->constants,
+                    (char *)(chunk->constants + chunk->const_count), &wl);
+    }
   }
 
-  /* Conservative roots: spilled registers, the C stack, and data/BSS. */
+  /* Conservative roots: spilled registers, the C stack, and data/BSS.  An
+   * old object they point at is traced as well, in case whoever holds it
+   * has stored into it. */
   memset(&regs, 0, sizeof(regs));
   (void)setjmp(regs);
   sp = (volatile char *)&sp;
-  gc_scan_range(h, (char *)&regs, (char *)&regs + sizeof(regs), &wl);
-  gc_scan_range(h, (char *)(uintptr_t)sp, gc_stack_base(), &wl);
-  gc_scan_range(h, (char *)__data_start, (char *)__bss_start, &wl);
-  gc_scan_range(h, (char *)__bss_start, (char *)_end, &wl);
-
-  /* Trace: scan each live object's bytes for further pointers. */
-  while (wl.count > 0U && !wl.oom) {
-    gc_obj_t o = wl.items[--wl.count];
-    gc_scan_range(h, (char *)o.base, (char *)o.base + o.size, &wl);
+  gc_scan_roots(h, (char *)&regs, (char *)&regs + sizeof(regs), &wl);
+  gc_scan_roots(h, (char *)(uintptr_t)sp, gc_stack_base(), &wl);
+  gc_scan_roots(h, (char *)__data_start, (char *)__bss_start, &wl);
+  gc_scan_roots(h, (char *)__bss_start, (char *)_end, &wl);
+
+  /* Trace: follow each live object's pointers, as its policy says.  An
+   * expansion the memo keeps for a live form may keep other forms live. */
+  live.heap = h;
+  live.wl = &wl;
+  for (;;) {
+    while (wl.count > 0U && !wl.oom) {
+      gc_obj_t o = wl.items[--wl.count];
+      gc_trace_object(h, &o, &wl);
+    }
+    if (wl.oom) break;
+    lizard_expansion_memo_trace(h->expansion_memo, gc_live, gc_visit, &live);
+    if (wl.count == 0U) break;
   }
 
   if (wl.oom) {
@@ -659,7 +959,33 @@ size_t lizard_gc_collect_objects(lizard_heap_t *h, lizard_env_t *env) {
     return 0U;
   }
 
-  (void)lizard_gc_metadata_sweep(h->gc_metadata, gc_reclaim_cb, &freed_bytes);
+  lizard_expansion_memo_prune(h->expansion_memo, gc_live, &live);
+  if (wl.minor) {
+    (void)lizard_gc_metadata_sweep_young(h->gc_metadata, gc_reclaim_cb,
+                                         &freed_bytes);
+  } else {
+    (void)lizard_gc_metadata_sweep(h->gc_metadata, gc_reclaim_cb,
+                                   &freed_bytes);
+    h->full_old_bytes = lizard_gc_metadata_old_bytes(h->gc_metadata);
+  }
+  /* Whatever survived is old now, so no old object points at a young one. */
+  h->remembered_count = 0U;
+  h->remembered_lost = 0;
   free(wl.items);
   return freed_bytes;
 }
+
+size_t lizard_gc_collect_objects(lizard_heap_t *h, lizard_env_t *env) {
+  return gc_collect(h, env, 0);
+}
+
+size_t lizard_gc_collect_minor(lizard_heap_t *h, lizard_env_t *env) {
+  return gc_collect(h, env, 1);
+}
+
+int lizard_gc_wants_full(lizard_heap_t *h) {
+  size_t old;
+  if (h == NULL || h->gc_metadata == NULL) return 1;
+  old = lizard_gc_metadata_old_bytes(h->gc_metadata);
+  return h->remembered_lost || old == 0U || old > 2U * h->full_old_bytes;
+}
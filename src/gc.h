@@ -24,8 +24,8 @@ void lizard_gc_mark_node(lizard_ast_node_t *node);
 /* Mark all bindings reachable from an environment chain. */
 void lizard_gc_mark_env(lizard_env_t *env);
 
-/* Clear all mark bits across the entire heap. Must be called before
- * a new mark pass. */
+/* Clear the mark bits set since the last clear. Each pass clears its own
+ * marks when done, before any marked node can be reclaimed. */
 void lizard_gc_clear_marks(lizard_heap_t *heap);
 
 /* Count marked nodes across the heap. Call after a mark pass. */
@@ -41,11 +41,56 @@ void lizard_gc_collect_stats(lizard_heap_t *heap, lizard_env_t *env,
  * Does NOT move objects — no pointer updating needed. */
 size_t lizard_gc_collect(lizard_heap_t *heap, lizard_env_t *env);
 
-/* Phase 5: per-object, non-moving, conservative mark & sweep. Reclaims
- * individual dead objects into per-size free lists for reuse (addresses of
- * live objects are never changed). Returns the number of bytes reclaimed. */
+/* Phase 5: per-object, non-moving mark & sweep, precise for objects
+ * allocated with their kind and conservative for the rest and the C stack.
+ * Reclaims individual dead objects into size-class free lists for reuse
+ * (addresses of live objects are never changed). Returns the number of
+ * bytes reclaimed. */
 size_t lizard_gc_collect_objects(lizard_heap_t *heap, lizard_env_t *env);
 
+/* A minor collection: the same, for the objects allocated since the last
+ * collection only.  Old objects are traced only where the roots or the
+ * remembered set point into them, and are all kept. */
+size_t lizard_gc_collect_minor(lizard_heap_t *heap, lizard_env_t *env);
+
+/* Whether the next collection should be full: nothing is old yet, the
+ * old objects have doubled in size since the last full collection, or the
+ * remembered set lost a slot. */
+int lizard_gc_wants_full(lizard_heap_t *heap);
+
+/* Write barrier: call after storing a pointer into `slot`, a field of a
+ * heap object that may be old, unless the object is known to be young
+ * (allocated since the last collection) or a root.  A slot of a young
+ * object costs a page map lookup and is not remembered. */
+void lizard_gc_write_barrier(const void *slot);
+
+/* Tracing of objects of a kind whose trace policy is
+ * LIZARD_OBJECT_TRACE_CUSTOM: the tracer calls `visit` with every pointer
+ * `obj` holds.  Without one, such objects are scanned conservatively. */
+typedef void (*lizard_gc_visit_fn)(const void *ptr, void *ctx);
+typedef void (*lizard_gc_trace_fn)(void *obj, size_t size,
+                                   lizard_gc_visit_fn visit, void *ctx);
+void lizard_gc_set_tracer(lizard_gc_object_kind_t kind,
+                          lizard_gc_trace_fn trace);
+
+/* The run-time expansion memo (lizard.c) is weak.  After tracing, the
+ * collector has lizard_expansion_memo_trace visit what each entry whose
+ * form `live` says is kept holds, until that marks nothing new, and
+ * lizard_expansion_memo_prune then drops the other entries. */
+typedef int (*lizard_gc_live_fn)(const void *ptr, void *ctx);
+struct lizard_expansion_memo;
+void lizard_expansion_memo_trace(struct lizard_expansion_memo *memo,
+                                 lizard_gc_live_fn live,
+                                 lizard_gc_visit_fn visit, void *ctx);
+void lizard_expansion_memo_prune(struct lizard_expansion_memo *memo,
+                                 lizard_gc_live_fn live, void *ctx);
+
+/* Finalisation of objects of a kind: the sweep calls `finalize` on each
+ * one it frees, before the chunk is reused, to release what it owns. */
+typedef void (*lizard_gc_finalize_fn)(void *obj, size_t size);
+void lizard_gc_set_finalizer(lizard_gc_object_kind_t kind,
+                             lizard_gc_finalize_fn finalize);
+
 
 /* Phase 3B: non-invasive metadata side-table inspection. */
 void lizard_gc_metadata_stats(lizard_heap_t *heap,
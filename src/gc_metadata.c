@@ -1,30 +1,95 @@
-/* src/gc_metadata.c -- Phase 3B GC metadata side-table scaffold. */
+/* src/gc_metadata.c -- Phase 3B GC metadata side table and its page map. */
 
 #include "gc_metadata.h"
 #include "mem.h"
 
+#include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define LIZARD_GC_METADATA_INITIAL_CAPACITY 128U
 
+/* The object map.  Tracked memory is cut into pages of
+ * LIZARD_GC_PAGE_SIZE bytes, aligned like the mmap'd heap segments, so a
+ * segment is a whole number of pages.  A page has one bit per word in
+ * `starts`, set where a tracked object begins, and one in `marks`, set
+ * when that object is marked.  The entry of the n-th object starting on
+ * a page, in address order, is objects[n]; an object that begins on an
+ * earlier page and runs into this one is `cover`.  So the object holding
+ * an address is found from its page alone, with no sort of the table.
+ *
+ * Registering only appends the entry and queues it; the queue goes into
+ * the pages when marking starts, so allocation pays no more than before
+ * and a collection pays for what was allocated since the last one.
+ *
+ * What a collection keeps becomes old.  Entries put on their pages since
+ * the last collection are listed in `young`, so a minor collection sweeps
+ * those alone. */
+#define LIZARD_GC_PAGE_SHIFT 12U
+#define LIZARD_GC_PAGE_SIZE ((uintptr_t)1 << LIZARD_GC_PAGE_SHIFT)
+#define LIZARD_GC_PAGE_WORDS (LIZARD_GC_PAGE_SIZE / sizeof(void *))
+#define LIZARD_GC_MAP_BITS (CHAR_BIT * sizeof(unsigned long))
+#define LIZARD_GC_MAP_WORDS \
+  ((LIZARD_GC_PAGE_WORDS + LIZARD_GC_MAP_BITS - 1U) / LIZARD_GC_MAP_BITS)
+#define LIZARD_GC_NO_ENTRY ((size_t)-1)
+#define LIZARD_GC_RECENT_PAGES 32U
+
 typedef struct lizard_gc_metadata_entry {
-  void *ptr;
-  size_t size;
+  void *ptr;            /* NULL while the entry is free */
+  size_t size;          /* of a free entry: the next free one */
   lizard_gc_object_kind_t kind;
   lizard_object_owner_t owner;
   lizard_object_trace_policy_t trace_policy;
-  unsigned char mark;   /* GC: set during the mark phase, cleared by sweep */
+  unsigned char inferred; /* kind guessed from the size: trace conservatively */
+  unsigned char old;      /* kept by a collection */
 } lizard_gc_metadata_entry_t;
 
+typedef struct lizard_gc_page {
+  uintptr_t number;     /* address >> LIZARD_GC_PAGE_SHIFT */
+  unsigned long starts[LIZARD_GC_MAP_WORDS];
+  unsigned long marks[LIZARD_GC_MAP_WORDS];
+  size_t *objects;
+  size_t object_count;
+  size_t object_cap;
+  size_t end_word;      /* one past the last word an object starts at */
+  size_t cover;
+} lizard_gc_page_t;
+
+/* Pages are never given back before the table goes, so they are carved
+ * from blocks rather than allocated one by one. */
+#define LIZARD_GC_PAGE_BLOCK 64U
+
+typedef struct lizard_gc_page_block {
+  struct lizard_gc_page_block *next;
+  size_t used;
+  lizard_gc_page_t pages[LIZARD_GC_PAGE_BLOCK];
+} lizard_gc_page_block_t;
+
 struct lizard_gc_metadata_table {
   lizard_gc_metadata_entry_t *entries;
-  size_t count;
+  size_t count;         /* entries in use */
+  size_t used;          /* entries ever handed out */
   size_t capacity;
+  size_t free_entry;    /* first free entry below `used`, or NO_ENTRY */
   size_t registration_failures;
-  size_t *sorted;       /* indices into entries[], sorted by ptr (GC mark) */
-  size_t sorted_count;
-  size_t sorted_cap;
+  size_t *pending;      /* entries registered but not yet on their page */
+  size_t pending_count;
+  size_t pending_cap;
+  size_t *young;        /* entries on their page since the last collection */
+  size_t young_count;
+  size_t young_cap;
+  size_t old_bytes;
+  int sweeping;
+  lizard_gc_page_t **pages; /* open-addressed by page number */
+  size_t page_count;
+  size_t page_slots;
+  lizard_gc_page_block_t *page_blocks;
+  /* Pages objects were last put on, by low bits of page number: the
+   * allocator bumps in a few places at once. */
+  lizard_gc_page_t *recent[LIZARD_GC_RECENT_PAGES];
+  uintptr_t lowest;     /* the tracked addresses lie in [lowest, highest) */
+  uintptr_t highest;
 };
 
 static void metadata_stats_clear(lizard_gc_metadata_stats_t *stats) {
@@ -38,6 +103,7 @@ static void metadata_stats_clear(lizard_gc_metadata_stats_t *stats) {
     stats->env_entries = 0U;
     stats->kernel_terms = 0U;
     stats->raw_objects = 0U;
+    stats->numbers = 0U;
     stats->trace_required = 0U;
     stats->registration_failures = 0U;
   }
@@ -50,6 +116,8 @@ static void metadata_entry_clear(lizard_gc_metadata_entry_t *entry) {
     entry->kind = LIZARD_GC_OBJECT_UNKNOWN;
     entry->owner = LIZARD_OBJECT_OWNER_UNKNOWN;
     entry->trace_policy = LIZARD_OBJECT_TRACE_NONE;
+    entry->inferred = 0;
+    entry->old = 0;
   }
 }
 
@@ -57,7 +125,6 @@ static int metadata_ensure_capacity(lizard_gc_metadata_table_t *table,
                                     size_t needed) {
   lizard_gc_metadata_entry_t *next_entries;
   size_t next_capacity;
-  size_t i;
 
   if (table == NULL) {
     return 0;
@@ -76,10 +143,7 @@ static int metadata_ensure_capacity(lizard_gc_metadata_table_t *table,
     table->registration_failures++;
     return 0;
   }
-  table->entries = next_entries;
-  for (i = table->capacity; i < next_capacity; i++) {
-    metadata_entry_clear(&table->entries[i]);
-  }
+  table->entries = next_entries; /* read only up to `used` */
   table->capacity = next_capacity;
   return 1;
 }
@@ -100,6 +164,8 @@ const char *lizard_gc_object_kind_name(lizard_gc_object_kind_t kind) {
     return "kernel-term";
   case LIZARD_GC_OBJECT_RAW:
     return "raw";
+  case LIZARD_GC_OBJECT_NUMBER:
+    return "number";
   }
   return "unknown";
 }
@@ -129,11 +195,25 @@ lizard_gc_metadata_table_t *lizard_gc_metadata_table_create(void) {
   }
   table->entries = NULL;
   table->count = 0U;
+  table->used = 0U;
   table->capacity = 0U;
+  table->free_entry = LIZARD_GC_NO_ENTRY;
   table->registration_failures = 0U;
-  table->sorted = NULL;
-  table->sorted_count = 0U;
-  table->sorted_cap = 0U;
+  table->pending = NULL;
+  table->pending_count = 0U;
+  table->pending_cap = 0U;
+  table->young = NULL;
+  table->young_count = 0U;
+  table->young_cap = 0U;
+  table->old_bytes = 0U;
+  table->sweeping = 0;
+  table->pages = NULL;
+  table->page_count = 0U;
+  table->page_slots = 0U;
+  table->page_blocks = NULL;
+  memset(table->recent, 0, sizeof(table->recent));
+  table->lowest = 0U;
+  table->highest = 0U;
   if (!metadata_ensure_capacity(table, LIZARD_GC_METADATA_INITIAL_CAPACITY)) {
     free(table);
     return NULL;
@@ -142,152 +222,564 @@ lizard_gc_metadata_table_t *lizard_gc_metadata_table_create(void) {
 }
 
 void lizard_gc_metadata_table_destroy(lizard_gc_metadata_table_t *table) {
+  lizard_gc_page_block_t *block;
+  size_t i;
   if (table == NULL) {
     return;
   }
+  while ((block = table->page_blocks) != NULL) {
+    table->page_blocks = block->next;
+    for (i = 0U; i < block->used; i++) {
+      free(block->pages[i].objects);
+    }
+    free(block);
+  }
+  free(table->pages);
+  free(table->pending);
+  free(table->young);
   free(table->entries);
-  free(table->sorted);
   free(table);
 }
 
+/* ---- the page map ---- */
+
+static size_t page_hash(uintptr_t number, size_t slots) {
+  return (size_t)(number * (uintptr_t)2654435761UL) & (slots - 1U);
+}
+
+static lizard_gc_page_t *page_find(const lizard_gc_metadata_table_t *table,
+                                   uintptr_t number) {
+  size_t h;
+  lizard_gc_page_t *page;
+  if (table->page_slots == 0U) return NULL;
+  h = page_hash(number, table->page_slots);
+  while ((page = table->pages[h]) != NULL) {
+    if (page->number == number) return page;
+    h = (h + 1U) & (table->page_slots - 1U);
+  }
+  return NULL;
+}
+
+/* The page `number`, added if new; NULL when out of memory. */
+static lizard_gc_page_t *page_get(lizard_gc_metadata_table_t *table,
+                                  uintptr_t number) {
+  lizard_gc_page_t *page = page_find(table, number);
+  size_t h, i;
+  if (page != NULL) return page;
+  if (2U * (table->page_count + 1U) > table->page_slots) {
+    size_t slots = table->page_slots ? table->page_slots * 2U : 64U;
+    lizard_gc_page_t **grown =
+        (lizard_gc_page_t **)calloc(slots, sizeof(lizard_gc_page_t *));
+    if (grown == NULL) return NULL;
+    for (i = 0U; i < table->page_slots; i++) {
+      if (table->pages[i] == NULL) continue;
+      h = page_hash(table->pages[i]->number, slots);
+      while (grown[h] != NULL) h = (h + 1U) & (slots - 1U);
+      grown[h] = table->pages[i];
+    }
+    free(table->pages);
+    table->pages = grown;
+    table->page_slots = slots;
+  }
+  if (table->page_blocks == NULL ||
+      table->page_blocks->used == LIZARD_GC_PAGE_BLOCK) {
+    lizard_gc_page_block_t *block =
+        (lizard_gc_page_block_t *)malloc(sizeof(lizard_gc_page_block_t));
+    if (block == NULL) return NULL;
+    block->next = table->page_blocks;
+    block->used = 0U;
+    table->page_blocks = block;
+  }
+  page = &table->page_blocks->pages[table->page_blocks->used++];
+  memset(page, 0, sizeof(*page));
+  page->number = number;
+  page->cover = LIZARD_GC_NO_ENTRY;
+  h = page_hash(number, table->page_slots);
+  while (table->pages[h] != NULL) h = (h + 1U) & (table->page_slots - 1U);
+  table->pages[h] = page;
+  table->page_count++;
+  return page;
+}
+
+static uintptr_t page_number(const void *addr) {
+  return (uintptr_t)addr >> LIZARD_GC_PAGE_SHIFT;
+}
+
+/* The word of its page `addr` falls in. */
+static size_t page_word(const void *addr) {
+  return (size_t)(((uintptr_t)addr & (LIZARD_GC_PAGE_SIZE - 1U)) /
+                  sizeof(void *));
+}
+
+static unsigned map_count(unsigned long bits) {
+#if defined(__GNUC__)
+  return (unsigned)__builtin_popcountl(bits);
+#else
+  unsigned n = 0U;
+  for (; bits != 0UL; bits &= bits - 1UL) n++;
+  return n;
+#endif
+}
+
+/* How many objects start on `page` before word `word`. */
+static size_t starts_before(const lizard_gc_page_t *page, size_t word) {
+  size_t w, n = 0U;
+  for (w = 0U; w < word / LIZARD_GC_MAP_BITS; w++) {
+    n += map_count(page->starts[w]);
+  }
+  if (word % LIZARD_GC_MAP_BITS != 0U) {
+    n += map_count(page->starts[w] &
+                   ((1UL << (word % LIZARD_GC_MAP_BITS)) - 1UL));
+  }
+  return n;
+}
+
+static int map_test(const unsigned long *map, size_t word) {
+  return (map[word / LIZARD_GC_MAP_BITS] >> (word % LIZARD_GC_MAP_BITS)) & 1UL
+             ? 1
+             : 0;
+}
+
+static void map_set(unsigned long *map, size_t word) {
+  map[word / LIZARD_GC_MAP_BITS] |= 1UL << (word % LIZARD_GC_MAP_BITS);
+}
+
+static void map_clear(unsigned long *map, size_t word) {
+  map[word / LIZARD_GC_MAP_BITS] &= ~(1UL << (word % LIZARD_GC_MAP_BITS));
+}
+
+/* The entry of the object starting at `ptr`, or NO_ENTRY. */
+static size_t page_object_at(const lizard_gc_metadata_table_t *table,
+                             const void *ptr) {
+  const lizard_gc_page_t *page = page_find(table, page_number(ptr));
+  size_t word = page_word(ptr);
+  size_t idx;
+  if (page == NULL || !map_test(page->starts, word)) return LIZARD_GC_NO_ENTRY;
+  idx = page->objects[starts_before(page, word)];
+  return table->entries[idx].ptr == ptr ? idx : LIZARD_GC_NO_ENTRY;
+}
+
+/* Index of the indexed object `addr` falls inside, with `*out_page` the
+ * page it starts on; LIZARD_GC_NO_ENTRY if none. */
+static size_t page_object_containing(const lizard_gc_metadata_table_t *table,
+                                     const void *addr,
+                                     lizard_gc_page_t **out_page) {
+  lizard_gc_page_t *page;
+  const lizard_gc_metadata_entry_t *e;
+  size_t n, idx;
+  uintptr_t a = (uintptr_t)addr;
+  if (a < table->lowest || a >= table->highest) return LIZARD_GC_NO_ENTRY;
+  page = page_find(table, page_number(addr));
+  if (page == NULL) return LIZARD_GC_NO_ENTRY;
+  n = starts_before(page, page_word(addr) + 1U);
+  idx = n > 0U ? page->objects[n - 1U] : page->cover;
+  if (idx == LIZARD_GC_NO_ENTRY) return LIZARD_GC_NO_ENTRY;
+  e = &table->entries[idx];
+  if (a < (uintptr_t)e->ptr || a - (uintptr_t)e->ptr >= e->size) {
+    return LIZARD_GC_NO_ENTRY;
+  }
+  *out_page = n > 0U ? page : page_find(table, page_number(e->ptr));
+  return idx;
+}
+
+/* Make the pages after the first that object `idx` runs into point back
+ * at it, or with `clear` forget it there; 0 when out of memory. */
+static int page_cover(lizard_gc_metadata_table_t *table, size_t idx,
+                      int clear) {
+  const lizard_gc_metadata_entry_t *e = &table->entries[idx];
+  uintptr_t n = page_number(e->ptr);
+  uintptr_t last = page_number((const char *)e->ptr + e->size - 1U);
+  lizard_gc_page_t *page;
+  for (n++; n <= last; n++) {
+    if (clear) {
+      page = page_find(table, n);
+      if (page != NULL && page->cover == idx) page->cover = LIZARD_GC_NO_ENTRY;
+    } else {
+      page = page_get(table, n);
+      if (page == NULL) return 0;
+      page->cover = idx;
+    }
+  }
+  return 1;
+}
+
+static size_t entry_take(lizard_gc_metadata_table_t *table) {
+  size_t idx = table->free_entry;
+  if (idx != LIZARD_GC_NO_ENTRY) {
+    table->free_entry = table->entries[idx].size;
+    return idx;
+  }
+  if (!metadata_ensure_capacity(table, table->used + 1U)) {
+    return LIZARD_GC_NO_ENTRY;
+  }
+  return table->used++;
+}
+
+static void entry_release(lizard_gc_metadata_table_t *table, size_t idx) {
+  if (table->entries[idx].old) {
+    table->old_bytes -= table->entries[idx].size;
+  }
+  metadata_entry_clear(&table->entries[idx]);
+  table->entries[idx].size = table->free_entry;
+  table->free_entry = idx;
+  table->count--;
+}
+
+/* Put entry `idx` on its page; 0 when out of memory.  An object still on
+ * the page at the same address was never swept and gives way. */
+static int page_put(lizard_gc_metadata_table_t *table, size_t idx) {
+  lizard_gc_metadata_entry_t *e = &table->entries[idx];
+  lizard_gc_page_t *page;
+  uintptr_t number = page_number(e->ptr), a = (uintptr_t)e->ptr;
+  size_t word, n;
+
+  page = table->recent[number % LIZARD_GC_RECENT_PAGES];
+  if (page == NULL || page->number != number) {
+    page = page_get(table, number);
+    if (page == NULL) return 0;
+    table->recent[number % LIZARD_GC_RECENT_PAGES] = page;
+  }
+  word = page_word(e->ptr);
+  /* Bump allocation comes in address order: append without counting. */
+  n = word >= page->end_word ? page->object_count : starts_before(page, word);
+  if (word < page->end_word && map_test(page->starts, word)) {
+    size_t old = page->objects[n];
+    if (page_number((const char *)table->entries[old].ptr +
+                    table->entries[old].size - 1U) != number) {
+      (void)page_cover(table, old, 1);
+    }
+    entry_release(table, old);
+    page->objects[n] = idx;
+  } else {
+    if (page->object_count == page->object_cap) {
+      size_t cap = page->object_cap ? page->object_cap * 2U : 32U;
+      size_t *grown = (size_t *)realloc(page->objects, cap * sizeof(size_t));
+      if (grown == NULL) return 0;
+      page->objects = grown;
+      page->object_cap = cap;
+    }
+    if (n < page->object_count) {
+      memmove(&page->objects[n + 1U], &page->objects[n],
+              (page->object_count - n) * sizeof(size_t));
+    }
+    page->objects[n] = idx;
+    page->object_count++;
+    map_set(page->starts, word);
+    if (word >= page->end_word) {
+      page->end_word = word + 1U;
+    }
+  }
+  if (page_number((const char *)e->ptr + e->size - 1U) != number &&
+      !page_cover(table, idx, 0)) {
+    return 0;
+  }
+  if (table->highest == 0U || a < table->lowest) {
+    table->lowest = a;
+  }
+  if (a + e->size > table->highest) {
+    table->highest = a + e->size;
+  }
+  return 1;
+}
+
+/* Put every queued entry on its page, and list it as young.  One that
+ * cannot be listed is left to full collections. */
+static void page_put_pending(lizard_gc_metadata_table_t *table) {
+  size_t i, need = table->young_count + table->pending_count;
+  if (need > table->young_cap) {
+    size_t cap = table->young_cap ? table->young_cap : 1024U;
+    size_t *grown;
+    while (cap < need) cap *= 2U;
+    grown = (size_t *)realloc(table->young, cap * sizeof(size_t));
+    if (grown != NULL) {
+      table->young = grown;
+      table->young_cap = cap;
+    }
+  }
+  for (i = 0U; i < table->pending_count; i++) {
+    if (!page_put(table, table->pending[i])) {
+      table->registration_failures++;
+    } else if (table->young_count < table->young_cap) {
+      table->young[table->young_count++] = table->pending[i];
+    }
+  }
+  table->pending_count = 0U;
+}
+
 /* ===================================================================
- * GC support: mark phase (sorted address lookup) + per-object sweep.
+ * GC support: mark phase (page map lookup) + per-object sweep.
  * The collector (gc.c) is non-moving and fully conservative, so these
  * routines only need to (a) find which tracked object contains an
  * arbitrary address, (b) record marks, and (c) free + remove the
  * unmarked objects after marking.
  * ================================================================== */
 
-static int metadata_sorted_cmp(const void *a, const void *b,
-                               lizard_gc_metadata_entry_t *entries) {
-  size_t ia = *(const size_t *)a;
-  size_t ib = *(const size_t *)b;
-  if (entries[ia].ptr < entries[ib].ptr) return -1;
-  if (entries[ia].ptr > entries[ib].ptr) return 1;
-  return 0;
-}
-
-/* qsort lacks a context argument in C89, so sort with a simple insertion /
- * shell sort over the index array keyed by entries[].ptr. */
-static void metadata_sort_index(lizard_gc_metadata_table_t *t) {
-  size_t gap, i, j, tmp;
-  for (gap = t->sorted_count / 2U; gap > 0U; gap /= 2U) {
-    for (i = gap; i < t->sorted_count; i++) {
-      tmp = t->sorted[i];
-      j = i;
-      while (j >= gap &&
-             metadata_sorted_cmp(&t->sorted[j - gap], &tmp, t->entries) > 0) {
-        t->sorted[j] = t->sorted[j - gap];
-        j -= gap;
-      }
-      t->sorted[j] = tmp;
-    }
-  }
-}
-
 void lizard_gc_metadata_prepare_marking(lizard_gc_metadata_table_t *table) {
   size_t i;
   if (table == NULL) return;
-  if (table->sorted_cap < table->count) {
-    size_t newcap = table->count > 0U ? table->count : 1U;
-    size_t *p = (size_t *)realloc(table->sorted, newcap * sizeof(size_t));
-    if (p == NULL) { table->sorted_count = 0U; return; }
-    table->sorted = p;
-    table->sorted_cap = newcap;
-  }
-  table->sorted_count = table->count;
-  for (i = 0; i < table->count; i++) {
-    table->entries[i].mark = 0;
-    table->sorted[i] = i;
+  page_put_pending(table);
+  for (i = 0U; i < table->page_slots; i++) {
+    if (table->pages[i] != NULL) {
+      memset(table->pages[i]->marks, 0, sizeof(table->pages[i]->marks));
+    }
   }
-  metadata_sort_index(table);
 }
 
 /* If `addr` falls inside a tracked object that is currently UNMARKED, mark it,
- * fill the out-parameters with its extent, and return 1.  Otherwise return 0
- * (address not tracked, or object already marked). */
+ * fill the out-parameters with its extent, how to trace it and whether it is
+ * old, and return 1.  Otherwise return 0 (address not tracked, or object
+ * already marked). */
+int lizard_gc_metadata_mark_object(
+    lizard_gc_metadata_table_t *table, const void *addr, void **out_base,
+    size_t *out_size, lizard_gc_object_kind_t *out_kind,
+    lizard_object_trace_policy_t *out_trace_policy, int *out_old) {
+  lizard_gc_page_t *page;
+  lizard_gc_metadata_entry_t *e;
+  size_t word, idx;
+  if (table == NULL) return 0;
+  idx = page_object_containing(table, addr, &page);
+  if (idx == LIZARD_GC_NO_ENTRY) return 0;
+  e = &table->entries[idx];
+  word = page_word(e->ptr);
+  if (map_test(page->marks, word)) return 0;
+  map_set(page->marks, word);
+  if (out_base) *out_base = e->ptr;
+  if (out_size) *out_size = e->size;
+  if (out_kind) *out_kind = e->kind;
+  if (out_trace_policy) {
+    *out_trace_policy =
+        e->inferred ? LIZARD_OBJECT_TRACE_CONSERVATIVE : e->trace_policy;
+  }
+  if (out_old) *out_old = e->old;
+  return 1;
+}
+
+int lizard_gc_metadata_is_marked(const lizard_gc_metadata_table_t *table,
+                                 const void *addr) {
+  lizard_gc_page_t *page;
+  size_t idx;
+  if (table == NULL) return 0;
+  idx = page_object_containing(table, addr, &page);
+  return idx != LIZARD_GC_NO_ENTRY &&
+         map_test(page->marks, page_word(table->entries[idx].ptr));
+}
+
 int lizard_gc_metadata_mark_addr(lizard_gc_metadata_table_t *table,
                                  const void *addr, void **out_base,
                                  size_t *out_size) {
-  size_t lo, hi;
-  const char *a = (const char *)addr;
-  if (table == NULL || table->sorted_count == 0U) return 0;
-  lo = 0U;
-  hi = table->sorted_count; /* find last entry with ptr <= addr */
-  while (lo < hi) {
-    size_t mid = lo + (hi - lo) / 2U;
-    if ((const char *)table->entries[table->sorted[mid]].ptr <= a) {
-      lo = mid + 1U;
-    } else {
-      hi = mid;
-    }
+  return lizard_gc_metadata_mark_object(table, addr, out_base, out_size, NULL,
+                                        NULL, NULL);
+}
+
+static void entry_promote(lizard_gc_metadata_table_t *table,
+                          lizard_gc_metadata_entry_t *e) {
+  if (!e->old) {
+    e->old = 1;
+    table->old_bytes += e->size;
   }
-  if (lo == 0U) return 0;
-  {
-    lizard_gc_metadata_entry_t *e = &table->entries[table->sorted[lo - 1U]];
-    const char *base = (const char *)e->ptr;
-    if (a >= base && a < base + e->size) {
-      if (e->mark) return 0;
-      e->mark = 1;
-      if (out_base) *out_base = e->ptr;
-      if (out_size) *out_size = e->size;
-      return 1;
+}
+
+/* Free unmarked object `idx` of `page` (its first page). */
+static void entry_sweep(lizard_gc_metadata_table_t *table,
+                        lizard_gc_page_t *page, size_t idx,
+                        lizard_gc_free_fn free_cb, void *ctx) {
+  lizard_gc_metadata_entry_t *e = &table->entries[idx];
+  map_clear(page->starts, page_word(e->ptr));
+  if (page_number((const char *)e->ptr + e->size - 1U) != page->number) {
+    (void)page_cover(table, idx, 1);
+  }
+  if (free_cb) free_cb(e->ptr, e->size, e->kind, ctx);
+  entry_release(table, idx);
+}
+
+/* Drop the entries swept from `page`, whose start bits are gone. */
+static void page_compact(lizard_gc_metadata_table_t *table,
+                         lizard_gc_page_t *page) {
+  size_t j, live = 0U;
+  for (j = 0U; j < page->object_count; j++) {
+    size_t idx = page->objects[j];
+    const void *ptr = table->entries[idx].ptr;
+    if (ptr != NULL && page_number(ptr) == page->number &&
+        map_test(page->starts, page_word(ptr))) {
+      page->objects[live++] = idx;
     }
   }
-  return 0;
+  page->object_count = live;
+  page->end_word =
+      live > 0U ? page_word(table->entries[page->objects[live - 1U]].ptr) + 1U
+                : 0U;
 }
 
 size_t lizard_gc_metadata_sweep(lizard_gc_metadata_table_t *table,
                                 lizard_gc_free_fn free_cb, void *ctx) {
-  size_t i, live = 0U, freed = 0U;
+  size_t i, j, live, freed = 0U;
   if (table == NULL) return 0U;
-  for (i = 0; i < table->count; i++) {
-    lizard_gc_metadata_entry_t *e = &table->entries[i];
-    if (e->mark) {
-      e->mark = 0;
-      if (live != i) table->entries[live] = *e;
-      live++;
-    } else {
-      if (free_cb) free_cb(e->ptr, e->size, e->kind, ctx);
+  table->sweeping = 1;
+  for (i = 0U; i < table->page_slots; i++) {
+    lizard_gc_page_t *page = table->pages[i];
+    if (page == NULL) continue;
+    live = 0U;
+    for (j = 0U; j < page->object_count; j++) {
+      size_t idx = page->objects[j];
+      lizard_gc_metadata_entry_t *e = &table->entries[idx];
+      size_t word = page_word(e->ptr);
+      if (map_test(page->marks, word)) {
+        entry_promote(table, e);
+        page->objects[live++] = idx;
+        continue;
+      }
+      entry_sweep(table, page, idx, free_cb, ctx);
       freed++;
     }
+    page->object_count = live;
+    page->end_word =
+        live > 0U ? page_word(table->entries[page->objects[live - 1U]].ptr) + 1U
+                  : 0U;
+    memset(page->marks, 0, sizeof(page->marks));
   }
-  table->count = live;
-  table->sorted_count = 0U; /* index is now stale */
+  table->young_count = 0U;
+  table->sweeping = 0;
   return freed;
 }
 
-int lizard_gc_metadata_register(lizard_gc_metadata_table_t *table,
-                                void *ptr,
-                                size_t size,
-                                lizard_gc_object_kind_t kind,
-                                lizard_object_owner_t owner,
-                                lizard_object_trace_policy_t trace_policy) {
+size_t lizard_gc_metadata_sweep_young(lizard_gc_metadata_table_t *table,
+                                      lizard_gc_free_fn free_cb, void *ctx) {
+  size_t i, n, freed = 0U;
+  lizard_gc_page_t **swept;
+  if (table == NULL) return 0U;
+  /* The pages something was freed from, to compact afterwards; an entry
+   * released since it was listed is either gone or listed again. */
+  swept = (lizard_gc_page_t **)malloc((table->young_count + 1U) *
+                                      sizeof(lizard_gc_page_t *));
+  n = 0U;
+  table->sweeping = 1;
+  for (i = 0U; i < table->young_count; i++) {
+    size_t idx = table->young[i];
+    lizard_gc_metadata_entry_t *e = &table->entries[idx];
+    lizard_gc_page_t *page;
+    if (e->ptr == NULL || e->old) continue;
+    page = page_find(table, page_number(e->ptr));
+    if (page == NULL) continue;
+    if (map_test(page->marks, page_word(e->ptr))) {
+      entry_promote(table, e);
+      continue;
+    }
+    if (swept == NULL) continue; /* kept until a full collection */
+    entry_sweep(table, page, idx, free_cb, ctx);
+    freed++;
+    if (n == 0U || swept[n - 1U] != page) swept[n++] = page;
+  }
+  for (i = 0U; i < n; i++) {
+    page_compact(table, swept[i]);
+  }
+  free(swept);
+  table->young_count = 0U;
+  table->sweeping = 0;
+  return freed;
+}
+
+size_t lizard_gc_metadata_release(lizard_gc_metadata_table_t *table,
+                                  const void *ptr) {
+  lizard_gc_page_t *page;
+  size_t idx, n, size;
+  if (table == NULL || ptr == NULL || table->sweeping) return 0U;
+  page_put_pending(table);
+  idx = page_object_at(table, ptr);
+  if (idx == LIZARD_GC_NO_ENTRY) return 0U;
+  page = page_find(table, page_number(ptr));
+  n = starts_before(page, page_word(ptr));
+  size = table->entries[idx].size;
+  entry_sweep(table, page, idx, NULL, NULL);
+  memmove(&page->objects[n], &page->objects[n + 1U],
+          (page->object_count - n - 1U) * sizeof(size_t));
+  page->object_count--;
+  if (n == page->object_count) {
+    page->end_word =
+        n > 0U ? page_word(table->entries[page->objects[n - 1U]].ptr) + 1U
+               : 0U;
+  }
+  return size;
+}
+
+size_t lizard_gc_metadata_old_bytes(const lizard_gc_metadata_table_t *table) {
+  return table != NULL ? table->old_bytes : 0U;
+}
+
+/* Objects still pending are young, so the page map alone answers. */
+int lizard_gc_metadata_is_old(const lizard_gc_metadata_table_t *table,
+                              const void *addr) {
+  lizard_gc_page_t *page;
+  size_t idx;
+  if (table == NULL || table->old_bytes == 0U) return 0;
+  idx = page_object_containing(table, addr, &page);
+  return idx != LIZARD_GC_NO_ENTRY && table->entries[idx].old;
+}
+
+/* Objects of no bytes are not tracked: nothing can point into them, and
+ * they share their address with whatever is allocated next. */
+static int metadata_register(lizard_gc_metadata_table_t *table, void *ptr,
+                             size_t size, lizard_gc_object_kind_t kind,
+                             lizard_object_owner_t owner,
+                             lizard_object_trace_policy_t trace_policy,
+                             int inferred) {
   lizard_gc_metadata_entry_t *entry;
+  size_t idx;
 
   if (table == NULL || ptr == NULL) {
     return 0;
   }
-  if (!metadata_ensure_capacity(table, table->count + 1U)) {
+  if (size == 0U) {
+    return 1;
+  }
+  if (table->pending_count == table->pending_cap) {
+    size_t cap = table->pending_cap ? table->pending_cap * 2U : 1024U;
+    size_t *grown = (size_t *)realloc(table->pending, cap * sizeof(size_t));
+    if (grown == NULL) {
+      table->registration_failures++;
+      return 0;
+    }
+    table->pending = grown;
+    table->pending_cap = cap;
+  }
+  idx = entry_take(table);
+  if (idx == LIZARD_GC_NO_ENTRY) {
     return 0;
   }
-  entry = &table->entries[table->count];
+  entry = &table->entries[idx];
   entry->ptr = ptr;
   entry->size = size;
   entry->kind = kind;
   entry->owner = owner;
   entry->trace_policy = trace_policy;
-  entry->mark = 0;
+  entry->inferred = (unsigned char)(inferred != 0);
+  entry->old = 0;
   table->count++;
+  table->pending[table->pending_count++] = idx;
   return 1;
 }
 
+int lizard_gc_metadata_register(lizard_gc_metadata_table_t *table,
+                                void *ptr,
+                                size_t size,
+                                lizard_gc_object_kind_t kind,
+                                lizard_object_owner_t owner,
+                                lizard_object_trace_policy_t trace_policy) {
+  return metadata_register(table, ptr, size, kind, owner, trace_policy, 0);
+}
+
+int lizard_gc_metadata_register_inferred(
+    lizard_gc_metadata_table_t *table, void *ptr, size_t size,
+    lizard_gc_object_kind_t kind, lizard_object_owner_t owner,
+    lizard_object_trace_policy_t trace_policy) {
+  return metadata_register(table, ptr, size, kind, owner, trace_policy, 1);
+}
+
 int lizard_gc_metadata_lookup(lizard_gc_metadata_table_t *table,
                               const void *ptr,
                               lizard_gc_object_kind_t *out_kind,
                               size_t *out_size,
                               lizard_object_trace_policy_t *out_trace_policy) {
-  size_t i;
+  size_t idx;
 
   if (out_kind != NULL) {
     *out_kind = LIZARD_GC_OBJECT_UNKNOWN;
@@ -301,21 +793,21 @@ int lizard_gc_metadata_lookup(lizard_gc_metadata_table_t *table,
   if (table == NULL || ptr == NULL) {
     return 0;
   }
-  for (i = 0U; i < table->count; i++) {
-    if (table->entries[i].ptr == ptr) {
-      if (out_kind != NULL) {
-        *out_kind = table->entries[i].kind;
-      }
-      if (out_size != NULL) {
-        *out_size = table->entries[i].size;
-      }
-      if (out_trace_policy != NULL) {
-        *out_trace_policy = table->entries[i].trace_policy;
-      }
-      return 1;
-    }
+  page_put_pending(table);
+  idx = page_object_at(table, ptr);
+  if (idx == LIZARD_GC_NO_ENTRY) {
+    return 0;
   }
-  return 0;
+  if (out_kind != NULL) {
+    *out_kind = table->entries[idx].kind;
+  }
+  if (out_size != NULL) {
+    *out_size = table->entries[idx].size;
+  }
+  if (out_trace_policy != NULL) {
+    *out_trace_policy = table->entries[idx].trace_policy;
+  }
+  return 1;
 }
 
 void lizard_gc_metadata_collect_stats(lizard_gc_metadata_table_t *table,
@@ -329,7 +821,10 @@ void lizard_gc_metadata_collect_stats(lizard_gc_metadata_table_t *table,
   out_stats->entries = table->count;
   out_stats->capacity = table->capacity;
   out_stats->registration_failures = table->registration_failures;
-  for (i = 0U; i < table->count; i++) {
+  for (i = 0U; i < table->used; i++) {
+    if (table->entries[i].ptr == NULL) {
+      continue;
+    }
     out_stats->bytes_registered += table->entries[i].size;
     switch (table->entries[i].kind) {
     case LIZARD_GC_OBJECT_AST_NODE:
@@ -350,6 +845,9 @@ void lizard_gc_metadata_collect_stats(lizard_gc_metadata_table_t *table,
     case LIZARD_GC_OBJECT_RAW:
       out_stats->raw_objects++;
       break;
+    case LIZARD_GC_OBJECT_NUMBER:
+      out_stats->numbers++;
+      break;
     case LIZARD_GC_OBJECT_UNKNOWN:
       break;
     }
@@ -18,7 +18,10 @@ typedef enum lizard_gc_object_kind {
   LIZARD_GC_OBJECT_ENV = 3,
   LIZARD_GC_OBJECT_ENV_ENTRY = 4,
   LIZARD_GC_OBJECT_KERNEL_TERM = 5,
-  LIZARD_GC_OBJECT_RAW = 6
+  LIZARD_GC_OBJECT_RAW = 6,
+  /* An AST node made for an exact number, whose GMP payload is cleared
+   * when it is swept. */
+  LIZARD_GC_OBJECT_NUMBER = 7
 } lizard_gc_object_kind_t;
 
 typedef struct lizard_gc_metadata_stats {
@@ -31,6 +34,7 @@ typedef struct lizard_gc_metadata_stats {
   size_t env_entries;
   size_t kernel_terms;
   size_t raw_objects;
+  size_t numbers;
   size_t trace_required;
   size_t registration_failures;
 } lizard_gc_metadata_stats_t;
@@ -46,6 +50,14 @@ int lizard_gc_metadata_register(lizard_gc_metadata_table_t *table,
                                 lizard_gc_object_kind_t kind,
                                 lizard_object_owner_t owner,
                                 lizard_object_trace_policy_t trace_policy);
+/* As lizard_gc_metadata_register, for an object whose kind was inferred
+ * from its size rather than given by whoever allocated it.  Its kind and
+ * trace policy are kept for lookups, but the collector does not trust
+ * them to say where its pointers are and scans it conservatively. */
+int lizard_gc_metadata_register_inferred(
+    lizard_gc_metadata_table_t *table, void *ptr, size_t size,
+    lizard_gc_object_kind_t kind, lizard_object_owner_t owner,
+    lizard_object_trace_policy_t trace_policy);
 int lizard_gc_metadata_lookup(lizard_gc_metadata_table_t *table,
                               const void *ptr,
                               lizard_gc_object_kind_t *out_kind,
@@ -58,18 +70,53 @@ void lizard_gc_metadata_collect_stats(lizard_gc_metadata_table_t *table,
 typedef void (*lizard_gc_free_fn)(void *ptr, size_t size,
                                   lizard_gc_object_kind_t kind, void *ctx);
 
-/* Clear all marks and (re)build the ptr-sorted index for address lookup. */
+/* Clear the mark bitmap of every page of the object map. */
 void lizard_gc_metadata_prepare_marking(lizard_gc_metadata_table_t *table);
 
-/* Mark the tracked object containing `addr`. Returns 1 only on the transition
- * from unmarked to marked (so the caller can enqueue it for scanning). */
+/* Mark the tracked object containing `addr`, found from the page `addr` is
+ * on. Returns 1 only on the transition from unmarked to marked (so the caller
+ * can enqueue it for scanning). */
 int lizard_gc_metadata_mark_addr(lizard_gc_metadata_table_t *table,
                                  const void *addr, void **out_base,
                                  size_t *out_size);
 
-/* Free every unmarked object via free_cb, compact the table to the survivors,
- * and clear their marks. Returns the number of objects freed. */
+/* As lizard_gc_metadata_mark_addr, also giving the object's kind, how
+ * to trace it (its trace policy, or LIZARD_OBJECT_TRACE_CONSERVATIVE when
+ * it was registered with an inferred kind) and whether it is old: kept by
+ * an earlier collection. */
+int lizard_gc_metadata_mark_object(
+    lizard_gc_metadata_table_t *table, const void *addr, void **out_base,
+    size_t *out_size, lizard_gc_object_kind_t *out_kind,
+    lizard_object_trace_policy_t *out_trace_policy, int *out_old);
+
+/* Whether `addr` falls inside an object marked since prepare_marking. */
+int lizard_gc_metadata_is_marked(const lizard_gc_metadata_table_t *table,
+                                 const void *addr);
+
+/* Free every unmarked object via free_cb, drop it from the table and its
+ * page, and clear the survivors' marks; the survivors are old from now on.
+ * Returns the number of objects freed. */
 size_t lizard_gc_metadata_sweep(lizard_gc_metadata_table_t *table,
                                 lizard_gc_free_fn free_cb, void *ctx);
 
+/* As lizard_gc_metadata_sweep for a minor collection: only the objects
+ * registered since the last collection are looked at, and old ones stay
+ * whether marked or not.  Marks are left for the next prepare_marking. */
+size_t lizard_gc_metadata_sweep_young(lizard_gc_metadata_table_t *table,
+                                      lizard_gc_free_fn free_cb, void *ctx);
+
+/* Drop the object that starts at `ptr`, freed by its owner rather than
+ * found dead, and return its size so its chunk can be reused; 0 if no
+ * object starts there, or while the table is being swept: what is freed
+ * then is left to the sweep. */
+size_t lizard_gc_metadata_release(lizard_gc_metadata_table_t *table,
+                                  const void *ptr);
+
+/* Bytes of the objects old now. */
+size_t lizard_gc_metadata_old_bytes(const lizard_gc_metadata_table_t *table);
+
+/* Whether `addr` falls inside an object that is old. */
+int lizard_gc_metadata_is_old(const lizard_gc_metadata_table_t *table,
+                              const void *addr);
+
 #endif /* LIZARD_GC_METADATA_H */
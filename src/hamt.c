@@ -44,8 +44,15 @@ unsigned long lizard_hamt_hash(const lizard_ast_node_t *key) {
     case AST_SYMBOL: return djb2(key->data.variable);
     case AST_STRING: return djb2(key->data.string);
     case AST_NUMBER: {
-      unsigned long h = (unsigned long)mpz_get_ui(key->data.number);
-      if (mpz_sgn(key->data.number) < 0) h = ~h;
+      unsigned long h;
+      if (LIZARD_IS_FIXNUM(key)) {
+        /* same bits as the mpz path below: low limb of |n|, then sign */
+        h = (unsigned long)key->data.fixnum.limb;
+        if (LIZARD_FIXNUM_VALUE(key) < 0) h = ~h;
+      } else {
+        h = (unsigned long)mpz_get_ui(key->data.number);
+        if (mpz_sgn(key->data.number) < 0) h = ~h;
+      }
       h ^= (h >> 16);
       h *= 2654435761UL;
       return h;
@@ -70,7 +77,10 @@ int lizard_hamt_key_equal(const lizard_ast_node_t *a,
   switch (a->type) {
     case AST_SYMBOL: return strcmp(a->data.variable, b->data.variable) == 0;
     case AST_STRING: return strcmp(a->data.string, b->data.string) == 0;
-    case AST_NUMBER: return mpz_cmp(a->data.number, b->data.number) == 0;
+    case AST_NUMBER:
+      if (LIZARD_IS_FIXNUM(a) && LIZARD_IS_FIXNUM(b))
+        return LIZARD_FIXNUM_VALUE(a) == LIZARD_FIXNUM_VALUE(b);
+      return mpz_cmp(a->data.number, b->data.number) == 0;
     case AST_RATIONAL: return mpq_cmp(a->data.rational, b->data.rational) == 0;
     case AST_BOOL:   return a->data.boolean == b->data.boolean;
     case AST_NIL:    return 1;
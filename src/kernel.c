@@ -4,15 +4,37 @@
  * intentionally kept small and simple.
  */
 #include "kernel.h"
+#include "gc.h"
 #include "mem.h"
 #include <stdio.h>
 #include <string.h>
 
 /* ---- constructors ---- */
 
+/* For the collector: past the tag, every field of a term that is not an
+ * index, level or id is a name or a subterm. */
+static void kt_trace(void *obj, size_t size, lizard_gc_visit_fn visit,
+                     void *ctx) {
+  kterm_t *t = (kterm_t *)obj;
+  void **field = (void **)(void *)&t->data;
+  size_t i;
+  (void)size;
+  if (t->tag == KT_VAR || t->tag == KT_SORT || t->tag == KT_META) return;
+  for (i = 0; i < sizeof(t->data) / sizeof(void *); i++) {
+    visit(field[i], ctx);
+  }
+}
+
 static kterm_t *kt_alloc(lizard_heap_t *heap, kterm_tag_t tag) {
-  kterm_t *t = (kterm_t *)lizard_heap_alloc(sizeof(kterm_t));
-  memset(t, 0, sizeof(kterm_t));
+  static int traced = 0;
+  kterm_t *t;
+  if (!traced) {
+    lizard_gc_set_tracer(LIZARD_GC_OBJECT_KERNEL_TERM, kt_trace);
+    traced = 1;
+  }
+  t = (kterm_t *)lizard_heap_alloc_tagged(sizeof(kterm_t),
+                                          LIZARD_GC_OBJECT_KERNEL_TERM,
+                                          LIZARD_OBJECT_TRACE_CUSTOM);
   t->tag = tag;
   return t;
 }
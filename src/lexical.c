@@ -0,0 +1,996 @@
+/* src/lexical.c — lexical addressing for lambda bodies (see lexical.h). */
+
+#include "lexical.h"
+
+#include "env.h"
+#include "gc.h"
+#include "mem.h"
+#include "symbol.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Static scope during resolution: one link per enclosing resolved lambda,
+ * innermost first.  Depth in an AST_LOCAL_REF counts these links. */
+typedef struct lexical_scope {
+  const lizard_frame_layout_t *layout;
+  const struct lexical_scope *outer;
+  /* Laid out without seeing the code now resolved against it, which may
+   * assign its slots: lambdas within are not made flat. */
+  int partial;
+} lexical_scope_t;
+
+/* Growable name list used while laying out a frame. */
+typedef struct {
+  const char **names;
+  size_t count;
+  size_t cap;
+} lexical_names_t;
+
+static lizard_frame_layout_t *resolve_lambda(lizard_ast_node_t *lambda,
+                                             const lexical_scope_t *outer,
+                                             int flat, lizard_heap_t *heap);
+static lizard_ast_node_t *resolve_expr(lizard_ast_node_t *node,
+                                       const lexical_scope_t *scope,
+                                       lizard_heap_t *heap);
+
+static size_t names_find(const lexical_names_t *ns, const char *name) {
+  size_t i;
+  for (i = 0; i < ns->count; i++) {
+    if (ns->names[i] == name) {
+      return i;
+    }
+  }
+  return ns->count;
+}
+
+static void names_add(lexical_names_t *ns, const char *name) {
+  if (names_find(ns, name) < ns->count) {
+    return;
+  }
+  if (ns->count == ns->cap) {
+    size_t cap = ns->cap != 0U ? ns->cap * 2U : 8U;
+    const char **grown = lizard_heap_alloc(cap * sizeof(const char *));
+    if (ns->count > 0U) {
+      memcpy((void *)grown, (const void *)ns->names,
+             ns->count * sizeof(const char *));
+    }
+    ns->names = grown;
+    ns->cap = cap;
+  }
+  ns->names[ns->count++] = name;
+}
+
+/* Collect the names `node` defines in the frame it is evaluated in.  Nested
+ * lambdas get their own frames, and forms the resolver does not know are
+ * left alone: a define hidden in one lands in the frame's entry list at run
+ * time, which makes local references through that frame take the by-name
+ * path. */
+static void collect_defines(lizard_ast_node_t *node, lexical_names_t *ns) {
+  lz_list_node_t *it;
+  if (node == NULL) {
+    return;
+  }
+  switch (node->type) {
+  case AST_DEFINITION:
+    if (node->data.definition.variable != NULL &&
+        node->data.definition.variable->type == AST_SYMBOL) {
+      names_add(ns, lizard_intern(node->data.definition.variable->data.variable));
+    }
+    collect_defines(node->data.definition.value, ns);
+    break;
+  case AST_MACRO:
+    if (node->data.macro_def.variable != NULL &&
+        node->data.macro_def.variable->type == AST_SYMBOL) {
+      names_add(ns, lizard_intern(node->data.macro_def.variable->data.variable));
+    }
+    break;
+  case AST_ASSIGNMENT:
+    collect_defines(node->data.assignment.value, ns);
+    break;
+  case AST_IF:
+    collect_defines(node->data.if_clause.pred, ns);
+    collect_defines(node->data.if_clause.cons, ns);
+    collect_defines(node->data.if_clause.alt, ns);
+    break;
+  case AST_BEGIN:
+    for (it = node->data.begin_expressions->head;
+         it != node->data.begin_expressions->nil; it = it->next) {
+      collect_defines(((lizard_ast_list_node_t *)it)->ast, ns);
+    }
+    break;
+  case AST_COND:
+    for (it = node->data.cond_clauses->head; it != node->data.cond_clauses->nil;
+         it = it->next) {
+      collect_defines(((lizard_ast_list_node_t *)it)->ast, ns);
+    }
+    break;
+  case AST_APPLICATION:
+  case AST_CALLCC:
+    for (it = node->data.application_arguments->head;
+         it != node->data.application_arguments->nil; it = it->next) {
+      collect_defines(((lizard_ast_list_node_t *)it)->ast, ns);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+/* Lay out the parameter spec (the head of a lambda's parameter list).
+ * Returns 0 for specs the generic binder should handle (and report). */
+static int layout_params(lizard_ast_node_t *spec, lexical_names_t *ns,
+                         size_t *nparams, int *rest) {
+  lz_list_node_t *it;
+  *nparams = 0U;
+  *rest = 0;
+  if (spec->type == AST_NIL) {
+    return 1;
+  }
+  if (spec->type == AST_SYMBOL) {
+    names_add(ns, lizard_intern(spec->data.variable));
+    *rest = 1;
+    return 1;
+  }
+  if (spec->type != AST_APPLICATION) {
+    return 0;
+  }
+  for (it = spec->data.application_arguments->head;
+       it != spec->data.application_arguments->nil; it = it->next) {
+    lizard_ast_node_t *p = ((lizard_ast_list_node_t *)it)->ast;
+    const char *name;
+    if (p->type != AST_SYMBOL) {
+      return 0;
+    }
+    if (strcmp(p->data.variable, ".") == 0) {
+      lizard_ast_node_t *r;
+      if (it->next == spec->data.application_arguments->nil ||
+          it->next->next != spec->data.application_arguments->nil) {
+        return 0;
+      }
+      r = ((lizard_ast_list_node_t *)it->next)->ast;
+      if (r->type != AST_SYMBOL) {
+        return 0;
+      }
+      name = lizard_intern(r->data.variable);
+      if (names_find(ns, name) < ns->count) {
+        return 0;
+      }
+      names_add(ns, name);
+      *rest = 1;
+      return 1;
+    }
+    name = lizard_intern(p->data.variable);
+    if (names_find(ns, name) < ns->count) {
+      return 0; /* duplicate parameter: keep by-name shadowing semantics */
+    }
+    names_add(ns, name);
+    (*nparams)++;
+  }
+  return 1;
+}
+
+static lizard_ast_node_t *make_local_ref(lizard_ast_node_t *sym,
+                                         const char *name, unsigned int depth,
+                                         unsigned int slot,
+                                         const lizard_frame_layout_t *layout) {
+  lizard_ast_node_t *ref = lizard_heap_alloc_tagged(
+      sizeof(lizard_ast_node_t), LIZARD_GC_OBJECT_AST_NODE,
+      LIZARD_OBJECT_TRACE_AST);
+  ref->type = AST_LOCAL_REF;
+  ref->span = sym->span;
+  ref->data.local_ref.name = name;
+  ref->data.local_ref.depth = depth;
+  ref->data.local_ref.slot = slot;
+  ref->data.local_ref.layout = layout;
+  return ref;
+}
+
+/* ---- flat closures ----------------------------------------------------- */
+
+/* Mark in layout->assigned the slots `node` may assign: set! targets and
+ * defines of a parameter, at any depth, nested lambdas included (a
+ * shadowing binding there only costs a missed flat closure).  Returns 0 on
+ * a form it cannot see into. */
+static int note_assigned(lizard_ast_node_t *node, lizard_frame_layout_t *layout) {
+  lz_list_t *list = NULL;
+  lz_list_node_t *it;
+  const char *target = NULL;
+  if (node == NULL) {
+    return 1;
+  }
+  switch (node->type) {
+  case AST_ASSIGNMENT:
+    if (node->data.assignment.variable->type != AST_SYMBOL) {
+      return 0;
+    }
+    target = node->data.assignment.variable->data.variable;
+    if (!note_assigned(node->data.assignment.value, layout)) {
+      return 0;
+    }
+    break;
+  case AST_DEFINITION:
+    if (node->data.definition.variable->type != AST_SYMBOL) {
+      return 0;
+    }
+    target = node->data.definition.variable->data.variable;
+    if (!note_assigned(node->data.definition.value, layout)) {
+      return 0;
+    }
+    break;
+  case AST_IF:
+    return note_assigned(node->data.if_clause.pred, layout) &&
+           note_assigned(node->data.if_clause.cons, layout) &&
+           note_assigned(node->data.if_clause.alt, layout);
+  case AST_BEGIN:
+    list = node->data.begin_expressions;
+    break;
+  case AST_COND:
+    list = node->data.cond_clauses;
+    break;
+  case AST_APPLICATION:
+  case AST_CALLCC:
+    list = node->data.application_arguments;
+    break;
+  case AST_LAMBDA:
+    for (it = node->data.lambda.parameters->head->next;
+         it != node->data.lambda.parameters->nil; it = it->next) {
+      if (!note_assigned(((lizard_ast_list_node_t *)it)->ast, layout)) {
+        return 0;
+      }
+    }
+    return 1;
+  case AST_QUOTE:
+  case AST_SYMBOL:
+  case AST_NUMBER:
+  case AST_RATIONAL:
+  case AST_REAL:
+  case AST_STRING:
+  case AST_BOOL:
+  case AST_NIL:
+    return 1;
+  default:
+    return 0;
+  }
+  if (target != NULL) {
+    size_t i;
+    target = lizard_intern(target);
+    for (i = 0; i < layout->nslots; i++) {
+      if (layout->names[i] == target) {
+        layout->assigned[i] = 1;
+      }
+    }
+    return 1;
+  }
+  for (it = list->head; it != list->nil; it = it->next) {
+    if (!note_assigned(((lizard_ast_list_node_t *)it)->ast, layout)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Names bound inside the lambda being made flat, innermost first. */
+typedef struct capture_scope {
+  const char **names;
+  size_t count;
+  const struct capture_scope *outer;
+} capture_scope_t;
+
+/* The enclosing variables a flat closure copies, and where from. */
+typedef struct {
+  lexical_names_t names;
+  lizard_ast_node_t **from;
+  size_t from_cap;
+} capture_set_t;
+
+static int scope_binds(const capture_scope_t *s, const char *name) {
+  size_t i;
+  for (; s != NULL; s = s->outer) {
+    for (i = 0; i < s->count; i++) {
+      if (s->names[i] == name) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* Depth, slot and layout of `name` in the resolver's scope chain. */
+static int scope_find(const lexical_scope_t *scope, const char *name,
+                      unsigned int *depth, size_t *slot,
+                      const lizard_frame_layout_t **layout) {
+  unsigned int d = 0U;
+  for (; scope != NULL; scope = scope->outer, d++) {
+    size_t i;
+    for (i = 0; i < scope->layout->nslots; i++) {
+      if (scope->layout->names[i] == name) {
+        *depth = d;
+        *slot = i;
+        *layout = scope->layout;
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* Whether quoted `datum` names a variable of the enclosing scopes. */
+static int datum_mentions(const lizard_ast_node_t *datum,
+                          const lexical_scope_t *outer) {
+  lz_list_node_t *it;
+  unsigned int depth;
+  size_t slot;
+  const lizard_frame_layout_t *layout;
+  if (datum == NULL) {
+    return 0;
+  }
+  switch (datum->type) {
+  case AST_SYMBOL:
+    return scope_find(outer, lizard_intern(datum->data.variable), &depth, &slot,
+                      &layout);
+  case AST_PAIR:
+    return datum_mentions(datum->data.pair.car, outer) ||
+           datum_mentions(datum->data.pair.cdr, outer);
+  case AST_APPLICATION:
+    for (it = datum->data.application_arguments->head;
+         it != datum->data.application_arguments->nil; it = it->next) {
+      if (datum_mentions(((lizard_ast_list_node_t *)it)->ast, outer)) {
+        return 1;
+      }
+    }
+    return 0;
+  case AST_QUOTE:
+  case AST_QUASIQUOTE:
+  case AST_UNQUOTE:
+  case AST_UNQUOTE_SPLICING:
+    return datum_mentions(datum->data.quoted, outer);
+  default:
+    return 0;
+  }
+}
+
+/* Add the reference to enclosing `name` to `caps`; 0 when it cannot be
+ * copied: only parameters nothing assigns can. */
+static int capture(capture_set_t *caps, const char *name,
+                   const lexical_scope_t *outer, lizard_ast_node_t *sym) {
+  unsigned int depth;
+  size_t slot;
+  const lizard_frame_layout_t *layout;
+  if (!scope_find(outer, name, &depth, &slot, &layout)) {
+    return 1; /* global */
+  }
+  if (slot >= layout->nparams + (layout->rest ? 1U : 0U) ||
+      (layout->assigned != NULL && layout->assigned[slot])) {
+    return 0;
+  }
+  if (names_find(&caps->names, name) < caps->names.count) {
+    return 1;
+  }
+  if (caps->names.count == caps->from_cap) {
+    size_t cap = caps->from_cap != 0U ? caps->from_cap * 2U : 8U;
+    lizard_ast_node_t **grown = lizard_heap_alloc(cap * sizeof(lizard_ast_node_t *));
+    if (caps->names.count > 0U) {
+      memcpy(grown, caps->from, caps->names.count * sizeof(lizard_ast_node_t *));
+    }
+    caps->from = grown;
+    caps->from_cap = cap;
+  }
+  caps->from[caps->names.count] =
+      make_local_ref(sym, name, depth, (unsigned int)slot, layout);
+  names_add(&caps->names, name);
+  return 1;
+}
+
+static int find_captures(lizard_ast_node_t *node, const capture_scope_t *inner,
+                         const lexical_scope_t *outer, capture_set_t *caps);
+
+static int find_captures_list(lz_list_node_t *it, lz_list_node_t *nil,
+                              const capture_scope_t *inner,
+                              const lexical_scope_t *outer,
+                              capture_set_t *caps) {
+  for (; it != nil; it = it->next) {
+    if (!find_captures(((lizard_ast_list_node_t *)it)->ast, inner, outer, caps)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Collect into `caps` the enclosing variables `node` uses, walking it as
+ * resolve_expr does; 0 when the lambda cannot be flat. */
+static int find_captures(lizard_ast_node_t *node, const capture_scope_t *inner,
+                         const lexical_scope_t *outer, capture_set_t *caps) {
+  lz_list_node_t *it;
+  const char *name;
+  if (node == NULL) {
+    return 1;
+  }
+  switch (node->type) {
+  case AST_SYMBOL:
+    name = lizard_intern(node->data.variable);
+    return scope_binds(inner, name) || capture(caps, name, outer, node);
+  case AST_ASSIGNMENT: {
+    unsigned int depth;
+    size_t slot;
+    const lizard_frame_layout_t *layout;
+    if (node->data.assignment.variable->type != AST_SYMBOL) {
+      return 0;
+    }
+    name = lizard_intern(node->data.assignment.variable->data.variable);
+    if (!scope_binds(inner, name) &&
+        scope_find(outer, name, &depth, &slot, &layout)) {
+      return 0;
+    }
+    return find_captures(node->data.assignment.value, inner, outer, caps);
+  }
+  case AST_DEFINITION:
+    return find_captures(node->data.definition.value, inner, outer, caps);
+  case AST_IF:
+    return find_captures(node->data.if_clause.pred, inner, outer, caps) &&
+           find_captures(node->data.if_clause.cons, inner, outer, caps) &&
+           find_captures(node->data.if_clause.alt, inner, outer, caps);
+  case AST_BEGIN:
+    return find_captures_list(node->data.begin_expressions->head,
+                              node->data.begin_expressions->nil, inner, outer,
+                              caps);
+  case AST_COND:
+    for (it = node->data.cond_clauses->head; it != node->data.cond_clauses->nil;
+         it = it->next) {
+      lizard_ast_node_t *clause = ((lizard_ast_list_node_t *)it)->ast;
+      lz_list_node_t *first;
+      if (clause->type != AST_APPLICATION) {
+        return 0;
+      }
+      first = clause->data.application_arguments->head;
+      if (first != clause->data.application_arguments->nil &&
+          ((lizard_ast_list_node_t *)first)->ast->type == AST_SYMBOL &&
+          strcmp(((lizard_ast_list_node_t *)first)->ast->data.variable,
+                 "else") == 0) {
+        first = first->next;
+      }
+      if (!find_captures_list(first, clause->data.application_arguments->nil,
+                              inner, outer, caps)) {
+        return 0;
+      }
+    }
+    return 1;
+  case AST_APPLICATION:
+  case AST_CALLCC:
+    return find_captures_list(node->data.application_arguments->head,
+                              node->data.application_arguments->nil, inner,
+                              outer, caps);
+  case AST_LAMBDA: {
+    lexical_names_t ns;
+    capture_scope_t scope;
+    lz_list_t *params = node->data.lambda.parameters;
+    size_t nparams;
+    int rest;
+    /* Resolved elsewhere, against frames this closure will not have. */
+    if (node->data.lambda.layout != NULL) {
+      return 0;
+    }
+    if (params == NULL || params->head == params->nil) {
+      return 1;
+    }
+    ns.names = NULL;
+    ns.count = 0U;
+    ns.cap = 0U;
+    if (!layout_params(((lizard_ast_list_node_t *)params->head)->ast, &ns,
+                       &nparams, &rest)) {
+      return 0;
+    }
+    for (it = params->head->next; it != params->nil; it = it->next) {
+      collect_defines(((lizard_ast_list_node_t *)it)->ast, &ns);
+    }
+    scope.names = ns.names;
+    scope.count = ns.count;
+    scope.outer = inner;
+    return find_captures_list(params->head->next, params->nil, &scope, outer,
+                              caps);
+  }
+  case AST_QUOTE:
+    return !datum_mentions(node->data.quoted, outer);
+  case AST_NUMBER:
+  case AST_RATIONAL:
+  case AST_REAL:
+  case AST_STRING:
+  case AST_BOOL:
+  case AST_NIL:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/* Make `layout` (being resolved inside `outer`) a flat closure if it can
+ * be: fills in its capture layout, and returns the scope link its body
+ * resolves against in `cscope`. */
+static int make_flat(lizard_ast_node_t *lambda, lizard_frame_layout_t *layout,
+                     const lexical_scope_t *outer, lexical_scope_t *cscope) {
+  lz_list_t *params = lambda->data.lambda.parameters;
+  capture_scope_t inner;
+  capture_set_t caps;
+  lizard_frame_layout_t *captures;
+  const lexical_scope_t *s;
+  unsigned int n = 0U;
+  inner.names = layout->names;
+  inner.count = layout->nslots;
+  inner.outer = NULL;
+  caps.names.names = NULL;
+  caps.names.count = 0U;
+  caps.names.cap = 0U;
+  caps.from = NULL;
+  caps.from_cap = 0U;
+  if (!find_captures_list(params->head->next, params->nil, &inner, outer,
+                          &caps)) {
+    return 0;
+  }
+  captures = lizard_heap_alloc(sizeof(lizard_frame_layout_t));
+  captures->nslots = caps.names.count;
+  captures->nparams = caps.names.count;
+  captures->names = caps.names.names;
+  layout->captures = captures;
+  layout->captured_from = caps.from;
+  for (s = outer; s != NULL; s = s->outer) {
+    n++;
+  }
+  layout->outer_layouts = lizard_heap_alloc(n * sizeof(lizard_frame_layout_t *));
+  n = 0U;
+  for (s = outer; s != NULL; s = s->outer) {
+    layout->outer_layouts[n++] = s->layout;
+  }
+  layout->outer_depth = n;
+  cscope->layout = captures;
+  cscope->outer = NULL;
+  cscope->partial = 0;
+  return 1;
+}
+
+lizard_env_t *lizard_lexical_closure_env(const lizard_frame_layout_t *layout,
+                                         lizard_env_t *env,
+                                         lizard_heap_t *heap) {
+  lizard_env_t *e = env;
+  lizard_env_t *frame;
+  size_t i;
+  if (layout == NULL || layout->captures == NULL) {
+    return env;
+  }
+  for (i = 0; i < layout->outer_depth; i++) {
+    if (e == NULL || e->layout != layout->outer_layouts[i] || e->entries != NULL) {
+      return env;
+    }
+    e = e->parent;
+  }
+  frame = lizard_env_create_frame(heap, e, layout->captures);
+  for (i = 0; i < layout->captures->nslots; i++) {
+    frame->slots[i] = lizard_lexical_lookup(env, layout->captured_from[i]);
+    if (frame->slots[i] == NULL) {
+      return env;
+    }
+  }
+  return frame;
+}
+
+/* Resolve every element of `list`; returns `list` itself when nothing
+ * changed so unaffected subtrees stay shared with the source AST.  With
+ * `keep_else`, a leading `else` symbol (a cond clause) is left alone. */
+static lz_list_t *resolve_list(lz_list_t *list, const lexical_scope_t *scope,
+                               lizard_heap_t *heap, int keep_else) {
+  lz_list_t *out;
+  lz_list_node_t *it;
+  int changed = 0;
+  out = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+  for (it = list->head; it != list->nil; it = it->next) {
+    lizard_ast_node_t *e = ((lizard_ast_list_node_t *)it)->ast;
+    lizard_ast_node_t *r = e;
+    lizard_ast_list_node_t *w;
+    if (!(keep_else && it == list->head && e->type == AST_SYMBOL &&
+          strcmp(e->data.variable, "else") == 0)) {
+      r = resolve_expr(e, scope, heap);
+    }
+    if (r != e) {
+      changed = 1;
+    }
+    w = lizard_heap_alloc(sizeof(lizard_ast_list_node_t));
+    w->ast = r;
+    list_append(out, &w->node);
+  }
+  return changed ? out : list;
+}
+
+static lizard_ast_node_t *resolve_expr(lizard_ast_node_t *node,
+                                       const lexical_scope_t *scope,
+                                       lizard_heap_t *heap) {
+  if (node == NULL) {
+    return NULL;
+  }
+  switch (node->type) {
+  case AST_SYMBOL: {
+    const char *name = lizard_intern(node->data.variable);
+    const lexical_scope_t *s;
+    unsigned int depth = 0U;
+    for (s = scope; s != NULL; s = s->outer, depth++) {
+      size_t i;
+      for (i = 0; i < s->layout->nslots; i++) {
+        if (s->layout->names[i] == name) {
+          return make_local_ref(node, name, depth, (unsigned int)i, s->layout);
+        }
+      }
+    }
+    return node;
+  }
+  case AST_DEFINITION: {
+    lizard_ast_node_t *v = resolve_expr(node->data.definition.value, scope, heap);
+    lizard_ast_node_t *c;
+    if (v == node->data.definition.value) {
+      return node;
+    }
+    c = lizard_copy_node(heap, node);
+    c->data.definition.value = v;
+    return c;
+  }
+  case AST_ASSIGNMENT: {
+    lizard_ast_node_t *v = resolve_expr(node->data.assignment.value, scope, heap);
+    lizard_ast_node_t *c;
+    if (v == node->data.assignment.value) {
+      return node;
+    }
+    c = lizard_copy_node(heap, node);
+    c->data.assignment.value = v;
+    return c;
+  }
+  case AST_IF: {
+    lizard_ast_node_t *p = resolve_expr(node->data.if_clause.pred, scope, heap);
+    lizard_ast_node_t *t = resolve_expr(node->data.if_clause.cons, scope, heap);
+    lizard_ast_node_t *f = resolve_expr(node->data.if_clause.alt, scope, heap);
+    lizard_ast_node_t *c;
+    if (p == node->data.if_clause.pred && t == node->data.if_clause.cons &&
+        f == node->data.if_clause.alt) {
+      return node;
+    }
+    c = lizard_copy_node(heap, node);
+    c->data.if_clause.pred = p;
+    c->data.if_clause.cons = t;
+    c->data.if_clause.alt = f;
+    return c;
+  }
+  case AST_BEGIN: {
+    lz_list_t *l = resolve_list(node->data.begin_expressions, scope, heap, 0);
+    lizard_ast_node_t *c;
+    if (l == node->data.begin_expressions) {
+      return node;
+    }
+    c = lizard_copy_node(heap, node);
+    c->data.begin_expressions = l;
+    return c;
+  }
+  case AST_COND: {
+    lz_list_t *out;
+    lz_list_node_t *it;
+    lizard_ast_node_t *c;
+    int changed = 0;
+    out = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+    for (it = node->data.cond_clauses->head; it != node->data.cond_clauses->nil;
+         it = it->next) {
+      lizard_ast_node_t *clause = ((lizard_ast_list_node_t *)it)->ast;
+      lizard_ast_node_t *r = clause;
+      lizard_ast_list_node_t *w;
+      if (clause->type == AST_APPLICATION) {
+        lz_list_t *l =
+            resolve_list(clause->data.application_arguments, scope, heap, 1);
+        if (l != clause->data.application_arguments) {
+          r = lizard_copy_node(heap, clause);
+          r->data.application_arguments = l;
+          changed = 1;
+        }
+      }
+      w = lizard_heap_alloc(sizeof(lizard_ast_list_node_t));
+      w->ast = r;
+      list_append(out, &w->node);
+    }
+    if (!changed) {
+      return node;
+    }
+    c = lizard_copy_node(heap, node);
+    c->data.cond_clauses = out;
+    return c;
+  }
+  case AST_APPLICATION:
+  case AST_CALLCC: {
+    lz_list_t *l;
+    lizard_ast_node_t *c;
+    if (node->data.application_arguments->head !=
+        node->data.application_arguments->nil) {
+      /* A lambda applied on the spot does not outlive its frame. */
+      lizard_ast_node_t *op =
+          ((lizard_ast_list_node_t *)node->data.application_arguments->head)->ast;
+      if (op->type == AST_LAMBDA && op->data.lambda.layout == NULL) {
+        (void)resolve_lambda(op, scope, 0, heap);
+      }
+    }
+    l = resolve_list(node->data.application_arguments, scope, heap, 0);
+    if (l == node->data.application_arguments) {
+      return node;
+    }
+    c = lizard_copy_node(heap, node);
+    c->data.application_arguments = l;
+    return c;
+  }
+  case AST_LAMBDA:
+    /* The layout is recorded on the lambda node itself; the node is
+     * returned unchanged so the source AST stays intact. */
+    if (node->data.lambda.layout == NULL) {
+      (void)resolve_lambda(node, scope, 1, heap);
+    }
+    return node;
+  default:
+    /* Quoted data, quasiquote templates, macros and foreign forms keep
+     * their symbols; those resolve by name. */
+    return node;
+  }
+}
+
+static lizard_frame_layout_t *resolve_lambda(lizard_ast_node_t *lambda,
+                                             const lexical_scope_t *outer,
+                                             int flat, lizard_heap_t *heap) {
+  lizard_frame_layout_t *layout;
+  lexical_names_t ns;
+  lexical_scope_t scope;
+  lexical_scope_t cscope;
+  lz_list_t *params = lambda->data.lambda.parameters;
+  lz_list_node_t *it;
+
+  layout = lizard_heap_alloc(sizeof(lizard_frame_layout_t));
+  lambda->data.lambda.layout = layout;
+  lizard_gc_write_barrier(&lambda->data.lambda.layout);
+  if (params == NULL || params->head == params->nil) {
+    return layout;
+  }
+  ns.names = NULL;
+  ns.count = 0U;
+  ns.cap = 0U;
+  if (!layout_params(((lizard_ast_list_node_t *)params->head)->ast, &ns,
+                     &layout->nparams, &layout->rest)) {
+    return layout;
+  }
+  for (it = params->head->next; it != params->nil; it = it->next) {
+    collect_defines(((lizard_ast_list_node_t *)it)->ast, &ns);
+  }
+  layout->nslots = ns.count;
+  layout->names = ns.names;
+  layout->assigned = lizard_heap_alloc(ns.count + 1U);
+  for (it = params->head->next; it != params->nil; it = it->next) {
+    if (!note_assigned(((lizard_ast_list_node_t *)it)->ast, layout)) {
+      memset(layout->assigned, 1, ns.count + 1U);
+      break;
+    }
+  }
+
+  scope.layout = layout;
+  scope.outer = outer;
+  scope.partial = outer != NULL && outer->partial;
+  if (flat && !scope.partial && outer != NULL && make_flat(lambda, layout, outer, &cscope)) {
+    scope.outer = &cscope;
+  }
+  layout->body = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+  for (it = params->head->next; it != params->nil; it = it->next) {
+    lizard_ast_list_node_t *w = lizard_heap_alloc(sizeof(lizard_ast_list_node_t));
+    w->ast = resolve_expr(((lizard_ast_list_node_t *)it)->ast, &scope, heap);
+    list_append(layout->body, &w->node);
+  }
+  layout->resolved = 1;
+  return layout;
+}
+
+lizard_frame_layout_t *lizard_lexical_resolve(lizard_ast_node_t *lambda,
+                                              lizard_heap_t *heap) {
+  if (lambda->data.lambda.layout != NULL) {
+    return lambda->data.lambda.layout;
+  }
+  return resolve_lambda(lambda, NULL, 0, heap);
+}
+
+/* ---- run-time macro expansion ----------------------------------------- */
+
+static lizard_ast_node_t *unresolve_expr(lizard_ast_node_t *node,
+                                         lizard_heap_t *heap);
+
+/* As resolve_list, the other way. */
+static lz_list_t *unresolve_list(lz_list_t *list, lizard_heap_t *heap) {
+  lz_list_t *out;
+  lz_list_node_t *it;
+  int changed = 0;
+  out = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+  for (it = list->head; it != list->nil; it = it->next) {
+    lizard_ast_node_t *e = ((lizard_ast_list_node_t *)it)->ast;
+    lizard_ast_node_t *r = unresolve_expr(e, heap);
+    lizard_ast_list_node_t *w;
+    if (r != e) {
+      changed = 1;
+    }
+    w = lizard_heap_alloc(sizeof(lizard_ast_list_node_t));
+    w->ast = r;
+    list_append(out, &w->node);
+  }
+  return changed ? out : list;
+}
+
+/* Walks what resolve_expr rewrites, and turns each local reference back
+ * into the symbol it was made from. */
+static lizard_ast_node_t *unresolve_expr(lizard_ast_node_t *node,
+                                         lizard_heap_t *heap) {
+  lizard_ast_node_t *c;
+  if (node == NULL) {
+    return NULL;
+  }
+  switch (node->type) {
+  case AST_LOCAL_REF:
+    c = lizard_heap_alloc_tagged(sizeof(lizard_ast_node_t),
+                                 LIZARD_GC_OBJECT_AST_NODE,
+                                 LIZARD_OBJECT_TRACE_AST);
+    c->type = AST_SYMBOL;
+    c->span = node->span;
+    c->data.variable = node->data.local_ref.name;
+    return c;
+  case AST_DEFINITION: {
+    lizard_ast_node_t *v = unresolve_expr(node->data.definition.value, heap);
+    if (v == node->data.definition.value) {
+      return node;
+    }
+    c = lizard_copy_node(heap, node);
+    c->data.definition.value = v;
+    return c;
+  }
+  case AST_ASSIGNMENT: {
+    lizard_ast_node_t *v = unresolve_expr(node->data.assignment.value, heap);
+    if (v == node->data.assignment.value) {
+      return node;
+    }
+    c = lizard_copy_node(heap, node);
+    c->data.assignment.value = v;
+    return c;
+  }
+  case AST_IF: {
+    lizard_ast_node_t *p = unresolve_expr(node->data.if_clause.pred, heap);
+    lizard_ast_node_t *t = unresolve_expr(node->data.if_clause.cons, heap);
+    lizard_ast_node_t *f = unresolve_expr(node->data.if_clause.alt, heap);
+    if (p == node->data.if_clause.pred && t == node->data.if_clause.cons &&
+        f == node->data.if_clause.alt) {
+      return node;
+    }
+    c = lizard_copy_node(heap, node);
+    c->data.if_clause.pred = p;
+    c->data.if_clause.cons = t;
+    c->data.if_clause.alt = f;
+    return c;
+  }
+  case AST_BEGIN: {
+    lz_list_t *l = unresolve_list(node->data.begin_expressions, heap);
+    if (l == node->data.begin_expressions) {
+      return node;
+    }
+    c = lizard_copy_node(heap, node);
+    c->data.begin_expressions = l;
+    return c;
+  }
+  case AST_COND: {
+    lz_list_t *l = unresolve_list(node->data.cond_clauses, heap);
+    if (l == node->data.cond_clauses) {
+      return node;
+    }
+    c = lizard_copy_node(heap, node);
+    c->data.cond_clauses = l;
+    return c;
+  }
+  case AST_APPLICATION:
+  case AST_CALLCC: {
+    lz_list_t *l = unresolve_list(node->data.application_arguments, heap);
+    if (l == node->data.application_arguments) {
+      return node;
+    }
+    c = lizard_copy_node(heap, node);
+    c->data.application_arguments = l;
+    return c;
+  }
+  default:
+    return node;
+  }
+}
+
+lizard_ast_node_t *lizard_lexical_unresolve(lizard_ast_node_t *form,
+                                            lizard_heap_t *heap) {
+  return unresolve_expr(form, heap);
+}
+
+lizard_ast_node_t *lizard_lexical_resolve_in(lizard_ast_node_t *form,
+                                             lizard_env_t *env,
+                                             lizard_heap_t *heap) {
+  lexical_scope_t *links;
+  lizard_ast_node_t *resolved;
+  lizard_env_t *e;
+  size_t i, n = 0U;
+  for (e = env; e != NULL && e->layout != NULL; e = e->parent) {
+    n++;
+  }
+  if (n == 0U) {
+    return resolve_expr(form, NULL, heap);
+  }
+  links = (lexical_scope_t *)malloc(n * sizeof(lexical_scope_t));
+  if (links == NULL) {
+    return form;
+  }
+  for (e = env, i = 0U; i < n; e = e->parent, i++) {
+    links[i].layout = e->layout;
+    links[i].outer = i + 1U < n ? &links[i + 1U] : NULL;
+    links[i].partial = 1;
+  }
+  resolved = resolve_expr(form, links, heap);
+  free(links);
+  return resolved;
+}
+
+lizard_frame_status_t lizard_lexical_bind(lizard_heap_t *heap,
+                                          const lizard_frame_layout_t *layout,
+                                          lizard_env_t *closure_env,
+                                          lz_list_t *args,
+                                          lizard_env_t **out_env) {
+  lizard_env_t *frame;
+  lz_list_node_t *it = args->head;
+  size_t i;
+  frame = lizard_env_create_frame(heap, closure_env, layout);
+  for (i = 0; i < layout->nparams; i++) {
+    if (it == args->nil) {
+      return LIZARD_FRAME_TOO_FEW;
+    }
+    /* Forcing a promise may collect, leaving the frame old. */
+    frame->slots[i] = lizard_force(((lizard_ast_list_node_t *)it)->ast, heap);
+    lizard_gc_write_barrier(&frame->slots[i]);
+    it = it->next;
+  }
+  if (layout->rest) {
+    lizard_ast_node_t *nil = lizard_make_nil(heap);
+    lizard_ast_node_t *xs = nil;
+    lizard_ast_node_t *tail = NULL;
+    for (; it != args->nil; it = it->next) {
+      lizard_ast_node_t *pair = lizard_heap_alloc_tagged(
+          sizeof(lizard_ast_node_t), LIZARD_GC_OBJECT_AST_NODE,
+          LIZARD_OBJECT_TRACE_AST);
+      pair->type = AST_PAIR;
+      pair->data.pair.car =
+          lizard_force(((lizard_ast_list_node_t *)it)->ast, heap);
+      lizard_gc_write_barrier(&pair->data.pair.car);
+      pair->data.pair.cdr = nil;
+      if (tail != NULL) {
+        tail->data.pair.cdr = pair;
+        lizard_gc_write_barrier(&tail->data.pair.cdr);
+      } else {
+        xs = pair;
+      }
+      tail = pair;
+    }
+    frame->slots[layout->nparams] = xs;
+    lizard_gc_write_barrier(&frame->slots[layout->nparams]);
+  } else if (it != args->nil) {
+    return LIZARD_FRAME_TOO_MANY;
+  }
+  *out_env = frame;
+  return LIZARD_FRAME_OK;
+}
+
+lizard_ast_node_t *lizard_lexical_lookup(lizard_env_t *env,
+                                         const lizard_ast_node_t *ref) {
+  lizard_env_t *e = env;
+  unsigned int d;
+  for (d = 0; d < ref->data.local_ref.depth; d++) {
+    if (e == NULL || e->entries != NULL) {
+      return lizard_env_lookup(env, ref->data.local_ref.name);
+    }
+    e = e->parent;
+  }
+  if (e != NULL && e->layout == ref->data.local_ref.layout &&
+      e->slots[ref->data.local_ref.slot] != NULL) {
+    return e->slots[ref->data.local_ref.slot];
+  }
+  return lizard_env_lookup(env, ref->data.local_ref.name);
+}
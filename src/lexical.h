@@ -0,0 +1,97 @@
+/* src/lexical.h — lexical addressing for lambda bodies.
+ *
+ * The first time a lambda expression is evaluated, lizard_lexical_resolve
+ * lays out its frame — required parameters, an optional rest parameter, then
+ * every name the body defines — and produces a resolved copy of the body in
+ * which references to variables bound by the lambda or by any enclosing
+ * resolved lambda become AST_LOCAL_REF (depth, slot) nodes.  Nested lambdas
+ * are laid out in the same pass.  Free variables stay AST_SYMBOL and are
+ * looked up by name, as before.
+ *
+ * Applying a resolved closure allocates a single slot frame
+ * (lizard_env_create_frame) instead of one env plus one entry per parameter.
+ * Slot frames keep their names, so every by-name operation (eval, set!,
+ * define, closures the resolver did not reach) still sees them.  A local
+ * reference checks the layout of the frame it lands on and falls back to a
+ * by-name lookup whenever the frames on the way do not match what the
+ * resolver saw, so a stale or shared resolution can only be slow, never
+ * wrong.
+ *
+ * A lambda nested in resolved ones is a flat closure when every enclosing
+ * variable it uses is a parameter nothing assigns: its closures copy those
+ * values into a small capture frame parented on the by-name env, so they
+ * neither keep the enclosing frames alive nor walk them.  A lambda that
+ * assigns, or quotes the name of, an enclosing variable, uses one defined
+ * in an enclosing body, or contains a form the resolver does not know
+ * keeps its defining env, as does a lambda in operator position, which is
+ * applied at once.  Bodies are scanned after macro expansion; a macro
+ * defined only later that expands to an enclosing name is not seen, and
+ * neither is a set! that a use the expander does not reach (in a cond
+ * clause, say) expands to when run.
+ */
+#ifndef LIZARD_LEXICAL_H
+#define LIZARD_LEXICAL_H
+
+#include "lizard_internal.h"
+
+struct lizard_frame_layout {
+  size_t nslots;
+  size_t nparams;      /* required positional parameters: slots 0..nparams-1 */
+  int rest;            /* slot `nparams` collects any remaining arguments */
+  int resolved;        /* 0 => parameter list not laid out; apply by name */
+  const char **names;  /* interned name of each slot */
+  lz_list_t *body;     /* resolved body expressions */
+  struct lizard_code *code; /* compiled body (analyze.h), built on first run */
+  unsigned char *assigned; /* per slot: set! or define somewhere in the body */
+  /* Flat closure: when `captures` is set, a closure of this lambda keeps a
+   * capture frame of that layout instead of the frame it was made in; see
+   * lizard_lexical_closure_env. */
+  const lizard_frame_layout_t *captures;
+  lizard_ast_node_t **captured_from; /* per capture slot, a local ref */
+  const lizard_frame_layout_t **outer_layouts; /* innermost first */
+  unsigned int outer_depth;
+};
+
+typedef enum {
+  LIZARD_FRAME_OK = 0,
+  LIZARD_FRAME_TOO_FEW,
+  LIZARD_FRAME_TOO_MANY
+} lizard_frame_status_t;
+
+/* Layout of `lambda` (an AST_LAMBDA node or closure), resolving it on first
+ * use.  Check ->resolved before using the slots. */
+lizard_frame_layout_t *lizard_lexical_resolve(lizard_ast_node_t *lambda,
+                                              lizard_heap_t *heap);
+
+/* Bind `args` (forced on the way in) into a fresh frame for `layout` whose
+ * parent is `closure_env`. */
+lizard_frame_status_t lizard_lexical_bind(lizard_heap_t *heap,
+                                          const lizard_frame_layout_t *layout,
+                                          lizard_env_t *closure_env,
+                                          lz_list_t *args,
+                                          lizard_env_t **out_env);
+
+/* Env a closure of `layout` made in `env` keeps: a fresh capture frame for
+ * a flat closure, or `env` itself when the lambda is not flat or `env` is
+ * not laid out as the resolver saw it. */
+lizard_env_t *lizard_lexical_closure_env(const lizard_frame_layout_t *layout,
+                                         lizard_env_t *env,
+                                         lizard_heap_t *heap);
+
+/* A macro use met at run time in a resolved body: lizard_lexical_unresolve
+ * gives back `form` with its local references turned into the symbols they
+ * were made from, for the transformer to see names, and
+ * lizard_lexical_resolve_in resolves the expansion against the frames of
+ * `env`.  Lambdas in it are not made flat, since the frames were laid out
+ * without seeing what the expansion assigns. */
+lizard_ast_node_t *lizard_lexical_unresolve(lizard_ast_node_t *form,
+                                            lizard_heap_t *heap);
+lizard_ast_node_t *lizard_lexical_resolve_in(lizard_ast_node_t *form,
+                                             lizard_env_t *env,
+                                             lizard_heap_t *heap);
+
+/* Value of an AST_LOCAL_REF in `env`, or NULL when unbound. */
+lizard_ast_node_t *lizard_lexical_lookup(lizard_env_t *env,
+                                         const lizard_ast_node_t *ref);
+
+#endif /* LIZARD_LEXICAL_H */
@@ -1,9 +1,14 @@
 #include "lizard_internal.h"
+#include "analyze.h"
+#include "bytecode.h"
 #include "env.h"
+#include "gc.h"
 #include "lang.h"
+#include "lexical.h"
 #include "mem.h"
 #include "primitives.h"
 #include "runtime.h"
+#include "symbol.h"
 #include <ctype.h>
 #include <ds.h>
 #include <gmp.h>
@@ -13,15 +18,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
-/* Phase 0: callcc state moved to runtime (heap->runtime->callcc_*).
- * Fallback globals for standalone heaps without a runtime. These are
- * non-static because primitives.c also needs them until all callers
- * go through a runtime. Will be removed when the heap always has
- * a runtime (Phase 0 Turn 2). */
-jmp_buf callcc_buf_fallback;
-int callcc_active_fallback = 0;
-lizard_ast_node_t *callcc_value_fallback = NULL;
-
 int lizard_continuation_jumped = 0;
 lizard_ast_node_t *lizard_jump_value = NULL;
 
@@ -74,12 +70,23 @@ lizard_ast_node_t *lizard_make_promise(lizard_heap_t *heap,
   return promise;
 }
 
+/* Store `value` into `*field`, a field of an AST object rewritten in place,
+ * which may be old; the barrier is only paid when the field changes. */
+static void lizard_ast_store(lizard_ast_node_t **field,
+                             lizard_ast_node_t *value) {
+  if (*field != value) {
+    *field = value;
+    lizard_gc_write_barrier(field);
+  }
+}
+
 lizard_ast_node_t *lizard_force(lizard_ast_node_t *node, lizard_heap_t *heap) {
   if (node->type == AST_PROMISE) {
     if (!node->data.promise.forced) {
       node->data.promise.value =
           lizard_eval(node->data.promise.expr, node->data.promise.env, heap,
                       lizard_identity_cont);
+      lizard_gc_write_barrier(&node->data.promise.value);
       node->data.promise.forced = true;
     }
     return node->data.promise.value;
@@ -107,6 +114,208 @@ lizard_ast_node_t *lizard_primitive_force(lz_list_t *args, lizard_env_t *env,
   return lizard_force(node, heap);
 }
 
+/* Evaluate the argument expressions [first, nil) straight into a C buffer
+ * and call the (argc, argv) entry of `prim`: no promise and no list node per
+ * argument.  An argument that evaluates to an error is returned instead, as
+ * on the list path.  Returns 0, having evaluated nothing, when there are
+ * more arguments than the buffer holds. */
+static int lizard_eval_primitive_argv(lizard_ast_node_t *prim,
+                                      lz_list_node_t *first,
+                                      lz_list_node_t *nil, lizard_env_t *env,
+                                      lizard_heap_t *heap,
+                                      lizard_ast_node_t **out) {
+  lizard_ast_node_t *argv[LIZARD_PRIMITIVE_ARGV_MAX];
+  lz_list_node_t *it;
+  int argc = 0;
+  for (it = first; it != nil; it = it->next) {
+    if (argc == LIZARD_PRIMITIVE_ARGV_MAX) {
+      return 0;
+    }
+    argc++;
+  }
+  argc = 0;
+  for (it = first; it != nil; it = it->next) {
+    lizard_ast_node_t *value = lizard_eval(((lizard_ast_list_node_t *)it)->ast,
+                                           env, heap, lizard_identity_cont);
+    if (value && value->type == AST_ERROR) {
+      *out = value;
+      return 1;
+    }
+    argv[argc++] = value;
+  }
+  *out = prim->data.primitive.argv(argc, argv, env, heap);
+  return 1;
+}
+
+/* For a resolved closure without a rest parameter applied to exactly its
+ * arity, allocate the callee frame and evaluate each argument straight into
+ * its slot.  NULL when the call needs the general binding path. */
+static lizard_env_t *lizard_eval_into_frame(lizard_ast_node_t *func,
+                                            lz_list_node_t *first,
+                                            lz_list_node_t *nil,
+                                            lizard_env_t *env,
+                                            lizard_heap_t *heap) {
+  const lizard_frame_layout_t *layout = func->data.lambda.layout;
+  lizard_env_t *frame;
+  lz_list_node_t *it;
+  size_t n = 0;
+  if (layout == NULL || !layout->resolved || layout->rest) {
+    return NULL;
+  }
+  for (it = first; it != nil; it = it->next) {
+    n++;
+  }
+  if (n != layout->nparams) {
+    return NULL;
+  }
+  frame = lizard_env_create_frame(heap, func->data.lambda.closure_env, layout);
+  n = 0;
+  for (it = first; it != nil; it = it->next) {
+    /* Evaluating an argument may collect, leaving the frame old. */
+    frame->slots[n] = lizard_eval(((lizard_ast_list_node_t *)it)->ast, env,
+                                  heap, lizard_identity_cont);
+    lizard_gc_write_barrier(&frame->slots[n++]);
+  }
+  return frame;
+}
+
+/* A macro use the expander did not reach (inside a cond clause, say) meets
+ * its macro as the operator's value at run time.  Each such source form is
+ * expanded once: the expansion is remembered per form, keyed by node
+ * identity, together with the macro object it came from.  Redefining the
+ * macro binds a new object, which makes the entry stale.  The memo holds
+ * its entries weakly: an entry keeps its macro and expansion alive only as
+ * long as its form is, and goes when the form does. */
+typedef struct {
+  const lizard_ast_node_t *form;
+  const lizard_ast_node_t *macro;
+  lizard_ast_node_t *expansion;
+} lizard_expansion_entry_t;
+
+struct lizard_expansion_memo {
+  size_t cap; /* power of two */
+  size_t count;
+  lizard_expansion_entry_t *entries;
+};
+
+static lizard_expansion_entry_t *
+lizard_expansion_find(struct lizard_expansion_memo *memo,
+                      const lizard_ast_node_t *form) {
+  size_t i = (((size_t)form >> 4) * 2654435761U) & (memo->cap - 1U);
+  while (memo->entries[i].form != NULL && memo->entries[i].form != form) {
+    i = (i + 1U) & (memo->cap - 1U);
+  }
+  return &memo->entries[i];
+}
+
+/* Neither the memo nor its entries are traced: the collector goes through
+ * them with lizard_expansion_memo_trace. */
+static struct lizard_expansion_memo *
+lizard_expansion_memo_create(size_t cap) {
+  struct lizard_expansion_memo *memo = lizard_heap_alloc_tagged(
+      sizeof(struct lizard_expansion_memo), LIZARD_GC_OBJECT_RAW,
+      LIZARD_OBJECT_TRACE_NONE);
+  memo->cap = cap;
+  memo->entries = lizard_heap_alloc_tagged(
+      cap * sizeof(lizard_expansion_entry_t), LIZARD_GC_OBJECT_RAW,
+      LIZARD_OBJECT_TRACE_NONE);
+  return memo;
+}
+
+void lizard_expansion_memo_trace(struct lizard_expansion_memo *memo,
+                                 lizard_gc_live_fn live,
+                                 lizard_gc_visit_fn visit, void *ctx) {
+  size_t i;
+  if (memo == NULL) {
+    return;
+  }
+  visit(memo->entries, ctx);
+  for (i = 0; i < memo->cap; i++) {
+    if (memo->entries[i].form != NULL && live(memo->entries[i].form, ctx)) {
+      visit(memo->entries[i].macro, ctx);
+      visit(memo->entries[i].expansion, ctx);
+    }
+  }
+}
+
+void lizard_expansion_memo_prune(struct lizard_expansion_memo *memo,
+                                 lizard_gc_live_fn live, void *ctx) {
+  lizard_expansion_entry_t *kept;
+  size_t i, n = 0U;
+  if (memo == NULL || memo->count == 0U) {
+    return;
+  }
+  kept = (lizard_expansion_entry_t *)malloc(memo->count *
+                                            sizeof(lizard_expansion_entry_t));
+  if (kept == NULL) {
+    return; /* dead forms stay keys; they are never looked up again */
+  }
+  for (i = 0; i < memo->cap; i++) {
+    if (memo->entries[i].form != NULL && live(memo->entries[i].form, ctx)) {
+      kept[n++] = memo->entries[i];
+    }
+  }
+  if (n < memo->count) {
+    /* Rehash what is left: open addressing has no holes to leave. */
+    memset(memo->entries, 0, memo->cap * sizeof(lizard_expansion_entry_t));
+    for (i = 0; i < n; i++) {
+      *lizard_expansion_find(memo, kept[i].form) = kept[i];
+    }
+    memo->count = n;
+  }
+  free(kept);
+}
+
+/* Expansion of macro use `node` whose operator evaluated to `macro`; `node`
+ * itself when no rule matches.  A use in a resolved body has local
+ * references among its arguments: the transformer is given the names they
+ * stand for, and its expansion is resolved against the frames of `env`. */
+static lizard_ast_node_t *lizard_expand_use(lizard_ast_node_t *node,
+                                            lizard_ast_node_t *macro,
+                                            lizard_env_t *env,
+                                            lizard_heap_t *heap) {
+  struct lizard_expansion_memo **slot = &heap->expansion_memo;
+  lizard_expansion_entry_t *entry;
+  lizard_ast_node_t *source;
+  lizard_ast_node_t *expansion;
+  if (*slot == NULL) {
+    *slot = lizard_expansion_memo_create(64U);
+  }
+  entry = lizard_expansion_find(*slot, node);
+  if (entry->form == node && entry->macro == macro) {
+    return entry->expansion;
+  }
+  source = lizard_lexical_unresolve(node, heap);
+  expansion = lizard_expand_macros(source, env, heap);
+  if (expansion == source) {
+    return node;
+  }
+  expansion = lizard_lexical_resolve_in(expansion, env, heap);
+  /* A transformer may have expanded other uses meanwhile. */
+  entry = lizard_expansion_find(*slot, node);
+  if (entry->form == NULL) {
+    if (((*slot)->count + 1U) * 4U > (*slot)->cap * 3U) {
+      struct lizard_expansion_memo *grown =
+          lizard_expansion_memo_create((*slot)->cap * 2U);
+      size_t i;
+      for (i = 0; i < (*slot)->cap; i++) {
+        if ((*slot)->entries[i].form != NULL) {
+          *lizard_expansion_find(grown, (*slot)->entries[i].form) =
+              (*slot)->entries[i];
+        }
+      }
+      grown->count = (*slot)->count;
+      *slot = grown;
+      entry = lizard_expansion_find(grown, node);
+    }
+    entry->form = node;
+    (*slot)->count++;
+  }
+  entry->macro = macro;
+  entry->expansion = expansion;
+  return expansion;
+}
+
 lizard_ast_node_t *lizard_eval(
     lizard_ast_node_t *node, lizard_env_t *env, lizard_heap_t *heap,
     lizard_ast_node_t *(*cont)(lizard_ast_node_t *result, lizard_env_t *env,
@@ -129,7 +338,16 @@ lizard_ast_node_t *lizard_eval(
 
     case AST_SYMBOL: {
       lizard_ast_node_t *val;
-      val = lizard_env_lookup(env, node->data.variable);
+      val = lizard_env_lookup_site(env, node);
+      if (!val) {
+        return cont(lizard_make_error_at(heap, LIZARD_ERROR_UNBOUND_SYMBOL, node->span), env,
+                    heap);
+      }
+      return cont(lizard_force(val, heap), env, heap);
+    }
+
+    case AST_LOCAL_REF: {
+      lizard_ast_node_t *val = lizard_lexical_lookup(env, node);
       if (!val) {
         return cont(lizard_make_error_at(heap, LIZARD_ERROR_UNBOUND_SYMBOL, node->span), env,
                     heap);
@@ -256,7 +474,9 @@ lizard_ast_node_t *lizard_eval(
       closure = lizard_heap_alloc(sizeof(lizard_ast_node_t));
       closure->type = AST_LAMBDA;
       closure->data.lambda.parameters = node->data.lambda.parameters;
-      closure->data.lambda.closure_env = env;
+      closure->data.lambda.layout = lizard_lexical_resolve(node, heap);
+      closure->data.lambda.closure_env =
+          lizard_lexical_closure_env(closure->data.lambda.layout, env, heap);
       return cont(closure, env, heap);
     }
 
@@ -331,8 +551,9 @@ lizard_ast_node_t *lizard_eval(
     case AST_APPLICATION: {
       lz_list_node_t *func_node;
       lizard_ast_node_t *func;
-      lz_list_t *arg_list;
+      lz_list_t *arg_list = NULL;
       lz_list_node_t *arg_node;
+      lizard_env_t *bound_env = NULL;
       func_node = node->data.application_arguments->head;
       func =
           lizard_force(lizard_eval(((lizard_ast_list_node_t *)func_node)->ast,
@@ -343,8 +564,35 @@ lizard_ast_node_t *lizard_eval(
       if (func->type == AST_ERROR) {
         return cont(func, env, heap);
       }
-      arg_list = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+      if (func->type == AST_MACRO) {
+        lizard_ast_node_t *expansion = lizard_expand_use(node, func, env, heap);
+        if (expansion == node) {
+          return cont(lizard_make_error_at(heap, LIZARD_ERROR_INVALID_APPLY,
+                                           node->span),
+                      env, heap);
+        }
+        node = expansion;
+        continue;
+      }
+      /* Allocation-free argument passing for argv primitives and resolved
+         closures; everything else gets a list of argument promises. */
+      if (func->type == AST_PRIMITIVE && func->data.primitive.argv != NULL) {
+        lizard_ast_node_t *result;
+        if (lizard_eval_primitive_argv(func, func_node->next,
+                                       node->data.application_arguments->nil,
+                                       env, heap, &result)) {
+          return cont(result, env, heap);
+        }
+      } else if (func->type == AST_LAMBDA) {
+        bound_env = lizard_eval_into_frame(
+            func, func_node->next, node->data.application_arguments->nil, env,
+            heap);
+      }
+      if (bound_env == NULL) {
+        arg_list = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+      }
       for (arg_node = func_node->next;
+           arg_list != NULL &&
            arg_node != node->data.application_arguments->nil;
            arg_node = arg_node->next) {
         lizard_ast_node_t *arg_expr;
@@ -363,19 +611,12 @@ lizard_ast_node_t *lizard_eval(
         value = (arg != arg_list->nil)
                     ? lizard_force(((lizard_ast_list_node_t *)arg)->ast, heap)
                     : lizard_make_nil(heap);
-        if (heap->runtime != NULL
-              ? heap->runtime->callcc_active
-              : callcc_active_fallback) {
-          if (heap->runtime != NULL) {
-            heap->runtime->callcc_value = value;
-            longjmp(heap->runtime->callcc_buf, 1);
-          } else {
-            callcc_value_fallback = value;
-            longjmp(callcc_buf_fallback, 1);
-          }
-        }
+        lizard_continuation_escape(func, value, heap);
         return func->data.continuation.captured_cont(value, env, heap);
       }
+      if (lizard_vm_is_closure(func)) {
+        return cont(lizard_vm_apply(func, arg_list, heap), env, heap);
+      }
 
       if (func->type == AST_PRIMITIVE) {
         /* Short-circuit `and` and `or`. They are registered as
@@ -385,7 +626,7 @@ lizard_ast_node_t *lizard_eval(
            wrong-typed value that earlier arguments would have ruled
            out) propagate spuriously. Handle these two by iterating
            and forcing one argument at a time. */
-        if (func->data.primitive == lizard_primitive_and) {
+        if (func->data.primitive.fn == lizard_primitive_and) {
           lz_list_node_t *cur;
           lizard_ast_node_t *last = lizard_make_bool(heap, true);
           for (cur = arg_list->head; cur != arg_list->nil; cur = cur->next) {
@@ -401,7 +642,7 @@ lizard_ast_node_t *lizard_eval(
           }
           return cont(last, env, heap);
         }
-        if (func->data.primitive == lizard_primitive_or) {
+        if (func->data.primitive.fn == lizard_primitive_or) {
           lz_list_node_t *cur;
           lizard_ast_node_t *last = lizard_make_bool(heap, false);
           for (cur = arg_list->head; cur != arg_list->nil; cur = cur->next) {
@@ -428,14 +669,14 @@ lizard_ast_node_t *lizard_eval(
                *receive* errors as values: `error-object?` (testing)
                and `error-value` (unwrapping the payload). */
             if (forced && forced->type == AST_ERROR &&
-                func->data.primitive != lizard_primitive_error_objp &&
-                func->data.primitive != lizard_primitive_error_value) {
+                func->data.primitive.fn != lizard_primitive_error_objp &&
+                func->data.primitive.fn != lizard_primitive_error_value) {
               return cont(forced, env, heap);
             }
-            ((lizard_ast_list_node_t *)cur)->ast = forced;
+            lizard_ast_store(&((lizard_ast_list_node_t *)cur)->ast, forced);
           }
         }
-        return cont(func->data.primitive(arg_list, env, heap), env, heap);
+        return cont(func->data.primitive.fn(arg_list, env, heap), env, heap);
       } else if (func->type == AST_LAMBDA) {
         {
           lizard_env_t *new_env;
@@ -443,129 +684,163 @@ lizard_ast_node_t *lizard_eval(
           lz_list_t *formal_params;
           lz_list_node_t *param_node, *arg_iter;
           lizard_ast_list_node_t *param;
-          new_env = lizard_env_create(heap, func->data.lambda.closure_env);
-          param_list =
-              ((lizard_ast_list_node_t *)func->data.lambda.parameters->head)
-                  ->ast;
-          if (param_list->type == AST_NIL) {
-            /* zero-parameter lambda: nothing to bind */
-            if (arg_list->head != arg_list->nil) {
-              return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_MORE),
-                          env, heap);
-            }
-            param_node = NULL;
-            arg_iter = NULL;
-            formal_params = NULL;
-          } else if (param_list->type == AST_SYMBOL) {
-            /* Varargs: (lambda args body) — bind all args as a list to
-               the single symbol. Build a proper pair-chain from the
-               (already-forced) AST list of args. */
-            lz_list_node_t *it;
-            lizard_ast_node_t *xs = lizard_make_nil(heap);
-            lizard_ast_node_t *pair;
-            /* Walk arg_list in order, build list in reverse, then
-               flip. Cheaper: collect args into a temporary array
-               and build cons chain right-to-left. */
-            {
-              size_t count = 0;
-              lizard_ast_node_t **buf;
-              size_t i;
-              for (it = arg_list->head; it != arg_list->nil; it = it->next) {
-                count++;
-              }
-              buf = lizard_heap_alloc(count * sizeof(lizard_ast_node_t *) + 1);
-              i = 0;
-              for (it = arg_list->head; it != arg_list->nil; it = it->next) {
-                buf[i++] = lizard_force(
-                    ((lizard_ast_list_node_t *)it)->ast, heap);
-              }
-              for (i = count; i > 0; i--) {
-                pair = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-                pair->type = AST_PAIR;
-                pair->data.pair.car = buf[i - 1];
-                pair->data.pair.cdr = xs;
-                xs = pair;
+          lz_list_node_t *body_first, *body_nil;
+          lizard_frame_layout_t *layout = func->data.lambda.layout;
+          if (layout != NULL && layout->resolved) {
+            /* Resolved bodies run as compiled handler trees (analyze.c); a
+               tail form they hand back continues this trampoline. */
+            lizard_ast_node_t *result;
+            if (bound_env != NULL) {
+              new_env = bound_env;
+            } else {
+              switch (lizard_lexical_bind(heap, layout,
+                                          func->data.lambda.closure_env,
+                                          arg_list, &new_env)) {
+              case LIZARD_FRAME_TOO_FEW:
+                return cont(
+                    lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_LESS),
+                    env, heap);
+              case LIZARD_FRAME_TOO_MANY:
+                return cont(
+                    lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_MORE),
+                    env, heap);
+              default:
+                break;
               }
             }
-            lizard_env_define(heap, new_env, param_list->data.variable, xs);
-            param_node = NULL;
-            arg_iter = NULL;
-            formal_params = NULL;
-          } else if (param_list->type == AST_APPLICATION) {
-            formal_params = param_list->data.application_arguments;
-            param_node = formal_params->head;
-            arg_iter = arg_list->head;
-          } else {
-            return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMS),
-                        env, heap);
-          }
-          while (formal_params && param_node != formal_params->nil) {
-            param = (lizard_ast_list_node_t *)param_node;
-            if (param->ast->type != AST_SYMBOL) {
-              return cont(
-                  lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMETER), env,
-                  heap);
+            if (lizard_analyze_run(layout, new_env, heap, &result, &new_env)) {
+              return cont(result, env, heap);
             }
-            /* Dotted-rest: a `.` symbol means the next param captures
-               all remaining args as a list. (lambda (a b . rest) ...) */
-            if (strcmp(param->ast->data.variable, ".") == 0) {
-              lizard_ast_list_node_t *rest_param;
+            node = result;
+            env = new_env;
+            continue;
+          } else {
+            new_env = lizard_env_create(heap, func->data.lambda.closure_env);
+            param_list =
+                ((lizard_ast_list_node_t *)func->data.lambda.parameters->head)
+                    ->ast;
+            if (param_list->type == AST_NIL) {
+              /* zero-parameter lambda: nothing to bind */
+              if (arg_list->head != arg_list->nil) {
+                return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_MORE),
+                            env, heap);
+              }
+              param_node = NULL;
+              arg_iter = NULL;
+              formal_params = NULL;
+            } else if (param_list->type == AST_SYMBOL) {
+              /* Varargs: (lambda args body) — bind all args as a list to
+                 the single symbol. Build a proper pair-chain from the
+                 (already-forced) AST list of args. */
               lz_list_node_t *it;
               lizard_ast_node_t *xs = lizard_make_nil(heap);
-              lizard_ast_node_t **buf;
-              size_t count = 0, i;
-              if (param_node->next == formal_params->nil) {
-                return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMS),
-                            env, heap);
+              lizard_ast_node_t *pair;
+              /* Walk arg_list in order, build list in reverse, then
+                 flip. Cheaper: collect args into a temporary array
+                 and build cons chain right-to-left. */
+              {
+                size_t count = 0;
+                lizard_ast_node_t **buf;
+                size_t i;
+                for (it = arg_list->head; it != arg_list->nil; it = it->next) {
+                  count++;
+                }
+                buf = lizard_heap_alloc(count * sizeof(lizard_ast_node_t *) + 1);
+                i = 0;
+                for (it = arg_list->head; it != arg_list->nil; it = it->next) {
+                  buf[i++] = lizard_force(
+                      ((lizard_ast_list_node_t *)it)->ast, heap);
+                }
+                for (i = count; i > 0; i--) {
+                  pair = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+                  pair->type = AST_PAIR;
+                  pair->data.pair.car = buf[i - 1];
+                  pair->data.pair.cdr = xs;
+                  xs = pair;
+                }
               }
-              rest_param = (lizard_ast_list_node_t *)param_node->next;
-              if (rest_param->ast->type != AST_SYMBOL) {
-                return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMETER),
-                            env, heap);
+              lizard_env_define(heap, new_env, param_list->data.variable, xs);
+              param_node = NULL;
+              arg_iter = NULL;
+              formal_params = NULL;
+            } else if (param_list->type == AST_APPLICATION) {
+              formal_params = param_list->data.application_arguments;
+              param_node = formal_params->head;
+              arg_iter = arg_list->head;
+            } else {
+              return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMS),
+                          env, heap);
+            }
+            while (formal_params && param_node != formal_params->nil) {
+              param = (lizard_ast_list_node_t *)param_node;
+              if (param->ast->type != AST_SYMBOL) {
+                return cont(
+                    lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMETER), env,
+                    heap);
               }
-              for (it = arg_iter; it != arg_list->nil; it = it->next) count++;
-              buf = lizard_heap_alloc(count * sizeof(lizard_ast_node_t *) + 1);
-              i = 0;
-              for (it = arg_iter; it != arg_list->nil; it = it->next) {
-                buf[i++] = lizard_force(
-                    ((lizard_ast_list_node_t *)it)->ast, heap);
+              /* Dotted-rest: a `.` symbol means the next param captures
+                 all remaining args as a list. (lambda (a b . rest) ...) */
+              if (strcmp(param->ast->data.variable, ".") == 0) {
+                lizard_ast_list_node_t *rest_param;
+                lz_list_node_t *it;
+                lizard_ast_node_t *xs = lizard_make_nil(heap);
+                lizard_ast_node_t **buf;
+                size_t count = 0, i;
+                if (param_node->next == formal_params->nil) {
+                  return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMS),
+                              env, heap);
+                }
+                rest_param = (lizard_ast_list_node_t *)param_node->next;
+                if (rest_param->ast->type != AST_SYMBOL) {
+                  return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMETER),
+                              env, heap);
+                }
+                for (it = arg_iter; it != arg_list->nil; it = it->next) count++;
+                buf = lizard_heap_alloc(count * sizeof(lizard_ast_node_t *) + 1);
+                i = 0;
+                for (it = arg_iter; it != arg_list->nil; it = it->next) {
+                  buf[i++] = lizard_force(
+                      ((lizard_ast_list_node_t *)it)->ast, heap);
+                }
+                for (i = count; i > 0; i--) {
+                  lizard_ast_node_t *pair =
+                      lizard_heap_alloc(sizeof(lizard_ast_node_t));
+                  pair->type = AST_PAIR;
+                  pair->data.pair.car = buf[i - 1];
+                  pair->data.pair.cdr = xs;
+                  xs = pair;
+                }
+                lizard_env_define(heap, new_env,
+                                  rest_param->ast->data.variable, xs);
+                param_node = formal_params->nil;  /* done */
+                arg_iter = arg_list->nil;         /* consumed all */
+                break;
               }
-              for (i = count; i > 0; i--) {
-                lizard_ast_node_t *pair =
-                    lizard_heap_alloc(sizeof(lizard_ast_node_t));
-                pair->type = AST_PAIR;
-                pair->data.pair.car = buf[i - 1];
-                pair->data.pair.cdr = xs;
-                xs = pair;
+              if (arg_iter == arg_list->nil) {
+                return cont(
+                    lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_LESS), env,
+                    heap);
               }
-              lizard_env_define(heap, new_env,
-                                rest_param->ast->data.variable, xs);
-              param_node = formal_params->nil;  /* done */
-              arg_iter = arg_list->nil;         /* consumed all */
-              break;
-            }
-            if (arg_iter == arg_list->nil) {
-              return cont(
-                  lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_LESS), env,
-                  heap);
+              {
+                /* Force the arg eagerly. R5RS is applicative-order: the
+                   binding receives a value, not a thunk that re-evaluates
+                   in the original env where set! may have mutated things.
+                   We deliberately do NOT propagate errors here — handlers
+                   passed to `try` receive error values as arguments. */
+                lizard_ast_node_t *arg_val = lizard_force(
+                    ((lizard_ast_list_node_t *)arg_iter)->ast, heap);
+                lizard_env_define(heap, new_env, param->ast->data.variable,
+                                  arg_val);
+              }
+              param_node = param_node->next;
+              arg_iter = arg_iter->next;
             }
-            {
-              /* Force the arg eagerly. R5RS is applicative-order: the
-                 binding receives a value, not a thunk that re-evaluates
-                 in the original env where set! may have mutated things.
-                 We deliberately do NOT propagate errors here — handlers
-                 passed to `try` receive error values as arguments. */
-              lizard_ast_node_t *arg_val = lizard_force(
-                  ((lizard_ast_list_node_t *)arg_iter)->ast, heap);
-              lizard_env_define(heap, new_env, param->ast->data.variable,
-                                arg_val);
+            if (arg_iter && arg_iter != arg_list->nil) {
+              return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_MORE),
+                          env, heap);
             }
-            param_node = param_node->next;
-            arg_iter = arg_iter->next;
-          }
-          if (arg_iter && arg_iter != arg_list->nil) {
-            return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_MORE),
-                        env, heap);
+            body_first = func->data.lambda.parameters->head->next;
+            body_nil = func->data.lambda.parameters->nil;
           }
           /* Lambda body trampoline.
              Evaluate every NON-tail body for its side effects with an
@@ -579,20 +854,18 @@ lizard_ast_node_t *lizard_eval(
           {
             lz_list_node_t *tail_body;
             lz_list_node_t *iter;
-            tail_body = func->data.lambda.parameters->nil;
-            for (iter = func->data.lambda.parameters->head->next;
-                 iter != func->data.lambda.parameters->nil; iter = iter->next) {
+            tail_body = body_nil;
+            for (iter = body_first; iter != body_nil; iter = iter->next) {
               tail_body = iter;
             }
-            if (tail_body == func->data.lambda.parameters->nil) {
+            if (tail_body == body_nil) {
               /* lambda with no body — degenerate but valid; returns nil */
               return cont(lizard_make_nil(heap), env, heap);
             }
             /* non-tail bodies: side effects only. But an AST_ERROR
                here must short-circuit — otherwise (lambda () (foo)
                (raise 'x) (bar)) would silently swallow the raise. */
-            for (iter = func->data.lambda.parameters->head->next;
-                 iter != tail_body; iter = iter->next) {
+            for (iter = body_first; iter != tail_body; iter = iter->next) {
               lizard_ast_node_t *side =
                   lizard_eval(((lizard_ast_list_node_t *)iter)->ast, new_env,
                               heap, lizard_identity_cont);
@@ -691,7 +964,16 @@ lizard_ast_node_t *lizard_apply(lizard_ast_node_t *func, lz_list_t *args,
             lizard_force(((lizard_ast_list_node_t *)cur)->ast, heap);
       }
     }
-    return cont(func->data.primitive(args, env, heap), env, heap);
+    return cont(func->data.primitive.fn(args, env, heap), env, heap);
+  } else if (func->type == AST_CONTINUATION) {
+    lizard_ast_node_t *value =
+        args->head != args->nil
+            ? lizard_force(((lizard_ast_list_node_t *)args->head)->ast, heap)
+            : lizard_make_nil(heap);
+    lizard_continuation_escape(func, value, heap);
+    return func->data.continuation.captured_cont(value, env, heap);
+  } else if (lizard_vm_is_closure(func)) {
+    return cont(lizard_vm_apply(func, args, heap), env, heap);
   } else if (func->type == AST_LAMBDA) {
     {
       lizard_env_t *new_env;
@@ -700,78 +982,48 @@ lizard_ast_node_t *lizard_apply(lizard_ast_node_t *func, lz_list_t *args,
       lz_list_node_t *param_node, *arg_node;
       lizard_ast_list_node_t *param;
       lizard_ast_node_t *result;
-      lz_list_node_t *body_iter;
-      new_env = lizard_env_create(heap, func->data.lambda.closure_env);
-      param_list =
-          ((lizard_ast_list_node_t *)func->data.lambda.parameters->head)->ast;
-      if (param_list->type == AST_NIL) {
-        /* zero-parameter lambda */
-        if (args->head != args->nil) {
+      lz_list_node_t *body_iter, *body_nil;
+      lizard_frame_layout_t *layout = func->data.lambda.layout;
+      if (layout != NULL && layout->resolved) {
+        switch (lizard_lexical_bind(heap, layout, func->data.lambda.closure_env,
+                                    args, &new_env)) {
+        case LIZARD_FRAME_TOO_FEW:
+          return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_LESS_2),
+                      env, heap);
+        case LIZARD_FRAME_TOO_MANY:
           return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_MORE_2),
                       env, heap);
+        default:
+          break;
         }
-        param_node = NULL;
-        arg_node = NULL;
-        formal_params = NULL;
-      } else if (param_list->type == AST_SYMBOL) {
-        /* Varargs — bind all args as a list to the single symbol. */
-        lz_list_node_t *it;
-        lizard_ast_node_t *xs = lizard_make_nil(heap);
-        size_t count = 0;
-        lizard_ast_node_t **buf;
-        size_t i;
-        for (it = args->head; it != args->nil; it = it->next) count++;
-        buf = lizard_heap_alloc(count * sizeof(lizard_ast_node_t *) + 1);
-        i = 0;
-        for (it = args->head; it != args->nil; it = it->next) {
-          buf[i++] = ((lizard_ast_list_node_t *)it)->ast;
-        }
-        for (i = count; i > 0; i--) {
-          lizard_ast_node_t *pair =
-              lizard_heap_alloc(sizeof(lizard_ast_node_t));
-          pair->type = AST_PAIR;
-          pair->data.pair.car = buf[i - 1];
-          pair->data.pair.cdr = xs;
-          xs = pair;
+        if (!lizard_analyze_run(layout, new_env, heap, &result, &new_env)) {
+          result = lizard_eval(result, new_env, heap, cont);
         }
-        lizard_env_define(heap, new_env, param_list->data.variable, xs);
-        param_node = NULL;
-        arg_node = NULL;
-        formal_params = NULL;
-      } else if (param_list->type == AST_APPLICATION) {
-        formal_params = param_list->data.application_arguments;
-        param_node = formal_params->head;
-        arg_node = args->head;
+        return cont(lizard_force(result, heap), env, heap);
       } else {
-        return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMS_2), env,
-                    heap);
-      }
-      while (formal_params && param_node != formal_params->nil) {
-        param = (lizard_ast_list_node_t *)param_node;
-        if (param->ast->type != AST_SYMBOL) {
-          return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMETER_2),
-                      env, heap);
-        }
-        /* Dotted-rest. */
-        if (strcmp(param->ast->data.variable, ".") == 0) {
-          lizard_ast_list_node_t *rest_param;
+        new_env = lizard_env_create(heap, func->data.lambda.closure_env);
+        param_list =
+            ((lizard_ast_list_node_t *)func->data.lambda.parameters->head)->ast;
+        if (param_list->type == AST_NIL) {
+          /* zero-parameter lambda */
+          if (args->head != args->nil) {
+            return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_MORE_2),
+                        env, heap);
+          }
+          param_node = NULL;
+          arg_node = NULL;
+          formal_params = NULL;
+        } else if (param_list->type == AST_SYMBOL) {
+          /* Varargs — bind all args as a list to the single symbol. */
           lz_list_node_t *it;
           lizard_ast_node_t *xs = lizard_make_nil(heap);
+          size_t count = 0;
           lizard_ast_node_t **buf;
-          size_t count = 0, i;
-          if (param_node->next == formal_params->nil) {
-            return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMS_2),
-                        env, heap);
-          }
-          rest_param = (lizard_ast_list_node_t *)param_node->next;
-          if (rest_param->ast->type != AST_SYMBOL) {
-            return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMETER_2),
-                        env, heap);
-          }
-          for (it = arg_node; it != args->nil; it = it->next) count++;
+          size_t i;
+          for (it = args->head; it != args->nil; it = it->next) count++;
           buf = lizard_heap_alloc(count * sizeof(lizard_ast_node_t *) + 1);
           i = 0;
-          for (it = arg_node; it != args->nil; it = it->next) {
+          for (it = args->head; it != args->nil; it = it->next) {
             buf[i++] = ((lizard_ast_list_node_t *)it)->ast;
           }
           for (i = count; i > 0; i--) {
@@ -782,31 +1034,81 @@ lizard_ast_node_t *lizard_apply(lizard_ast_node_t *func, lz_list_t *args,
             pair->data.pair.cdr = xs;
             xs = pair;
           }
-          lizard_env_define(heap, new_env, rest_param->ast->data.variable, xs);
-          arg_node = args->nil;
-          break;
+          lizard_env_define(heap, new_env, param_list->data.variable, xs);
+          param_node = NULL;
+          arg_node = NULL;
+          formal_params = NULL;
+        } else if (param_list->type == AST_APPLICATION) {
+          formal_params = param_list->data.application_arguments;
+          param_node = formal_params->head;
+          arg_node = args->head;
+        } else {
+          return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMS_2), env,
+                      heap);
         }
-        if (arg_node == args->nil) {
-          return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_LESS_2),
-                      env, heap);
+        while (formal_params && param_node != formal_params->nil) {
+          param = (lizard_ast_list_node_t *)param_node;
+          if (param->ast->type != AST_SYMBOL) {
+            return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMETER_2),
+                        env, heap);
+          }
+          /* Dotted-rest. */
+          if (strcmp(param->ast->data.variable, ".") == 0) {
+            lizard_ast_list_node_t *rest_param;
+            lz_list_node_t *it;
+            lizard_ast_node_t *xs = lizard_make_nil(heap);
+            lizard_ast_node_t **buf;
+            size_t count = 0, i;
+            if (param_node->next == formal_params->nil) {
+              return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMS_2),
+                          env, heap);
+            }
+            rest_param = (lizard_ast_list_node_t *)param_node->next;
+            if (rest_param->ast->type != AST_SYMBOL) {
+              return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMETER_2),
+                          env, heap);
+            }
+            for (it = arg_node; it != args->nil; it = it->next) count++;
+            buf = lizard_heap_alloc(count * sizeof(lizard_ast_node_t *) + 1);
+            i = 0;
+            for (it = arg_node; it != args->nil; it = it->next) {
+              buf[i++] = ((lizard_ast_list_node_t *)it)->ast;
+            }
+            for (i = count; i > 0; i--) {
+              lizard_ast_node_t *pair =
+                  lizard_heap_alloc(sizeof(lizard_ast_node_t));
+              pair->type = AST_PAIR;
+              pair->data.pair.car = buf[i - 1];
+              pair->data.pair.cdr = xs;
+              xs = pair;
+            }
+            lizard_env_define(heap, new_env, rest_param->ast->data.variable, xs);
+            arg_node = args->nil;
+            break;
+          }
+          if (arg_node == args->nil) {
+            return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_LESS_2),
+                        env, heap);
+          }
+          {
+            /* Eager force; do not propagate errors at this boundary so
+               try-handlers can receive errors as their arguments. */
+            lizard_ast_node_t *arg_val = lizard_force(
+                ((lizard_ast_list_node_t *)arg_node)->ast, heap);
+            lizard_env_define(heap, new_env, param->ast->data.variable, arg_val);
+          }
+          param_node = param_node->next;
+          arg_node = arg_node->next;
         }
-        {
-          /* Eager force; do not propagate errors at this boundary so
-             try-handlers can receive errors as their arguments. */
-          lizard_ast_node_t *arg_val = lizard_force(
-              ((lizard_ast_list_node_t *)arg_node)->ast, heap);
-          lizard_env_define(heap, new_env, param->ast->data.variable, arg_val);
+        if (arg_node && arg_node != args->nil) {
+          return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_MORE_2),
+                      env, heap);
         }
-        param_node = param_node->next;
-        arg_node = arg_node->next;
-      }
-      if (arg_node && arg_node != args->nil) {
-        return cont(lizard_make_error(heap, LIZARD_ERROR_LAMBDA_ARITY_MORE_2),
-                    env, heap);
+        body_iter = func->data.lambda.parameters->head->next;
+        body_nil = func->data.lambda.parameters->nil;
       }
-      body_iter = func->data.lambda.parameters->head->next;
       result = NULL;
-      while (body_iter->next != func->data.lambda.parameters->nil) {
+      while (body_iter->next != body_nil) {
         lizard_ast_list_node_t *body_expr = (lizard_ast_list_node_t *)body_iter;
         lizard_ast_node_t *side =
             lizard_eval(body_expr->ast, new_env, heap, cont);
@@ -1088,7 +1390,7 @@ static const char *lizard_sr_fresh(const char *base, lizard_heap_t *heap) {
               : &lizard_sr_counter_fallback;
   (*counter)++;
   sprintf(buf, "%s.h%lu", base, *counter);
-  return buf;
+  return lizard_intern(buf);
 }
 
 static const char *lizard_sr_renamed(lizard_sr_rename_t *r,
@@ -1528,6 +1830,26 @@ lizard_ast_node_t *lizard_reparse_datum(lizard_ast_node_t *n,
           de->data.definition.value = lizard_reparse_datum(val, heap);
           return de;
         }
+        /* (define (name . params) body...) — reparse as
+           (lambda params body...). */
+        if (name->type == AST_PAIR && name->data.pair.car &&
+            name->data.pair.car->type == AST_SYMBOL) {
+          lizard_ast_node_t *kw = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+          lizard_ast_node_t *spec = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+          lizard_ast_node_t *lam = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+          kw->type = AST_SYMBOL;
+          kw->data.variable = "lambda";
+          spec->type = AST_PAIR;
+          spec->data.pair.car = name->data.pair.cdr;
+          spec->data.pair.cdr = n->data.pair.cdr->data.pair.cdr;
+          lam->type = AST_PAIR;
+          lam->data.pair.car = kw;
+          lam->data.pair.cdr = spec;
+          de->type = AST_DEFINITION;
+          de->data.definition.variable = name->data.pair.car;
+          de->data.definition.value = lizard_reparse_datum(lam, heap);
+          return de;
+        }
       }
       /* (let ((n1 v1) ...) body...) — desugar to ((lambda (n1 ...)
          body...) v1 ...). */
@@ -1598,6 +1920,35 @@ lizard_ast_node_t *lizard_reparse_datum(lizard_ast_node_t *n,
         q->data.quoted = n->data.pair.cdr->data.pair.car;
         return q;
       }
+      /* (cond (test body...) ...) — each clause an application, as the
+         parser leaves it. */
+      if (strcmp(h, "cond") == 0) {
+        lizard_ast_node_t *cn =
+            lizard_heap_alloc(sizeof(lizard_ast_node_t));
+        lizard_ast_node_t *cur;
+        cn->type = AST_COND;
+        cn->data.cond_clauses =
+            list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+        for (cur = n->data.pair.cdr; cur && cur->type == AST_PAIR;
+             cur = cur->data.pair.cdr) {
+          lizard_ast_list_node_t *w =
+              lizard_heap_alloc(sizeof(lizard_ast_list_node_t));
+          w->ast = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+          w->ast->type = AST_APPLICATION;
+          w->ast->data.application_arguments =
+              pair_to_app_args(cur->data.pair.car, heap);
+          list_append(cn->data.cond_clauses, &w->node);
+        }
+        return cn;
+      }
+      /* (call/cc f) */
+      if (strcmp(h, "call/cc") == 0) {
+        lizard_ast_node_t *cc =
+            lizard_heap_alloc(sizeof(lizard_ast_node_t));
+        cc->type = AST_CALLCC;
+        cc->data.application_arguments = pair_to_app_args(n, heap);
+        return cc;
+      }
     }
     /* Generic application. */
     {
@@ -1620,7 +1971,7 @@ lizard_ast_node_t *lizard_reparse_datum(lizard_ast_node_t *n,
 static lizard_ast_node_t *mod_qsym(lizard_heap_t *heap, const char *s) {
   lizard_ast_node_t *n = lizard_heap_alloc(sizeof(lizard_ast_node_t));
   n->type = AST_SYMBOL;
-  n->data.variable = s;
+  n->data.variable = lizard_intern(s);
   return n;
 }
 static lizard_ast_node_t *mod_quote(lizard_heap_t *heap, lizard_ast_node_t *d) {
@@ -1784,34 +2135,42 @@ lizard_ast_node_t *lizard_expand_macros(lizard_ast_node_t *node,
     }
     for (arg = node->data.application_arguments->head;
          arg != node->data.application_arguments->nil; arg = arg->next) {
-      ((lizard_ast_list_node_t *)arg)->ast =
-          lizard_expand_macros(((lizard_ast_list_node_t *)arg)->ast, env, heap);
+      lizard_ast_list_node_t *a = (lizard_ast_list_node_t *)arg;
+      lizard_ast_store(&a->ast, lizard_expand_macros(a->ast, env, heap));
     }
   }
   switch (node->type) {
   case AST_QUOTE:
-    node->data.quoted = lizard_expand_macros(node->data.quoted, env, heap);
+    lizard_ast_store(&node->data.quoted,
+                     lizard_expand_macros(node->data.quoted, env, heap));
     break;
   case AST_ASSIGNMENT:
-    node->data.assignment.variable =
-        lizard_expand_macros(node->data.assignment.variable, env, heap);
-    node->data.assignment.value =
-        lizard_expand_macros(node->data.assignment.value, env, heap);
+    lizard_ast_store(&node->data.assignment.variable,
+                     lizard_expand_macros(node->data.assignment.variable, env,
+                                          heap));
+    lizard_ast_store(&node->data.assignment.value,
+                     lizard_expand_macros(node->data.assignment.value, env,
+                                          heap));
     break;
   case AST_DEFINITION:
-    node->data.definition.variable =
-        lizard_expand_macros(node->data.definition.variable, env, heap);
-    node->data.definition.value =
-        lizard_expand_macros(node->data.definition.value, env, heap);
+    lizard_ast_store(&node->data.definition.variable,
+                     lizard_expand_macros(node->data.definition.variable, env,
+                                          heap));
+    lizard_ast_store(&node->data.definition.value,
+                     lizard_expand_macros(node->data.definition.value, env,
+                                          heap));
     break;
   case AST_IF:
-    node->data.if_clause.pred =
-        lizard_expand_macros(node->data.if_clause.pred, env, heap);
-    node->data.if_clause.cons =
-        lizard_expand_macros(node->data.if_clause.cons, env, heap);
+    lizard_ast_store(&node->data.if_clause.pred,
+                     lizard_expand_macros(node->data.if_clause.pred, env,
+                                          heap));
+    lizard_ast_store(&node->data.if_clause.cons,
+                     lizard_expand_macros(node->data.if_clause.cons, env,
+                                          heap));
     if (node->data.if_clause.alt) {
-      node->data.if_clause.alt =
-          lizard_expand_macros(node->data.if_clause.alt, env, heap);
+      lizard_ast_store(&node->data.if_clause.alt,
+                       lizard_expand_macros(node->data.if_clause.alt, env,
+                                            heap));
     }
     break;
   case AST_LAMBDA: {
@@ -1822,7 +2181,8 @@ lizard_ast_node_t *lizard_expand_macros(lizard_ast_node_t *node,
       body_node = node->data.lambda.parameters->head->next;
       while (body_node != node->data.lambda.parameters->nil) {
         body_expr = (lizard_ast_list_node_t *)body_node;
-        body_expr->ast = lizard_expand_macros(body_expr->ast, env, heap);
+        lizard_ast_store(&body_expr->ast,
+                         lizard_expand_macros(body_expr->ast, env, heap));
         body_node = body_node->next;
       }
     }
@@ -1831,8 +2191,8 @@ lizard_ast_node_t *lizard_expand_macros(lizard_ast_node_t *node,
   case AST_BEGIN:
     for (expr = node->data.begin_expressions->head;
          expr != node->data.begin_expressions->nil; expr = expr->next) {
-      ((lizard_ast_list_node_t *)expr)->ast = lizard_expand_macros(
-          ((lizard_ast_list_node_t *)expr)->ast, env, heap);
+      lizard_ast_list_node_t *e = (lizard_ast_list_node_t *)expr;
+      lizard_ast_store(&e->ast, lizard_expand_macros(e->ast, env, heap));
     }
     break;
   default:
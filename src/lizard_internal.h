@@ -544,17 +544,28 @@ typedef enum {
   AST_SYNTAX,
   /* Track C: Persistent data structures. */
   AST_PVEC,
-  AST_HAMT
+  AST_HAMT,
+  /* Lexical addressing: a variable reference resolved to (depth, slot) in
+   * the vector-backed frames of the enclosing lambdas (see lexical.h).  Only
+   * appears in the resolved bodies the evaluator runs, never in source ASTs. */
+  AST_LOCAL_REF
 } lizard_ast_node_type_t;
 
 typedef struct lizard_ast_node lizard_ast_node_t;
 typedef struct lizard_env lizard_env_t;
 typedef struct lizard_heap lizard_heap_t;
+typedef struct lizard_frame_layout lizard_frame_layout_t;
 typedef struct lizard_gc_metadata_table lizard_gc_metadata_table_t;
 
 typedef lizard_ast_node_t *(*lizard_primitive_func_t)(lz_list_t *args,
                                                       lizard_env_t *env,
                                                       lizard_heap_t *heap);
+/* Second primitive calling convention: `argc` forced arguments in a buffer
+ * the caller owns (a C array or a slice of the VM stack), so a call costs no
+ * allocation.  The callee must not hold on to `argv`. */
+typedef lizard_ast_node_t *(*lizard_primitive_argv_func_t)(
+    int argc, lizard_ast_node_t **argv, lizard_env_t *env,
+    lizard_heap_t *heap);
 typedef lizard_ast_node_t *(*lizard_callcc_func_t)(
     lz_list_t *args, lizard_env_t *env, lizard_heap_t *heap,
     lizard_ast_node_t *(*current_cont)(lizard_ast_node_t *, lizard_env_t *,
@@ -568,6 +579,15 @@ struct lizard_ast_node {
     bool boolean;
     const char *string;
     mpz_t number;
+    /* Fixnum form of an AST_NUMBER: an integer that fits in a long, held
+     * without a GMP allocation.  `view` overlays `number` and is a read-only
+     * mpz over `limb` (mpz_roinit_n), so every mpz reader sees the value;
+     * writers always start from a fresh mpz_init.  See LIZARD_IS_FIXNUM. */
+    struct {
+      __mpz_struct view;
+      mp_limb_t limb;
+      long value;
+    } fixnum;
     mpq_t rational;  /* exact rational; canonical => denom > 1 */
     double real;     /* inexact real (IEEE double); type == AST_REAL */
     const char *variable;
@@ -588,7 +608,29 @@ struct lizard_ast_node {
     struct {
       lz_list_t *parameters;
       lizard_env_t *closure_env;
+      /* Frame layout and resolved body, filled in lazily by
+       * lizard_lexical_resolve; NULL until the lambda is first evaluated. */
+      lizard_frame_layout_t *layout;
     } lambda;
+    struct {
+      const char *name;
+      unsigned int depth;
+      unsigned int slot;
+      const lizard_frame_layout_t *layout; /* layout the target frame must have */
+    } local_ref;
+    /* A symbol evaluated as a global reference (or OP_LOAD's name constant):
+     * `name` overlays `variable` and `string`, the rest is the site's inline
+     * cache, filled in by lizard_env_lookup_site.  The binding's cell is
+     * `depth` frames up from an env whose innermost layout is `layout`, in
+     * frame `home`, as long as the env epoch is still `epoch`. */
+    struct {
+      const char *name;
+      unsigned long epoch;
+      unsigned int depth;
+      const lizard_frame_layout_t *layout;
+      lizard_env_t *home;
+      struct lizard_ast_node **cell;
+    } global_ref;
     lz_list_t *begin_expressions;
     lz_list_t *cond_clauses;
     lz_list_t *application_arguments;
@@ -596,7 +638,10 @@ struct lizard_ast_node {
       lizard_ast_node_t *car;
       lizard_ast_node_t *cdr;
     } pair;
-    lizard_primitive_func_t primitive;
+    struct {
+      lizard_primitive_func_t fn;        /* list convention; always set */
+      lizard_primitive_argv_func_t argv; /* (argc, argv) entry, or NULL */
+    } primitive;
     /* Phase 9: a natively-compiled procedure (see src/lzrt.c).  entry is the
      * generated C function; freevars is a heap array of captured values that
      * the conservative GC scans. */
@@ -622,6 +667,7 @@ struct lizard_ast_node {
       lizard_ast_node_t *(*captured_cont)(lizard_ast_node_t *result,
                                           lizard_env_t *env,
                                           lizard_heap_t *heap);
+      unsigned long escape_id; /* call/cc frame it escapes to */
     } continuation;
     struct {
       int code;
@@ -1040,6 +1086,14 @@ struct lizard_ast_node {
   } data;
 };
 
+/* True when `n` is an AST_NUMBER in fixnum form.  The view only points at
+ * the node's own limb while the node is untouched, so a node whose mpz was
+ * written in place is simply a bignum again. */
+#define LIZARD_IS_FIXNUM(n)                                                   \
+  ((n)->type == AST_NUMBER &&                                                 \
+   (n)->data.number->_mp_d == &(n)->data.fixnum.limb)
+#define LIZARD_FIXNUM_VALUE(n) ((n)->data.fixnum.value)
+
 typedef struct lizard_ast_list_node {
   lz_list_node_t node;
   lizard_ast_node_t *ast;
@@ -1052,12 +1106,29 @@ typedef struct lizard_heap_segment {
   struct lizard_heap_segment *next;
 } lizard_heap_segment_t;
 
-/* Phase 5: a per-size free list of reclaimed chunks. */
-struct lizard_free_bucket {
+/* Small objects are rounded up to one of LIZARD_HEAP_CLASS_COUNT size
+ * classes, the largest LIZARD_HEAP_SMALL_MAX bytes.  A class bump-allocates
+ * from a region of its own carved off the segments, and reuses reclaimed
+ * chunks first; a chunk on the free list keeps the link in its first word. */
+#define LIZARD_HEAP_CLASS_COUNT 28
+#define LIZARD_HEAP_SMALL_MAX 2048U
+
+struct lizard_heap_class {
   size_t size;
-  void *head;
+  void *free;
+  char *top;
+  char *end;
 };
 
+/* Larger objects each get a run of pages of their own, mapped apart from
+ * the segments.  The header sits just before the object. */
+typedef struct lizard_large_run {
+  struct lizard_large_run *next;      /* every run of the heap */
+  struct lizard_large_run *next_free; /* reclaimed runs */
+  size_t bytes;                       /* mapped, header included */
+  size_t size;                        /* usable by the object */
+} lizard_large_run_t;
+
 struct lizard_heap {
   lizard_heap_segment_t *head;
   lizard_heap_segment_t *current;
@@ -1069,12 +1140,22 @@ struct lizard_heap {
   lizard_runtime_t *runtime;
   /* Phase 3B: per-object metadata side table. C-owned, non-moving. */
   lizard_gc_metadata_table_t *gc_metadata;
-  /* Phase 5: per-size free lists of swept (reclaimed) chunks for reuse.
-   * Each bucket links free chunks of one exact (aligned) size; the link
-   * pointer is stored in the first word of each free chunk. */
-  struct lizard_free_bucket *free_buckets;
-  size_t free_bucket_count;
-  size_t free_bucket_cap;
+  /* Phase 5: swept (reclaimed) chunks are reused through their class. */
+  struct lizard_heap_class classes[LIZARD_HEAP_CLASS_COUNT];
+  size_t region_size;
+  lizard_large_run_t *large_runs;
+  lizard_large_run_t *large_free;
+  size_t large_bytes;
+  /* Generations (gc.c): slots of old objects stored into since the last
+   * collection, taken as roots by a minor one. */
+  const void **remembered;
+  size_t remembered_count;
+  size_t remembered_cap;
+  int remembered_lost;         /* one could not be kept: collect fully */
+  size_t full_old_bytes;       /* old after the last full collection */
+  /* Macro uses expanded at run time, by source form, held weakly
+   * (lizard.c). */
+  struct lizard_expansion_memo *expansion_memo;
 };
 
 typedef struct lizard_env_entry {
@@ -1083,9 +1164,19 @@ typedef struct lizard_env_entry {
   struct lizard_env_entry *next;
 } lizard_env_entry_t;
 
+/* A frame is either a list of named entries (globals, module bodies, and
+ * closures the resolver could not lay out) or a fixed vector of slots
+ * described by a lizard_frame_layout_t; slot frames may still grow entries
+ * when something defines a name the layout does not know about.  Frames that
+ * accumulate many entries get a hash index keyed by interned name. */
 struct lizard_env {
   lizard_env_entry_t *entries;
   struct lizard_env *parent;
+  const lizard_frame_layout_t *layout;
+  lizard_ast_node_t **slots;
+  lizard_env_entry_t **index;  /* open-addressed, NULL until count is large */
+  size_t index_cap;
+  size_t count;                /* number of entries */
 };
 
 typedef lizard_ast_node_t *(*lizard_continuation_t)(lizard_ast_node_t *result,
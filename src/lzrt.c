@@ -3,6 +3,7 @@
 #include "mem.h"
 #include "env.h"
 #include "primitives.h"
+#include "symbol.h"
 #include "errors.h"
 #include <gmp.h>
 #include <string.h>
@@ -11,7 +12,7 @@
 static lizard_env_t *g_env = NULL;
 
 void lzrt_init(void) {
-  mp_set_memory_functions(lizard_heap_alloc, lizard_heap_realloc,
+  mp_set_memory_functions(lizard_heap_alloc_atomic, lizard_heap_realloc_atomic,
                           lizard_heap_free_wrapper);
   heap = lizard_heap_create((size_t)1024 * 1024, (size_t)256 * 1024 * 1024);
   g_env = lizard_env_create(heap, NULL);
@@ -22,16 +23,12 @@ lizard_env_t *lzrt_global_env(void) { return g_env; }
 
 /* ---- literals ---- */
 
-lizard_ast_node_t *lzrt_int(long v) {
-  lizard_ast_node_t *n = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  n->type = AST_NUMBER;
-  mpz_init_set_si(n->data.number, v);
-  return n;
-}
+lizard_ast_node_t *lzrt_int(long v) { return lizard_make_fixnum(heap, v); }
 lizard_ast_node_t *lzrt_int_str(const char *decimal) {
-  lizard_ast_node_t *n = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  lizard_ast_node_t *n = lizard_make_number_node(heap);
   n->type = AST_NUMBER;
   mpz_init_set_str(n->data.number, decimal, 10);
+  lizard_number_normalize(n);
   return n;
 }
 lizard_ast_node_t *lzrt_real(double v) { return lizard_make_real(heap, v); }
@@ -41,7 +38,7 @@ lizard_ast_node_t *lzrt_nil(void) { return lizard_make_nil(heap); }
 lizard_ast_node_t *lzrt_string(const char *s) {
   lizard_ast_node_t *n = lizard_heap_alloc(sizeof(lizard_ast_node_t));
   size_t len = strlen(s);
-  char *copy = lizard_heap_alloc(len + 1);
+  char *copy = lizard_heap_alloc_atomic(len + 1);
   memcpy(copy, s, len + 1);
   n->type = AST_STRING;
   n->data.string = copy;
@@ -49,19 +46,12 @@ lizard_ast_node_t *lzrt_string(const char *s) {
 }
 lizard_ast_node_t *lzrt_symbol(const char *s) {
   lizard_ast_node_t *n = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  size_t len = strlen(s);
-  char *copy = lizard_heap_alloc(len + 1);
-  memcpy(copy, s, len + 1);
   n->type = AST_SYMBOL;
-  n->data.variable = copy;
+  n->data.variable = lizard_intern(s);
   return n;
 }
 lizard_ast_node_t *lzrt_cons(lizard_ast_node_t *a, lizard_ast_node_t *d) {
-  lizard_ast_node_t *n = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  n->type = AST_PAIR;
-  n->data.pair.car = a;
-  n->data.pair.cdr = d;
-  return n;
+  return lizard_make_pair(heap, a, d);
 }
 
 /* ---- assignment-conversion boxes -------------------------------------- *
@@ -146,19 +136,11 @@ lizard_ast_node_t *lzrt_tailcall(lizard_ast_node_t *fn,
   return &g_bounce_sentinel;
 }
 
-/* Build an lz_list_t of argv and call a primitive. */
+/* Call a primitive on argv (through its list entry if it has no argv one). */
 static lizard_ast_node_t *lzrt_call_primitive(lizard_ast_node_t *prim,
                                               lizard_ast_node_t **argv,
                                               long argc) {
-  lz_list_t *args = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
-  long i;
-  for (i = 0; i < argc; i++) {
-    lizard_ast_list_node_t *node =
-        lizard_heap_alloc(sizeof(lizard_ast_list_node_t));
-    node->ast = argv[i];
-    list_append(args, &node->node);
-  }
-  return prim->data.primitive(args, g_env, heap);
+  return lizard_primitive_call(prim, (int)argc, argv, g_env, heap);
 }
 
 /* Bind argv to a compiled procedure's parameters (handling rest args) and call
@@ -1,8 +1,11 @@
 #include "mem.h"
 #include "env.h"
+#include "gc.h"
 #include "gc_metadata.h"
 #include "lang.h"
 #include "lizard_internal.h"
+#include <limits.h>
+#include <unistd.h>
 
 static const char *lizard_error_messages_lang_en[LIZARD_ERROR_COUNT] = {
 #define X(fst, snd) snd,
@@ -41,91 +44,162 @@ lizard_heap_segment_t *lizard_create_heap_segment(size_t size) {
   return seg;
 }
 
+/* The size classes: every word up to 64 bytes, then four steps to each
+ * power of two.  heap_class_of maps an aligned size, in 8-byte units, to
+ * its class. */
+static const size_t heap_class_sizes[LIZARD_HEAP_CLASS_COUNT] = {
+    8,   16,  24,  32,  40,   48,   56,   64,   80,   96,
+    112, 128, 160, 192, 224,  256,  320,  384,  448,  512,
+    640, 768, 896, 1024, 1280, 1536, 1792, 2048};
+static unsigned char heap_class_of[LIZARD_HEAP_SMALL_MAX / 8U + 1U];
+static int heap_class_of_ready = 0;
+
+/* Bytes a class carves off a segment at a time. */
+#define LIZARD_HEAP_REGION_SIZE 16384U
+
+static size_t heap_class_index(size_t size) {
+  return heap_class_of[(size + 7U) / 8U];
+}
+
 lizard_heap_t *lizard_heap_create(size_t initial_size,
                                   size_t max_segment_size) {
   lizard_heap_t *heap;
+  size_t i, c;
   heap = (lizard_heap_t *)malloc(sizeof(lizard_heap_t));
   if (heap == NULL) {
     fprintf(stderr, "Error: Unable to allocate lizard_heap_t\n");
     exit(1);
   }
+  if (!heap_class_of_ready) {
+    for (i = 0, c = 0; i <= LIZARD_HEAP_SMALL_MAX / 8U; i++) {
+      if (i * 8U > heap_class_sizes[c]) c++;
+      heap_class_of[i] = (unsigned char)c;
+    }
+    heap_class_of_ready = 1;
+  }
   heap->initial_size = initial_size;
   heap->max_segment_size = max_segment_size;
   heap->head = lizard_create_heap_segment(initial_size);
   heap->current = heap->head;
   heap->runtime = NULL;  /* Phase 0: set by lizard_runtime_create */
   heap->gc_metadata = lizard_gc_metadata_table_create();
-  heap->free_buckets = NULL;
-  heap->free_bucket_count = 0U;
-  heap->free_bucket_cap = 0U;
+  for (i = 0; i < LIZARD_HEAP_CLASS_COUNT; i++) {
+    heap->classes[i].size = heap_class_sizes[i];
+    heap->classes[i].free = NULL;
+    heap->classes[i].top = NULL;
+    heap->classes[i].end = NULL;
+  }
+  heap->region_size = LIZARD_HEAP_REGION_SIZE < max_segment_size
+                          ? LIZARD_HEAP_REGION_SIZE
+                          : max_segment_size;
+  heap->large_runs = NULL;
+  heap->large_free = NULL;
+  heap->large_bytes = 0U;
+  heap->remembered = NULL;
+  heap->remembered_count = 0U;
+  heap->remembered_cap = 0U;
+  heap->remembered_lost = 0;
+  heap->full_old_bytes = 0U;
+  heap->expansion_memo = NULL;
   return heap;
 }
 
-/* Phase 5: per-size free list of reclaimed chunks.  A freed chunk stores the
- * next-pointer in its first word; buckets are keyed by exact aligned size. */
-static struct lizard_free_bucket *freelist_bucket(lizard_heap_t *h, size_t size) {
-  size_t i;
-  for (i = 0; i < h->free_bucket_count; i++) {
-    if (h->free_buckets[i].size == size) return &h->free_buckets[i];
+/* Give class `c` a fresh region to bump-allocate from, taken from the
+ * current segment or, when that is out of room, a new one. */
+static void heap_class_refill(lizard_heap_t *h, struct lizard_heap_class *c) {
+  lizard_heap_segment_t *seg = h->current;
+  size_t region = h->region_size > c->size ? h->region_size : c->size;
+  size_t new_segment_size;
+  if (seg->top + region > seg->end) {
+    new_segment_size = (size_t)(seg->end - seg->start) * 2U;
+    if (new_segment_size > h->max_segment_size) {
+      new_segment_size = h->max_segment_size;
+    }
+    if (new_segment_size < region) {
+      new_segment_size = region;
+    }
+    seg->next = lizard_create_heap_segment(new_segment_size);
+    h->current = seg->next;
+    seg = h->current;
+  }
+  c->top = seg->top;
+  c->end = seg->top + region - region % c->size;
+  seg->top += region;
+}
+
+/* A large object of at least `size` bytes: a reclaimed run that fits
+ * without wasting half of it, else a new mapping. */
+static lizard_large_run_t *heap_large_take(lizard_heap_t *h, size_t size) {
+  lizard_large_run_t **link, *run;
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t bytes;
+  void *map;
+  for (link = &h->large_free; (run = *link) != NULL; link = &run->next_free) {
+    if (run->size >= size && run->size / 2U < size) {
+      *link = run->next_free;
+      run->next_free = NULL;
+      return run;
+    }
   }
-  if (h->free_bucket_count == h->free_bucket_cap) {
-    size_t ncap = h->free_bucket_cap ? h->free_bucket_cap * 2U : 16U;
-    struct lizard_free_bucket *p = (struct lizard_free_bucket *)realloc(
-        h->free_buckets, ncap * sizeof(struct lizard_free_bucket));
-    if (p == NULL) return NULL;
-    h->free_buckets = p;
-    h->free_bucket_cap = ncap;
+  bytes = (sizeof(lizard_large_run_t) + size + page - 1U) / page * page;
+  map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+             -1, 0);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "mmap failed for large object size %lu\n",
+            (unsigned long)size);
+    perror("mmap");
+    exit(1);
   }
-  h->free_buckets[h->free_bucket_count].size = size;
-  h->free_buckets[h->free_bucket_count].head = NULL;
-  return &h->free_buckets[h->free_bucket_count++];
+  run = (lizard_large_run_t *)map;
+  run->next = h->large_runs;
+  run->next_free = NULL;
+  run->bytes = bytes;
+  run->size = bytes - sizeof(lizard_large_run_t);
+  h->large_runs = run;
+  h->large_bytes += bytes;
+  return run;
 }
 
 void lizard_heap_reclaim(void *ptr, size_t size) {
-  struct lizard_free_bucket *b;
   if (heap == NULL || ptr == NULL) return;
-  b = freelist_bucket(heap, size);
-  if (b == NULL) return;           /* OOM growing buckets: just drop it */
-  *(void **)ptr = b->head;         /* link this chunk into the bucket */
-  b->head = ptr;
-}
-
-static void *freelist_take(lizard_heap_t *h, size_t size) {
-  size_t i;
-  for (i = 0; i < h->free_bucket_count; i++) {
-    if (h->free_buckets[i].size == size && h->free_buckets[i].head != NULL) {
-      void *p = h->free_buckets[i].head;
-      h->free_buckets[i].head = *(void **)p;
-      return p;
-    }
+  if (size <= LIZARD_HEAP_SMALL_MAX) {
+    struct lizard_heap_class *c = &heap->classes[heap_class_index(size)];
+    *(void **)ptr = c->free;       /* link this chunk into its class */
+    c->free = ptr;
+  } else {
+    lizard_large_run_t *run = (lizard_large_run_t *)ptr - 1;
+    run->next_free = heap->large_free;
+    heap->large_free = run;
   }
-  return NULL;
 }
-void *lizard_heap_realloc(void *ptr, size_t old_size, size_t new_size) {
-  lizard_heap_segment_t *seg;
+
+/* Grow or shrink `ptr`, taking a new chunk, if it must move, from
+ * `alloc`. */
+static void *heap_realloc(void *ptr, size_t old_size, size_t new_size,
+                          void *(*alloc)(size_t)) {
   void *new_ptr;
-  size_t additional;
+  size_t room;
   size_t copy_size;
 
   new_size = align_size(new_size);
 
   if (ptr == NULL) {
-    return lizard_heap_alloc(new_size);
+    return alloc(new_size);
   }
   if (new_size == 0) {
     return NULL;
   }
 
-  seg = heap->current;
-  if ((char *)ptr + old_size == seg->top) {
-    additional = new_size - old_size;
-    if (seg->top + additional <= seg->end) {
-      seg->top += additional;
-      return ptr;
-    }
+  /* Grow in place while the chunk's class or run has the room. */
+  old_size = align_size(old_size);
+  room = old_size <= LIZARD_HEAP_SMALL_MAX
+             ? heap_class_sizes[heap_class_index(old_size)]
+             : ((lizard_large_run_t *)ptr - 1)->size;
+  if (new_size <= room) {
+    return ptr;
   }
 
-  new_ptr = lizard_heap_alloc(new_size);
+  new_ptr = alloc(new_size);
   if (new_ptr == NULL) {
     return NULL;
   }
@@ -134,10 +208,35 @@ void *lizard_heap_realloc(void *ptr, size_t old_size, size_t new_size) {
   return new_ptr;
 }
 
+void *lizard_heap_realloc(void *ptr, size_t old_size, size_t new_size) {
+  return heap_realloc(ptr, old_size, new_size, lizard_heap_alloc);
+}
+
+/* GMP is done with `ptr`: its chunk is reused at once rather than left
+ * to a collection. */
+static void heap_release(void *ptr) {
+  size_t size;
+  if (heap == NULL) return;
+  size = lizard_gc_metadata_release(heap->gc_metadata, ptr);
+  if (size > 0U) {
+    lizard_heap_reclaim(ptr, size);
+  }
+}
+
+void *lizard_heap_realloc_atomic(void *ptr, size_t old_size, size_t new_size) {
+  void *new_ptr = heap_realloc(ptr, old_size, new_size,
+                               lizard_heap_alloc_atomic);
+  if (new_ptr != NULL && new_ptr != ptr) {
+    heap_release(ptr);
+  }
+  return new_ptr;
+}
+
 static lizard_object_trace_policy_t lizard_heap_default_trace_policy(
     lizard_gc_object_kind_t kind) {
   switch (kind) {
   case LIZARD_GC_OBJECT_AST_NODE:
+  case LIZARD_GC_OBJECT_NUMBER:
     return LIZARD_OBJECT_TRACE_AST;
   case LIZARD_GC_OBJECT_AST_LIST_NODE:
     return LIZARD_OBJECT_TRACE_LIST;
@@ -153,72 +252,84 @@ static lizard_object_trace_policy_t lizard_heap_default_trace_policy(
   return LIZARD_OBJECT_TRACE_NONE;
 }
 
-void *lizard_heap_alloc_tagged(size_t size,
-                               lizard_gc_object_kind_t kind,
-                               lizard_object_trace_policy_t trace_policy) {
-  lizard_heap_segment_t *seg;
+/* An object of `kind` is registered as such only when the caller said so;
+ * one whose kind was inferred from its size is scanned conservatively. */
+static void *heap_alloc_object(size_t size, lizard_gc_object_kind_t kind,
+                               lizard_object_trace_policy_t trace_policy,
+                               int inferred) {
   void *ptr;
-  size_t current_seg_size;
-  size_t new_segment_size;
 
-  size = align_size(size);
-  if (kind == LIZARD_GC_OBJECT_UNKNOWN) {
-    kind = lizard_gc_infer_object_kind(size);
-  }
   if (trace_policy == LIZARD_OBJECT_TRACE_CUSTOM &&
       kind != LIZARD_GC_OBJECT_KERNEL_TERM) {
     trace_policy = lizard_heap_default_trace_policy(kind);
   }
 
-  /* Phase 5: reuse a previously reclaimed chunk of the same size if one is
-   * available, before extending the bump pointer. */
-  ptr = freelist_take(heap, size);
-  if (ptr != NULL) {
-    memset(ptr, 0, size);
-    if (heap->gc_metadata != NULL) {
-      (void)lizard_gc_metadata_register(heap->gc_metadata, ptr, size, kind,
-                                        LIZARD_OBJECT_OWNER_HEAP, trace_policy);
+  if (size <= LIZARD_HEAP_SMALL_MAX) {
+    /* Phase 5: reuse a reclaimed chunk of the class if there is one,
+     * before bumping the class's region. */
+    struct lizard_heap_class *c = &heap->classes[heap_class_index(size)];
+    size = c->size;
+    ptr = c->free;
+    if (ptr != NULL) {
+      c->free = *(void **)ptr;
+    } else {
+      if (c->top == NULL || c->top + size > c->end) {
+        heap_class_refill(heap, c);
+      }
+      ptr = c->top;
+      c->top += size;
     }
-    return ptr;
+    memset(ptr, 0, size);
+  } else {
+    lizard_large_run_t *run = heap_large_take(heap, size);
+    ptr = run + 1;
+    memset(ptr, 0, size);
+    size = run->size;
   }
-
-  seg = heap->current;
-  if (seg->top + size > seg->end) {
-    current_seg_size = (size_t)(seg->end - seg->start);
-    new_segment_size = current_seg_size * 2U;
-    if (new_segment_size < size) {
-      new_segment_size = size;
-    }
-    if (new_segment_size > heap->max_segment_size) {
-      new_segment_size = heap->max_segment_size;
-    }
-    seg->next = lizard_create_heap_segment(new_segment_size);
-    heap->current = seg->next;
-    seg = heap->current;
+  if (heap->gc_metadata == NULL) {
+    return ptr;
   }
-  ptr = seg->top;
-  seg->top += size;
-  memset(ptr, 0, size);
-  if (heap->gc_metadata != NULL) {
+  if (inferred) {
+    (void)lizard_gc_metadata_register_inferred(heap->gc_metadata, ptr, size,
+                                               kind, LIZARD_OBJECT_OWNER_HEAP,
+                                               trace_policy);
+  } else {
     (void)lizard_gc_metadata_register(heap->gc_metadata, ptr, size, kind,
                                       LIZARD_OBJECT_OWNER_HEAP, trace_policy);
   }
   return ptr;
 }
 
+void *lizard_heap_alloc_tagged(size_t size,
+                               lizard_gc_object_kind_t kind,
+                               lizard_object_trace_policy_t trace_policy) {
+  size = align_size(size);
+  if (kind == LIZARD_GC_OBJECT_UNKNOWN) {
+    return heap_alloc_object(size, lizard_gc_infer_object_kind(size),
+                             trace_policy, 1);
+  }
+  return heap_alloc_object(size, kind, trace_policy, 0);
+}
+
 void *lizard_heap_alloc(size_t size) {
   size_t aligned_size;
   lizard_gc_object_kind_t kind;
 
   aligned_size = align_size(size);
   kind = lizard_gc_infer_object_kind(aligned_size);
-  return lizard_heap_alloc_tagged(size, kind,
-                                  lizard_heap_default_trace_policy(kind));
+  return heap_alloc_object(aligned_size, kind,
+                           lizard_heap_default_trace_policy(kind), 1);
+}
+
+void *lizard_heap_alloc_atomic(size_t size) {
+  return heap_alloc_object(align_size(size), LIZARD_GC_OBJECT_RAW,
+                           LIZARD_OBJECT_TRACE_NONE, 0);
 }
 
 void lizard_heap_destroy(lizard_heap_t *heap) {
   lizard_heap_segment_t *seg;
   lizard_heap_segment_t *next;
+  lizard_large_run_t *run;
   size_t seg_size;
 
   seg = heap->head;
@@ -229,13 +340,21 @@ void lizard_heap_destroy(lizard_heap_t *heap) {
     free(seg);
     seg = next;
   }
+  while ((run = heap->large_runs) != NULL) {
+    heap->large_runs = run->next;
+    munmap((void *)run, run->bytes);
+  }
   lizard_gc_metadata_table_destroy(heap->gc_metadata);
+  free((void *)heap->remembered);
   free(heap);
 }
 
 void lizard_heap_free(void *ptr) { (void)ptr; }
 
-void lizard_heap_free_wrapper(void *ptr, size_t size) { (void)ptr; }
+void lizard_heap_free_wrapper(void *ptr, size_t size) {
+  (void)size;
+  heap_release(ptr);
+}
 
 lizard_ast_node_t *lizard_make_bool(lizard_heap_t *heap, bool value) {
   lizard_ast_node_t *node;
@@ -266,6 +385,132 @@ lizard_ast_node_t *lizard_make_real(lizard_heap_t *heap, double value) {
   return node;
 }
 
+lizard_ast_node_t *lizard_copy_node(lizard_heap_t *heap,
+                                    const lizard_ast_node_t *node) {
+  lizard_ast_node_t *c = lizard_heap_alloc_tagged(
+      sizeof(lizard_ast_node_t), LIZARD_GC_OBJECT_AST_NODE,
+      LIZARD_OBJECT_TRACE_AST);
+  memcpy(c, node, sizeof(lizard_ast_node_t));
+  return c;
+}
+
+lizard_ast_node_t *lizard_make_pair(lizard_heap_t *heap, lizard_ast_node_t *car,
+                                    lizard_ast_node_t *cdr) {
+  lizard_ast_node_t *node;
+  node = lizard_heap_alloc_tagged(sizeof(lizard_ast_node_t),
+                                LIZARD_GC_OBJECT_AST_NODE,
+                                LIZARD_OBJECT_TRACE_AST);
+  node->type = AST_PAIR;
+  node->data.pair.car = car;
+  node->data.pair.cdr = cdr;
+  return node;
+}
+
+/* A swept number clears its mpz or mpq, so GMP frees the limbs. */
+static void number_finalize(void *obj, size_t size) {
+  lizard_ast_node_t *node = (lizard_ast_node_t *)obj;
+  (void)size;
+  if (node->type == AST_RATIONAL) {
+    mpq_clear(node->data.rational);
+  } else if (node->type == AST_NUMBER && !LIZARD_IS_FIXNUM(node)) {
+    mpz_clear(node->data.number);
+  }
+}
+
+lizard_ast_node_t *lizard_make_number_node(lizard_heap_t *heap) {
+  static int finalized = 0;
+  if (!finalized) {
+    lizard_gc_set_finalizer(LIZARD_GC_OBJECT_NUMBER, number_finalize);
+    finalized = 1;
+  }
+  return lizard_heap_alloc_tagged(sizeof(lizard_ast_node_t),
+                                  LIZARD_GC_OBJECT_NUMBER,
+                                  LIZARD_OBJECT_TRACE_AST);
+}
+
+void lizard_fixnum_init(lizard_ast_node_t *node, long value) {
+  node->type = AST_NUMBER;
+  node->data.fixnum.value = value;
+  /* magnitude without negating LONG_MIN */
+  node->data.fixnum.limb =
+      value < 0 ? (mp_limb_t)(-(value + 1)) + 1U : (mp_limb_t)value;
+  mpz_roinit_n(&node->data.fixnum.view, &node->data.fixnum.limb,
+               value < 0 ? -1 : (value > 0 ? 1 : 0));
+}
+
+/* Shared nodes for the small integers loops and indices produce most;
+ * numbers are immutable once built, so one node per value suffices.  The
+ * table is fixed and outside the heap: it holds no pointer the collector
+ * needs to see. */
+static lizard_ast_node_t lizard_fixnum_cache[LIZARD_FIXNUM_SHARED_MAX -
+                                              LIZARD_FIXNUM_SHARED_MIN + 1];
+static int lizard_fixnum_cache_ready = 0;
+
+lizard_ast_node_t *lizard_make_fixnum(lizard_heap_t *heap, long value) {
+  lizard_ast_node_t *node;
+  if (value >= LIZARD_FIXNUM_SHARED_MIN && value <= LIZARD_FIXNUM_SHARED_MAX) {
+    if (!lizard_fixnum_cache_ready) {
+      long v;
+      for (v = LIZARD_FIXNUM_SHARED_MIN; v <= LIZARD_FIXNUM_SHARED_MAX; v++) {
+        lizard_fixnum_init(&lizard_fixnum_cache[v - LIZARD_FIXNUM_SHARED_MIN],
+                           v);
+      }
+      lizard_fixnum_cache_ready = 1;
+    }
+    return &lizard_fixnum_cache[value - LIZARD_FIXNUM_SHARED_MIN];
+  }
+  node = lizard_make_number_node(heap);
+  lizard_fixnum_init(node, value);
+  return node;
+}
+
+lizard_ast_node_t *lizard_make_integer(lizard_heap_t *heap, mpz_srcptr value) {
+  lizard_ast_node_t *node;
+  if (mpz_fits_slong_p(value)) {
+    return lizard_make_fixnum(heap, mpz_get_si(value));
+  }
+  node = lizard_make_number_node(heap);
+  node->type = AST_NUMBER;
+  mpz_init_set(node->data.number, value);
+  return node;
+}
+
+void lizard_number_normalize(lizard_ast_node_t *node) {
+  if (node->type == AST_NUMBER && !LIZARD_IS_FIXNUM(node) &&
+      mpz_fits_slong_p(node->data.number)) {
+    long value = mpz_get_si(node->data.number);
+    mpz_clear(node->data.number);
+    lizard_fixnum_init(node, value);
+  }
+}
+
+int lizard_fixnum_add(long a, long b, long *out) {
+  if (b > 0 ? a > LONG_MAX - b : a < LONG_MIN - b) {
+    return 0;
+  }
+  *out = a + b;
+  return 1;
+}
+
+int lizard_fixnum_sub(long a, long b, long *out) {
+  if (b < 0 ? a > LONG_MAX + b : a < LONG_MIN + b) {
+    return 0;
+  }
+  *out = a - b;
+  return 1;
+}
+
+int lizard_fixnum_mul(long a, long b, long *out) {
+  if (a != 0 && b != 0) {
+    if (a > 0 ? (b > 0 ? a > LONG_MAX / b : b < LONG_MIN / a)
+              : (b > 0 ? a < LONG_MIN / b : a < LONG_MAX / b)) {
+      return 0;
+    }
+  }
+  *out = a * b;
+  return 1;
+}
+
 lizard_ast_node_t *lizard_make_macro_def(lizard_heap_t *heap,
                                          lizard_ast_node_t *name,
                                          lizard_ast_node_t *transformer) {
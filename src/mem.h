@@ -10,6 +10,12 @@ extern lizard_heap_t *heap;
 size_t align_size(size_t size);
 lizard_heap_segment_t *lizard_create_heap_segment(size_t size);
 void *lizard_heap_realloc(void *ptr, size_t old_size, size_t new_size);
+/* Memory that never holds a pointer into the heap (string bytes, GMP
+ * limbs): kept alive by what points at it, never scanned itself.  GMP
+ * reallocs through lizard_heap_realloc_atomic, which reuses the chunk it
+ * moved from at once. */
+void *lizard_heap_alloc_atomic(size_t size);
+void *lizard_heap_realloc_atomic(void *ptr, size_t old_size, size_t new_size);
 lizard_heap_t *lizard_heap_create(size_t initial_size, size_t reserved_size);
 void lizard_heap_destroy(lizard_heap_t *heap);
 void *lizard_heap_alloc(size_t size);
@@ -18,12 +24,43 @@ void *lizard_heap_alloc_tagged(size_t size,
                                lizard_gc_object_kind_t kind,
                                lizard_object_trace_policy_t trace_policy);
 void lizard_heap_free(void *ptr);
+/* GMP's free: the chunk is reused at once, not left to a collection. */
 void lizard_heap_free_wrapper(void *ptr, size_t size);
 lizard_ast_node_t *lizard_make_primitive(lizard_heap_t *heap,
                                          lizard_primitive_func_t func);
+lizard_ast_node_t *lizard_make_primitive_argv(
+    lizard_heap_t *heap, lizard_primitive_func_t func,
+    lizard_primitive_argv_func_t argv_func);
 lizard_ast_node_t *lizard_make_bool(lizard_heap_t *heap, bool value);
 lizard_ast_node_t *lizard_make_real(lizard_heap_t *heap, double value);
+lizard_ast_node_t *lizard_make_pair(lizard_heap_t *heap, lizard_ast_node_t *car,
+                                    lizard_ast_node_t *cdr);
+/* Integers.  lizard_make_fixnum returns a shared node for values in
+ * LIZARD_FIXNUM_SHARED_MIN..MAX, and a fresh heap node for any other, so
+ * arithmetic on fixnums outside that range allocates; lizard_make_integer
+ * picks the fixnum form whenever `value` fits in a long.
+ * lizard_fixnum_init and lizard_number_normalize work on a node the caller
+ * owns (a fresh node, or a result just computed into its mpz). */
+#define LIZARD_FIXNUM_SHARED_MIN (-1024L)
+#define LIZARD_FIXNUM_SHARED_MAX 4095L
+lizard_ast_node_t *lizard_make_fixnum(lizard_heap_t *heap, long value);
+/* A node for an exact number, for the caller to give its type (AST_NUMBER
+ * or AST_RATIONAL) and payload; tagged as a number, it clears the payload
+ * when swept. */
+lizard_ast_node_t *lizard_make_number_node(lizard_heap_t *heap);
+lizard_ast_node_t *lizard_make_integer(lizard_heap_t *heap, mpz_srcptr value);
+void lizard_fixnum_init(lizard_ast_node_t *node, long value);
+void lizard_number_normalize(lizard_ast_node_t *node);
+/* Overflow-checked fixnum arithmetic: store the result and return 1, or
+ * return 0 (leaving *out alone) when it does not fit in a long. */
+int lizard_fixnum_add(long a, long b, long *out);
+int lizard_fixnum_sub(long a, long b, long *out);
+int lizard_fixnum_mul(long a, long b, long *out);
 lizard_ast_node_t *lizard_make_nil(lizard_heap_t *heap);
+/* Shallow copy of `node`, for the passes that copy the nodes they change
+ * and share the subtrees they do not (lexical.c, optimize.c). */
+lizard_ast_node_t *lizard_copy_node(lizard_heap_t *heap,
+                                    const lizard_ast_node_t *node);
 lizard_ast_node_t *lizard_make_macro_def(lizard_heap_t *heap,
                                          lizard_ast_node_t *name,
                                          lizard_ast_node_t *transformer);
@@ -66,6 +66,8 @@ const char *lizard_object_trace_policy_name(
     return "list";
   case LIZARD_OBJECT_TRACE_CUSTOM:
     return "custom";
+  case LIZARD_OBJECT_TRACE_CONSERVATIVE:
+    return "conservative";
   }
   return "none";
 }
@@ -80,7 +82,8 @@ int lizard_object_trace_policy_requires_mark(
   return policy == LIZARD_OBJECT_TRACE_AST ||
          policy == LIZARD_OBJECT_TRACE_ENV ||
          policy == LIZARD_OBJECT_TRACE_LIST ||
-         policy == LIZARD_OBJECT_TRACE_CUSTOM;
+         policy == LIZARD_OBJECT_TRACE_CUSTOM ||
+         policy == LIZARD_OBJECT_TRACE_CONSERVATIVE;
 }
 
 void lizard_object_model_ast_node(lizard_object_model_info_t *out_info) {
@@ -24,7 +24,9 @@ typedef enum lizard_object_trace_policy {
   LIZARD_OBJECT_TRACE_AST = 1,
   LIZARD_OBJECT_TRACE_ENV = 2,
   LIZARD_OBJECT_TRACE_LIST = 3,
-  LIZARD_OBJECT_TRACE_CUSTOM = 4
+  LIZARD_OBJECT_TRACE_CUSTOM = 4,
+  /* Layout unknown: every word that looks like a pointer is one. */
+  LIZARD_OBJECT_TRACE_CONSERVATIVE = 5
 } lizard_object_trace_policy_t;
 
 typedef struct lizard_object_model_info {
@@ -0,0 +1,869 @@
+/* src/optimize.c — constant folding and inlining (see optimize.h). */
+
+#include "optimize.h"
+
+#include "env.h"
+#include "mem.h"
+#include "primitives.h"
+#include "runtime.h"
+#include "symbol.h"
+
+#include <string.h>
+
+/* Largest body inlined, in AST nodes, and how many inlined bodies may nest
+ * inside one another (mutually calling procedures stop here). */
+#define OPTIMIZE_INLINE_NODES 16U
+#define OPTIMIZE_INLINE_DEPTH 4
+
+/* Growable set of interned names. */
+typedef struct {
+  const char **names;
+  size_t count;
+  size_t cap;
+} optimize_names_t;
+
+/* Names assigned by set! in every form optimised so far. */
+struct lizard_optimize_state {
+  optimize_names_t assigned;
+};
+
+static struct lizard_optimize_state *optimize_state_fallback = NULL;
+
+/* A procedure defined in a body that calls may be replaced by. */
+typedef struct optimize_inline {
+  const char *name;
+  lizard_ast_node_t *params; /* AST_NIL or an application of symbols */
+  lizard_ast_node_t *body;   /* its single body expression */
+  optimize_names_t free;     /* names the body uses besides its params */
+  struct optimize_inline *next;
+} optimize_inline_t;
+
+/* Static scope: one link per enclosing lambda, innermost first. */
+typedef struct optimize_scope {
+  optimize_names_t names; /* parameters and body defines */
+  optimize_names_t twice; /* of those, names bound more than once */
+  optimize_inline_t *inlines;
+  const struct optimize_scope *outer;
+} optimize_scope_t;
+
+typedef struct {
+  lizard_env_t *env;
+  lizard_heap_t *heap;
+  optimize_names_t *assigned; /* set! targets, this form and earlier */
+  optimize_names_t defined;   /* define targets anywhere in the form */
+  optimize_names_t macros;    /* define-syntax names anywhere in the form */
+  int depth;                  /* inlined bodies being optimised */
+} optimize_ctx_t;
+
+static lizard_ast_node_t *optimize_expr(lizard_ast_node_t *node,
+                                        optimize_scope_t *scope,
+                                        optimize_ctx_t *ctx);
+
+static int names_has(const optimize_names_t *ns, const char *name) {
+  size_t i;
+  for (i = 0; i < ns->count; i++) {
+    if (ns->names[i] == name) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Add `name`; returns 0 when it was already there. */
+static int names_add(optimize_names_t *ns, const char *name) {
+  if (names_has(ns, name)) {
+    return 0;
+  }
+  if (ns->count == ns->cap) {
+    size_t cap = ns->cap != 0U ? ns->cap * 2U : 8U;
+    const char **grown = lizard_heap_alloc(cap * sizeof(const char *));
+    if (ns->count > 0U) {
+      memcpy((void *)grown, (const void *)ns->names,
+             ns->count * sizeof(const char *));
+    }
+    ns->names = grown;
+    ns->cap = cap;
+  }
+  ns->names[ns->count++] = name;
+  return 1;
+}
+
+static const char *symbol_name(const lizard_ast_node_t *node) {
+  return node != NULL && node->type == AST_SYMBOL
+             ? lizard_intern(node->data.variable)
+             : NULL;
+}
+
+static lizard_ast_node_t *list_ast(lz_list_node_t *it) {
+  return ((lizard_ast_list_node_t *)it)->ast;
+}
+
+static void list_push(lz_list_t *list, lizard_ast_node_t *ast) {
+  lizard_ast_list_node_t *w = lizard_heap_alloc(sizeof(lizard_ast_list_node_t));
+  w->ast = ast;
+  list_append(list, &w->node);
+}
+
+/* Self-evaluating forms whose value the pass may compute with. */
+static int is_literal(const lizard_ast_node_t *node) {
+  if (node == NULL) {
+    return 0;
+  }
+  switch (node->type) {
+  case AST_NUMBER:
+  case AST_RATIONAL:
+  case AST_REAL:
+  case AST_BOOL:
+  case AST_STRING:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/* Forms whose truth value is known without evaluating anything. */
+static int known_test(const lizard_ast_node_t *node) {
+  return is_literal(node) || (node != NULL && node->type == AST_NIL);
+}
+
+static int is_else(const lizard_ast_node_t *node) {
+  return node != NULL && node->type == AST_SYMBOL &&
+         strcmp(node->data.variable, "else") == 0;
+}
+
+/* Record every define, set! and define-syntax target in the form, at any
+ * depth: a define in a nested body is harmless to count, a set! anywhere
+ * may reach a global. */
+static void collect_targets(lizard_ast_node_t *node, optimize_ctx_t *ctx) {
+  lz_list_node_t *it;
+  lz_list_t *list = NULL;
+  const char *name;
+  if (node == NULL) {
+    return;
+  }
+  switch (node->type) {
+  case AST_DEFINITION:
+    if ((name = symbol_name(node->data.definition.variable)) != NULL) {
+      (void)names_add(&ctx->defined, name);
+    }
+    collect_targets(node->data.definition.value, ctx);
+    return;
+  case AST_ASSIGNMENT:
+    if ((name = symbol_name(node->data.assignment.variable)) != NULL) {
+      (void)names_add(ctx->assigned, name);
+    }
+    collect_targets(node->data.assignment.value, ctx);
+    return;
+  case AST_MACRO:
+    if ((name = symbol_name(node->data.macro_def.variable)) != NULL) {
+      (void)names_add(&ctx->macros, name);
+    }
+    return;
+  case AST_IF:
+    collect_targets(node->data.if_clause.pred, ctx);
+    collect_targets(node->data.if_clause.cons, ctx);
+    collect_targets(node->data.if_clause.alt, ctx);
+    return;
+  case AST_BEGIN:
+    list = node->data.begin_expressions;
+    break;
+  case AST_COND:
+    list = node->data.cond_clauses;
+    break;
+  case AST_LAMBDA:
+    list = node->data.lambda.parameters;
+    break;
+  case AST_APPLICATION:
+  case AST_CALLCC:
+    list = node->data.application_arguments;
+    break;
+  default:
+    return;
+  }
+  for (it = list->head; it != list->nil; it = it->next) {
+    collect_targets(list_ast(it), ctx);
+  }
+}
+
+/* Names `node` defines in the frame it runs in (not in nested lambdas). */
+static void scope_defines(lizard_ast_node_t *node, optimize_scope_t *scope) {
+  lz_list_node_t *it;
+  lz_list_t *list = NULL;
+  const char *name = NULL;
+  if (node == NULL) {
+    return;
+  }
+  switch (node->type) {
+  case AST_DEFINITION:
+    name = symbol_name(node->data.definition.variable);
+    scope_defines(node->data.definition.value, scope);
+    break;
+  case AST_MACRO:
+    name = symbol_name(node->data.macro_def.variable);
+    break;
+  case AST_ASSIGNMENT:
+    scope_defines(node->data.assignment.value, scope);
+    return;
+  case AST_IF:
+    scope_defines(node->data.if_clause.pred, scope);
+    scope_defines(node->data.if_clause.cons, scope);
+    scope_defines(node->data.if_clause.alt, scope);
+    return;
+  case AST_BEGIN:
+    list = node->data.begin_expressions;
+    break;
+  case AST_COND:
+    list = node->data.cond_clauses;
+    break;
+  case AST_APPLICATION:
+  case AST_CALLCC:
+    list = node->data.application_arguments;
+    break;
+  default:
+    return;
+  }
+  if (name != NULL && !names_add(&scope->names, name)) {
+    (void)names_add(&scope->twice, name);
+  }
+  if (list != NULL) {
+    for (it = list->head; it != list->nil; it = it->next) {
+      scope_defines(list_ast(it), scope);
+    }
+  }
+}
+
+static int lexically_bound(const optimize_scope_t *scope, const char *name) {
+  for (; scope != NULL; scope = scope->outer) {
+    if (names_has(&scope->names, name)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Is the operator `op` a macro keyword, whose arguments are not forms? */
+static int is_macro_use(const lizard_ast_node_t *op,
+                        const optimize_scope_t *scope, optimize_ctx_t *ctx) {
+  const char *name = symbol_name(op);
+  lizard_ast_node_t *value;
+  if (name == NULL) {
+    return 0;
+  }
+  if (names_has(&ctx->macros, name)) {
+    return 1;
+  }
+  if (lexically_bound(scope, name)) {
+    return 0;
+  }
+  value = lizard_env_lookup(ctx->env, name);
+  return value != NULL &&
+         (value->type == AST_MACRO || value->type == AST_SYNTAX_RULES);
+}
+
+/* Primitives with no effects whose result depends only on their arguments. */
+static int is_pure(lizard_primitive_func_t fn) {
+  static const lizard_primitive_func_t pure[] = {
+      lizard_primitive_plus,         lizard_primitive_minus,
+      lizard_primitive_multiply,     lizard_primitive_divide,
+      lizard_primitive_equal,        lizard_primitive_mod,
+      lizard_primitive_lt,           lizard_primitive_le,
+      lizard_primitive_gt,           lizard_primitive_ge,
+      lizard_primitive_not,          lizard_primitive_min,
+      lizard_primitive_max,          lizard_primitive_gcd,
+      lizard_primitive_lcm,          lizard_primitive_quotient,
+      lizard_primitive_remainder,    lizard_primitive_abs,
+      lizard_primitive_square,       lizard_primitive_arith_shift,
+      lizard_primitive_expt,         lizard_primitive_numberp,
+      lizard_primitive_integerp,     lizard_primitive_boolp,
+      lizard_primitive_stringp,      lizard_primitive_str_length,
+      lizard_primitive_str_eq,       lizard_primitive_exact_to_inexact,
+      lizard_primitive_inexact_to_exact, lizard_primitive_floor,
+      lizard_primitive_ceiling,      lizard_primitive_truncate,
+      lizard_primitive_round};
+  size_t i;
+  for (i = 0; i < sizeof(pure) / sizeof(pure[0]); i++) {
+    if (pure[i] == fn) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Value of application `node` when it calls a pure built-in on literals,
+ * NULL otherwise.  Only calls the form makes as it runs are folded: one in
+ * a lambda body runs after later forms, which may have rebound the name by
+ * then. */
+static lizard_ast_node_t *fold_call(lizard_ast_node_t *node,
+                                    const optimize_scope_t *scope,
+                                    optimize_ctx_t *ctx) {
+  lizard_ast_node_t *argv[LIZARD_PRIMITIVE_ARGV_MAX];
+  lz_list_t *elems = node->data.application_arguments;
+  lz_list_node_t *it;
+  lizard_ast_node_t *prim;
+  lizard_ast_node_t *result;
+  const char *name;
+  int argc = 0;
+  if (scope != NULL) {
+    return NULL;
+  }
+  name = symbol_name(list_ast(elems->head));
+  if (name == NULL || names_has(&ctx->defined, name) ||
+      names_has(ctx->assigned, name)) {
+    return NULL;
+  }
+  for (it = elems->head->next; it != elems->nil; it = it->next) {
+    if (argc == LIZARD_PRIMITIVE_ARGV_MAX || !is_literal(list_ast(it))) {
+      return NULL;
+    }
+    argv[argc++] = list_ast(it);
+  }
+  prim = lizard_env_lookup(ctx->env, name);
+  if (prim == NULL || prim->type != AST_PRIMITIVE ||
+      !is_pure(prim->data.primitive.fn)) {
+    return NULL;
+  }
+  result = lizard_primitive_call(prim, argc, argv, ctx->env, ctx->heap);
+  if (result == NULL) {
+    return NULL;
+  }
+  switch (result->type) {
+  case AST_NUMBER:
+  case AST_RATIONAL:
+  case AST_REAL:
+  case AST_BOOL:
+    return result;
+  default:
+    return NULL; /* errors stay in place; strings may be mutated */
+  }
+}
+
+/* Count the nodes of a body simple enough to inline, or return 0: only
+ * literals, variables, quote, if and calls through a named operator. */
+static size_t inline_size(const lizard_ast_node_t *node) {
+  lz_list_node_t *it;
+  size_t total = 1U;
+  size_t n;
+  if (node == NULL) {
+    return 1U;
+  }
+  switch (node->type) {
+  case AST_NUMBER:
+  case AST_RATIONAL:
+  case AST_REAL:
+  case AST_BOOL:
+  case AST_STRING:
+  case AST_NIL:
+  case AST_SYMBOL:
+  case AST_QUOTE:
+    return 1U;
+  case AST_IF:
+    if ((n = inline_size(node->data.if_clause.pred)) == 0U) {
+      return 0U;
+    }
+    total += n;
+    if ((n = inline_size(node->data.if_clause.cons)) == 0U) {
+      return 0U;
+    }
+    total += n;
+    if ((n = inline_size(node->data.if_clause.alt)) == 0U) {
+      return 0U;
+    }
+    return total + n;
+  case AST_APPLICATION: {
+    const lz_list_t *elems = node->data.application_arguments;
+    const char *op;
+    if (elems->head == elems->nil ||
+        (op = symbol_name(list_ast(elems->head))) == NULL) {
+      return 0U;
+    }
+    /* These see the environment they are called from. */
+    if (strcmp(op, "eval") == 0 || strcmp(op, "defined?") == 0 ||
+        strcmp(op, "env-keys") == 0) {
+      return 0U;
+    }
+    for (it = elems->head; it != elems->nil; it = it->next) {
+      if ((n = inline_size(list_ast(it))) == 0U) {
+        return 0U;
+      }
+      total += n;
+    }
+    return total;
+  }
+  default:
+    return 0U;
+  }
+}
+
+static void free_names(const lizard_ast_node_t *node,
+                       const optimize_names_t *params, optimize_names_t *out) {
+  lz_list_node_t *it;
+  const char *name;
+  if (node == NULL) {
+    return;
+  }
+  switch (node->type) {
+  case AST_SYMBOL:
+    name = lizard_intern(node->data.variable);
+    if (!names_has(params, name)) {
+      (void)names_add(out, name);
+    }
+    return;
+  case AST_IF:
+    free_names(node->data.if_clause.pred, params, out);
+    free_names(node->data.if_clause.cons, params, out);
+    free_names(node->data.if_clause.alt, params, out);
+    return;
+  case AST_APPLICATION:
+    for (it = node->data.application_arguments->head;
+         it != node->data.application_arguments->nil; it = it->next) {
+      free_names(list_ast(it), params, out);
+    }
+    return;
+  default:
+    return;
+  }
+}
+
+/* Make the body define `def` an inline candidate of `scope` when its value
+ * is a small, fixed-arity, non-recursive lambda bound once and never
+ * assigned. */
+static void note_inline(lizard_ast_node_t *def, optimize_scope_t *scope,
+                        optimize_ctx_t *ctx) {
+  lizard_ast_node_t *lambda = def->data.definition.value;
+  const char *name = symbol_name(def->data.definition.variable);
+  lz_list_t *parts;
+  lizard_ast_node_t *spec;
+  lizard_ast_node_t *body;
+  optimize_names_t params;
+  optimize_inline_t *cand;
+  lz_list_node_t *it;
+  size_t size;
+  if (name == NULL || lambda == NULL || lambda->type != AST_LAMBDA ||
+      names_has(&scope->twice, name) || names_has(ctx->assigned, name)) {
+    return;
+  }
+  parts = lambda->data.lambda.parameters;
+  if (parts->head == parts->nil || parts->head->next == parts->nil ||
+      parts->head->next->next != parts->nil) {
+    return;
+  }
+  spec = list_ast(parts->head);
+  body = list_ast(parts->head->next);
+  memset(&params, 0, sizeof(params));
+  if (spec->type == AST_APPLICATION) {
+    for (it = spec->data.application_arguments->head;
+         it != spec->data.application_arguments->nil; it = it->next) {
+      const char *p = symbol_name(list_ast(it));
+      if (p == NULL || strcmp(p, ".") == 0 || !names_add(&params, p)) {
+        return;
+      }
+    }
+  } else if (spec->type != AST_NIL) {
+    return;
+  }
+  size = inline_size(body);
+  if (size == 0U || size > OPTIMIZE_INLINE_NODES) {
+    return;
+  }
+  cand = lizard_heap_alloc(sizeof(optimize_inline_t));
+  cand->name = name;
+  cand->params = spec;
+  cand->body = body;
+  free_names(body, &params, &cand->free);
+  if (names_has(&cand->free, name)) {
+    return; /* recursive */
+  }
+  cand->next = scope->inlines;
+  scope->inlines = cand;
+}
+
+/* Copy of `node` with each parameter symbol replaced by its argument. */
+static lizard_ast_node_t *substitute(lizard_ast_node_t *node,
+                                     const lizard_ast_node_t *spec,
+                                     lz_list_node_t *first_arg,
+                                     lizard_heap_t *heap) {
+  lizard_ast_node_t *c;
+  lz_list_node_t *it;
+  lz_list_node_t *arg;
+  lz_list_t *out;
+  const char *name;
+  if (node == NULL) {
+    return NULL;
+  }
+  switch (node->type) {
+  case AST_SYMBOL:
+    if (spec->type != AST_APPLICATION) {
+      return node;
+    }
+    name = lizard_intern(node->data.variable);
+    arg = first_arg;
+    for (it = spec->data.application_arguments->head;
+         it != spec->data.application_arguments->nil;
+         it = it->next, arg = arg->next) {
+      if (symbol_name(list_ast(it)) == name) {
+        return list_ast(arg);
+      }
+    }
+    return node;
+  case AST_IF:
+    c = lizard_copy_node(heap, node);
+    c->data.if_clause.pred =
+        substitute(node->data.if_clause.pred, spec, first_arg, heap);
+    c->data.if_clause.cons =
+        substitute(node->data.if_clause.cons, spec, first_arg, heap);
+    c->data.if_clause.alt =
+        substitute(node->data.if_clause.alt, spec, first_arg, heap);
+    return c;
+  case AST_APPLICATION:
+    out = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+    for (it = node->data.application_arguments->head;
+         it != node->data.application_arguments->nil; it = it->next) {
+      list_push(out, substitute(list_ast(it), spec, first_arg, heap));
+    }
+    c = lizard_copy_node(heap, node);
+    c->data.application_arguments = out;
+    return c;
+  default:
+    return node;
+  }
+}
+
+/* Inlined body for the call `node`, or NULL. */
+static lizard_ast_node_t *inline_call(lizard_ast_node_t *node,
+                                      optimize_scope_t *scope,
+                                      optimize_ctx_t *ctx) {
+  lz_list_t *elems = node->data.application_arguments;
+  const char *name = symbol_name(list_ast(elems->head));
+  const optimize_scope_t *s;
+  const optimize_scope_t *home = NULL;
+  optimize_inline_t *cand = NULL;
+  lz_list_node_t *it;
+  lz_list_node_t *p;
+  lizard_ast_node_t *result;
+  size_t i;
+  if (name == NULL || ctx->depth >= OPTIMIZE_INLINE_DEPTH) {
+    return NULL;
+  }
+  for (s = scope; s != NULL && home == NULL; s = s->outer) {
+    for (cand = s->inlines; cand != NULL; cand = cand->next) {
+      if (cand->name == name) {
+        home = s;
+        break;
+      }
+    }
+    if (home == NULL && names_has(&s->names, name)) {
+      return NULL; /* shadowed by a binding that is not a candidate */
+    }
+  }
+  if (home == NULL) {
+    return NULL;
+  }
+  /* The body's free names must mean at the call what they mean at the
+   * definition. */
+  for (s = scope; s != home; s = s->outer) {
+    for (i = 0; i < cand->free.count; i++) {
+      if (names_has(&s->names, cand->free.names[i])) {
+        return NULL;
+      }
+    }
+  }
+  /* Arity must match, and each argument must have the same value wherever
+   * the body uses it. */
+  p = cand->params->type == AST_APPLICATION
+          ? cand->params->data.application_arguments->head
+          : NULL;
+  for (it = elems->head->next; it != elems->nil; it = it->next) {
+    lizard_ast_node_t *arg = list_ast(it);
+    const char *arg_name = symbol_name(arg);
+    if (p == NULL || p == cand->params->data.application_arguments->nil) {
+      return NULL;
+    }
+    if (!is_literal(arg) &&
+        (arg_name == NULL || !lexically_bound(scope, arg_name) ||
+         names_has(ctx->assigned, arg_name))) {
+      return NULL;
+    }
+    p = p->next;
+  }
+  if (p != NULL && p != cand->params->data.application_arguments->nil) {
+    return NULL;
+  }
+  result = substitute(cand->body, cand->params, elems->head->next, ctx->heap);
+  ctx->depth++;
+  result = optimize_expr(result, scope, ctx);
+  ctx->depth--;
+  return result;
+}
+
+/* Optimise each element of `list`; `list` itself when nothing changed. */
+static lz_list_t *optimize_list(lz_list_t *list, optimize_scope_t *scope,
+                                optimize_ctx_t *ctx, int keep_else) {
+  lz_list_t *out = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+  lz_list_node_t *it;
+  int changed = 0;
+  for (it = list->head; it != list->nil; it = it->next) {
+    lizard_ast_node_t *e = list_ast(it);
+    lizard_ast_node_t *r = e;
+    if (!(keep_else && it == list->head && is_else(e))) {
+      r = optimize_expr(e, scope, ctx);
+    }
+    if (r != e) {
+      changed = 1;
+    }
+    list_push(out, r);
+  }
+  return changed ? out : list;
+}
+
+static lizard_ast_node_t *optimize_lambda(lizard_ast_node_t *node,
+                                          optimize_scope_t *outer,
+                                          optimize_ctx_t *ctx) {
+  lz_list_t *parts = node->data.lambda.parameters;
+  lz_list_t *out;
+  lz_list_node_t *it;
+  optimize_scope_t scope;
+  lizard_ast_node_t *spec;
+  lizard_ast_node_t *c;
+  int changed = 0;
+  if (parts->head == parts->nil) {
+    return node;
+  }
+  memset(&scope, 0, sizeof(scope));
+  scope.outer = outer;
+  spec = list_ast(parts->head);
+  if (spec->type == AST_SYMBOL) {
+    (void)names_add(&scope.names, lizard_intern(spec->data.variable));
+  } else if (spec->type == AST_APPLICATION) {
+    for (it = spec->data.application_arguments->head;
+         it != spec->data.application_arguments->nil; it = it->next) {
+      const char *p = symbol_name(list_ast(it));
+      if (p != NULL && !names_add(&scope.names, p)) {
+        (void)names_add(&scope.twice, p);
+      }
+    }
+  }
+  for (it = parts->head->next; it != parts->nil; it = it->next) {
+    scope_defines(list_ast(it), &scope);
+  }
+  /* Body forms in order, so a procedure is inlined only after its define. */
+  out = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+  list_push(out, spec);
+  for (it = parts->head->next; it != parts->nil; it = it->next) {
+    lizard_ast_node_t *e = list_ast(it);
+    lizard_ast_node_t *r = optimize_expr(e, &scope, ctx);
+    if (r != e) {
+      changed = 1;
+    }
+    if (r->type == AST_DEFINITION) {
+      note_inline(r, &scope, ctx);
+    }
+    list_push(out, r);
+  }
+  if (!changed) {
+    return node;
+  }
+  c = lizard_copy_node(ctx->heap, node);
+  c->data.lambda.parameters = out;
+  c->data.lambda.layout = NULL;
+  return c;
+}
+
+/* Drop cond clauses whose test is a literal false and everything after the
+ * first clause certain to be taken; a cond left with only that clause
+ * becomes its body. */
+static lizard_ast_node_t *optimize_cond(lizard_ast_node_t *node,
+                                        optimize_scope_t *scope,
+                                        optimize_ctx_t *ctx) {
+  lz_list_t *out = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+  lz_list_node_t *it;
+  lizard_ast_node_t *c;
+  int changed = 0;
+  for (it = node->data.cond_clauses->head; it != node->data.cond_clauses->nil;
+       it = it->next) {
+    lizard_ast_node_t *clause = list_ast(it);
+    lizard_ast_node_t *r = clause;
+    lizard_ast_node_t *test;
+    lz_list_t *l;
+    if (clause->type != AST_APPLICATION ||
+        clause->data.application_arguments->head ==
+            clause->data.application_arguments->nil) {
+      list_push(out, clause);
+      continue;
+    }
+    l = optimize_list(clause->data.application_arguments, scope, ctx, 1);
+    if (l != clause->data.application_arguments) {
+      r = lizard_copy_node(ctx->heap, clause);
+      r->data.application_arguments = l;
+      changed = 1;
+    }
+    test = list_ast(l->head);
+    if (known_test(test) && !lizard_is_true(test)) {
+      changed = 1;
+      continue;
+    }
+    list_push(out, r);
+    if (is_else(test) || known_test(test)) {
+      changed |= it->next != node->data.cond_clauses->nil;
+      break;
+    }
+  }
+  if (out->head == out->nil) {
+    return lizard_make_nil(ctx->heap);
+  }
+  if (out->head->next == out->nil) {
+    lizard_ast_node_t *only = list_ast(out->head);
+    lz_list_t *l = only->type == AST_APPLICATION
+                       ? only->data.application_arguments
+                       : NULL;
+    lizard_ast_node_t *test = l != NULL ? list_ast(l->head) : NULL;
+    if (test != NULL && (is_else(test) || known_test(test))) {
+      lz_list_t *body;
+      if (l->head->next == l->nil) {
+        return test; /* (cond (5)) is 5 */
+      }
+      if (l->head->next->next == l->nil) {
+        return list_ast(l->head->next);
+      }
+      body = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+      for (it = l->head->next; it != l->nil; it = it->next) {
+        list_push(body, list_ast(it));
+      }
+      c = lizard_heap_alloc_tagged(sizeof(lizard_ast_node_t),
+                                   LIZARD_GC_OBJECT_AST_NODE,
+                                   LIZARD_OBJECT_TRACE_AST);
+      c->type = AST_BEGIN;
+      c->span = node->span;
+      c->data.begin_expressions = body;
+      return c;
+    }
+  }
+  if (!changed) {
+    return node;
+  }
+  c = lizard_copy_node(ctx->heap, node);
+  c->data.cond_clauses = out;
+  return c;
+}
+
+static lizard_ast_node_t *optimize_expr(lizard_ast_node_t *node,
+                                        optimize_scope_t *scope,
+                                        optimize_ctx_t *ctx) {
+  if (node == NULL) {
+    return NULL;
+  }
+  switch (node->type) {
+  case AST_DEFINITION: {
+    lizard_ast_node_t *v = optimize_expr(node->data.definition.value, scope, ctx);
+    lizard_ast_node_t *c;
+    if (v == node->data.definition.value) {
+      return node;
+    }
+    c = lizard_copy_node(ctx->heap, node);
+    c->data.definition.value = v;
+    return c;
+  }
+  case AST_ASSIGNMENT: {
+    lizard_ast_node_t *v = optimize_expr(node->data.assignment.value, scope, ctx);
+    lizard_ast_node_t *c;
+    if (v == node->data.assignment.value) {
+      return node;
+    }
+    c = lizard_copy_node(ctx->heap, node);
+    c->data.assignment.value = v;
+    return c;
+  }
+  case AST_IF: {
+    lizard_ast_node_t *p = optimize_expr(node->data.if_clause.pred, scope, ctx);
+    lizard_ast_node_t *t;
+    lizard_ast_node_t *f;
+    lizard_ast_node_t *c;
+    if (known_test(p)) {
+      if (lizard_is_true(p)) {
+        return optimize_expr(node->data.if_clause.cons, scope, ctx);
+      }
+      if (node->data.if_clause.alt != NULL) {
+        return optimize_expr(node->data.if_clause.alt, scope, ctx);
+      }
+    }
+    t = optimize_expr(node->data.if_clause.cons, scope, ctx);
+    f = optimize_expr(node->data.if_clause.alt, scope, ctx);
+    if (p == node->data.if_clause.pred && t == node->data.if_clause.cons &&
+        f == node->data.if_clause.alt) {
+      return node;
+    }
+    c = lizard_copy_node(ctx->heap, node);
+    c->data.if_clause.pred = p;
+    c->data.if_clause.cons = t;
+    c->data.if_clause.alt = f;
+    return c;
+  }
+  case AST_BEGIN: {
+    lz_list_t *l = optimize_list(node->data.begin_expressions, scope, ctx, 0);
+    lizard_ast_node_t *c;
+    if (l == node->data.begin_expressions) {
+      return node;
+    }
+    c = lizard_copy_node(ctx->heap, node);
+    c->data.begin_expressions = l;
+    return c;
+  }
+  case AST_COND:
+    return optimize_cond(node, scope, ctx);
+  case AST_APPLICATION: {
+    lz_list_t *elems = node->data.application_arguments;
+    lz_list_t *l;
+    lizard_ast_node_t *c = node;
+    lizard_ast_node_t *r;
+    if (elems->head == elems->nil ||
+        is_macro_use(list_ast(elems->head), scope, ctx)) {
+      return node;
+    }
+    l = optimize_list(elems, scope, ctx, 0);
+    if (l != elems) {
+      c = lizard_copy_node(ctx->heap, node);
+      c->data.application_arguments = l;
+    }
+    if ((r = fold_call(c, scope, ctx)) != NULL ||
+        (r = inline_call(c, scope, ctx)) != NULL) {
+      return r;
+    }
+    return c;
+  }
+  case AST_CALLCC: {
+    lz_list_t *l = optimize_list(node->data.application_arguments, scope, ctx, 0);
+    lizard_ast_node_t *c;
+    if (l == node->data.application_arguments) {
+      return node;
+    }
+    c = lizard_copy_node(ctx->heap, node);
+    c->data.application_arguments = l;
+    return c;
+  }
+  case AST_LAMBDA:
+    return optimize_lambda(node, scope, ctx);
+  default:
+    /* Literals, variables, quoted data, quasiquote templates, macro
+     * definitions and foreign forms. */
+    return node;
+  }
+}
+
+lizard_ast_node_t *lizard_optimize(lizard_ast_node_t *node, lizard_env_t *env,
+                                   lizard_heap_t *heap) {
+  struct lizard_optimize_state **slot =
+      heap->runtime != NULL ? &heap->runtime->optimize_state
+                            : &optimize_state_fallback;
+  optimize_ctx_t ctx;
+  if (node == NULL) {
+    return NULL;
+  }
+  if (*slot == NULL) {
+    *slot = lizard_heap_alloc(sizeof(struct lizard_optimize_state));
+  }
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.env = env;
+  ctx.heap = heap;
+  ctx.assigned = &(*slot)->assigned;
+  collect_targets(node, &ctx);
+  return optimize_expr(node, NULL, &ctx);
+}
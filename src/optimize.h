@@ -0,0 +1,36 @@
+/* src/optimize.h — constant folding, branch pruning and inlining.
+ *
+ * lizard_optimize runs on each top-level form after macro expansion, before
+ * the form reaches the walker or the bytecode compiler.  It rewrites:
+ *
+ *   - applications of a pure built-in (arithmetic, comparisons, `not`,
+ *     numeric and string predicates) to literal arguments, made while the
+ *     form itself runs, into the value the primitive returns for them,
+ *     unless that value is an error;
+ *   - `if` and `cond` whose tests are literals into the branch taken;
+ *   - calls to a small non-recursive procedure defined inside a body, with
+ *     literal or never-assigned local arguments, into its body with the
+ *     arguments substituted.
+ *
+ * The source tree is not modified: changed nodes are copied and unchanged
+ * subtrees shared, as in lexical.c.  Quoted data, quasiquote templates and
+ * the arguments of macro uses are left alone.
+ *
+ * A name is taken to be its built-in only when it is not lexically bound at
+ * the use, is bound to that primitive in the environment now, is not the
+ * target of a define in the form and has not been the target of any set!
+ * the pass has seen.  Calls in lambda bodies are not folded, since they run
+ * after forms the pass has not seen, which may rebind the name; literal
+ * tests in them still pick their branch.
+ */
+#ifndef LIZARD_OPTIMIZE_H
+#define LIZARD_OPTIMIZE_H
+
+#include "lizard_internal.h"
+
+/* Optimised equivalent of top-level form `node` in `env`; `node` itself
+ * when nothing applies. */
+lizard_ast_node_t *lizard_optimize(lizard_ast_node_t *node, lizard_env_t *env,
+                                   lizard_heap_t *heap);
+
+#endif /* LIZARD_OPTIMIZE_H */
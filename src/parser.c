@@ -4,6 +4,7 @@
 #include "lizard_internal.h"
 #include "mem.h"
 #include "primitives.h"
+#include "symbol.h"
 #include "tokenizer.h"
 
 #include <setjmp.h>
@@ -104,7 +105,9 @@ lizard_ast_node_t *lizard_parse_expression(lz_list_t *token_list,
   if (current_node == token_list->nil) {
     return NULL;
   }
-  ast_node = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  ast_node = current_token->type == TOKEN_NUMBER && !current_token->is_real
+                 ? lizard_make_number_node(heap)
+                 : lizard_heap_alloc(sizeof(lizard_ast_node_t));
   lizard_set_node_span_from_token(ast_node, current_token);
   switch (current_token->type) {
   case TOKEN_LEFT_PAREN: {
@@ -184,6 +187,7 @@ lizard_ast_node_t *lizard_parse_expression(lz_list_t *token_list,
 
           lambda_node = lizard_heap_alloc(sizeof(lizard_ast_node_t));
           lambda_node->type = AST_LAMBDA;
+          lambda_node->span = ast_node->span;
           lambda_node->data.lambda.closure_env = NULL;
           lambda_node->data.lambda.parameters =
               list_create_alloc(lizard_heap_alloc, lizard_heap_free);
@@ -408,6 +412,7 @@ lizard_ast_node_t *lizard_parse_expression(lz_list_t *token_list,
 
         lambda_node = lizard_heap_alloc(sizeof(lizard_ast_node_t));
         lambda_node->type = AST_LAMBDA;
+        lambda_node->span = ast_node->span;
         lambda_node->data.lambda.parameters =
             list_create_alloc(lizard_heap_alloc, lizard_heap_free);
         lambda_node->data.lambda.closure_env = NULL;
@@ -773,7 +778,7 @@ lizard_ast_node_t *lizard_parse_expression(lz_list_t *token_list,
       return lizard_get_canonical_nil(heap);
     } else {
       ast_node->type = AST_SYMBOL;
-      ast_node->data.variable = current_token->data.symbol;
+      ast_node->data.variable = lizard_intern(current_token->data.symbol);
       *current_node_pointer = current_node->next;
       current_node = current_node->next;
     }
@@ -790,6 +795,7 @@ lizard_ast_node_t *lizard_parse_expression(lz_list_t *token_list,
       ast_node->type = AST_NUMBER;
       mpz_init(ast_node->data.number);
       mpz_set(ast_node->data.number, current_token->data.number);
+      lizard_number_normalize(ast_node);
     }
     *current_node_pointer = current_node->next;
     current_node = current_node->next;
@@ -854,7 +860,9 @@ lizard_ast_node_t *lizard_parse_datum(lz_list_t *token_list,
     lizard_parser_fail("missing closing paren in datum.", tok);
   }
   /* atom */
-  node = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  node = tok->type == TOKEN_NUMBER && !tok->is_real
+             ? lizard_make_number_node(heap)
+             : lizard_heap_alloc(sizeof(lizard_ast_node_t));
   node->span.start_line = tok->line;
   node->span.start_column = tok->column;
   switch (tok->type) {
@@ -870,6 +878,7 @@ lizard_ast_node_t *lizard_parse_datum(lz_list_t *token_list,
       node->type = AST_NUMBER;
       mpz_init(node->data.number);
       mpz_set(node->data.number, tok->data.number);
+      lizard_number_normalize(node);
     }
     *cur = (*cur)->next;
     return node;
@@ -894,10 +903,10 @@ lizard_ast_node_t *lizard_parse_datum(lz_list_t *token_list,
       body = lizard_parse_datum(token_list, cur, heap);
       tag = lizard_heap_alloc(sizeof(lizard_ast_node_t));
       tag->type = AST_SYMBOL;
-      if (strcmp(prefix, "'")  == 0) tag->data.variable = "quote";
-      if (strcmp(prefix, "`")  == 0) tag->data.variable = "quasiquote";
-      if (strcmp(prefix, ",")  == 0) tag->data.variable = "unquote";
-      if (strcmp(prefix, ",@") == 0) tag->data.variable = "unquote-splicing";
+      if (strcmp(prefix, "'")  == 0) tag->data.variable = lizard_intern("quote");
+      if (strcmp(prefix, "`")  == 0) tag->data.variable = lizard_intern("quasiquote");
+      if (strcmp(prefix, ",")  == 0) tag->data.variable = lizard_intern("unquote");
+      if (strcmp(prefix, ",@") == 0) tag->data.variable = lizard_intern("unquote-splicing");
       p2 = lizard_heap_alloc(sizeof(lizard_ast_node_t));
       p2->type = AST_PAIR;
       p2->data.pair.car = body;
@@ -926,7 +935,7 @@ lizard_ast_node_t *lizard_parse_datum(lz_list_t *token_list,
       return node;
     }
     node->type = AST_SYMBOL;
-    node->data.variable = tok->data.symbol;
+    node->data.variable = lizard_intern(tok->data.symbol);
     *cur = (*cur)->next;
     return node;
   default:
@@ -934,11 +943,15 @@ lizard_ast_node_t *lizard_parse_datum(lz_list_t *token_list,
   }
 }
 
-lz_list_t *lizard_parse(lz_list_t *token_list, lizard_heap_t *heap) {
+/* Parse every form of `token_list`; with `starts`, also record the source
+ * offset of each form's first token, and -1 after the last. */
+static lz_list_t *parse_forms(lz_list_t *token_list, lizard_heap_t *heap,
+                              int **starts) {
   lz_list_t *ast_list;
   lz_list_node_t *current;
   int depth;
   volatile int prev_active;
+  size_t count = 0;
 
   /* Establish a recovery point: any lizard_parser_fail() below longjmps
    * here instead of killing the process. */
@@ -952,14 +965,26 @@ lz_list_t *lizard_parse(lz_list_t *token_list, lizard_heap_t *heap) {
   lz_parse_active = 1;
 
   ast_list = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+  if (starts != NULL) {
+    for (current = token_list->head; current != token_list->nil;
+         current = current->next) {
+      count++;
+    }
+    *starts = (int *)lizard_heap_alloc((count + 1) * sizeof(int));
+    count = 0;
+  }
   current = token_list->head;
   depth = 0;
   while (current != token_list->nil) {
-    lizard_ast_node_t *ast =
-        lizard_parse_expression(token_list, &current, &depth, heap);
-    lizard_ast_list_node_t *ast_node =
-        (lizard_ast_list_node_t *)lizard_heap_alloc(
-            sizeof(lizard_ast_list_node_t));
+    lizard_ast_node_t *ast;
+    lizard_ast_list_node_t *ast_node;
+    if (starts != NULL) {
+      (*starts)[count++] =
+          CAST(current, lizard_token_list_node_t)->token.offset;
+    }
+    ast = lizard_parse_expression(token_list, &current, &depth, heap);
+    ast_node = (lizard_ast_list_node_t *)lizard_heap_alloc(
+        sizeof(lizard_ast_list_node_t));
     ast_node->ast = ast;
 
     if (ast != NULL) {
@@ -968,7 +993,19 @@ lz_list_t *lizard_parse(lz_list_t *token_list, lizard_heap_t *heap) {
       lizard_parser_fail("Failed to parse expression.", NULL);
     }
   }
+  if (starts != NULL) {
+    (*starts)[count] = -1;
+  }
 
   lz_parse_active = prev_active;
   return ast_list;
 }
+
+lz_list_t *lizard_parse(lz_list_t *token_list, lizard_heap_t *heap) {
+  return parse_forms(token_list, heap, NULL);
+}
+
+lz_list_t *lizard_parse_located(lz_list_t *token_list, lizard_heap_t *heap,
+                                int **starts) {
+  return parse_forms(token_list, heap, starts);
+}
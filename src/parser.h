@@ -9,6 +9,10 @@ lizard_ast_node_t *lizard_parse_expression(lz_list_t *token_list,
                                            lz_list_node_t **current_node_pointer,
                                            int *depth, lizard_heap_t *);
 lz_list_t *lizard_parse(lz_list_t *token_list, lizard_heap_t *);
+/* lizard_parse, also setting *starts to the source offset where each form
+ * begins, followed by -1 (for splitting a file into its forms' text). */
+lz_list_t *lizard_parse_located(lz_list_t *token_list, lizard_heap_t *heap,
+                                int **starts);
 
 lizard_ast_node_t *lizard_parse_datum(lz_list_t *token_list,
                                       lz_list_node_t **cur,
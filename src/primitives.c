@@ -3,6 +3,7 @@
 #include <float.h>
 #include "pvector.h"
 #include "inet.h"
+#include "bytecode.h"
 #include "prims_shared.h"
 #include "env.h"
 #include "errors.h"
@@ -11,14 +12,14 @@
 #include "parser.h"
 #include "printer.h"
 #include "runtime.h"
+#include "symbol.h"
 #include "tokenizer.h"
+#include <limits.h>
 #include <setjmp.h>
 #include <stdint.h>
-/* Phase 0: callcc state accessed via heap->runtime. Fallback
- * globals defined in lizard.c for standalone-heap compat. */
-extern jmp_buf callcc_buf_fallback;
-extern int callcc_active_fallback;
-extern lizard_ast_node_t *callcc_value_fallback;
+/* Escape frames of heaps without a runtime. */
+static lizard_escape_frame_t *escape_top_fallback = NULL;
+static unsigned long escape_counter_fallback = 0;
 
 
 #pragma GCC diagnostic push
@@ -31,7 +32,7 @@ static const char *lizard_heap_strdup(lizard_heap_t *heap, const char *src) {
     return NULL;
   }
   len = strlen(src) + 1U;
-  dst = lizard_heap_alloc(len);
+  dst = lizard_heap_alloc_atomic(len);
   memcpy(dst, src, len);
   return dst;
 }
@@ -39,7 +40,7 @@ static const char *lizard_heap_strdup(lizard_heap_t *heap, const char *src) {
 static lizard_ast_node_t *lizard_make_number_copy(lizard_heap_t *heap,
                                                    lizard_ast_node_t *source) {
   lizard_ast_node_t *copy;
-  copy = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  copy = lizard_make_number_node(heap);
   copy->type = AST_NUMBER;
   mpz_init(copy->data.number);
   mpz_set(copy->data.number, source->data.number);
@@ -56,11 +57,12 @@ static int lizard_num_like(const lizard_ast_node_t *n) {
 /* Build a canonical numeric node from an mpq, demoting to an integer when the
  * (canonicalized) denominator is 1.  Caller still owns/clears its own q. */
 static lizard_ast_node_t *lizard_make_rational(lizard_heap_t *heap, mpq_t q) {
-  lizard_ast_node_t *r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  lizard_ast_node_t *r = lizard_make_number_node(heap);
   mpq_canonicalize(q);
   if (mpz_cmp_ui(mpq_denref(q), 1U) == 0) {
     r->type = AST_NUMBER;
     mpz_init_set(r->data.number, mpq_numref(q));
+    lizard_number_normalize(r);
   } else {
     r->type = AST_RATIONAL;
     mpq_init(r->data.rational);
@@ -90,11 +92,11 @@ static double lizard_num_to_double(const lizard_ast_node_t *n) {
   return mpz_get_d(n->data.number);
 }
 
-/* True if any argument in [head, nil) is inexact (forces an inexact result). */
-static int lizard_args_any_real(lz_list_node_t *head, lz_list_node_t *nil) {
-  lz_list_node_t *s;
-  for (s = head; s != nil; s = s->next) {
-    if (((lizard_ast_list_node_t *)s)->ast->type == AST_REAL) {
+/* True if any of the argc arguments is inexact (forces an inexact result). */
+static int lizard_args_any_real(int argc, lizard_ast_node_t **argv) {
+  int i;
+  for (i = 0; i < argc; i++) {
+    if (argv[i]->type == AST_REAL) {
       return 1;
     }
   }
@@ -105,6 +107,11 @@ static int lizard_args_any_real(lz_list_node_t *head, lz_list_node_t *nil) {
 static int lizard_num_cmp(const lizard_ast_node_t *a, const lizard_ast_node_t *b) {
   int c;
   mpq_t qa, qb;
+  if (LIZARD_IS_FIXNUM(a) && LIZARD_IS_FIXNUM(b)) {
+    return LIZARD_FIXNUM_VALUE(a) < LIZARD_FIXNUM_VALUE(b)
+               ? -1
+               : LIZARD_FIXNUM_VALUE(a) > LIZARD_FIXNUM_VALUE(b);
+  }
   if (a->type == AST_NUMBER && b->type == AST_NUMBER) {
     return mpz_cmp(a->data.number, b->data.number);
   }
@@ -123,40 +130,47 @@ static int lizard_num_cmp(const lizard_ast_node_t *a, const lizard_ast_node_t *b
   return c;
 }
 
-lizard_ast_node_t *lizard_primitive_plus(lz_list_t *args, lizard_env_t *env,
-                                         lizard_heap_t *heap) {
-  lz_list_node_t *node;
-  lizard_ast_list_node_t *arg_node;
-  lizard_ast_node_t *arg, *result;
-  node = args->head;
-  if (node == args->nil) {
+lizard_ast_node_t *lizard_primitive_plus_argv(int argc, lizard_ast_node_t **argv,
+                                              lizard_env_t *env,
+                                              lizard_heap_t *heap) {
+  lizard_ast_node_t *result;
+  int i;
+  if (argc == 0) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGC);
   }
-  if (lizard_args_any_real(node, args->nil)) { /* inexact contagion */
-    lz_list_node_t *s;
+  { /* all fixnums and no overflow: no GMP, no allocation for small sums */
+    long acc = 0;
+    for (i = 0; i < argc; i++) {
+      if (!LIZARD_IS_FIXNUM(argv[i]) ||
+          !lizard_fixnum_add(acc, LIZARD_FIXNUM_VALUE(argv[i]), &acc)) {
+        break;
+      }
+    }
+    if (i == argc) {
+      return lizard_make_fixnum(heap, acc);
+    }
+  }
+  if (lizard_args_any_real(argc, argv)) { /* inexact contagion */
     double acc = 0.0;
-    for (s = node; s != args->nil; s = s->next) {
-      lizard_ast_node_t *a = ((lizard_ast_list_node_t *)s)->ast;
-      if (!lizard_num_like(a))
+    for (i = 0; i < argc; i++) {
+      if (!lizard_num_like(argv[i]))
         return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
-      acc += lizard_num_to_double(a);
+      acc += lizard_num_to_double(argv[i]);
     }
     return lizard_make_real(heap, acc);
   }
   { /* exact-rational path when any operand is a rational */
-    lz_list_node_t *s;
     int any_rat = 0;
-    for (s = node; s != args->nil; s = s->next) {
-      lizard_ast_node_t *a = ((lizard_ast_list_node_t *)s)->ast;
-      if (!lizard_num_like(a))
+    for (i = 0; i < argc; i++) {
+      if (!lizard_num_like(argv[i]))
         return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
-      if (a->type == AST_RATIONAL) any_rat = 1;
+      if (argv[i]->type == AST_RATIONAL) any_rat = 1;
     }
     if (any_rat) {
       mpq_t acc, t;
       mpq_init(acc);
-      for (s = node; s != args->nil; s = s->next) {
-        lizard_num_to_mpq(((lizard_ast_list_node_t *)s)->ast, t);
+      for (i = 0; i < argc; i++) {
+        lizard_num_to_mpq(argv[i], t);
         mpq_add(acc, acc, t);
         mpq_clear(t);
       }
@@ -165,74 +179,82 @@ lizard_ast_node_t *lizard_primitive_plus(lz_list_t *args, lizard_env_t *env,
       return result;
     }
   }
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  result = lizard_make_number_node(heap);
   result->type = AST_NUMBER;
   mpz_init(result->data.number);
-  while (node != args->nil) {
-    arg_node = (lizard_ast_list_node_t *)node;
-    arg = arg_node->ast;
-    if (arg->type != AST_NUMBER) {
+  for (i = 0; i < argc; i++) {
+    if (argv[i]->type != AST_NUMBER) {
       return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
     }
-    mpz_add(result->data.number, result->data.number, arg->data.number);
-    node = node->next;
+    mpz_add(result->data.number, result->data.number, argv[i]->data.number);
   }
-
+  lizard_number_normalize(result);
   return result;
 }
 
-lizard_ast_node_t *lizard_primitive_minus(lz_list_t *args, lizard_env_t *env,
-                                          lizard_heap_t *heap) {
-  lz_list_node_t *node;
-  lizard_ast_list_node_t *first_arg_node, *arg_node;
+lizard_ast_node_t *lizard_primitive_minus_argv(int argc, lizard_ast_node_t **argv,
+                                               lizard_env_t *env,
+                                               lizard_heap_t *heap) {
   lizard_ast_node_t *acc, *arg;
+  int i;
 
-  node = args->head;
-  if (node == args->nil) {
+  if (argc == 0) {
     return lizard_make_error(heap, LIZARD_ERROR_MINUS_ARGC);
   }
-  if (lizard_args_any_real(node, args->nil)) { /* inexact contagion */
-    lz_list_node_t *s = node;
-    double acc;
-    lizard_ast_node_t *a0 = ((lizard_ast_list_node_t *)s)->ast;
-    if (!lizard_num_like(a0))
+  if (LIZARD_IS_FIXNUM(argv[0])) { /* all fixnums and no overflow */
+    long accl = 0;
+    if (argc == 1) {
+      if (lizard_fixnum_sub(0, LIZARD_FIXNUM_VALUE(argv[0]), &accl)) {
+        return lizard_make_fixnum(heap, accl);
+      }
+    } else {
+      accl = LIZARD_FIXNUM_VALUE(argv[0]);
+      for (i = 1; i < argc; i++) {
+        if (!LIZARD_IS_FIXNUM(argv[i]) ||
+            !lizard_fixnum_sub(accl, LIZARD_FIXNUM_VALUE(argv[i]), &accl)) {
+          break;
+        }
+      }
+      if (i == argc) {
+        return lizard_make_fixnum(heap, accl);
+      }
+    }
+  }
+  if (lizard_args_any_real(argc, argv)) { /* inexact contagion */
+    double accd;
+    if (!lizard_num_like(argv[0]))
       return lizard_make_error(heap, LIZARD_ERROR_MINUS_ARGT);
-    acc = lizard_num_to_double(a0);
-    s = s->next;
-    if (s == args->nil) {
-      return lizard_make_real(heap, -acc);
+    accd = lizard_num_to_double(argv[0]);
+    if (argc == 1) {
+      return lizard_make_real(heap, -accd);
     }
-    for (; s != args->nil; s = s->next) {
-      lizard_ast_node_t *a = ((lizard_ast_list_node_t *)s)->ast;
-      if (!lizard_num_like(a))
+    for (i = 1; i < argc; i++) {
+      if (!lizard_num_like(argv[i]))
         return lizard_make_error(heap, LIZARD_ERROR_MINUS_ARGT_2);
-      acc -= lizard_num_to_double(a);
+      accd -= lizard_num_to_double(argv[i]);
     }
-    return lizard_make_real(heap, acc);
+    return lizard_make_real(heap, accd);
   }
   { /* exact-rational path when any operand is a rational */
-    lz_list_node_t *s;
-    int any_rat = 0, idx = 0;
-    for (s = node; s != args->nil; s = s->next, idx++) {
-      lizard_ast_node_t *a = ((lizard_ast_list_node_t *)s)->ast;
-      if (!lizard_num_like(a))
-        return lizard_make_error(heap, idx == 0 ? LIZARD_ERROR_MINUS_ARGT
-                                                : LIZARD_ERROR_MINUS_ARGT_2);
-      if (a->type == AST_RATIONAL) any_rat = 1;
+    int any_rat = 0;
+    for (i = 0; i < argc; i++) {
+      if (!lizard_num_like(argv[i]))
+        return lizard_make_error(heap, i == 0 ? LIZARD_ERROR_MINUS_ARGT
+                                              : LIZARD_ERROR_MINUS_ARGT_2);
+      if (argv[i]->type == AST_RATIONAL) any_rat = 1;
     }
     if (any_rat) {
       mpq_t accq, t;
       lizard_ast_node_t *r;
-      lizard_num_to_mpq(((lizard_ast_list_node_t *)node)->ast, accq);
-      s = node->next;
-      if (s == args->nil) {
+      lizard_num_to_mpq(argv[0], accq);
+      if (argc == 1) {
         mpq_neg(accq, accq);
         r = lizard_make_rational(heap, accq);
         mpq_clear(accq);
         return r;
       }
-      for (; s != args->nil; s = s->next) {
-        lizard_num_to_mpq(((lizard_ast_list_node_t *)s)->ast, t);
+      for (i = 1; i < argc; i++) {
+        lizard_num_to_mpq(argv[i], t);
         mpq_sub(accq, accq, t);
         mpq_clear(t);
       }
@@ -241,80 +263,83 @@ lizard_ast_node_t *lizard_primitive_minus(lz_list_t *args, lizard_env_t *env,
       return r;
     }
   }
-  first_arg_node = (lizard_ast_list_node_t *)node;
-  arg = first_arg_node->ast;
+  arg = argv[0];
   if (arg->type != AST_NUMBER) {
     return lizard_make_error(heap, LIZARD_ERROR_MINUS_ARGT);
   }
   /* Fast path: exactly two number arguments — subtract directly
    * into a fresh result without copying the first operand. */
-  if (node->next != args->nil && node->next->next == args->nil) {
-    lizard_ast_node_t *b = ((lizard_ast_list_node_t *)node->next)->ast;
-    if (b->type == AST_NUMBER) {
-      lizard_ast_node_t *result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-      result->type = AST_NUMBER;
-      mpz_init(result->data.number);
-      mpz_sub(result->data.number, arg->data.number, b->data.number);
-      return result;
-    }
+  if (argc == 2 && argv[1]->type == AST_NUMBER) {
+    lizard_ast_node_t *result = lizard_make_number_node(heap);
+    result->type = AST_NUMBER;
+    mpz_init(result->data.number);
+    mpz_sub(result->data.number, arg->data.number, argv[1]->data.number);
+    lizard_number_normalize(result);
+    return result;
   }
   acc = lizard_make_number_copy(heap, arg);
-  node = node->next;
-  if (node == args->nil) {
+  if (argc == 1) {
     mpz_neg(acc->data.number, acc->data.number);
+    lizard_number_normalize(acc);
     return acc;
   }
-  while (node != args->nil) {
-    arg_node = (lizard_ast_list_node_t *)node;
-    arg = arg_node->ast;
+  for (i = 1; i < argc; i++) {
+    arg = argv[i];
     if (arg->type != AST_NUMBER) {
       return lizard_make_error(heap, LIZARD_ERROR_MINUS_ARGT_2);
     }
     mpz_sub(acc->data.number, acc->data.number, arg->data.number);
-    node = node->next;
   }
+  lizard_number_normalize(acc);
   return acc;
 }
 
-lizard_ast_node_t *lizard_primitive_multiply(lz_list_t *args, lizard_env_t *env,
-                                             lizard_heap_t *heap) {
-  lz_list_node_t *node;
-  lizard_ast_list_node_t *first_arg_node;
+lizard_ast_node_t *lizard_primitive_multiply_argv(int argc,
+                                                  lizard_ast_node_t **argv,
+                                                  lizard_env_t *env,
+                                                  lizard_heap_t *heap) {
   lizard_ast_node_t *acc;
-  lizard_ast_list_node_t *arg_node;
   lizard_ast_node_t *arg;
+  int i;
 
-  node = args->head;
-  if (node == args->nil) {
+  if (argc == 0) {
     return lizard_make_error(heap, LIZARD_ERROR_MUL_ARGC);
   }
-  if (lizard_args_any_real(node, args->nil)) { /* inexact contagion */
-    lz_list_node_t *s;
-    double acc = 1.0;
-    for (s = node; s != args->nil; s = s->next) {
-      lizard_ast_node_t *a = ((lizard_ast_list_node_t *)s)->ast;
-      if (!lizard_num_like(a))
+  { /* all fixnums and no overflow */
+    long accl = 1;
+    for (i = 0; i < argc; i++) {
+      if (!LIZARD_IS_FIXNUM(argv[i]) ||
+          !lizard_fixnum_mul(accl, LIZARD_FIXNUM_VALUE(argv[i]), &accl)) {
+        break;
+      }
+    }
+    if (i == argc) {
+      return lizard_make_fixnum(heap, accl);
+    }
+  }
+  if (lizard_args_any_real(argc, argv)) { /* inexact contagion */
+    double accd = 1.0;
+    for (i = 0; i < argc; i++) {
+      if (!lizard_num_like(argv[i]))
         return lizard_make_error(heap, LIZARD_ERROR_MUL_ARGT);
-      acc *= lizard_num_to_double(a);
+      accd *= lizard_num_to_double(argv[i]);
     }
-    return lizard_make_real(heap, acc);
+    return lizard_make_real(heap, accd);
   }
   { /* exact-rational path when any operand is a rational */
-    lz_list_node_t *s;
     int any_rat = 0;
-    for (s = node; s != args->nil; s = s->next) {
-      lizard_ast_node_t *a = ((lizard_ast_list_node_t *)s)->ast;
-      if (!lizard_num_like(a))
+    for (i = 0; i < argc; i++) {
+      if (!lizard_num_like(argv[i]))
         return lizard_make_error(heap, LIZARD_ERROR_MUL_ARGT);
-      if (a->type == AST_RATIONAL) any_rat = 1;
+      if (argv[i]->type == AST_RATIONAL) any_rat = 1;
     }
     if (any_rat) {
       mpq_t accq, t;
       lizard_ast_node_t *r;
       mpq_init(accq);
       mpq_set_ui(accq, 1U, 1U);
-      for (s = node; s != args->nil; s = s->next) {
-        lizard_num_to_mpq(((lizard_ast_list_node_t *)s)->ast, t);
+      for (i = 0; i < argc; i++) {
+        lizard_num_to_mpq(argv[i], t);
         mpq_mul(accq, accq, t);
         mpq_clear(t);
       }
@@ -323,65 +348,57 @@ lizard_ast_node_t *lizard_primitive_multiply(lz_list_t *args, lizard_env_t *env,
       return r;
     }
   }
-  first_arg_node = (lizard_ast_list_node_t *)node;
-  acc = first_arg_node->ast;
+  acc = argv[0];
   if (acc->type != AST_NUMBER) {
     return lizard_make_error(heap, LIZARD_ERROR_MUL_ARGT);
   }
   /* Fast path: exactly two number arguments. Avoid copying the
    * (potentially huge) accumulator — multiply directly into a fresh
    * result. This is the dominant case for bignum power loops. */
-  if (node->next != args->nil && node->next->next == args->nil) {
-    lizard_ast_node_t *b = ((lizard_ast_list_node_t *)node->next)->ast;
-    if (b->type == AST_NUMBER) {
-      lizard_ast_node_t *result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-      result->type = AST_NUMBER;
-      mpz_init(result->data.number);
-      mpz_mul(result->data.number, acc->data.number, b->data.number);
-      return result;
-    }
+  if (argc == 2 && argv[1]->type == AST_NUMBER) {
+    lizard_ast_node_t *result = lizard_make_number_node(heap);
+    result->type = AST_NUMBER;
+    mpz_init(result->data.number);
+    mpz_mul(result->data.number, acc->data.number, argv[1]->data.number);
+    lizard_number_normalize(result);
+    return result;
   }
   acc = lizard_make_number_copy(heap, acc);
-  node = node->next;
-  while (node != args->nil) {
-    arg_node = (lizard_ast_list_node_t *)node;
-    arg = arg_node->ast;
+  for (i = 1; i < argc; i++) {
+    arg = argv[i];
     if (arg->type != AST_NUMBER) {
       return lizard_make_error(heap, LIZARD_ERROR_MUL_ARGT_2);
     }
     mpz_mul(acc->data.number, acc->data.number, arg->data.number);
-    node = node->next;
   }
+  lizard_number_normalize(acc);
   return acc;
 }
 
-lizard_ast_node_t *lizard_primitive_divide(lz_list_t *args, lizard_env_t *env,
-                                           lizard_heap_t *heap) {
-  lz_list_node_t *node;
+lizard_ast_node_t *lizard_primitive_divide_argv(int argc,
+                                                lizard_ast_node_t **argv,
+                                                lizard_env_t *env,
+                                                lizard_heap_t *heap) {
   lizard_ast_node_t *arg, *result;
   mpq_t accq, t;
-  int idx = 0;
+  int i;
   (void)env;
-  node = args->head;
-  if (node == args->nil || node->next == args->nil) {
+  if (argc < 2) {
     return lizard_make_error(heap, LIZARD_ERROR_DIV_ARGC);
   }
-  if (lizard_args_any_real(node, args->nil)) { /* inexact contagion (IEEE) */
-    lz_list_node_t *s = node;
+  if (lizard_args_any_real(argc, argv)) { /* inexact contagion (IEEE) */
     double acc;
-    lizard_ast_node_t *a0 = ((lizard_ast_list_node_t *)s)->ast;
-    if (!lizard_num_like(a0))
+    if (!lizard_num_like(argv[0]))
       return lizard_make_error(heap, LIZARD_ERROR_DIV_ARGT);
-    acc = lizard_num_to_double(a0);
-    for (s = s->next; s != args->nil; s = s->next) {
-      lizard_ast_node_t *a = ((lizard_ast_list_node_t *)s)->ast;
-      if (!lizard_num_like(a))
+    acc = lizard_num_to_double(argv[0]);
+    for (i = 1; i < argc; i++) {
+      if (!lizard_num_like(argv[i]))
         return lizard_make_error(heap, LIZARD_ERROR_DIV_ARGT_2);
-      acc /= lizard_num_to_double(a);
+      acc /= lizard_num_to_double(argv[i]);
     }
     return lizard_make_real(heap, acc);
   }
-  arg = ((lizard_ast_list_node_t *)node)->ast;
+  arg = argv[0];
   if (!lizard_num_like(arg)) {
     return lizard_make_error(heap, LIZARD_ERROR_DIV_ARGT);
   }
@@ -389,8 +406,8 @@ lizard_ast_node_t *lizard_primitive_divide(lz_list_t *args, lizard_env_t *env,
    * Integer operands divide exactly into a reduced fraction (7/2), not a
    * truncated quotient. */
   lizard_num_to_mpq(arg, accq);
-  for (node = node->next; node != args->nil; node = node->next, idx++) {
-    arg = ((lizard_ast_list_node_t *)node)->ast;
+  for (i = 1; i < argc; i++) {
+    arg = argv[i];
     if (!lizard_num_like(arg)) {
       mpq_clear(accq);
       return lizard_make_error(heap, LIZARD_ERROR_DIV_ARGT_2);
@@ -409,6 +426,11 @@ lizard_ast_node_t *lizard_primitive_divide(lz_list_t *args, lizard_env_t *env,
   return result;
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_plus)
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_minus)
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_multiply)
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_divide)
+
 int lizard_is_empty_list(lizard_ast_node_t *node) {
   if (!node)
     return 1;
@@ -441,6 +463,9 @@ int lizard_ast_equal(lizard_ast_node_t *a, lizard_ast_node_t *b) {
 
   switch (a->type) {
   case AST_NUMBER:
+    if (LIZARD_IS_FIXNUM(a) && LIZARD_IS_FIXNUM(b)) {
+      return LIZARD_FIXNUM_VALUE(a) == LIZARD_FIXNUM_VALUE(b);
+    }
     return (mpz_cmp(a->data.number, b->data.number) == 0);
   case AST_RATIONAL:
     return (mpq_cmp(a->data.rational, b->data.rational) == 0);
@@ -516,13 +541,15 @@ int lizard_ast_equal(lizard_ast_node_t *a, lizard_ast_node_t *b) {
     return (na == args_a->nil && nb == args_b->nil);
   }
   case AST_PRIMITIVE:
-    return (a->data.primitive == b->data.primitive);
+    return (a->data.primitive.fn == b->data.primitive.fn);
   case AST_MACRO:
     return lizard_ast_equal(a->data.macro_def.variable,
                             b->data.macro_def.variable) &&
            lizard_ast_equal(a->data.macro_def.transformer,
                             b->data.macro_def.transformer);
   case AST_PROMISE:
+    if (a->data.promise.value == a && b->data.promise.value == b)
+      return 0; /* bytecode closures: only identical ones are equal */
     if (a->data.promise.forced && b->data.promise.forced)
       return lizard_ast_equal(a->data.promise.value, b->data.promise.value);
     return lizard_ast_equal(a->data.promise.expr, b->data.promise.expr);
@@ -541,21 +568,19 @@ int lizard_ast_equal(lizard_ast_node_t *a, lizard_ast_node_t *b) {
   }
 }
 
-lizard_ast_node_t *lizard_primitive_equal(lz_list_t *args, lizard_env_t *env,
-                                          lizard_heap_t *heap) {
-  lz_list_node_t *node;
-  lizard_ast_list_node_t *first_node;
+lizard_ast_node_t *lizard_primitive_equal_argv(int argc,
+                                               lizard_ast_node_t **argv,
+                                               lizard_env_t *env,
+                                               lizard_heap_t *heap) {
   lizard_ast_node_t *first;
-  lizard_ast_node_t *result;
+  int i;
   int eq = 1;
-  if (args->head == args->nil || args->head->next == args->nil) {
+  if (argc < 2) {
     return lizard_make_error(heap, LIZARD_ERROR_EQ_ARGC);
   }
-  first_node = (lizard_ast_list_node_t *)args->head;
-  first = first_node->ast;
-  for (node = args->head->next; node != args->nil; node = node->next) {
-    lizard_ast_list_node_t *other_node = (lizard_ast_list_node_t *)node;
-    lizard_ast_node_t *other = other_node->ast;
+  first = argv[0];
+  for (i = 1; i < argc; i++) {
+    lizard_ast_node_t *other = argv[i];
     int same;
     if (lizard_num_like(first) && lizard_num_like(other)) {
       same = (lizard_num_cmp(first, other) == 0); /* numeric, with contagion */
@@ -567,12 +592,11 @@ lizard_ast_node_t *lizard_primitive_equal(lz_list_t *args, lizard_env_t *env,
       break;
     }
   }
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  result->type = AST_BOOL;
-  result->data.boolean = (eq != 0);
-  return result;
+  return lizard_make_bool(heap, eq != 0);
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_equal)
+
 lizard_ast_node_t *lizard_primitive_pow(lz_list_t *args, lizard_env_t *env,
                                         lizard_heap_t *heap) {
   lizard_ast_list_node_t *arg_node;
@@ -606,164 +630,112 @@ lizard_ast_node_t *lizard_primitive_pow(lz_list_t *args, lizard_env_t *env,
     return ret;
   }
 
-  ret = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  ret = lizard_make_number_node(heap);
   ret->type = AST_NUMBER;
   mpz_init(ret->data.number);
   mpz_pow_ui(ret->data.number, base_node->data.number, exp);
-
+  lizard_number_normalize(ret);
   return ret;
 }
 
-lizard_ast_node_t *lizard_primitive_lt(lz_list_t *args, lizard_env_t *env,
-                                       lizard_heap_t *heap) {
-  lizard_ast_list_node_t *arg_node;
-  lizard_ast_node_t *prev, *current;
-  lz_list_node_t *node;
-  int cmp;
+lizard_ast_node_t *lizard_primitive_lt_argv(int argc, lizard_ast_node_t **argv,
+                                            lizard_env_t *env,
+                                            lizard_heap_t *heap) {
+  int i;
 
-  if (args->head == args->nil || args->head->next == args->nil) {
+  if (argc < 2) {
     return lizard_make_error(heap, LIZARD_ERROR_LT_ARGC);
   }
-
-  arg_node = CAST(args->head, lizard_ast_list_node_t);
-  prev = arg_node->ast;
-  if (!lizard_num_like(prev)) {
+  if (!lizard_num_like(argv[0])) {
     return lizard_make_error(heap, LIZARD_ERROR_LT_ARGT);
   }
-
-  node = args->head->next;
-  while (node != args->nil) {
-    arg_node = CAST(node, lizard_ast_list_node_t);
-    current = arg_node->ast;
-    if (!lizard_num_like(current)) {
+  for (i = 1; i < argc; i++) {
+    if (!lizard_num_like(argv[i])) {
       return lizard_make_error(heap, LIZARD_ERROR_LT_ARGT_2);
     }
-    cmp = lizard_num_cmp(prev, current);
-    if (cmp >= 0) {
+    if (lizard_num_cmp(argv[i - 1], argv[i]) >= 0) {
       return lizard_make_bool(heap, 0);
     }
-    prev = current;
-    node = node->next;
   }
   return lizard_make_bool(heap, 1);
 }
 
-lizard_ast_node_t *lizard_primitive_le(lz_list_t *args, lizard_env_t *env,
-                                       lizard_heap_t *heap) {
-  lizard_ast_list_node_t *arg_node;
-  lizard_ast_node_t *prev, *current;
-  lz_list_node_t *node;
-  int cmp;
+lizard_ast_node_t *lizard_primitive_le_argv(int argc, lizard_ast_node_t **argv,
+                                            lizard_env_t *env,
+                                            lizard_heap_t *heap) {
+  int i;
 
-  if (args->head == args->nil || args->head->next == args->nil) {
+  if (argc < 2) {
     return lizard_make_error(heap, LIZARD_ERROR_LE_ARGC);
   }
-
-  arg_node = CAST(args->head, lizard_ast_list_node_t);
-  prev = arg_node->ast;
-  if (!lizard_num_like(prev)) {
+  if (!lizard_num_like(argv[0])) {
     return lizard_make_error(heap, LIZARD_ERROR_LE_ARGT);
   }
-
-  node = args->head->next;
-  while (node != args->nil) {
-    arg_node = CAST(node, lizard_ast_list_node_t);
-    current = arg_node->ast;
-    if (!lizard_num_like(current)) {
+  for (i = 1; i < argc; i++) {
+    if (!lizard_num_like(argv[i])) {
       return lizard_make_error(heap, LIZARD_ERROR_LE_ARGT_2);
     }
-    cmp = lizard_num_cmp(prev, current);
-    if (cmp > 0) {
+    if (lizard_num_cmp(argv[i - 1], argv[i]) > 0) {
       return lizard_make_bool(heap, 0);
     }
-    prev = current;
-    node = node->next;
   }
   return lizard_make_bool(heap, 1);
 }
 
-lizard_ast_node_t *lizard_primitive_gt(lz_list_t *args, lizard_env_t *env,
-                                       lizard_heap_t *heap) {
-  lizard_ast_list_node_t *arg_node;
-  lizard_ast_node_t *prev, *current;
-  lz_list_node_t *node;
-  int cmp;
+lizard_ast_node_t *lizard_primitive_gt_argv(int argc, lizard_ast_node_t **argv,
+                                            lizard_env_t *env,
+                                            lizard_heap_t *heap) {
+  int i;
 
-  if (args->head == args->nil || args->head->next == args->nil) {
+  if (argc < 2) {
     return lizard_make_error(heap, LIZARD_ERROR_GT_ARGC);
   }
-
-  arg_node = CAST(args->head, lizard_ast_list_node_t);
-  prev = arg_node->ast;
-  if (!lizard_num_like(prev)) {
+  if (!lizard_num_like(argv[0])) {
     return lizard_make_error(heap, LIZARD_ERROR_GT_ARGT);
   }
-
-  node = args->head->next;
-  while (node != args->nil) {
-    arg_node = CAST(node, lizard_ast_list_node_t);
-    current = arg_node->ast;
-    if (!lizard_num_like(current)) {
+  for (i = 1; i < argc; i++) {
+    if (!lizard_num_like(argv[i])) {
       return lizard_make_error(heap, LIZARD_ERROR_GT_ARGT_2);
     }
-    cmp = lizard_num_cmp(prev, current);
-    if (cmp <= 0) {
+    if (lizard_num_cmp(argv[i - 1], argv[i]) <= 0) {
       return lizard_make_bool(heap, 0);
     }
-    prev = current;
-    node = node->next;
   }
   return lizard_make_bool(heap, 1);
 }
 
-lizard_ast_node_t *lizard_primitive_ge(lz_list_t *args, lizard_env_t *env,
-                                       lizard_heap_t *heap) {
-  lizard_ast_list_node_t *arg_node;
-  lizard_ast_node_t *prev, *current;
-  lz_list_node_t *node;
-  int cmp;
+lizard_ast_node_t *lizard_primitive_ge_argv(int argc, lizard_ast_node_t **argv,
+                                            lizard_env_t *env,
+                                            lizard_heap_t *heap) {
+  int i;
 
-  if (args->head == args->nil || args->head->next == args->nil) {
+  if (argc < 2) {
     return lizard_make_error(heap, LIZARD_ERROR_GE_ARGC);
   }
-
-  arg_node = CAST(args->head, lizard_ast_list_node_t);
-  prev = arg_node->ast;
-  if (!lizard_num_like(prev)) {
+  if (!lizard_num_like(argv[0])) {
     return lizard_make_error(heap, LIZARD_ERROR_GE_ARGT);
   }
-
-  node = args->head->next;
-  while (node != args->nil) {
-    arg_node = CAST(node, lizard_ast_list_node_t);
-    current = arg_node->ast;
-    if (!lizard_num_like(current)) {
+  for (i = 1; i < argc; i++) {
+    if (!lizard_num_like(argv[i])) {
       return lizard_make_error(heap, LIZARD_ERROR_GE_ARGT_2);
     }
-    cmp = lizard_num_cmp(prev, current);
-    if (cmp < 0) {
+    if (lizard_num_cmp(argv[i - 1], argv[i]) < 0) {
       return lizard_make_bool(heap, 0);
     }
-    prev = current;
-    node = node->next;
   }
   return lizard_make_bool(heap, 1);
 }
 
-lizard_ast_node_t *lizard_primitive_mod(lz_list_t *args, lizard_env_t *env,
-                                        lizard_heap_t *heap) {
-  lizard_ast_list_node_t *arg_node;
+lizard_ast_node_t *lizard_primitive_mod_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env,
+                                             lizard_heap_t *heap) {
   lizard_ast_node_t *dividend, *divisor, *ret;
 
-  if (args->head == args->nil || args->head->next == args->nil ||
-      args->head->next->next != args->nil) {
+  if (argc != 2) {
     return lizard_make_error(heap, LIZARD_ERROR_MOD_ARGC);
   }
-
-  arg_node = CAST(args->head, lizard_ast_list_node_t);
-  dividend = arg_node->ast;
-  arg_node = CAST(args->head->next, lizard_ast_list_node_t);
-  divisor = arg_node->ast;
+  dividend = argv[0];
+  divisor = argv[1];
 
   if (dividend->type != AST_NUMBER || divisor->type != AST_NUMBER) {
     return lizard_make_error(heap, LIZARD_ERROR_MOD_ARGT);
@@ -771,75 +743,128 @@ lizard_ast_node_t *lizard_primitive_mod(lz_list_t *args, lizard_env_t *env,
   if (mpz_cmp_ui(divisor->data.number, 0) == 0) {
     return lizard_make_error(heap, LIZARD_ERROR_DIV_ZERO);
   }
+  if (LIZARD_IS_FIXNUM(dividend) && LIZARD_IS_FIXNUM(divisor) &&
+      LIZARD_FIXNUM_VALUE(dividend) != LONG_MIN &&
+      LIZARD_FIXNUM_VALUE(divisor) != LONG_MIN) {
+    /* same result as mpz_mod: in [0, |divisor|) */
+    long d = LIZARD_FIXNUM_VALUE(divisor);
+    long r = LIZARD_FIXNUM_VALUE(dividend) % d;
+    return lizard_make_fixnum(heap, r < 0 ? r + labs(d) : r);
+  }
 
-  ret = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  ret = lizard_make_number_node(heap);
   ret->type = AST_NUMBER;
   mpz_init(ret->data.number);
   mpz_mod(ret->data.number, dividend->data.number, divisor->data.number);
-
+  lizard_number_normalize(ret);
   return ret;
 }
 
-lizard_ast_node_t *lizard_primitive_cons(lz_list_t *args, lizard_env_t *env,
-                                         lizard_heap_t *heap) {
-  lizard_ast_list_node_t *car_node, *cdr_node;
-  lizard_ast_node_t *node;
-  if (args->head == args->nil || args->head->next == args->nil ||
-      args->head->next->next != args->nil) {
+lizard_ast_node_t *lizard_primitive_cons_argv(int argc, lizard_ast_node_t **argv,
+                                              lizard_env_t *env,
+                                              lizard_heap_t *heap) {
+  if (argc != 2) {
     return lizard_make_error(heap, LIZARD_ERROR_CONS_ARGC);
   }
 
-  car_node = (lizard_ast_list_node_t *)args->head;
-  cdr_node = (lizard_ast_list_node_t *)args->head->next;
-
-  node = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  node->type = AST_PAIR;
-
-  node->data.pair.car = lizard_ast_deep_copy(car_node->ast, heap);
-  node->data.pair.cdr = lizard_ast_deep_copy(cdr_node->ast, heap);
-  return node;
+  return lizard_make_pair(heap, lizard_ast_deep_copy(argv[0], heap),
+                          lizard_ast_deep_copy(argv[1], heap));
 }
 
-lizard_ast_node_t *lizard_primitive_car(lz_list_t *args, lizard_env_t *env,
-                                        lizard_heap_t *heap) {
-  lizard_ast_list_node_t *node;
-  if (args->head == args->nil || args->head->next != args->nil) {
+lizard_ast_node_t *lizard_primitive_car_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env,
+                                             lizard_heap_t *heap) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_CAR_ARGC);
   }
-  node = (lizard_ast_list_node_t *)args->head;
-  if (node->ast->type == AST_NIL) {
+  if (argv[0]->type == AST_NIL) {
     return lizard_make_error(heap, LIZARD_ERROR_CAR_NIL);
   }
-  if (node->ast->type != AST_PAIR) {
+  if (argv[0]->type != AST_PAIR) {
     return lizard_make_error(heap, LIZARD_ERROR_CAR_ARGT);
   }
-  return node->ast->data.pair.car;
+  return argv[0]->data.pair.car;
 }
 
-lizard_ast_node_t *lizard_primitive_cdr(lz_list_t *args, lizard_env_t *env,
-                                        lizard_heap_t *heap) {
-  lizard_ast_list_node_t *node;
-  if (args->head == args->nil || args->head->next != args->nil) {
+lizard_ast_node_t *lizard_primitive_cdr_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env,
+                                             lizard_heap_t *heap) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_CDR_ARGC);
   }
-  node = (lizard_ast_list_node_t *)args->head;
-  if (node->ast->type == AST_NIL) {
+  if (argv[0]->type == AST_NIL) {
     return lizard_make_error(heap, LIZARD_ERROR_CDR_NIL);
   }
-  if (node->ast->type != AST_PAIR) {
+  if (argv[0]->type != AST_PAIR) {
     return lizard_make_error(heap, LIZARD_ERROR_CDR_ARGT);
   }
-  return node->ast->data.pair.cdr;
+  return argv[0]->data.pair.cdr;
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_lt)
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_le)
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_gt)
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_ge)
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_mod)
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_cons)
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_car)
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_cdr)
+
 lizard_ast_node_t *lizard_make_primitive(lizard_heap_t *heap,
                                          lizard_primitive_func_t func) {
+  return lizard_make_primitive_argv(heap, func, NULL);
+}
+
+lizard_ast_node_t *lizard_make_primitive_argv(
+    lizard_heap_t *heap, lizard_primitive_func_t func,
+    lizard_primitive_argv_func_t argv_func) {
   lizard_ast_node_t *node = lizard_heap_alloc(sizeof(lizard_ast_node_t));
   node->type = AST_PRIMITIVE;
-  node->data.primitive = func;
+  node->data.primitive.fn = func;
+  node->data.primitive.argv = argv_func;
   return node;
 }
 
+lizard_ast_node_t *lizard_primitive_call(lizard_ast_node_t *prim, int argc,
+                                         lizard_ast_node_t **argv,
+                                         lizard_env_t *env,
+                                         lizard_heap_t *heap) {
+  lz_list_t *args;
+  int i;
+  if (prim->data.primitive.argv != NULL) {
+    return prim->data.primitive.argv(argc, argv, env, heap);
+  }
+  args = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+  for (i = 0; i < argc; i++) {
+    lizard_ast_list_node_t *node =
+        lizard_heap_alloc(sizeof(lizard_ast_list_node_t));
+    node->ast = argv[i];
+    list_append(args, &node->node);
+  }
+  return prim->data.primitive.fn(args, env, heap);
+}
+
+lizard_ast_node_t *lizard_primitive_call_list(lizard_primitive_argv_func_t fn,
+                                              lz_list_t *args,
+                                              lizard_env_t *env,
+                                              lizard_heap_t *heap) {
+  lizard_ast_node_t *buf[LIZARD_PRIMITIVE_ARGV_MAX];
+  lizard_ast_node_t **argv = buf;
+  lz_list_node_t *it;
+  int argc = 0;
+  for (it = args->head; it != args->nil; it = it->next) {
+    argc++;
+  }
+  if (argc > LIZARD_PRIMITIVE_ARGV_MAX) {
+    argv = lizard_heap_alloc((size_t)argc * sizeof(lizard_ast_node_t *));
+  }
+  argc = 0;
+  for (it = args->head; it != args->nil; it = it->next) {
+    argv[argc++] = ((lizard_ast_list_node_t *)it)->ast;
+  }
+  return fn(argc, argv, env, heap);
+}
+
 
 lizard_ast_node_t *lizard_primitive_tokens(lz_list_t *args, lizard_env_t *env,
                                            lizard_heap_t *heap) {
@@ -956,8 +981,11 @@ lizard_ast_node_t *lizard_primitive_callcc(
   lizard_ast_list_node_t *arg0;
   lizard_ast_node_t *proc;
   lizard_ast_node_t *cont_obj;
+  lizard_ast_node_t *result;
   lz_list_t *arg_list;
   lizard_ast_list_node_t *node_arg;
+  lizard_escape_frame_t frame;
+  lizard_escape_frame_t **top;
   if (args->head == args->nil) {
     return lizard_make_error(heap, LIZARD_ERROR_CALLCC_ARGC);
   }
@@ -966,31 +994,47 @@ lizard_ast_node_t *lizard_primitive_callcc(
   if (proc->type != AST_LAMBDA && proc->type != AST_PRIMITIVE) {
     return lizard_make_error(heap, LIZARD_ERROR_CALLCC_APPLY);
   }
-  if (heap->runtime != NULL) {
-    if (!heap->runtime->callcc_active) {
-      heap->runtime->callcc_active = 1;
-      if (setjmp(heap->runtime->callcc_buf) != 0) {
-        heap->runtime->callcc_active = 0;
-        return heap->runtime->callcc_value;
-      }
-    }
-  } else {
-    if (!callcc_active_fallback) {
-      callcc_active_fallback = 1;
-      if (setjmp(callcc_buf_fallback) != 0) {
-        callcc_active_fallback = 0;
-        return callcc_value_fallback;
-      }
-    }
-  }
+  top = heap->runtime != NULL ? &heap->runtime->escape_top : &escape_top_fallback;
+  frame.id = lizard_escape_next_id(heap);
+  frame.value = NULL;
+  frame.vm_top = heap->runtime != NULL ? heap->runtime->vm_top : NULL;
+  frame.prev = *top;
   cont_obj = lizard_make_continuation(current_cont, heap);
+  cont_obj->data.continuation.escape_id = frame.id;
 
   arg_list = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
   node_arg = lizard_heap_alloc(sizeof(lizard_ast_list_node_t));
   node_arg->ast = cont_obj; /* shallow copy */
   list_append(arg_list, &node_arg->node);
 
-  return lizard_apply(proc, arg_list, env, heap, current_cont);
+  if (setjmp(frame.buf) != 0) {
+    /* Escaped to: frames pushed by inner call/cc are gone with their C
+     * frames. */
+    *top = frame.prev;
+    return frame.value;
+  }
+  *top = &frame;
+  result = lizard_apply(proc, arg_list, env, heap, current_cont);
+  *top = frame.prev;
+  return result;
+}
+
+unsigned long lizard_escape_next_id(lizard_heap_t *heap) {
+  return heap->runtime != NULL ? ++heap->runtime->escape_counter
+                               : ++escape_counter_fallback;
+}
+
+void lizard_continuation_escape(lizard_ast_node_t *k, lizard_ast_node_t *value,
+                                lizard_heap_t *heap) {
+  lizard_escape_frame_t *frame =
+      heap->runtime != NULL ? heap->runtime->escape_top : escape_top_fallback;
+  for (; frame != NULL; frame = frame->prev) {
+    if (frame->id == k->data.continuation.escape_id) {
+      frame->value = value;
+      lizard_vm_unwind(heap, frame->vm_top);
+      longjmp(frame->buf, 1);
+    }
+  }
 }
 
 lizard_ast_node_t *lizard_identity_cont(lizard_ast_node_t *result,
@@ -1016,60 +1060,68 @@ int lizard_is_false(lizard_ast_node_t *node) {
 
 int lizard_is_true(lizard_ast_node_t *node) { return !lizard_is_false(node); }
 
-lizard_ast_node_t *lizard_primitive_nullp(lz_list_t *args, lizard_env_t *env,
-                                          lizard_heap_t *heap) {
-  lizard_ast_list_node_t *node_arg;
+lizard_ast_node_t *lizard_primitive_nullp_argv(int argc,
+                                               lizard_ast_node_t **argv,
+                                               lizard_env_t *env,
+                                               lizard_heap_t *heap) {
   (void)env; /* unused */
-  if (args->head == args->nil || args->head->next != args->nil) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_NULLP_ARGC);
   }
-  node_arg = (lizard_ast_list_node_t *)args->head;
-  if (node_arg->ast->type == AST_NIL)
+  if (argv[0]->type == AST_NIL)
     return lizard_make_bool(heap, true);
   else
     return lizard_make_bool(heap, false);
 }
 
-lizard_ast_node_t *lizard_primitive_pairp(lz_list_t *args, lizard_env_t *env,
-                                          lizard_heap_t *heap) {
-  lizard_ast_list_node_t *node_arg;
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_nullp)
+
+lizard_ast_node_t *lizard_primitive_pairp_argv(int argc,
+                                               lizard_ast_node_t **argv,
+                                               lizard_env_t *env,
+                                               lizard_heap_t *heap) {
   (void)env;
-  if (args->head == args->nil || args->head->next != args->nil) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_PAIRP_ARGC);
   }
-  node_arg = (lizard_ast_list_node_t *)args->head;
-  if (node_arg->ast->type == AST_PAIR)
+  if (argv[0]->type == AST_PAIR)
     return lizard_make_bool(heap, true);
   else
     return lizard_make_bool(heap, false);
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_pairp)
 
-lizard_ast_node_t *lizard_primitive_boolp(lz_list_t *args, lizard_env_t *env,
-                                          lizard_heap_t *heap) {
-  lizard_ast_list_node_t *node_arg;
+
+lizard_ast_node_t *lizard_primitive_boolp_argv(int argc,
+                                               lizard_ast_node_t **argv,
+                                               lizard_env_t *env,
+                                               lizard_heap_t *heap) {
   (void)env;
-  if (args->head == args->nil || args->head->next != args->nil) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_BOOLP_ARGC);
   }
-  node_arg = (lizard_ast_list_node_t *)args->head;
-  if (node_arg->ast->type == AST_BOOL)
+  if (argv[0]->type == AST_BOOL)
     return lizard_make_bool(heap, true);
   else
     return lizard_make_bool(heap, false);
 }
 
-lizard_ast_node_t *lizard_primitive_numberp(lz_list_t *args, lizard_env_t *env,
-                                            lizard_heap_t *heap) {
-  lizard_ast_list_node_t *node_arg;
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_boolp)
+
+lizard_ast_node_t *lizard_primitive_numberp_argv(int argc,
+                                                 lizard_ast_node_t **argv,
+                                                 lizard_env_t *env,
+                                                 lizard_heap_t *heap) {
   (void)env;
-  if (args->head == args->nil || args->head->next != args->nil) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  node_arg = (lizard_ast_list_node_t *)args->head;
-  return lizard_make_bool(heap, lizard_num_like(node_arg->ast));
+  return lizard_make_bool(heap, lizard_num_like(argv[0]));
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_numberp)
+
 /* (rational? x) — exact rationals/integers, plus finite inexact reals (R7RS). */
 lizard_ast_node_t *lizard_primitive_rationalp(lz_list_t *args,
                                               lizard_env_t *env,
@@ -1098,13 +1150,14 @@ lizard_ast_node_t *lizard_primitive_realp(lz_list_t *args, lizard_env_t *env,
 }
 
 /* (integer? x) — exact integers, and inexact reals with an integral value. */
-lizard_ast_node_t *lizard_primitive_integerp(lz_list_t *args,
-                                             lizard_env_t *env,
-                                             lizard_heap_t *heap) {
+lizard_ast_node_t *lizard_primitive_integerp_argv(int argc,
+                                                  lizard_ast_node_t **argv,
+                                                  lizard_env_t *env,
+                                                  lizard_heap_t *heap) {
   lizard_ast_node_t *a;
   (void)env;
-  if (!single_arg(args)) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
-  a = ((lizard_ast_list_node_t *)args->head)->ast;
+  if (argc != 1) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
+  a = argv[0];
   if (a->type == AST_NUMBER) {
     return lizard_make_bool(heap, 1);
   }
@@ -1116,6 +1169,8 @@ lizard_ast_node_t *lizard_primitive_integerp(lz_list_t *args,
   return lizard_make_bool(heap, 0);
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_integerp)
+
 /* (exact? x) — exact integers and exact rationals (NOT inexact reals). */
 lizard_ast_node_t *lizard_primitive_exactp(lz_list_t *args,
                                            lizard_env_t *env,
@@ -1257,10 +1312,11 @@ lizard_ast_node_t *lizard_primitive_sqrt(lz_list_t *args, lizard_env_t *env,
   if (!lizard_num_like(a)) return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   if (a->type == AST_NUMBER && mpz_sgn(a->data.number) >= 0 &&
       mpz_perfect_square_p(a->data.number)) {
-    result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+    result = lizard_make_number_node(heap);
     result->type = AST_NUMBER;
     mpz_init(result->data.number);
     mpz_sqrt(result->data.number, a->data.number);
+    lizard_number_normalize(result);
     return result;
   }
   return lizard_make_real(heap, sqrt(lizard_num_to_double(a)));
@@ -1295,11 +1351,12 @@ static lizard_ast_node_t *lz_rounder(lz_list_t *args, lizard_heap_t *heap, int m
       mpz_clear(tp);
       mpz_clear(tq);
     }
-    result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+    result = lizard_make_number_node(heap);
     result->type = AST_NUMBER;
     mpz_init(result->data.number);
     mpz_set(result->data.number, z);
     mpz_clear(z);
+    lizard_number_normalize(result);
     return result;
   }
   if (a->type == AST_REAL) {
@@ -1339,10 +1396,11 @@ lizard_ast_node_t *lizard_primitive_numerator(lz_list_t *args,
   if (!single_arg(args)) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   x = ((lizard_ast_list_node_t *)args->head)->ast;
   if (!lizard_num_like(x)) return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  r = lizard_make_number_node(heap);
   r->type = AST_NUMBER;
   if (x->type == AST_RATIONAL) mpz_init_set(r->data.number, mpq_numref(x->data.rational));
   else mpz_init_set(r->data.number, x->data.number);
+  lizard_number_normalize(r);
   return r;
 }
 
@@ -1355,36 +1413,42 @@ lizard_ast_node_t *lizard_primitive_denominator(lz_list_t *args,
   if (!single_arg(args)) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   x = ((lizard_ast_list_node_t *)args->head)->ast;
   if (!lizard_num_like(x)) return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  r = lizard_make_number_node(heap);
   r->type = AST_NUMBER;
   if (x->type == AST_RATIONAL) mpz_init_set(r->data.number, mpq_denref(x->data.rational));
   else mpz_init_set_ui(r->data.number, 1U);
+  lizard_number_normalize(r);
   return r;
 }
 
-lizard_ast_node_t *lizard_primitive_symbolp(lz_list_t *args, lizard_env_t *env,
-                                            lizard_heap_t *heap) {
-  lizard_ast_list_node_t *node_arg;
+lizard_ast_node_t *lizard_primitive_symbolp_argv(int argc,
+                                                 lizard_ast_node_t **argv,
+                                                 lizard_env_t *env,
+                                                 lizard_heap_t *heap) {
   (void)env;
-  if (args->head == args->nil || args->head->next != args->nil) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  node_arg = (lizard_ast_list_node_t *)args->head;
-  return lizard_make_bool(heap, node_arg->ast->type == AST_SYMBOL);
+  return lizard_make_bool(heap, argv[0]->type == AST_SYMBOL);
 }
 
-lizard_ast_node_t *lizard_primitive_procedurep(lz_list_t *args, lizard_env_t *env,
-                                               lizard_heap_t *heap) {
-  lizard_ast_list_node_t *node_arg;
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_symbolp)
+
+lizard_ast_node_t *lizard_primitive_procedurep_argv(int argc,
+                                                    lizard_ast_node_t **argv,
+                                                    lizard_env_t *env,
+                                                    lizard_heap_t *heap) {
   (void)env;
-  if (args->head == args->nil || args->head->next != args->nil) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  node_arg = (lizard_ast_list_node_t *)args->head;
-  return lizard_make_bool(heap, node_arg->ast->type == AST_LAMBDA ||
-                                    node_arg->ast->type == AST_PRIMITIVE);
+  return lizard_make_bool(heap, argv[0]->type == AST_LAMBDA ||
+                                    argv[0]->type == AST_PRIMITIVE ||
+                                    lizard_vm_is_closure(argv[0]));
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_procedurep)
+
 lizard_ast_node_t *lizard_primitive_and(lz_list_t *args, lizard_env_t *env,
                                         lizard_heap_t *heap) {
   lz_list_node_t *iter;
@@ -1418,20 +1482,21 @@ lizard_ast_node_t *lizard_primitive_or(lz_list_t *args, lizard_env_t *env,
   return result;
 }
 
-lizard_ast_node_t *lizard_primitive_not(lz_list_t *args, lizard_env_t *env,
-                                        lizard_heap_t *heap) {
-  lizard_ast_list_node_t *node_arg;
+lizard_ast_node_t *lizard_primitive_not_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env,
+                                             lizard_heap_t *heap) {
   (void)env;
-  if (args->head == args->nil || args->head->next != args->nil) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_NOT_ARGC);
   }
-  node_arg = (lizard_ast_list_node_t *)args->head;
-  if (lizard_is_false(node_arg->ast))
+  if (lizard_is_false(argv[0]))
     return lizard_make_bool(heap, true);
   else
     return lizard_make_bool(heap, false);
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_not)
+
 lizard_ast_node_t *lizard_primitive_xor(lz_list_t *args, lizard_env_t *env,
                                         lizard_heap_t *heap) {
   lz_list_node_t *iter;
@@ -1470,11 +1535,19 @@ lizard_ast_node_t *lizard_ast_deep_copy(lizard_ast_node_t *node,
   if (!node) {
     return NULL;
   }
-  copy = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  copy = node->type == AST_NUMBER || node->type == AST_RATIONAL
+             ? lizard_make_number_node(heap)
+             : lizard_heap_alloc_tagged(sizeof(lizard_ast_node_t),
+                                        LIZARD_GC_OBJECT_AST_NODE,
+                                        LIZARD_OBJECT_TRACE_AST);
   copy->type = node->type;
   copy->span = node->span;
   switch (node->type) {
   case AST_NUMBER:
+    if (LIZARD_IS_FIXNUM(node)) {
+      lizard_fixnum_init(copy, LIZARD_FIXNUM_VALUE(node));
+      break;
+    }
     mpz_init(copy->data.number);
     mpz_set(copy->data.number, node->data.number);
     break;
@@ -1667,12 +1740,13 @@ lizard_ast_node_t *gc_make_stat(lizard_heap_t *heap,
                                         const char *key,
                                         unsigned long val) {
   lizard_ast_node_t *k = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  lizard_ast_node_t *v = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  lizard_ast_node_t *v = lizard_make_number_node(heap);
   lizard_ast_node_t *p = lizard_heap_alloc(sizeof(lizard_ast_node_t));
   k->type = AST_SYMBOL;
   k->data.variable = key;
   v->type = AST_NUMBER;
   mpz_init_set_ui(v->data.number, val);
+  lizard_number_normalize(v);
   p->type = AST_PAIR;
   p->data.pair.car = k;
   p->data.pair.cdr = v;
@@ -1682,11 +1756,7 @@ lizard_ast_node_t *gc_make_stat(lizard_heap_t *heap,
 lizard_ast_node_t *gc_cons(lizard_heap_t *heap,
                                    lizard_ast_node_t *car,
                                    lizard_ast_node_t *cdr) {
-  lizard_ast_node_t *c = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  c->type = AST_PAIR;
-  c->data.pair.car = car;
-  c->data.pair.cdr = cdr;
-  return c;
+  return lizard_make_pair(heap, car, cdr);
 }
 
 
@@ -1938,6 +2008,7 @@ lizard_ast_node_t *lizard_primitive_swap(lz_list_t *args,
   new_val = lizard_apply(fn, call_args, env, heap, lizard_identity_cont);
   if (new_val && new_val->type == AST_ERROR) return new_val;
   a->data.pair.cdr = new_val;
+  lizard_gc_write_barrier(&a->data.pair.cdr);
   return new_val;
 }
 
@@ -1954,6 +2025,7 @@ lizard_ast_node_t *lizard_primitive_reset(lz_list_t *args,
   if (!is_atom(a))
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   a->data.pair.cdr = val;
+  lizard_gc_write_barrier(&a->data.pair.cdr);
   return val;
 }
 
@@ -2076,61 +2148,67 @@ lizard_ast_node_t *lizard_primitive_promisep(lz_list_t *args,
  * ============================================================ */
 
 #define NUM_PRED(name, test) \
-lizard_ast_node_t *name(lz_list_t *args, lizard_env_t *env, \
-                         lizard_heap_t *heap) { \
+lizard_ast_node_t *name##_argv(int argc, lizard_ast_node_t **argv, \
+                               lizard_env_t *env, lizard_heap_t *heap) { \
   lizard_ast_node_t *a; \
   (void)env; \
-  if (!single_arg(args)) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC); \
-  a = ((lizard_ast_list_node_t *)args->head)->ast; \
+  if (argc != 1) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC); \
+  a = argv[0]; \
   if (a->type != AST_NUMBER) return lizard_make_bool(heap, 0); \
   return lizard_make_bool(heap, test); \
-}
+} \
+LIZARD_PRIMITIVE_LIST_ENTRY(name)
 
 /* Sign predicates accept rationals too (mpq_sgn); even?/odd? stay integer-only. */
 #define SGN_PRED(name, op) \
-lizard_ast_node_t *name(lz_list_t *args, lizard_env_t *env, \
-                         lizard_heap_t *heap) { \
+lizard_ast_node_t *name##_argv(int argc, lizard_ast_node_t **argv, \
+                               lizard_env_t *env, lizard_heap_t *heap) { \
   lizard_ast_node_t *a; int sg; \
   (void)env; \
-  if (!single_arg(args)) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC); \
-  a = ((lizard_ast_list_node_t *)args->head)->ast; \
+  if (argc != 1) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC); \
+  a = argv[0]; \
   if (a->type == AST_NUMBER) sg = mpz_sgn(a->data.number); \
   else if (a->type == AST_RATIONAL) sg = mpq_sgn(a->data.rational); \
   else return lizard_make_bool(heap, 0); \
   return lizard_make_bool(heap, sg op 0); \
-}
+} \
+LIZARD_PRIMITIVE_LIST_ENTRY(name)
 SGN_PRED(lizard_primitive_zerop,     ==)
 SGN_PRED(lizard_primitive_positivep, >)
 SGN_PRED(lizard_primitive_negativep, <)
 NUM_PRED(lizard_primitive_evenp,     mpz_even_p(a->data.number))
 NUM_PRED(lizard_primitive_oddp,      mpz_odd_p(a->data.number))
 
-lizard_ast_node_t *lizard_primitive_min(lz_list_t *args,
-                                         lizard_env_t *env,
-                                         lizard_heap_t *heap) {
+lizard_ast_node_t *lizard_primitive_min_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env,
+                                             lizard_heap_t *heap) {
   lizard_ast_node_t *a, *b;
   (void)env;
-  if (!two_args(args)) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
-  a = ((lizard_ast_list_node_t *)args->head)->ast;
-  b = ((lizard_ast_list_node_t *)args->head->next)->ast;
+  if (argc != 2) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
+  a = argv[0];
+  b = argv[1];
   if (a->type != AST_NUMBER || b->type != AST_NUMBER)
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   return (mpz_cmp(a->data.number, b->data.number) <= 0) ? a : b;
 }
 
-lizard_ast_node_t *lizard_primitive_max(lz_list_t *args,
-                                         lizard_env_t *env,
-                                         lizard_heap_t *heap) {
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_min)
+
+lizard_ast_node_t *lizard_primitive_max_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env,
+                                             lizard_heap_t *heap) {
   lizard_ast_node_t *a, *b;
   (void)env;
-  if (!two_args(args)) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
-  a = ((lizard_ast_list_node_t *)args->head)->ast;
-  b = ((lizard_ast_list_node_t *)args->head->next)->ast;
+  if (argc != 2) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
+  a = argv[0];
+  b = argv[1];
   if (a->type != AST_NUMBER || b->type != AST_NUMBER)
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   return (mpz_cmp(a->data.number, b->data.number) >= 0) ? a : b;
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_max)
+
 /* ============================================================
  * Character + string conversion
  * ============================================================ */
@@ -2138,14 +2216,15 @@ lizard_ast_node_t *lizard_primitive_max(lz_list_t *args,
 /* (char->integer "c") — ASCII value of first char. */
 
 /* (integer->char n) — char from ASCII value. */
-lizard_ast_node_t *lizard_primitive_int_to_char(lz_list_t *args,
-                                                 lizard_env_t *env,
-                                                 lizard_heap_t *heap) {
+lizard_ast_node_t *lizard_primitive_int_to_char_argv(int argc,
+                                                     lizard_ast_node_t **argv,
+                                                     lizard_env_t *env,
+                                                     lizard_heap_t *heap) {
   lizard_ast_node_t *n, *r;
   char *buf;
   (void)env;
-  if (!single_arg(args)) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
-  n = ((lizard_ast_list_node_t *)args->head)->ast;
+  if (argc != 1) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
+  n = argv[0];
   if (n->type != AST_NUMBER) return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   buf = (char *)lizard_heap_alloc(2);
   buf[0] = (char)mpz_get_si(n->data.number);
@@ -2156,6 +2235,8 @@ lizard_ast_node_t *lizard_primitive_int_to_char(lz_list_t *args,
   return r;
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_int_to_char)
+
 /* (string->list "abc") — list of 1-char strings. */
 
 /* (list->string chars) — concatenate list of 1-char strings. */
@@ -2194,17 +2275,14 @@ lizard_ast_node_t *lizard_primitive_conj_mut(lz_list_t *args,
                (size_t)len * sizeof(lizard_ast_node_t *));
       new_elems[len] = val;
       vec->data.vector.elements = new_elems;
+      lizard_gc_write_barrier(&vec->data.vector.elements);
       vec->data.vector.size = (size_t)(len + 1);
     }
     return vec;
   }
   /* For lists, cons onto front. */
   if (vec->type == AST_PAIR || vec->type == AST_NIL) {
-    lizard_ast_node_t *node = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-    node->type = AST_PAIR;
-    node->data.pair.car = val;
-    node->data.pair.cdr = vec;
-    return node;
+    return lizard_make_pair(heap, val, vec);
   }
   return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
 }
@@ -2237,6 +2315,15 @@ static void install_one(lizard_heap_t *heap, lizard_env_t *env,
   lizard_env_define(heap, env, name, lizard_make_primitive(heap, func));
 }
 
+/* Register a primitive that also has an (argc, argv) entry; `func` is its
+ * list-convention twin, kept for lizard_apply and direct C callers. */
+static void install_argv(lizard_heap_t *heap, lizard_env_t *env,
+                         const char *name, lizard_primitive_func_t func,
+                         lizard_primitive_argv_func_t argv_func) {
+  lizard_env_define(heap, env, name,
+                    lizard_make_primitive_argv(heap, func, argv_func));
+}
+
 /* ---- Fast bignum primitives ----
  *
  * Idiomatic Scheme code often expresses big computations via repeated
@@ -2251,54 +2338,51 @@ static void install_one(lizard_heap_t *heap, lizard_env_t *env,
  *     (gcd huge-a huge-b)            ; one mpz_gcd
  */
 
-static lizard_ast_node_t *unary_number(lz_list_t *args, lizard_heap_t *heap,
+static lizard_ast_node_t *unary_number(int argc, lizard_ast_node_t **argv,
+                                       lizard_heap_t *heap,
                                        lizard_ast_node_t **out) {
-  lizard_ast_list_node_t *node;
-  if (args->head == args->nil || args->head->next != args->nil) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  node = (lizard_ast_list_node_t *)args->head;
-  if (node->ast->type != AST_NUMBER) {
+  if (argv[0]->type != AST_NUMBER) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
-  *out = node->ast;
+  *out = argv[0];
   return NULL;
 }
 
-static int binary_numbers(lz_list_t *args, lizard_heap_t *heap,
-                          lizard_ast_node_t **a, lizard_ast_node_t **b,
-                          lizard_ast_node_t **err) {
-  lizard_ast_list_node_t *na, *nb;
-  if (args->head == args->nil || args->head->next == args->nil ||
-      args->head->next->next != args->nil) {
+static int binary_numbers(int argc, lizard_ast_node_t **argv,
+                          lizard_heap_t *heap, lizard_ast_node_t **a,
+                          lizard_ast_node_t **b, lizard_ast_node_t **err) {
+  if (argc != 2) {
     *err = lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
     return 0;
   }
-  na = (lizard_ast_list_node_t *)args->head;
-  nb = (lizard_ast_list_node_t *)args->head->next;
-  if (na->ast->type != AST_NUMBER || nb->ast->type != AST_NUMBER) {
+  if (argv[0]->type != AST_NUMBER || argv[1]->type != AST_NUMBER) {
     *err = lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
     return 0;
   }
-  *a = na->ast;
-  *b = nb->ast;
+  *a = argv[0];
+  *b = argv[1];
   return 1;
 }
 
 /* (arithmetic-shift x n) — shift x left by n bits if n>0, right if n<0.
  * Uses mpz_mul_2exp / mpz_fdiv_q_2exp: one GMP call. */
-lizard_ast_node_t *lizard_primitive_arith_shift(lz_list_t *args, lizard_env_t *env,
-                                                lizard_heap_t *heap) {
+lizard_ast_node_t *lizard_primitive_arith_shift_argv(int argc,
+                                                     lizard_ast_node_t **argv,
+                                                     lizard_env_t *env,
+                                                     lizard_heap_t *heap) {
   lizard_ast_node_t *x, *n, *err = NULL;
   lizard_ast_node_t *result;
   long shift;
   (void)env;
-  if (!binary_numbers(args, heap, &x, &n, &err)) return err;
+  if (!binary_numbers(argc, argv, heap, &x, &n, &err)) return err;
   if (!mpz_fits_slong_p(n->data.number)) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
   shift = mpz_get_si(n->data.number);
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  result = lizard_make_number_node(heap);
   result->type = AST_NUMBER;
   mpz_init(result->data.number);
   if (shift >= 0) {
@@ -2307,9 +2391,12 @@ lizard_ast_node_t *lizard_primitive_arith_shift(lz_list_t *args, lizard_env_t *e
     mpz_fdiv_q_2exp(result->data.number, x->data.number,
                     (unsigned long)(-shift));
   }
+  lizard_number_normalize(result);
   return result;
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_arith_shift)
+
 /* (expt base exp) — base^exp where exp is a non-negative fixnum.
  * Uses mpz_pow_ui: GMP's optimised power routine, O(log exp). */
 lizard_ast_node_t *lizard_primitive_expt(lz_list_t *args, lizard_env_t *env,
@@ -2343,83 +2430,115 @@ lizard_ast_node_t *lizard_primitive_expt(lz_list_t *args, lizard_env_t *env,
     mpq_clear(q);
     return result;
   }
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  result = lizard_make_number_node(heap);
   result->type = AST_NUMBER;
   mpz_init(result->data.number);
   mpz_pow_ui(result->data.number, b->data.number, exp);
+  lizard_number_normalize(result);
   return result;
 }
 
 /* (gcd a b) — greatest common divisor via mpz_gcd. */
-lizard_ast_node_t *lizard_primitive_gcd(lz_list_t *args, lizard_env_t *env,
-                                        lizard_heap_t *heap) {
+lizard_ast_node_t *lizard_primitive_gcd_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env,
+                                             lizard_heap_t *heap) {
   lizard_ast_node_t *a, *b, *err = NULL;
   lizard_ast_node_t *result;
   (void)env;
-  if (!binary_numbers(args, heap, &a, &b, &err)) return err;
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  if (!binary_numbers(argc, argv, heap, &a, &b, &err)) return err;
+  result = lizard_make_number_node(heap);
   result->type = AST_NUMBER;
   mpz_init(result->data.number);
   mpz_gcd(result->data.number, a->data.number, b->data.number);
+  lizard_number_normalize(result);
   return result;
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_gcd)
+
 /* (lcm a b) — least common multiple via mpz_lcm. */
-lizard_ast_node_t *lizard_primitive_lcm(lz_list_t *args, lizard_env_t *env,
-                                        lizard_heap_t *heap) {
+lizard_ast_node_t *lizard_primitive_lcm_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env,
+                                             lizard_heap_t *heap) {
   lizard_ast_node_t *a, *b, *err = NULL;
   lizard_ast_node_t *result;
   (void)env;
-  if (!binary_numbers(args, heap, &a, &b, &err)) return err;
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  if (!binary_numbers(argc, argv, heap, &a, &b, &err)) return err;
+  result = lizard_make_number_node(heap);
   result->type = AST_NUMBER;
   mpz_init(result->data.number);
   mpz_lcm(result->data.number, a->data.number, b->data.number);
+  lizard_number_normalize(result);
   return result;
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_lcm)
+
 /* (quotient a b) — truncating integer division. */
-lizard_ast_node_t *lizard_primitive_quotient(lz_list_t *args, lizard_env_t *env,
-                                             lizard_heap_t *heap) {
+lizard_ast_node_t *lizard_primitive_quotient_argv(int argc,
+                                                  lizard_ast_node_t **argv,
+                                                  lizard_env_t *env,
+                                                  lizard_heap_t *heap) {
   lizard_ast_node_t *a, *b, *err = NULL;
   lizard_ast_node_t *result;
   (void)env;
-  if (!binary_numbers(args, heap, &a, &b, &err)) return err;
+  if (!binary_numbers(argc, argv, heap, &a, &b, &err)) return err;
   if (mpz_sgn(b->data.number) == 0) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  /* C89 leaves negative division to the implementation; the compilers we
+   * build with truncate, matching mpz_tdiv_q. */
+  if (LIZARD_IS_FIXNUM(a) && LIZARD_IS_FIXNUM(b) &&
+      LIZARD_FIXNUM_VALUE(a) != LONG_MIN) {
+    return lizard_make_fixnum(heap,
+                              LIZARD_FIXNUM_VALUE(a) / LIZARD_FIXNUM_VALUE(b));
+  }
+  result = lizard_make_number_node(heap);
   result->type = AST_NUMBER;
   mpz_init(result->data.number);
   mpz_tdiv_q(result->data.number, a->data.number, b->data.number);
+  lizard_number_normalize(result);
   return result;
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_quotient)
+
 /* (remainder a b) — truncating-division remainder (same sign as a). */
-lizard_ast_node_t *lizard_primitive_remainder(lz_list_t *args, lizard_env_t *env,
-                                              lizard_heap_t *heap) {
+lizard_ast_node_t *lizard_primitive_remainder_argv(int argc,
+                                                   lizard_ast_node_t **argv,
+                                                   lizard_env_t *env,
+                                                   lizard_heap_t *heap) {
   lizard_ast_node_t *a, *b, *err = NULL;
   lizard_ast_node_t *result;
   (void)env;
-  if (!binary_numbers(args, heap, &a, &b, &err)) return err;
+  if (!binary_numbers(argc, argv, heap, &a, &b, &err)) return err;
   if (mpz_sgn(b->data.number) == 0) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  if (LIZARD_IS_FIXNUM(a) && LIZARD_IS_FIXNUM(b) &&
+      LIZARD_FIXNUM_VALUE(a) != LONG_MIN) {
+    return lizard_make_fixnum(heap,
+                              LIZARD_FIXNUM_VALUE(a) % LIZARD_FIXNUM_VALUE(b));
+  }
+  result = lizard_make_number_node(heap);
   result->type = AST_NUMBER;
   mpz_init(result->data.number);
   mpz_tdiv_r(result->data.number, a->data.number, b->data.number);
+  lizard_number_normalize(result);
   return result;
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_remainder)
+
 /* (abs n). */
-lizard_ast_node_t *lizard_primitive_abs(lz_list_t *args, lizard_env_t *env,
-                                        lizard_heap_t *heap) {
+lizard_ast_node_t *lizard_primitive_abs_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env,
+                                             lizard_heap_t *heap) {
   lizard_ast_node_t *x = NULL, *err;
   lizard_ast_node_t *result;
   (void)env;
-  if (args->head != args->nil && args->head->next == args->nil) {
-    lizard_ast_node_t *a = ((lizard_ast_list_node_t *)args->head)->ast;
+  if (argc == 1) {
+    lizard_ast_node_t *a = argv[0];
     if (a->type == AST_REAL) {
       return lizard_make_real(heap, fabs(a->data.real));
     }
@@ -2432,30 +2551,38 @@ lizard_ast_node_t *lizard_primitive_abs(lz_list_t *args, lizard_env_t *env,
       return result;
     }
   }
-  err = unary_number(args, heap, &x);
+  err = unary_number(argc, argv, heap, &x);
   if (err) return err;
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  result = lizard_make_number_node(heap);
   result->type = AST_NUMBER;
   mpz_init(result->data.number);
   mpz_abs(result->data.number, x->data.number);
+  lizard_number_normalize(result);
   return result;
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_abs)
+
 /* (square n) — one mpz_mul instead of (* n n) which would force-and-copy. */
-lizard_ast_node_t *lizard_primitive_square(lz_list_t *args, lizard_env_t *env,
-                                           lizard_heap_t *heap) {
+lizard_ast_node_t *lizard_primitive_square_argv(int argc,
+                                                lizard_ast_node_t **argv,
+                                                lizard_env_t *env,
+                                                lizard_heap_t *heap) {
   lizard_ast_node_t *x = NULL, *err;
   lizard_ast_node_t *result;
   (void)env;
-  err = unary_number(args, heap, &x);
+  err = unary_number(argc, argv, heap, &x);
   if (err) return err;
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  result = lizard_make_number_node(heap);
   result->type = AST_NUMBER;
   mpz_init(result->data.number);
   mpz_mul(result->data.number, x->data.number, x->data.number);
+  lizard_number_normalize(result);
   return result;
 }
 
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_square)
+
 /* (modular-expt base exp mod) — modular exponentiation, O(log exp) and
  * keeps intermediates bounded by mod. */
 lizard_ast_node_t *lizard_primitive_modexpt(lz_list_t *args, lizard_env_t *env,
@@ -2475,11 +2602,12 @@ lizard_ast_node_t *lizard_primitive_modexpt(lz_list_t *args, lizard_env_t *env,
       nc->ast->type != AST_NUMBER) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  result = lizard_make_number_node(heap);
   result->type = AST_NUMBER;
   mpz_init(result->data.number);
   mpz_powm(result->data.number, na->ast->data.number, nb->ast->data.number,
            nc->ast->data.number);
+  lizard_number_normalize(result);
   return result;
 }
 
@@ -2489,18 +2617,15 @@ lizard_ast_node_t *lizard_primitive_modexpt(lz_list_t *args, lizard_env_t *env,
 
 lizard_ast_node_t *make_symbol(lizard_heap_t *heap, const char *name) {
   lizard_ast_node_t *n = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  size_t len = strlen(name);
-  char *buf = lizard_heap_alloc(len + 1);
-  memcpy(buf, name, len + 1);
   n->type = AST_SYMBOL;
-  n->data.variable = buf;
+  n->data.variable = lizard_intern(name);
   return n;
 }
 
 lizard_ast_node_t *make_string(lizard_heap_t *heap, const char *src,
                                       size_t len) {
   lizard_ast_node_t *n = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  char *buf = lizard_heap_alloc(len + 1);
+  char *buf = lizard_heap_alloc_atomic(len + 1);
   if (len > 0) memcpy(buf, src, len);
   buf[len] = '\0';
   n->type = AST_STRING;
@@ -2679,7 +2804,6 @@ lizard_ast_node_t *lizard_primitive_proc_arity(lz_list_t *args,
   lizard_ast_list_node_t *node;
   lizard_ast_node_t *fn;
   lizard_ast_node_t *param_list;
-  lizard_ast_node_t *result;
   lz_list_node_t *p;
   long count;
   (void)env;
@@ -2708,10 +2832,7 @@ lizard_ast_node_t *lizard_primitive_proc_arity(lz_list_t *args,
   } else {
     return lizard_make_error(heap, LIZARD_ERROR_LAMBDA_PARAMS);
   }
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  result->type = AST_NUMBER;
-  mpz_init_set_si(result->data.number, count);
-  return result;
+  return lizard_make_fixnum(heap, count);
 }
 
 /* ---------------------------------------------------------------------
@@ -3411,18 +3532,13 @@ static lizard_ast_node_t *lz_inet_run(lz_list_t *args, lizard_heap_t *heap,
   if (want_cost) {
     mpz_clear(res);
     if (st < 0) return lizard_make_bool(heap, false);
-    out = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-    out->type = AST_NUMBER;
-    mpz_init_set_si(out->data.number, inter);
-    return out;
+    return lizard_make_fixnum(heap, inter);
   }
   if (st != 1) {
     mpz_clear(res);
     return lizard_make_bool(heap, false);
   }
-  out = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  out->type = AST_NUMBER;
-  mpz_init_set(out->data.number, res);
+  out = lizard_make_integer(heap, res);
   mpz_clear(res);
   return out;
 }
@@ -3475,14 +3591,14 @@ void lizard_install_primitives(lizard_heap_t *heap, lizard_env_t *env) {
   install_one(heap, env, "inet-normalize", lizard_primitive_inet_normalize);
   install_one(heap, env, "inet-cost",      lizard_primitive_inet_cost);
   install_one(heap, env, "inet-reduce",    lizard_primitive_inet_reduce);
-  install_one(heap, env, "null?",   lizard_primitive_nullp);
-  install_one(heap, env, "pair?",   lizard_primitive_pairp);
-  install_one(heap, env, "string?", lizard_primitive_stringp);
-  install_one(heap, env, "bool?",   lizard_primitive_boolp);
-  install_one(heap, env, "number?", lizard_primitive_numberp);
+  install_argv(heap, env, "null?",   lizard_primitive_nullp, lizard_primitive_nullp_argv);
+  install_argv(heap, env, "pair?",   lizard_primitive_pairp, lizard_primitive_pairp_argv);
+  install_argv(heap, env, "string?", lizard_primitive_stringp, lizard_primitive_stringp_argv);
+  install_argv(heap, env, "bool?",   lizard_primitive_boolp, lizard_primitive_boolp_argv);
+  install_argv(heap, env, "number?", lizard_primitive_numberp, lizard_primitive_numberp_argv);
   install_one(heap, env, "rational?", lizard_primitive_rationalp);
   install_one(heap, env, "real?",     lizard_primitive_realp);
-  install_one(heap, env, "integer?",  lizard_primitive_integerp);
+  install_argv(heap, env, "integer?",  lizard_primitive_integerp, lizard_primitive_integerp_argv);
   install_one(heap, env, "exact?",    lizard_primitive_exactp);
   install_one(heap, env, "inexact?",       lizard_primitive_inexactp);
   install_one(heap, env, "exact-integer?", lizard_primitive_exact_integerp);
@@ -3506,30 +3622,30 @@ void lizard_install_primitives(lizard_heap_t *heap, lizard_env_t *env) {
   install_one(heap, env, "round",    lizard_primitive_round);
   install_one(heap, env, "numerator", lizard_primitive_numerator);
   install_one(heap, env, "denominator", lizard_primitive_denominator);
-  install_one(heap, env, "symbol?", lizard_primitive_symbolp);
-  install_one(heap, env, "procedure?", lizard_primitive_procedurep);
-  install_one(heap, env, "+",       lizard_primitive_plus);
-  install_one(heap, env, "-",       lizard_primitive_minus);
-  install_one(heap, env, "*",       lizard_primitive_multiply);
-  install_one(heap, env, "/",       lizard_primitive_divide);
-  install_one(heap, env, "=",       lizard_primitive_equal);
+  install_argv(heap, env, "symbol?", lizard_primitive_symbolp, lizard_primitive_symbolp_argv);
+  install_argv(heap, env, "procedure?", lizard_primitive_procedurep, lizard_primitive_procedurep_argv);
+  install_argv(heap, env, "+",       lizard_primitive_plus, lizard_primitive_plus_argv);
+  install_argv(heap, env, "-",       lizard_primitive_minus, lizard_primitive_minus_argv);
+  install_argv(heap, env, "*",       lizard_primitive_multiply, lizard_primitive_multiply_argv);
+  install_argv(heap, env, "/",       lizard_primitive_divide, lizard_primitive_divide_argv);
+  install_argv(heap, env, "=",       lizard_primitive_equal, lizard_primitive_equal_argv);
   install_one(heap, env, "^",       lizard_primitive_pow);
-  install_one(heap, env, "%",       lizard_primitive_mod);
-  install_one(heap, env, "<",       lizard_primitive_lt);
-  install_one(heap, env, "<=",      lizard_primitive_le);
-  install_one(heap, env, ">",       lizard_primitive_gt);
-  install_one(heap, env, ">=",      lizard_primitive_ge);
-  install_one(heap, env, "cons",    lizard_primitive_cons);
-  install_one(heap, env, "car",     lizard_primitive_car);
-  install_one(heap, env, "cdr",     lizard_primitive_cdr);
-  install_one(heap, env, "list",    lizard_primitive_list);
+  install_argv(heap, env, "%",       lizard_primitive_mod, lizard_primitive_mod_argv);
+  install_argv(heap, env, "<",       lizard_primitive_lt, lizard_primitive_lt_argv);
+  install_argv(heap, env, "<=",      lizard_primitive_le, lizard_primitive_le_argv);
+  install_argv(heap, env, ">",       lizard_primitive_gt, lizard_primitive_gt_argv);
+  install_argv(heap, env, ">=",      lizard_primitive_ge, lizard_primitive_ge_argv);
+  install_argv(heap, env, "cons",    lizard_primitive_cons, lizard_primitive_cons_argv);
+  install_argv(heap, env, "car",     lizard_primitive_car, lizard_primitive_car_argv);
+  install_argv(heap, env, "cdr",     lizard_primitive_cdr, lizard_primitive_cdr_argv);
+  install_argv(heap, env, "list",    lizard_primitive_list, lizard_primitive_list_argv);
   install_one(heap, env, "eval",    lizard_primitive_eval);
   install_one(heap, env, "unquote", lizard_primitive_unquote);
   install_one(heap, env, "tokens",  lizard_primitive_tokens);
   install_one(heap, env, "ast",     lizard_primitive_ast);
   install_one(heap, env, "and",     lizard_primitive_and);
   install_one(heap, env, "or",      lizard_primitive_or);
-  install_one(heap, env, "not",     lizard_primitive_not);
+  install_argv(heap, env, "not",     lizard_primitive_not, lizard_primitive_not_argv);
   install_one(heap, env, "xor",     lizard_primitive_xor);
   install_one(heap, env, "nand",    lizard_primitive_nand);
   install_one(heap, env, "nor",     lizard_primitive_nor);
@@ -3545,6 +3661,7 @@ void lizard_install_primitives(lizard_heap_t *heap, lizard_env_t *env) {
   install_one(heap, env, "lz:import",           lizard_primitive_pct_import);
   install_one(heap, env, "module-loaded?",    lizard_primitive_module_loadedp);
   install_one(heap, env, "module-search-path",lizard_primitive_module_search_path);
+  install_one(heap, env, "compile-file",      lizard_primitive_compile_file);
   install_one(heap, env, "add-module-path!",  lizard_primitive_add_module_path);
   /* Phase D: GC. */
   install_one(heap, env, "gc-stats",          lizard_primitive_gc_stats);
@@ -3557,7 +3674,7 @@ void lizard_install_primitives(lizard_heap_t *heap, lizard_env_t *env) {
   install_one(heap, env, "profile",          lizard_primitive_profile);
   install_one(heap, env, "error-location",   lizard_primitive_error_location);
   /* List operations. */
-  install_one(heap, env, "length",           lizard_primitive_length);
+  install_argv(heap, env, "length",           lizard_primitive_length, lizard_primitive_length_argv);
   install_one(heap, env, "append",           lizard_primitive_append);
   install_one(heap, env, "reverse",          lizard_primitive_reverse);
   install_one(heap, env, "list?",            lizard_primitive_listp);
@@ -3640,7 +3757,7 @@ void lizard_install_primitives(lizard_heap_t *heap, lizard_env_t *env) {
   /* Exceptions — raise/try already registered below; guard is new. */
   install_one(heap, env, "guard",            lizard_primitive_guard);
   /* String operations. */
-  install_one(heap, env, "string-ref",       lizard_primitive_string_ref);
+  install_argv(heap, env, "string-ref",       lizard_primitive_string_ref, lizard_primitive_string_ref_argv);
   install_one(heap, env, "string-contains?", lizard_primitive_string_contains);
   install_one(heap, env, "string-upcase",    lizard_primitive_string_upcase);
   install_one(heap, env, "string-downcase",  lizard_primitive_string_downcase);
@@ -3662,16 +3779,16 @@ void lizard_install_primitives(lizard_heap_t *heap, lizard_env_t *env) {
   install_one(heap, env, "kernel-define",    lizard_primitive_kernel_define);
   install_one(heap, env, "kernel-lookup",    lizard_primitive_kernel_lookup);
   /* Core Scheme predicates + math. */
-  install_one(heap, env, "zero?",            lizard_primitive_zerop);
-  install_one(heap, env, "positive?",        lizard_primitive_positivep);
-  install_one(heap, env, "negative?",        lizard_primitive_negativep);
-  install_one(heap, env, "even?",            lizard_primitive_evenp);
-  install_one(heap, env, "odd?",             lizard_primitive_oddp);
-  install_one(heap, env, "min",              lizard_primitive_min);
-  install_one(heap, env, "max",              lizard_primitive_max);
+  install_argv(heap, env, "zero?",            lizard_primitive_zerop, lizard_primitive_zerop_argv);
+  install_argv(heap, env, "positive?",        lizard_primitive_positivep, lizard_primitive_positivep_argv);
+  install_argv(heap, env, "negative?",        lizard_primitive_negativep, lizard_primitive_negativep_argv);
+  install_argv(heap, env, "even?",            lizard_primitive_evenp, lizard_primitive_evenp_argv);
+  install_argv(heap, env, "odd?",             lizard_primitive_oddp, lizard_primitive_oddp_argv);
+  install_argv(heap, env, "min",              lizard_primitive_min, lizard_primitive_min_argv);
+  install_argv(heap, env, "max",              lizard_primitive_max, lizard_primitive_max_argv);
   /* Character + string conversion. */
-  install_one(heap, env, "char->integer",    lizard_primitive_char_to_int);
-  install_one(heap, env, "integer->char",    lizard_primitive_int_to_char);
+  install_argv(heap, env, "char->integer",    lizard_primitive_char_to_int, lizard_primitive_char_to_int_argv);
+  install_argv(heap, env, "integer->char",    lizard_primitive_int_to_char, lizard_primitive_int_to_char_argv);
   install_one(heap, env, "string->list",     lizard_primitive_string_to_list);
   install_one(heap, env, "list->string",     lizard_primitive_list_to_string);
   install_one(heap, env, "string-reverse",   lizard_primitive_string_reverse);
@@ -3679,14 +3796,14 @@ void lizard_install_primitives(lizard_heap_t *heap, lizard_env_t *env) {
   install_one(heap, env, "transient!",       lizard_primitive_transient);
   install_one(heap, env, "conj!",            lizard_primitive_conj_mut);
   install_one(heap, env, "persistent!",      lizard_primitive_persistent);
-  install_one(heap, env, "arithmetic-shift", lizard_primitive_arith_shift);
+  install_argv(heap, env, "arithmetic-shift", lizard_primitive_arith_shift, lizard_primitive_arith_shift_argv);
   install_one(heap, env, "expt",            lizard_primitive_expt);
-  install_one(heap, env, "gcd",             lizard_primitive_gcd);
-  install_one(heap, env, "lcm",             lizard_primitive_lcm);
-  install_one(heap, env, "quotient",        lizard_primitive_quotient);
-  install_one(heap, env, "remainder",       lizard_primitive_remainder);
-  install_one(heap, env, "abs",             lizard_primitive_abs);
-  install_one(heap, env, "square",          lizard_primitive_square);
+  install_argv(heap, env, "gcd",             lizard_primitive_gcd, lizard_primitive_gcd_argv);
+  install_argv(heap, env, "lcm",             lizard_primitive_lcm, lizard_primitive_lcm_argv);
+  install_argv(heap, env, "quotient",        lizard_primitive_quotient, lizard_primitive_quotient_argv);
+  install_argv(heap, env, "remainder",       lizard_primitive_remainder, lizard_primitive_remainder_argv);
+  install_argv(heap, env, "abs",             lizard_primitive_abs, lizard_primitive_abs_argv);
+  install_argv(heap, env, "square",          lizard_primitive_square, lizard_primitive_square_argv);
   install_one(heap, env, "modular-expt",    lizard_primitive_modexpt);
   /* Reflection. */
   install_one(heap, env, "type-of",         lizard_primitive_type_of);
@@ -3694,10 +3811,10 @@ void lizard_install_primitives(lizard_heap_t *heap, lizard_env_t *env) {
   install_one(heap, env, "defined?",        lizard_primitive_definedp);
   install_one(heap, env, "procedure-arity", lizard_primitive_proc_arity);
   /* String ops. */
-  install_one(heap, env, "string-length",   lizard_primitive_str_length);
+  install_argv(heap, env, "string-length",   lizard_primitive_str_length, lizard_primitive_str_length_argv);
   install_one(heap, env, "string-append",   lizard_primitive_str_append);
   install_one(heap, env, "substring",       lizard_primitive_substring);
-  install_one(heap, env, "string=?",        lizard_primitive_str_eq);
+  install_argv(heap, env, "string=?",        lizard_primitive_str_eq, lizard_primitive_str_eq_argv);
   install_one(heap, env, "number->string",  lizard_primitive_num_to_str);
   install_one(heap, env, "string->number",  lizard_primitive_str_to_num);
   install_one(heap, env, "symbol->string",  lizard_primitive_sym_to_str);
@@ -3710,19 +3827,19 @@ void lizard_install_primitives(lizard_heap_t *heap, lizard_env_t *env) {
   install_one(heap, env, "gensym",          lizard_primitive_gensym);
   /* Vectors. */
   install_one(heap, env, "make-vector",     lizard_primitive_make_vector);
-  install_one(heap, env, "vector",          lizard_primitive_vector);
-  install_one(heap, env, "vector?",         lizard_primitive_vectorp);
-  install_one(heap, env, "vector-length",   lizard_primitive_vec_length);
-  install_one(heap, env, "vector-ref",      lizard_primitive_vec_ref);
-  install_one(heap, env, "vector-set!",     lizard_primitive_vec_set);
+  install_argv(heap, env, "vector",          lizard_primitive_vector, lizard_primitive_vector_argv);
+  install_argv(heap, env, "vector?",         lizard_primitive_vectorp, lizard_primitive_vectorp_argv);
+  install_argv(heap, env, "vector-length",   lizard_primitive_vec_length, lizard_primitive_vec_length_argv);
+  install_argv(heap, env, "vector-ref",      lizard_primitive_vec_ref, lizard_primitive_vec_ref_argv);
+  install_argv(heap, env, "vector-set!",     lizard_primitive_vec_set, lizard_primitive_vec_set_argv);
   install_one(heap, env, "vector->list",    lizard_primitive_vec_to_list);
   install_one(heap, env, "list->vector",    lizard_primitive_list_to_vec);
   /* Hash tables. */
   install_one(heap, env, "make-hash-table", lizard_primitive_make_hash);
-  install_one(heap, env, "hash?",           lizard_primitive_hashp);
-  install_one(heap, env, "hash-set!",       lizard_primitive_hash_set);
-  install_one(heap, env, "hash-ref",        lizard_primitive_hash_ref);
-  install_one(heap, env, "hash-has-key?",   lizard_primitive_hash_has);
+  install_argv(heap, env, "hash?",           lizard_primitive_hashp, lizard_primitive_hashp_argv);
+  install_argv(heap, env, "hash-set!",       lizard_primitive_hash_set, lizard_primitive_hash_set_argv);
+  install_argv(heap, env, "hash-ref",        lizard_primitive_hash_ref, lizard_primitive_hash_ref_argv);
+  install_argv(heap, env, "hash-has-key?",   lizard_primitive_hash_has, lizard_primitive_hash_has_argv);
   install_one(heap, env, "hash-size",       lizard_primitive_hash_size);
   install_one(heap, env, "hash-keys",       lizard_primitive_hash_keys);
   install_one(heap, env, "hash-remove!",    lizard_primitive_hash_remove);
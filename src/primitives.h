@@ -45,6 +45,12 @@ lizard_ast_node_t *lizard_primitive_callcc(
     lz_list_t *args, lizard_env_t *env, lizard_heap_t *heap,
     lizard_ast_node_t *(*current_cont)(lizard_ast_node_t *, lizard_env_t *,
                                        lizard_heap_t *));
+/* Escape to the call/cc that captured continuation `k`, which returns
+ * `value`.  Returns only when that call/cc has already returned. */
+void lizard_continuation_escape(lizard_ast_node_t *k, lizard_ast_node_t *value,
+                                lizard_heap_t *heap);
+/* A fresh escape id for a call/cc, shared by the evaluator and the VM. */
+unsigned long lizard_escape_next_id(lizard_heap_t *heap);
 lizard_ast_node_t *lizard_identity_cont(lizard_ast_node_t *result,
                                         lizard_env_t *env, lizard_heap_t *heap);
 int lizard_is_false(lizard_ast_node_t *node);
@@ -86,6 +92,9 @@ lizard_ast_node_t *lizard_primitive_import(lz_list_t *args, lizard_env_t *env,
 lizard_ast_node_t *lizard_primitive_module_loadedp(lz_list_t *args,
                                                     lizard_env_t *env,
                                                     lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_compile_file(lz_list_t *args,
+                                                 lizard_env_t *env,
+                                                 lizard_heap_t *heap);
 lizard_ast_node_t *lizard_primitive_module_search_path(lz_list_t *args,
                                                         lizard_env_t *env,
                                                         lizard_heap_t *heap);
@@ -1051,4 +1060,133 @@ lizard_ast_node_t *lizard_primitive_tt_system_next(lz_list_t *, lizard_env_t *,
 lizard_ast_node_t *lizard_tt_system_lookup(lizard_ast_node_t *system, lizard_ast_node_t *phi);
 lizard_ast_node_t *lizard_primitive_tt_system_lookup(lz_list_t *, lizard_env_t *, lizard_heap_t *);
 
+/* (argc, argv) entries of the primitives the evaluator and VM call most.
+ * Each has a list-convention twin of the same name without the suffix. */
+lizard_ast_node_t *lizard_primitive_plus_argv(int argc, lizard_ast_node_t **argv,
+                                              lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_minus_argv(int argc, lizard_ast_node_t **argv,
+                                               lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_multiply_argv(int argc, lizard_ast_node_t **argv,
+                                                  lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_divide_argv(int argc, lizard_ast_node_t **argv,
+                                                lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_equal_argv(int argc, lizard_ast_node_t **argv,
+                                               lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_lt_argv(int argc, lizard_ast_node_t **argv,
+                                            lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_le_argv(int argc, lizard_ast_node_t **argv,
+                                            lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_gt_argv(int argc, lizard_ast_node_t **argv,
+                                            lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_ge_argv(int argc, lizard_ast_node_t **argv,
+                                            lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_mod_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_cons_argv(int argc, lizard_ast_node_t **argv,
+                                              lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_car_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_cdr_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_nullp_argv(int argc, lizard_ast_node_t **argv,
+                                               lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_pairp_argv(int argc, lizard_ast_node_t **argv,
+                                               lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_boolp_argv(int argc, lizard_ast_node_t **argv,
+                                               lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_numberp_argv(int argc, lizard_ast_node_t **argv,
+                                                 lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_integerp_argv(int argc, lizard_ast_node_t **argv,
+                                                  lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_symbolp_argv(int argc, lizard_ast_node_t **argv,
+                                                 lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_procedurep_argv(int argc, lizard_ast_node_t **argv,
+                                                    lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_not_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_zerop_argv(int argc, lizard_ast_node_t **argv,
+                                               lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_positivep_argv(int argc, lizard_ast_node_t **argv,
+                                                   lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_negativep_argv(int argc, lizard_ast_node_t **argv,
+                                                   lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_evenp_argv(int argc, lizard_ast_node_t **argv,
+                                               lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_oddp_argv(int argc, lizard_ast_node_t **argv,
+                                              lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_min_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_max_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_int_to_char_argv(int argc, lizard_ast_node_t **argv,
+                                                     lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_arith_shift_argv(int argc, lizard_ast_node_t **argv,
+                                                     lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_gcd_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_lcm_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_quotient_argv(int argc, lizard_ast_node_t **argv,
+                                                  lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_remainder_argv(int argc, lizard_ast_node_t **argv,
+                                                   lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_abs_argv(int argc, lizard_ast_node_t **argv,
+                                             lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_square_argv(int argc, lizard_ast_node_t **argv,
+                                                lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_vector_argv(int argc, lizard_ast_node_t **argv,
+                                                lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_vectorp_argv(int argc, lizard_ast_node_t **argv,
+                                                 lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_vec_length_argv(int argc, lizard_ast_node_t **argv,
+                                                    lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_vec_ref_argv(int argc, lizard_ast_node_t **argv,
+                                                 lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_vec_set_argv(int argc, lizard_ast_node_t **argv,
+                                                 lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_hashp_argv(int argc, lizard_ast_node_t **argv,
+                                               lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_hash_set_argv(int argc, lizard_ast_node_t **argv,
+                                                  lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_hash_ref_argv(int argc, lizard_ast_node_t **argv,
+                                                  lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_hash_has_argv(int argc, lizard_ast_node_t **argv,
+                                                  lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_list_argv(int argc, lizard_ast_node_t **argv,
+                                              lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_length_argv(int argc, lizard_ast_node_t **argv,
+                                                lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_stringp_argv(int argc, lizard_ast_node_t **argv,
+                                                 lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_string_ref_argv(int argc, lizard_ast_node_t **argv,
+                                                    lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_char_to_int_argv(int argc, lizard_ast_node_t **argv,
+                                                     lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_str_length_argv(int argc, lizard_ast_node_t **argv,
+                                                    lizard_env_t *env, lizard_heap_t *heap);
+lizard_ast_node_t *lizard_primitive_str_eq_argv(int argc, lizard_ast_node_t **argv,
+                                                lizard_env_t *env, lizard_heap_t *heap);
+
+/* Call primitive node `prim` on `argc` forced arguments, through its argv
+ * entry when it has one and by building the argument list otherwise. */
+lizard_ast_node_t *lizard_primitive_call(lizard_ast_node_t *prim, int argc,
+                                         lizard_ast_node_t **argv,
+                                         lizard_env_t *env,
+                                         lizard_heap_t *heap);
+
+/* Adapter in the other direction: flatten `args` into a buffer (on the C
+ * stack up to LIZARD_PRIMITIVE_ARGV_MAX arguments) and call `fn`. */
+#define LIZARD_PRIMITIVE_ARGV_MAX 8
+lizard_ast_node_t *lizard_primitive_call_list(lizard_primitive_argv_func_t fn,
+                                              lz_list_t *args,
+                                              lizard_env_t *env,
+                                              lizard_heap_t *heap);
+
+/* Define the list-convention entry `name` in terms of `name##_argv`. */
+#define LIZARD_PRIMITIVE_LIST_ENTRY(name)                                      \
+  lizard_ast_node_t *name(lz_list_t *args, lizard_env_t *env,                  \
+                          lizard_heap_t *heap) {                               \
+    return lizard_primitive_call_list(name##_argv, args, env, heap);           \
+  }
+
 #endif /* LIZARD_PRIMITIVES_H */
@@ -5,6 +5,7 @@
 #include "errors.h"
 #include "lizard_internal.h"
 #include "mem.h"
+#include "optimize.h"
 #include "parser.h"
 #include "printer.h"
 #include "runtime.h"
@@ -21,7 +22,7 @@ static const char *opcode_name(lizard_opcode_t op) {
   case OP_NIL: return "NIL";
   case OP_TRUE: return "TRUE";
   case OP_FALSE: return "FALSE";
-  case OP_LOAD: return "LOAD";
+  case OP_LOAD_GLOBAL: return "LOADG";
   case OP_STORE: return "STORE";
   case OP_SET: return "SET";
   case OP_POP: return "POP";
@@ -46,9 +47,44 @@ static const char *opcode_name(lizard_opcode_t op) {
   case OP_DISPLAY: return "DISPLAY";
   case OP_NEWLINE: return "NEWLINE";
   case OP_HALT: return "HALT";
+  case OP_LOAD_LOCAL: return "LOADL";
+  case OP_STORE_LOCAL: return "STOREL";
+  case OP_LOAD_UPVAL: return "LOADU";
+  case OP_BOX: return "BOX";
+  case OP_UNBOX: return "UNBOX";
+  case OP_SET_BOX: return "SETBOX";
+  case OP_ADD_IMM: return "ADDI";
+  case OP_JUMP_UNLESS_EQ: return "JNEQ";
+  case OP_JUMP_UNLESS_LT: return "JNLT";
+  case OP_JUMP_UNLESS_GT: return "JNGT";
+  case OP_JUMP_IF_FALSE_OR_POP: return "JIFOP";
+  case OP_JUMP_IF_TRUE_OR_POP: return "JITOP";
+  case OP_VECTOR_REF: return "VREF";
+  case OP_VECTOR_SET: return "VSET";
+  case OP_VECTOR_LENGTH: return "VLEN";
+  case OP_STRING_REF: return "SREF";
+  case OP_STRING_LENGTH: return "SLEN";
+  case OP_CALLCC: return "CALLCC";
+  case OP_JUMP_IF_TRUE: return "JIT";
+  case OP_RETURN_LOCAL: return "RETL";
+  case OP_LOAD_UPVAL_UNBOX: return "LOADUB";
+  case OP_STORE_LOCAL_POP: return "STORELP";
+  case OP_LOAD_LOCAL2: return "LOADL2";
+  case OP_LOAD_LOCAL_ADD_IMM: return "LOADLAI";
+  case OP_CALL_PRIM: return "CALLP";
   }
   return "???";
 }
+/* The program a VM primitive runs for its argument: a quoted list is read
+ * back as code, then macros are expanded and the result optimized, as the
+ * REPL does before evaluating. */
+static lizard_ast_node_t *vm_program(lizard_ast_node_t *expr, lizard_env_t *env,
+                                     lizard_heap_t *heap) {
+  if (expr->type == AST_PAIR) {
+    expr = lizard_reparse_datum(expr, heap);
+  }
+  return lizard_optimize(lizard_expand_macros(expr, env, heap), env, heap);
+}
 lizard_ast_node_t *lizard_primitive_vm_eval(lz_list_t *args,
                                              lizard_env_t *env,
                                              lizard_heap_t *heap) {
@@ -65,9 +101,11 @@ lizard_ast_node_t *lizard_primitive_vm_eval(lz_list_t *args,
       expr->type <= AST_TT_EXTENSION) {
     return lizard_make_error(heap, LIZARD_ERROR_USER);
   }
+  expr = vm_program(expr, env, heap);
   chunk = lizard_compile(expr, heap);
   if (chunk == NULL) {
-    return lizard_make_error(heap, LIZARD_ERROR_USER);
+    /* A form the compiler does not cover. */
+    return lizard_eval(expr, env, heap, lizard_identity_cont);
   }
   return lizard_vm_exec(chunk, env, heap);
 }
@@ -77,12 +115,11 @@ lizard_ast_node_t *lizard_primitive_disassemble(lz_list_t *args,
   lizard_ast_node_t *expr;
   lizard_bc_chunk_t *chunk;
   int i;
-  (void)env;
   if (!single_arg(args)) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
   expr = ((lizard_ast_list_node_t *)args->head)->ast;
-  chunk = lizard_compile(expr, heap);
+  chunk = lizard_compile(vm_program(expr, env, heap), heap);
   if (chunk == NULL) {
     return lizard_make_error(heap, LIZARD_ERROR_USER);
   }
@@ -93,8 +130,9 @@ lizard_ast_node_t *lizard_primitive_disassemble(lz_list_t *args,
            chunk->code[i].arg);
     /* Show constant value for CONST/LOAD/STORE instructions. */
     if ((chunk->code[i].op == OP_CONST ||
-         chunk->code[i].op == OP_LOAD ||
-         chunk->code[i].op == OP_STORE) &&
+         chunk->code[i].op == OP_LOAD_GLOBAL ||
+         chunk->code[i].op == OP_STORE ||
+         chunk->code[i].op == OP_CALL_PRIM) &&
         chunk->code[i].arg < chunk->const_count) {
       printf("  ; ");
       lizard_fprint_value(stdout, chunk->constants[chunk->code[i].arg]);
@@ -116,7 +154,7 @@ lizard_ast_node_t *lizard_primitive_vm_time(lz_list_t *args,
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
   expr = ((lizard_ast_list_node_t *)args->head)->ast;
-  chunk = lizard_compile(expr, heap);
+  chunk = lizard_compile(vm_program(expr, env, heap), heap);
   if (chunk == NULL) {
     return lizard_make_error(heap, LIZARD_ERROR_USER);
   }
@@ -145,20 +183,55 @@ lizard_ast_node_t *lizard_primitive_time_eval(lz_list_t *args,
   printf("; time-eval: %.6f s\n", elapsed);
   return result;
 }
+/* The `n` most frequent adjacent opcode pairs in `prof`, most frequent
+ * first. */
+static void print_top_pairs(const lizard_vm_profile_t *prof, int n) {
+  static unsigned char shown[LIZARD_OPCODE_COUNT][LIZARD_OPCODE_COUNT];
+  int i;
+  memset(shown, 0, sizeof(shown));
+  for (i = 0; i < n; i++) {
+    size_t best = 0;
+    int a, b, ba = 0, bb = 0;
+    for (a = 0; a < LIZARD_OPCODE_COUNT; a++) {
+      for (b = 0; b < LIZARD_OPCODE_COUNT; b++) {
+        if (!shown[a][b] && prof->pair_counts[a][b] > best) {
+          best = prof->pair_counts[a][b];
+          ba = a;
+          bb = b;
+        }
+      }
+    }
+    if (best == 0) break;
+    shown[ba][bb] = 1;
+    printf("    %-8s %-8s %lu\n", opcode_name((lizard_opcode_t)ba),
+           opcode_name((lizard_opcode_t)bb), (unsigned long)best);
+  }
+}
+/* (profile expr [path]): run expr on the VM and print where it went; with
+ * a path, also write the collapsed stacks there, for a flame graph. */
 lizard_ast_node_t *lizard_primitive_profile(lz_list_t *args,
                                              lizard_env_t *env,
                                              lizard_heap_t *heap) {
   lizard_ast_node_t *expr;
+  lizard_ast_node_t *path = NULL;
   lizard_ast_node_t *result;
   lizard_bc_chunk_t *chunk;
   lizard_vm_profile_t prof;
   clock_t start, end;
+  FILE *out;
   int i;
-  if (!single_arg(args)) {
+  if (args->head == args->nil ||
+      (args->head->next != args->nil && args->head->next->next != args->nil)) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
   expr = ((lizard_ast_list_node_t *)args->head)->ast;
-  chunk = lizard_compile(expr, heap);
+  if (args->head->next != args->nil) {
+    path = ((lizard_ast_list_node_t *)args->head->next)->ast;
+    if (path->type != AST_STRING) {
+      return lizard_make_error(heap, LIZARD_ERROR_LOAD_ARGT);
+    }
+  }
+  chunk = lizard_compile(vm_program(expr, env, heap), heap);
   if (chunk == NULL) {
     return lizard_make_error(heap, LIZARD_ERROR_USER);
   }
@@ -184,6 +257,20 @@ lizard_ast_node_t *lizard_primitive_profile(lz_list_t *args,
              (unsigned long)prof.opcode_counts[i]);
     }
   }
+  printf("  top pairs:\n");
+  print_top_pairs(&prof, 10);
+  printf("  functions:\n");
+  lizard_vm_profile_report(stdout, &prof, 20);
   printf("---\n");
+  if (path != NULL) {
+    out = fopen(path->data.string, "w");
+    if (out == NULL) {
+      result = lizard_make_error(heap, LIZARD_ERROR_LOAD_WRITE);
+    } else if ((lizard_vm_profile_write_collapsed(out, &prof) < 0) |
+               (fclose(out) != 0)) {
+      result = lizard_make_error(heap, LIZARD_ERROR_LOAD_WRITE);
+    }
+  }
+  lizard_vm_profile_free(&prof);
   return result;
 }
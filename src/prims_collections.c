@@ -3,6 +3,7 @@
 #include "primitives.h"
 #include "env.h"
 #include "errors.h"
+#include "gc.h"
 #include "lizard_internal.h"
 #include "mem.h"
 #include "parser.h"
@@ -36,60 +37,61 @@ lizard_ast_node_t *lizard_primitive_make_vector(lz_list_t *args,
              : lizard_make_nil(heap);
   return make_vector(heap, (size_t)n, fill);
 }
-lizard_ast_node_t *lizard_primitive_vector(lz_list_t *args, lizard_env_t *env,
-                                           lizard_heap_t *heap) {
-  size_t n;
-  lz_list_node_t *iter;
+lizard_ast_node_t *lizard_primitive_vector_argv(int argc,
+                                                lizard_ast_node_t **argv,
+                                                lizard_env_t *env,
+                                                lizard_heap_t *heap) {
   lizard_ast_node_t *v;
-  size_t i;
+  int i;
   (void)env;
-  n = 0;
-  for (iter = args->head; iter != args->nil; iter = iter->next) n++;
-  v = make_vector(heap, n, lizard_make_nil(heap));
-  i = 0;
-  for (iter = args->head; iter != args->nil; iter = iter->next) {
-    v->data.vector.elements[i++] = ((lizard_ast_list_node_t *)iter)->ast;
+  v = make_vector(heap, (size_t)argc, lizard_make_nil(heap));
+  for (i = 0; i < argc; i++) {
+    v->data.vector.elements[i] = argv[i];
   }
   return v;
 }
-lizard_ast_node_t *lizard_primitive_vectorp(lz_list_t *args, lizard_env_t *env,
-                                            lizard_heap_t *heap) {
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_vector)
+lizard_ast_node_t *lizard_primitive_vectorp_argv(int argc,
+                                                 lizard_ast_node_t **argv,
+                                                 lizard_env_t *env,
+                                                 lizard_heap_t *heap) {
   lizard_ast_node_t *x;
   (void)env;
-  if (args->head == args->nil || args->head->next != args->nil) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  x = ((lizard_ast_list_node_t *)args->head)->ast;
+  x = argv[0];
   return lizard_make_bool(heap, x && x->type == AST_VECTOR);
 }
-lizard_ast_node_t *lizard_primitive_vec_length(lz_list_t *args,
-                                               lizard_env_t *env,
-                                               lizard_heap_t *heap) {
-  lizard_ast_node_t *v, *r;
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_vectorp)
+lizard_ast_node_t *lizard_primitive_vec_length_argv(int argc,
+                                                    lizard_ast_node_t **argv,
+                                                    lizard_env_t *env,
+                                                    lizard_heap_t *heap) {
+  lizard_ast_node_t *v;
   (void)env;
-  if (args->head == args->nil || args->head->next != args->nil) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  v = ((lizard_ast_list_node_t *)args->head)->ast;
+  v = argv[0];
   if (v->type != AST_VECTOR) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  r->type = AST_NUMBER;
-  mpz_init_set_ui(r->data.number, (unsigned long)v->data.vector.size);
-  return r;
+  return lizard_make_fixnum(heap, (long)v->data.vector.size);
 }
-lizard_ast_node_t *lizard_primitive_vec_ref(lz_list_t *args, lizard_env_t *env,
-                                            lizard_heap_t *heap) {
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_vec_length)
+lizard_ast_node_t *lizard_primitive_vec_ref_argv(int argc,
+                                                 lizard_ast_node_t **argv,
+                                                 lizard_env_t *env,
+                                                 lizard_heap_t *heap) {
   lizard_ast_node_t *v, *idx;
   long i;
   (void)env;
-  if (args->head == args->nil || args->head->next == args->nil ||
-      args->head->next->next != args->nil) {
+  if (argc != 2) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  v = ((lizard_ast_list_node_t *)args->head)->ast;
-  idx = ((lizard_ast_list_node_t *)args->head->next)->ast;
+  v = argv[0];
+  idx = argv[1];
   if (v->type != AST_VECTOR || idx->type != AST_NUMBER) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
@@ -99,19 +101,20 @@ lizard_ast_node_t *lizard_primitive_vec_ref(lz_list_t *args, lizard_env_t *env,
   }
   return v->data.vector.elements[i];
 }
-lizard_ast_node_t *lizard_primitive_vec_set(lz_list_t *args, lizard_env_t *env,
-                                            lizard_heap_t *heap) {
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_vec_ref)
+lizard_ast_node_t *lizard_primitive_vec_set_argv(int argc,
+                                                 lizard_ast_node_t **argv,
+                                                 lizard_env_t *env,
+                                                 lizard_heap_t *heap) {
   lizard_ast_node_t *v, *idx, *val;
   long i;
   (void)env;
-  if (args->head == args->nil || args->head->next == args->nil ||
-      args->head->next->next == args->nil ||
-      args->head->next->next->next != args->nil) {
+  if (argc != 3) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  v = ((lizard_ast_list_node_t *)args->head)->ast;
-  idx = ((lizard_ast_list_node_t *)args->head->next)->ast;
-  val = ((lizard_ast_list_node_t *)args->head->next->next)->ast;
+  v = argv[0];
+  idx = argv[1];
+  val = argv[2];
   if (v->type != AST_VECTOR || idx->type != AST_NUMBER) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
@@ -120,8 +123,10 @@ lizard_ast_node_t *lizard_primitive_vec_set(lz_list_t *args, lizard_env_t *env,
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
   v->data.vector.elements[i] = val;
+  lizard_gc_write_barrier(&v->data.vector.elements[i]);
   return lizard_make_nil(heap);
 }
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_vec_set)
 lizard_ast_node_t *lizard_primitive_vec_to_list(lz_list_t *args,
                                                 lizard_env_t *env,
                                                 lizard_heap_t *heap) {
@@ -150,7 +155,11 @@ static unsigned long lizard_hash_value(lizard_ast_node_t *k) {
   const char *s;
   switch (k->type) {
   case AST_NUMBER:
-    /* mpz hashed by mod-2^64 of its first limb. */
+    /* mpz hashed by mod-2^64 of its first limb; a fixnum keeps |n| in the
+     * same limb, so both forms of a value hash alike. */
+    if (LIZARD_IS_FIXNUM(k)) {
+      return (unsigned long)k->data.fixnum.limb * 2654435761UL;
+    }
     return mpz_get_ui(k->data.number) * 2654435761UL;
   case AST_RATIONAL:
     return (mpz_get_ui(mpq_numref(k->data.rational)) * 2654435761UL) ^
@@ -182,7 +191,10 @@ static unsigned long lizard_hash_value(lizard_ast_node_t *k) {
 static int lizard_keys_eq(lizard_ast_node_t *a, lizard_ast_node_t *b) {
   if (!a || !b || a->type != b->type) return 0;
   switch (a->type) {
-  case AST_NUMBER: return mpz_cmp(a->data.number, b->data.number) == 0;
+  case AST_NUMBER:
+    if (LIZARD_IS_FIXNUM(a) && LIZARD_IS_FIXNUM(b))
+      return LIZARD_FIXNUM_VALUE(a) == LIZARD_FIXNUM_VALUE(b);
+    return mpz_cmp(a->data.number, b->data.number) == 0;
   case AST_RATIONAL: return mpq_cmp(a->data.rational, b->data.rational) == 0;
   case AST_STRING: return strcmp(a->data.string, b->data.string) == 0;
   case AST_SYMBOL: return strcmp(a->data.variable, b->data.variable) == 0;
@@ -214,6 +226,8 @@ static void hash_grow(lizard_heap_t *heap, lizard_ast_node_t *h) {
       h->data.hash.values[idx] = old_v[i];
     }
   }
+  lizard_gc_write_barrier(&h->data.hash.keys);
+  lizard_gc_write_barrier(&h->data.hash.values);
 }
 lizard_ast_node_t *lizard_primitive_make_hash(lz_list_t *args,
                                               lizard_env_t *env,
@@ -236,16 +250,19 @@ lizard_ast_node_t *lizard_primitive_make_hash(lz_list_t *args,
   }
   return h;
 }
-lizard_ast_node_t *lizard_primitive_hashp(lz_list_t *args, lizard_env_t *env,
-                                          lizard_heap_t *heap) {
+lizard_ast_node_t *lizard_primitive_hashp_argv(int argc,
+                                               lizard_ast_node_t **argv,
+                                               lizard_env_t *env,
+                                               lizard_heap_t *heap) {
   lizard_ast_node_t *x;
   (void)env;
-  if (args->head == args->nil || args->head->next != args->nil) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  x = ((lizard_ast_list_node_t *)args->head)->ast;
+  x = argv[0];
   return lizard_make_bool(heap, x && x->type == AST_HASH);
 }
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_hashp)
 static size_t hash_find_slot(lizard_ast_node_t *h, lizard_ast_node_t *k,
                              int *found) {
   size_t idx = lizard_hash_value(k) & (h->data.hash.cap - 1);
@@ -259,20 +276,20 @@ static size_t hash_find_slot(lizard_ast_node_t *h, lizard_ast_node_t *k,
   *found = 0;
   return idx;
 }
-lizard_ast_node_t *lizard_primitive_hash_set(lz_list_t *args, lizard_env_t *env,
-                                             lizard_heap_t *heap) {
+lizard_ast_node_t *lizard_primitive_hash_set_argv(int argc,
+                                                  lizard_ast_node_t **argv,
+                                                  lizard_env_t *env,
+                                                  lizard_heap_t *heap) {
   lizard_ast_node_t *h, *k, *v;
   size_t idx;
   int found;
   (void)env;
-  if (args->head == args->nil || args->head->next == args->nil ||
-      args->head->next->next == args->nil ||
-      args->head->next->next->next != args->nil) {
+  if (argc != 3) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  h = ((lizard_ast_list_node_t *)args->head)->ast;
-  k = ((lizard_ast_list_node_t *)args->head->next)->ast;
-  v = ((lizard_ast_list_node_t *)args->head->next->next)->ast;
+  h = argv[0];
+  k = argv[1];
+  v = argv[2];
   if (h->type != AST_HASH) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
@@ -284,48 +301,56 @@ lizard_ast_node_t *lizard_primitive_hash_set(lz_list_t *args, lizard_env_t *env,
   if (!found) {
     h->data.hash.size++;
     h->data.hash.keys[idx] = k;
+    lizard_gc_write_barrier(&h->data.hash.keys[idx]);
   }
   h->data.hash.values[idx] = v;
+  lizard_gc_write_barrier(&h->data.hash.values[idx]);
   return lizard_make_nil(heap);
 }
-lizard_ast_node_t *lizard_primitive_hash_ref(lz_list_t *args, lizard_env_t *env,
-                                             lizard_heap_t *heap) {
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_hash_set)
+lizard_ast_node_t *lizard_primitive_hash_ref_argv(int argc,
+                                                  lizard_ast_node_t **argv,
+                                                  lizard_env_t *env,
+                                                  lizard_heap_t *heap) {
   lizard_ast_node_t *h, *k, *deflt;
   size_t idx;
   int found;
   (void)env;
-  if (args->head == args->nil || args->head->next == args->nil) {
+  if (argc < 2) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  h = ((lizard_ast_list_node_t *)args->head)->ast;
-  k = ((lizard_ast_list_node_t *)args->head->next)->ast;
+  h = argv[0];
+  k = argv[1];
   if (h->type != AST_HASH) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
-  deflt = (args->head->next->next != args->nil)
-              ? ((lizard_ast_list_node_t *)args->head->next->next)->ast
+  deflt = (argc > 2)
+              ? argv[2]
               : lizard_make_bool(heap, false);
   idx = hash_find_slot(h, k, &found);
   if (found) return h->data.hash.values[idx];
   return deflt;
 }
-lizard_ast_node_t *lizard_primitive_hash_has(lz_list_t *args, lizard_env_t *env,
-                                             lizard_heap_t *heap) {
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_hash_ref)
+lizard_ast_node_t *lizard_primitive_hash_has_argv(int argc,
+                                                  lizard_ast_node_t **argv,
+                                                  lizard_env_t *env,
+                                                  lizard_heap_t *heap) {
   lizard_ast_node_t *h, *k;
   int found;
   (void)env;
-  if (args->head == args->nil || args->head->next == args->nil ||
-      args->head->next->next != args->nil) {
+  if (argc != 2) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  h = ((lizard_ast_list_node_t *)args->head)->ast;
-  k = ((lizard_ast_list_node_t *)args->head->next)->ast;
+  h = argv[0];
+  k = argv[1];
   if (h->type != AST_HASH) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
   hash_find_slot(h, k, &found);
   return lizard_make_bool(heap, found ? true : false);
 }
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_hash_has)
 lizard_ast_node_t *lizard_primitive_hash_size(lz_list_t *args,
                                               lizard_env_t *env,
                                               lizard_heap_t *heap) {
@@ -338,9 +363,10 @@ lizard_ast_node_t *lizard_primitive_hash_size(lz_list_t *args,
   if (h->type != AST_HASH) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  r = lizard_make_number_node(heap);
   r->type = AST_NUMBER;
   mpz_init_set_ui(r->data.number, (unsigned long)h->data.hash.size);
+  lizard_number_normalize(r);
   return r;
 }
 lizard_ast_node_t *lizard_primitive_hash_keys(lz_list_t *args,
@@ -44,12 +44,13 @@ lizard_ast_node_t *lizard_prim_make_stat(lizard_heap_t *heap,
   lizard_ast_node_t *v;
   lizard_ast_node_t *p;
   k = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  v = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  v = lizard_make_number_node(heap);
   p = lizard_heap_alloc(sizeof(lizard_ast_node_t));
   k->type = AST_SYMBOL;
   k->data.variable = key;
   v->type = AST_NUMBER;
   mpz_init_set_ui(v->data.number, val);
+  lizard_number_normalize(v);
   p->type = AST_PAIR;
   p->data.pair.car = k;
   p->data.pair.cdr = v;
@@ -38,20 +38,41 @@ lizard_ast_node_t *lizard_primitive_gc(lz_list_t *args,
                                         lizard_heap_t *heap) {
   lizard_gc_stats_t before, after;
   size_t freed_bytes;
-  lizard_ast_node_t *result;
-  (void)args;
+  lizard_ast_node_t *result, *mode = NULL;
+  int full;
+
+  /* (gc) collects the young generation, or everything when that is due;
+   * (gc 'full) and (gc 'minor) say which. */
+  if (args->head != args->nil) {
+    mode = ((lizard_ast_list_node_t *)args->head)->ast;
+    if (args->head->next != args->nil || mode->type != AST_SYMBOL ||
+        (strcmp(mode->data.variable, "full") != 0 &&
+         strcmp(mode->data.variable, "minor") != 0)) {
+      return lizard_make_error(heap, LIZARD_ERROR_GC_ARGT);
+    }
+  }
+  full = mode != NULL ? strcmp(mode->data.variable, "full") == 0
+                      : lizard_gc_wants_full(heap);
+  result = lizard_make_nil(heap);
+  if (!full) {
+    /* A minor collection does not walk the heap, so neither do its stats. */
+    freed_bytes = lizard_gc_collect_minor(heap, env);
+    result = gc_cons(heap, gc_make_stat(heap, "old-bytes",       (unsigned long)lizard_gc_metadata_old_bytes(heap->gc_metadata)), result);
+    result = gc_cons(heap, gc_make_stat(heap, "freed-bytes",     (unsigned long)freed_bytes),          result);
+    return result;
+  }
 
   /* Object-level stats before collection. */
   lizard_gc_collect_stats(heap, env, 1, &before);
 
-  /* Per-object, non-moving, conservative reclamation (Phase 5). */
+  /* Per-object, non-moving reclamation (Phase 5). */
   freed_bytes = lizard_gc_collect_objects(heap, env);
 
   /* Stats after. */
   lizard_gc_collect_stats(heap, env, 1, &after);
 
   /* Build result alist. */
-  result = lizard_make_nil(heap);
+  result = gc_cons(heap, gc_make_stat(heap, "old-bytes",       (unsigned long)lizard_gc_metadata_old_bytes(heap->gc_metadata)), result);
   result = gc_cons(heap, gc_make_stat(heap, "freed-bytes",     (unsigned long)freed_bytes),          result);
   result = gc_cons(heap, gc_make_stat(heap, "live-after",      (unsigned long)after.nodes_marked),   result);
   result = gc_cons(heap, gc_make_stat(heap, "live-before",     (unsigned long)before.nodes_marked),  result);
@@ -477,7 +477,7 @@ static meta_ctx_t *get_meta_ctx(lizard_heap_t *heap) {
 lizard_ast_node_t *lizard_primitive_kernel_hole(lz_list_t *args,
                                                  lizard_env_t *env,
                                                  lizard_heap_t *heap) {
-  lizard_ast_node_t *type_expr, *result;
+  lizard_ast_node_t *type_expr;
   kterm_t *type, *hole;
   meta_ctx_t *mctx;
   (void)env;
@@ -491,10 +491,7 @@ lizard_ast_node_t *lizard_primitive_kernel_hole(lz_list_t *args,
   printf("Created hole ?%d : ", hole->data.meta.id);
   kt_fprint(stdout, type);
   printf("\n");
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  result->type = AST_NUMBER;
-  mpz_init_set_si(result->data.number, hole->data.meta.id);
-  return result;
+  return lizard_make_fixnum(heap, hole->data.meta.id);
 }
 lizard_ast_node_t *lizard_primitive_kernel_solve(lz_list_t *args,
                                                   lizard_env_t *env,
@@ -547,14 +544,10 @@ lizard_ast_node_t *lizard_primitive_kernel_meta_state(lz_list_t *args,
                                                        lizard_env_t *env,
                                                        lizard_heap_t *heap) {
   meta_ctx_t *mctx;
-  lizard_ast_node_t *r;
   (void)args; (void)env;
   mctx = get_meta_ctx(heap);
   meta_ctx_fprint(stdout, mctx);
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  r->type = AST_NUMBER;
-  mpz_init_set_si(r->data.number, (long)meta_unsolved_count(mctx));
-  return r;
+  return lizard_make_fixnum(heap, (long)meta_unsolved_count(mctx));
 }
 lizard_ast_node_t *lizard_primitive_kernel_unify(lz_list_t *args,
                                                   lizard_env_t *env,
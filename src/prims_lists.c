@@ -3,6 +3,7 @@
 #include "primitives.h"
 #include "env.h"
 #include "errors.h"
+#include "gc.h"
 #include "lizard_internal.h"
 #include "mem.h"
 #include "parser.h"
@@ -14,51 +15,42 @@
 #include <stdint.h>
 #include <string.h>
 
-lizard_ast_node_t *lizard_primitive_list(lz_list_t *args, lizard_env_t *env,
-                                         lizard_heap_t *heap) {
-  lizard_ast_node_t *first, *rest;
-  lz_list_t *rest_args, *cons_args;
-  lizard_ast_list_node_t *first_node, *rest_node;
-  if (args->head == args->nil) {
-    return lizard_make_nil(heap);
+/* Elements are deep-copied, as `cons` does; the spine is built once from the
+ * right instead of re-copying the tail at every step. */
+lizard_ast_node_t *lizard_primitive_list_argv(int argc, lizard_ast_node_t **argv,
+                                              lizard_env_t *env,
+                                              lizard_heap_t *heap) {
+  lizard_ast_node_t *result = lizard_make_nil(heap);
+  int i;
+  (void)env;
+  for (i = argc - 1; i >= 0; i--) {
+    lizard_ast_node_t *pair = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+    pair->type = AST_PAIR;
+    pair->data.pair.car = lizard_ast_deep_copy(argv[i], heap);
+    pair->data.pair.cdr = result;
+    result = pair;
   }
-
-  first = CAST(args->head, lizard_ast_list_node_t)->ast;
-  rest_args = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
-  rest_args->head = args->head->next;
-  rest_args->nil = args->nil;
-  rest = lizard_primitive_list(rest_args, env, heap);
-
-  cons_args = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
-  first_node = lizard_heap_alloc(sizeof(lizard_ast_list_node_t));
-  first_node->ast = first;
-  list_append(cons_args, &first_node->node);
-  rest_node = lizard_heap_alloc(sizeof(lizard_ast_list_node_t));
-  rest_node->ast = rest;
-  list_append(cons_args, &rest_node->node);
-
-  return lizard_primitive_cons(cons_args, env, heap);
+  return result;
 }
-lizard_ast_node_t *lizard_primitive_length(lz_list_t *args,
-                                            lizard_env_t *env,
-                                            lizard_heap_t *heap) {
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_list)
+lizard_ast_node_t *lizard_primitive_length_argv(int argc,
+                                                lizard_ast_node_t **argv,
+                                                lizard_env_t *env,
+                                                lizard_heap_t *heap) {
   lizard_ast_node_t *lst;
-  lizard_ast_node_t *r;
   long count = 0;
   (void)env;
-  if (!single_arg(args)) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  lst = ((lizard_ast_list_node_t *)args->head)->ast;
+  lst = argv[0];
   while (lst != NULL && lst->type == AST_PAIR) {
     count++;
     lst = lst->data.pair.cdr;
   }
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  r->type = AST_NUMBER;
-  mpz_init_set_si(r->data.number, count);
-  return r;
+  return lizard_make_fixnum(heap, count);
 }
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_length)
 lizard_ast_node_t *lizard_primitive_append(lz_list_t *args,
                                             lizard_env_t *env,
                                             lizard_heap_t *heap) {
@@ -154,7 +146,9 @@ lizard_ast_node_t *lizard_primitive_map(lz_list_t *args,
     node->data.pair.car = val;
     node->data.pair.cdr = lizard_make_nil(heap);
     if (tail != NULL) {
+      /* The call may have collected, leaving the list so far old. */
       tail->data.pair.cdr = node;
+      lizard_gc_write_barrier(&tail->data.pair.cdr);
     } else {
       result = node;
     }
@@ -194,6 +188,7 @@ lizard_ast_node_t *lizard_primitive_filter(lz_list_t *args,
       node->data.pair.cdr = lizard_make_nil(heap);
       if (tail != NULL) {
         tail->data.pair.cdr = node;
+        lizard_gc_write_barrier(&tail->data.pair.cdr);
       } else {
         result = node;
       }
@@ -366,9 +361,7 @@ lizard_ast_node_t *lizard_primitive_iota(lz_list_t *args,
     node = lizard_heap_alloc(sizeof(lizard_ast_node_t));
     node->type = AST_PAIR;
     node->data.pair.cdr = result;
-    node->data.pair.car = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-    node->data.pair.car->type = AST_NUMBER;
-    mpz_init_set_si(node->data.pair.car->data.number, i);
+    node->data.pair.car = lizard_make_fixnum(heap, i);
     result = node;
   }
   return result;
@@ -388,7 +381,7 @@ lizard_ast_node_t *lizard_primitive_list_to_string(lz_list_t *args,
     if (cur->data.pair.car->type == AST_STRING)
       len += strlen(cur->data.pair.car->data.string);
   }
-  buf = (char *)lizard_heap_alloc(len + 1);
+  buf = (char *)lizard_heap_alloc_atomic(len + 1);
   p = buf;
   for (cur = lst; cur != NULL && cur->type == AST_PAIR; cur = cur->data.pair.cdr) {
     if (cur->data.pair.car->type == AST_STRING) {
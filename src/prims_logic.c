@@ -140,13 +140,8 @@ lizard_ast_node_t *lizard_primitive_logic_config(lz_list_t *args,
 lizard_ast_node_t *lizard_primitive_logic_config_size(lz_list_t *args,
                                                      lizard_env_t *env,
                                                      lizard_heap_t *heap) {
-  lizard_ast_node_t *n;
   (void)env; (void)args;
-  n = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  n->type = AST_NUMBER;
-  mpz_init(n->data.number);
-  mpz_set_si(n->data.number, lizard_logic_config_size());
-  return n;
+  return lizard_make_fixnum(heap, lizard_logic_config_size());
 }
 lizard_ast_node_t *lizard_primitive_logic_config_reset(lz_list_t *args,
                                                       lizard_env_t *env,
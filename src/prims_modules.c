@@ -1,10 +1,12 @@
 /* prims_modules.c — extracted from primitives.c (#7 monolith split).
  * Registration stays in primitives.c; definitions linked from here. */
 #include "primitives.h"
+#include "bytecode.h"
 #include "env.h"
 #include "errors.h"
 #include "lizard_internal.h"
 #include "mem.h"
+#include "optimize.h"
 #include "parser.h"
 #include "printer.h"
 #include "runtime.h"
@@ -13,6 +15,7 @@
 #include <setjmp.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/stat.h>
 
 lizard_ast_node_t *lizard_primitive_load(lz_list_t *args, lizard_env_t *env,
                                          lizard_heap_t *heap) {
@@ -61,8 +64,9 @@ lizard_ast_node_t *lizard_primitive_load(lz_list_t *args, lizard_env_t *env,
   ast_list = lizard_parse(tokens, heap);
   result = lizard_make_nil(heap);
   for (iter = ast_list->head; iter != ast_list->nil; iter = iter->next) {
-    lizard_ast_node_t *expanded = lizard_expand_macros(
-        ((lizard_ast_list_node_t *)iter)->ast, env, heap);
+    lizard_ast_node_t *expanded = lizard_optimize(
+        lizard_expand_macros(((lizard_ast_list_node_t *)iter)->ast, env, heap),
+        env, heap);
     result = lizard_eval(expanded, env, heap, lizard_identity_cont);
     if (result && result->type == AST_ERROR) {
       return result;
@@ -123,6 +127,38 @@ static void cache_module(lizard_heap_t *heap, const char *path,
   e->next = heap->runtime->modules_head;
   heap->runtime->modules_head = e;
 }
+/* The compiled file of source `path`: its .lisp suffix, if any, replaced
+ * by .lzc. */
+static char *compiled_path(const char *path) {
+  size_t len = strlen(path);
+  char *out = (char *)lizard_heap_alloc(len + 5);
+  strcpy(out, path);
+  if (len >= 5 && strcmp(path + len - 5, ".lisp") == 0) {
+    out[len - 5] = '\0';
+  }
+  strcat(out, ".lzc");
+  return out;
+}
+/* Run the compiled file of source `path` when there is one newer than the
+ * source; NULL when there is none, or it is unreadable.  Times are in whole
+ * seconds, so a file written in the second the source was saved is not
+ * trusted: the source may have changed after it within that second. */
+static lizard_ast_node_t *import_compiled(const char *path, lizard_env_t *env,
+                                          lizard_heap_t *heap) {
+  char *lzc = compiled_path(path);
+  struct stat src_st, lzc_st;
+  FILE *fp;
+  lizard_ast_node_t *result;
+  if (stat(path, &src_st) != 0 || stat(lzc, &lzc_st) != 0 ||
+      lzc_st.st_mtime <= src_st.st_mtime) {
+    return NULL;
+  }
+  fp = fopen(lzc, "rb");
+  if (fp == NULL) return NULL;
+  result = lizard_lzc_load(fp, env, heap);
+  fclose(fp);
+  return result;
+}
 lizard_ast_node_t *lizard_primitive_import(lz_list_t *args, lizard_env_t *env,
                                            lizard_heap_t *heap) {
   lizard_ast_list_node_t *arg;
@@ -167,6 +203,19 @@ lizard_ast_node_t *lizard_primitive_import(lz_list_t *args, lizard_env_t *env,
     }
   }
 
+  result = import_compiled(resolved, env, heap);
+  if (result != NULL) {
+    fclose(fp);
+    if (result->type == AST_ERROR) {
+      return result;
+    }
+    cache_module(heap, path, result);
+    if (strcmp(resolved, path) != 0) {
+      cache_module(heap, resolved, result);
+    }
+    return result;
+  }
+
   /* Read file. */
   if (fseek(fp, 0L, SEEK_END) != 0) {
     fclose(fp);
@@ -191,8 +240,9 @@ lizard_ast_node_t *lizard_primitive_import(lz_list_t *args, lizard_env_t *env,
   ast_list = lizard_parse(tokens, heap);
   result = lizard_make_nil(heap);
   for (iter = ast_list->head; iter != ast_list->nil; iter = iter->next) {
-    lizard_ast_node_t *expanded = lizard_expand_macros(
-        ((lizard_ast_list_node_t *)iter)->ast, env, heap);
+    lizard_ast_node_t *expanded = lizard_optimize(
+        lizard_expand_macros(((lizard_ast_list_node_t *)iter)->ast, env, heap),
+        env, heap);
     result = lizard_eval(expanded, env, heap, lizard_identity_cont);
     if (result && result->type == AST_ERROR) {
       return result;
@@ -206,6 +256,77 @@ lizard_ast_node_t *lizard_primitive_import(lz_list_t *args, lizard_env_t *env,
   }
   return result;
 }
+/* The whole of `fp`, NUL-terminated; NULL on a read error.  Closes fp. */
+static char *read_source(FILE *fp) {
+  long file_size;
+  char *source;
+  size_t got;
+  if (fseek(fp, 0L, SEEK_END) != 0 || (file_size = ftell(fp)) < 0) {
+    fclose(fp);
+    return NULL;
+  }
+  rewind(fp);
+  source = (char *)lizard_heap_alloc((size_t)file_size + 1);
+  got = fread(source, 1, (size_t)file_size, fp);
+  fclose(fp);
+  if (got != (size_t)file_size) {
+    return NULL;
+  }
+  source[file_size] = '\0';
+  return source;
+}
+/* (compile-file "path") — import the file, writing the .lzc next to it
+ * that later imports run instead of the source.  Returns the .lzc path. */
+lizard_ast_node_t *lizard_primitive_compile_file(lz_list_t *args,
+                                                 lizard_env_t *env,
+                                                 lizard_heap_t *heap) {
+  lizard_ast_list_node_t *arg;
+  const char *path;
+  char *resolved;
+  char *source;
+  char *lzc;
+  FILE *fp;
+  FILE *out;
+  lizard_ast_node_t *result;
+
+  if (!single_arg(args)) {
+    return lizard_make_error(heap, LIZARD_ERROR_LOAD_ARGC);
+  }
+  arg = (lizard_ast_list_node_t *)args->head;
+  if (arg->ast->type != AST_STRING) {
+    return lizard_make_error(heap, LIZARD_ERROR_LOAD_ARGT);
+  }
+  path = arg->ast->data.string;
+  fp = resolve_module_file(path, heap, &resolved);
+  if (fp == NULL) {
+    return lizard_make_error(heap, LIZARD_ERROR_LOAD_OPEN);
+  }
+  source = read_source(fp);
+  if (source == NULL) {
+    return lizard_make_error(heap, LIZARD_ERROR_LOAD_READ);
+  }
+  lzc = compiled_path(resolved);
+  out = fopen(lzc, "wb");
+  if (out == NULL) {
+    return lizard_make_error(heap, LIZARD_ERROR_LOAD_WRITE);
+  }
+  result = lizard_lzc_compile(source, out, env, heap);
+  if (fclose(out) != 0 && result->type != AST_ERROR) {
+    result = lizard_make_error(heap, LIZARD_ERROR_LOAD_WRITE);
+  }
+  if (result->type == AST_ERROR) {
+    remove(lzc);
+    return result;
+  }
+  cache_module(heap, path, result);
+  if (strcmp(resolved, path) != 0) {
+    cache_module(heap, resolved, result);
+  }
+  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  result->type = AST_STRING;
+  result->data.string = lzc;
+  return result;
+}
 lizard_ast_node_t *lizard_primitive_module_loadedp(lz_list_t *args,
                                                     lizard_env_t *env,
                                                     lizard_heap_t *heap) {
@@ -301,8 +422,8 @@ static int run_forms_pairchain(lizard_heap_t *heap, lizard_env_t *menv,
                                lizard_ast_node_t *body) {
   lizard_ast_node_t *cur;
   for (cur = body; cur != NULL && cur->type == AST_PAIR; cur = cur->data.pair.cdr) {
-    lizard_ast_node_t *expanded =
-        lizard_expand_macros(cur->data.pair.car, menv, heap);
+    lizard_ast_node_t *expanded = lizard_optimize(
+        lizard_expand_macros(cur->data.pair.car, menv, heap), menv, heap);
     lizard_ast_node_t *r = lizard_eval(expanded, menv, heap, lizard_identity_cont);
     if (r != NULL && r->type == AST_ERROR) return 0;
   }
@@ -315,8 +436,9 @@ static int run_forms_list(lizard_heap_t *heap, lizard_env_t *menv,
   lz_list_node_t *iter;
   if (forms == NULL) return 1;
   for (iter = forms->head; iter != forms->nil; iter = iter->next) {
-    lizard_ast_node_t *expanded =
-        lizard_expand_macros(((lizard_ast_list_node_t *)iter)->ast, menv, heap);
+    lizard_ast_node_t *expanded = lizard_optimize(
+        lizard_expand_macros(((lizard_ast_list_node_t *)iter)->ast, menv, heap),
+        menv, heap);
     lizard_ast_node_t *r = lizard_eval(expanded, menv, heap, lizard_identity_cont);
     if (r != NULL && r->type == AST_ERROR) return 0;
   }
@@ -112,7 +112,7 @@ lizard_ast_node_t *lizard_primitive_pvec_pop(lz_list_t *args,
 lizard_ast_node_t *lizard_primitive_pvec_count(lz_list_t *args,
                                                 lizard_env_t *env,
                                                 lizard_heap_t *heap) {
-  lizard_ast_node_t *v, *r;
+  lizard_ast_node_t *v;
   (void)env;
   if (!single_arg(args)) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
@@ -121,10 +121,7 @@ lizard_ast_node_t *lizard_primitive_pvec_count(lz_list_t *args,
   if (v->type != AST_PVEC) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  r->type = AST_NUMBER;
-  mpz_init_set_si(r->data.number, lizard_pvec_count(v));
-  return r;
+  return lizard_make_fixnum(heap, lizard_pvec_count(v));
 }
 lizard_ast_node_t *lizard_primitive_pvec_to_list(lz_list_t *args,
                                                   lizard_env_t *env,
@@ -319,17 +316,14 @@ lizard_ast_node_t *lizard_primitive_phash_keys(lz_list_t *args,
 lizard_ast_node_t *lizard_primitive_phash_count(lz_list_t *args,
                                                 lizard_env_t *env,
                                                 lizard_heap_t *heap) {
-  lizard_ast_node_t *map_node, *r;
+  lizard_ast_node_t *map_node;
   (void)env;
   if (!single_arg(args)) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
   map_node = ((lizard_ast_list_node_t *)args->head)->ast;
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  r->type = AST_NUMBER;
-  mpz_init_set_si(r->data.number,
-      (map_node->type == AST_HAMT) ? map_node->data.hamt.count : 0);
-  return r;
+  return lizard_make_fixnum(
+      heap, (map_node->type == AST_HAMT) ? map_node->data.hamt.count : 0);
 }
 
 lizard_ast_node_t *lizard_primitive_phash_mapp(lz_list_t *args,
@@ -477,15 +471,12 @@ lizard_ast_node_t *lizard_primitive_pset_remove(lz_list_t *args,
 lizard_ast_node_t *lizard_primitive_pset_count(lz_list_t *args,
                                                lizard_env_t *env,
                                                lizard_heap_t *heap) {
-  lizard_ast_node_t *set_node, *r;
+  lizard_ast_node_t *set_node;
   (void)env;
   if (!single_arg(args)) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   set_node = ((lizard_ast_list_node_t *)args->head)->ast;
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  r->type = AST_NUMBER;
-  mpz_init_set_si(r->data.number,
-      (set_node->type == AST_HAMT) ? set_node->data.hamt.count : 0);
-  return r;
+  return lizard_make_fixnum(
+      heap, (set_node->type == AST_HAMT) ? set_node->data.hamt.count : 0);
 }
 
 lizard_ast_node_t *lizard_primitive_pset_to_list(lz_list_t *args,
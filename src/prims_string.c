@@ -14,30 +14,32 @@
 #include <stdint.h>
 #include <string.h>
 
-lizard_ast_node_t *lizard_primitive_stringp(lz_list_t *args, lizard_env_t *env,
-                                            lizard_heap_t *heap) {
-  lizard_ast_list_node_t *node_arg;
+lizard_ast_node_t *lizard_primitive_stringp_argv(int argc,
+                                                 lizard_ast_node_t **argv,
+                                                 lizard_env_t *env,
+                                                 lizard_heap_t *heap) {
   (void)env;
-  if (args->head == args->nil || args->head->next != args->nil) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_STRINGP_ARGC);
   }
-  node_arg = (lizard_ast_list_node_t *)args->head;
-  if (node_arg->ast->type == AST_STRING)
+  if (argv[0]->type == AST_STRING)
     return lizard_make_bool(heap, true);
   else
     return lizard_make_bool(heap, false);
 }
-lizard_ast_node_t *lizard_primitive_string_ref(lz_list_t *args,
-                                                lizard_env_t *env,
-                                                lizard_heap_t *heap) {
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_stringp)
+lizard_ast_node_t *lizard_primitive_string_ref_argv(int argc,
+                                                    lizard_ast_node_t **argv,
+                                                    lizard_env_t *env,
+                                                    lizard_heap_t *heap) {
   lizard_ast_node_t *s, *idx, *result;
   long i;
   char *buf;
   (void)env;
-  if (!two_args(args))
+  if (argc != 2)
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
-  s   = ((lizard_ast_list_node_t *)args->head)->ast;
-  idx = ((lizard_ast_list_node_t *)args->head->next)->ast;
+  s   = argv[0];
+  idx = argv[1];
   if (s->type != AST_STRING || idx->type != AST_NUMBER)
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   i = mpz_get_si(idx->data.number);
@@ -51,6 +53,7 @@ lizard_ast_node_t *lizard_primitive_string_ref(lz_list_t *args,
   result->data.string = buf;
   return result;
 }
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_string_ref)
 lizard_ast_node_t *lizard_primitive_string_contains(lz_list_t *args,
                                                      lizard_env_t *env,
                                                      lizard_heap_t *heap) {
@@ -77,7 +80,7 @@ lizard_ast_node_t *lizard_primitive_string_upcase(lz_list_t *args,
   if (s->type != AST_STRING)
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   len = strlen(s->data.string);
-  buf = (char *)lizard_heap_alloc(len + 1);
+  buf = (char *)lizard_heap_alloc_atomic(len + 1);
   for (i = 0; i < len; i++) {
     char c = s->data.string[i];
     buf[i] = (c >= 'a' && c <= 'z') ? (char)(c - 32) : c;
@@ -101,7 +104,7 @@ lizard_ast_node_t *lizard_primitive_string_downcase(lz_list_t *args,
   if (s->type != AST_STRING)
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   len = strlen(s->data.string);
-  buf = (char *)lizard_heap_alloc(len + 1);
+  buf = (char *)lizard_heap_alloc_atomic(len + 1);
   for (i = 0; i < len; i++) {
     char c = s->data.string[i];
     buf[i] = (c >= 'A' && c <= 'Z') ? (char)(c + 32) : c;
@@ -135,7 +138,7 @@ lizard_ast_node_t *lizard_primitive_string_split(lz_list_t *args,
   start = s;
   while ((found = strstr(start, d)) != NULL) {
     size_t len = (size_t)(found - start);
-    buf = (char *)lizard_heap_alloc(len + 1);
+    buf = (char *)lizard_heap_alloc_atomic(len + 1);
     memcpy(buf, start, len);
     buf[len] = '\0';
     str = lizard_heap_alloc(sizeof(lizard_ast_node_t));
@@ -151,7 +154,7 @@ lizard_ast_node_t *lizard_primitive_string_split(lz_list_t *args,
   /* Last segment. */
   {
     size_t len = strlen(start);
-    buf = (char *)lizard_heap_alloc(len + 1);
+    buf = (char *)lizard_heap_alloc_atomic(len + 1);
     memcpy(buf, start, len);
     buf[len] = '\0';
     str = lizard_heap_alloc(sizeof(lizard_ast_node_t));
@@ -209,7 +212,7 @@ lizard_ast_node_t *lizard_primitive_string_join(lz_list_t *args,
       cur = cur->data.pair.cdr;
     }
   }
-  buf = (char *)lizard_heap_alloc(total + 1);
+  buf = (char *)lizard_heap_alloc_atomic(total + 1);
   p = buf;
   first = 1;
   {
@@ -232,20 +235,19 @@ lizard_ast_node_t *lizard_primitive_string_join(lz_list_t *args,
   result->data.string = buf;
   return result;
 }
-lizard_ast_node_t *lizard_primitive_char_to_int(lz_list_t *args,
-                                                 lizard_env_t *env,
-                                                 lizard_heap_t *heap) {
-  lizard_ast_node_t *s, *r;
+lizard_ast_node_t *lizard_primitive_char_to_int_argv(int argc,
+                                                     lizard_ast_node_t **argv,
+                                                     lizard_env_t *env,
+                                                     lizard_heap_t *heap) {
+  lizard_ast_node_t *s;
   (void)env;
-  if (!single_arg(args)) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
-  s = ((lizard_ast_list_node_t *)args->head)->ast;
+  if (argc != 1) return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
+  s = argv[0];
   if (s->type != AST_STRING || strlen(s->data.string) == 0)
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  r->type = AST_NUMBER;
-  mpz_init_set_si(r->data.number, (long)(unsigned char)s->data.string[0]);
-  return r;
+  return lizard_make_fixnum(heap, (long)(unsigned char)s->data.string[0]);
 }
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_char_to_int)
 lizard_ast_node_t *lizard_primitive_string_to_list(lz_list_t *args,
                                                     lizard_env_t *env,
                                                     lizard_heap_t *heap) {
@@ -285,7 +287,7 @@ lizard_ast_node_t *lizard_primitive_string_reverse(lz_list_t *args,
   s = ((lizard_ast_list_node_t *)args->head)->ast;
   if (s->type != AST_STRING) return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   len = strlen(s->data.string);
-  buf = (char *)lizard_heap_alloc(len + 1);
+  buf = (char *)lizard_heap_alloc_atomic(len + 1);
   for (i = 0; i < len; i++) buf[i] = s->data.string[len - 1 - i];
   buf[len] = '\0';
   result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
@@ -293,31 +295,20 @@ lizard_ast_node_t *lizard_primitive_string_reverse(lz_list_t *args,
   result->data.string = buf;
   return result;
 }
-static int get_string(lz_list_node_t *node, const char **out, size_t *len) {
-  lizard_ast_node_t *ast = ((lizard_ast_list_node_t *)node)->ast;
-  if (ast->type != AST_STRING) return 0;
-  *out = ast->data.string;
-  *len = strlen(ast->data.string);
-  return 1;
-}
-lizard_ast_node_t *lizard_primitive_str_length(lz_list_t *args,
-                                               lizard_env_t *env,
-                                               lizard_heap_t *heap) {
-  const char *s;
-  size_t len;
-  lizard_ast_node_t *result;
+lizard_ast_node_t *lizard_primitive_str_length_argv(int argc,
+                                                    lizard_ast_node_t **argv,
+                                                    lizard_env_t *env,
+                                                    lizard_heap_t *heap) {
   (void)env;
-  if (args->head == args->nil || args->head->next != args->nil) {
+  if (argc != 1) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  if (!get_string(args->head, &s, &len)) {
+  if (argv[0]->type != AST_STRING) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
-  result = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  result->type = AST_NUMBER;
-  mpz_init_set_ui(result->data.number, (unsigned long)len);
-  return result;
+  return lizard_make_fixnum(heap, (long)strlen(argv[0]->data.string));
 }
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_str_length)
 lizard_ast_node_t *lizard_primitive_str_append(lz_list_t *args,
                                                lizard_env_t *env,
                                                lizard_heap_t *heap) {
@@ -335,7 +326,7 @@ lizard_ast_node_t *lizard_primitive_str_append(lz_list_t *args,
     }
     total += strlen(a->data.string);
   }
-  buf = lizard_heap_alloc(total + 1);
+  buf = lizard_heap_alloc_atomic(total + 1);
   off = 0;
   for (iter = args->head; iter != args->nil; iter = iter->next) {
     const char *s = ((lizard_ast_list_node_t *)iter)->ast->data.string;
@@ -382,21 +373,23 @@ lizard_ast_node_t *lizard_primitive_substring(lz_list_t *args,
   }
   return make_string(heap, s + start, (size_t)(end - start));
 }
-lizard_ast_node_t *lizard_primitive_str_eq(lz_list_t *args, lizard_env_t *env,
-                                           lizard_heap_t *heap) {
+lizard_ast_node_t *lizard_primitive_str_eq_argv(int argc,
+                                                lizard_ast_node_t **argv,
+                                                lizard_env_t *env,
+                                                lizard_heap_t *heap) {
   lizard_ast_node_t *a, *b;
   (void)env;
-  if (args->head == args->nil || args->head->next == args->nil ||
-      args->head->next->next != args->nil) {
+  if (argc != 2) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
   }
-  a = ((lizard_ast_list_node_t *)args->head)->ast;
-  b = ((lizard_ast_list_node_t *)args->head->next)->ast;
+  a = argv[0];
+  b = argv[1];
   if (a->type != AST_STRING || b->type != AST_STRING) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
   return lizard_make_bool(heap, strcmp(a->data.string, b->data.string) == 0);
 }
+LIZARD_PRIMITIVE_LIST_ENTRY(lizard_primitive_str_eq)
 lizard_ast_node_t *lizard_primitive_str_to_num(lz_list_t *args,
                                                lizard_env_t *env,
                                                lizard_heap_t *heap) {
@@ -410,13 +403,14 @@ lizard_ast_node_t *lizard_primitive_str_to_num(lz_list_t *args,
   if (s->type != AST_STRING) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  r = lizard_make_number_node(heap);
   r->type = AST_NUMBER;
   mpz_init(r->data.number);
   ok = (mpz_set_str(r->data.number, s->data.string, 10) == 0);
   if (!ok) {
     return lizard_make_bool(heap, false);
   }
+  lizard_number_normalize(r);
   return r;
 }
 lizard_ast_node_t *lizard_primitive_str_to_sym(lz_list_t *args,
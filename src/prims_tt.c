@@ -758,7 +758,7 @@ TT_ACCESSOR(tt_annot_type,   AST_TT_ANNOT, x->data.tt_annot.type)
 lizard_ast_node_t *lizard_primitive_tt_universe_level(lz_list_t *args,
                                                       lizard_env_t *env,
                                                       lizard_heap_t *heap) {
-  lizard_ast_node_t *x, *r;
+  lizard_ast_node_t *x;
   (void)env;
   if (!single_arg(args)) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
@@ -767,15 +767,12 @@ lizard_ast_node_t *lizard_primitive_tt_universe_level(lz_list_t *args,
   if (!x || x->type != AST_TT_UNIVERSE) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  r->type = AST_NUMBER;
-  mpz_init_set_si(r->data.number, x->data.tt_universe.level);
-  return r;
+  return lizard_make_fixnum(heap, x->data.tt_universe.level);
 }
 lizard_ast_node_t *lizard_primitive_tt_couniverse_level(lz_list_t *args,
                                                         lizard_env_t *env,
                                                         lizard_heap_t *heap) {
-  lizard_ast_node_t *x, *r;
+  lizard_ast_node_t *x;
   (void)env;
   if (!single_arg(args)) {
     return lizard_make_error(heap, LIZARD_ERROR_PREDICATE_ARGC);
@@ -784,10 +781,7 @@ lizard_ast_node_t *lizard_primitive_tt_couniverse_level(lz_list_t *args,
   if (!x || x->type != AST_TT_COUNIVERSE) {
     return lizard_make_error(heap, LIZARD_ERROR_PLUS_ARGT);
   }
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  r->type = AST_NUMBER;
-  mpz_init_set_si(r->data.number, x->data.tt_couniverse.level);
-  return r;
+  return lizard_make_fixnum(heap, x->data.tt_couniverse.level);
 }
 lizard_ast_node_t *lizard_primitive_tt_inductive_ctors(lz_list_t *args,
                                                        lizard_env_t *env,
@@ -1010,7 +1004,7 @@ lizard_ast_node_t *lizard_primitive_tt_ctx_bindings(lz_list_t *args,
 lizard_ast_node_t *lizard_primitive_tt_ctx_length(lz_list_t *args,
                                                   lizard_env_t *env,
                                                   lizard_heap_t *heap) {
-  lizard_ast_node_t *ctx, *r;
+  lizard_ast_node_t *ctx;
   lz_list_node_t *it;
   long count = 0;
   (void)env;
@@ -1023,10 +1017,7 @@ lizard_ast_node_t *lizard_primitive_tt_ctx_length(lz_list_t *args,
   }
   for (it = ctx->data.tt_context.bindings->head;
        it != ctx->data.tt_context.bindings->nil; it = it->next) count++;
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  r->type = AST_NUMBER;
-  mpz_init_set_si(r->data.number, count);
-  return r;
+  return lizard_make_fixnum(heap, count);
 }
 lizard_ast_node_t *lizard_primitive_tt_substitution(lz_list_t *args,
                                                     lizard_env_t *env,
@@ -1085,7 +1076,7 @@ lizard_ast_node_t *lizard_primitive_tt_empty_ctx(lz_list_t *args,
 lizard_ast_node_t *lizard_primitive_tt_uco_level(lz_list_t *args,
                                                  lizard_env_t *env,
                                                  lizard_heap_t *heap) {
-  lizard_ast_node_t *x, *r;
+  lizard_ast_node_t *x;
   long lvl;
   (void)env;
   if (!single_arg(args)) {
@@ -1101,10 +1092,7 @@ lizard_ast_node_t *lizard_primitive_tt_uco_level(lz_list_t *args,
   default:
     return lizard_make_bool(heap, false);
   }
-  r = lizard_heap_alloc(sizeof(lizard_ast_node_t));
-  r->type = AST_NUMBER;
-  mpz_init_set_si(r->data.number, lvl);
-  return r;
+  return lizard_make_fixnum(heap, lvl);
 }
 TT_PREDICATE(tt_variablep,     AST_TT_VARIABLE)
 TT_PREDICATE(tt_contextp,      AST_TT_CONTEXT)
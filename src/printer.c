@@ -40,6 +40,10 @@ void lizard_fprint_ast(FILE *fp, lizard_ast_node_t *node, int depth) {
   case AST_SYMBOL:
     fprintf(fp, "Symbol: %s\n", node->data.variable);
     break;
+  case AST_LOCAL_REF:
+    fprintf(fp, "LocalRef: %s (%u, %u)\n", node->data.local_ref.name,
+            node->data.local_ref.depth, node->data.local_ref.slot);
+    break;
   case AST_BOOL:
     fprintf(fp, "Boolean: %s\n", node->data.boolean ? "#t" : "#f");
     break;
@@ -186,7 +190,7 @@ void lizard_fprint_ast(FILE *fp, lizard_ast_node_t *node, int depth) {
   case AST_PROMISE:
     fprintf(fp, "Promise (forced=%s)\n",
             node->data.promise.forced ? "true" : "false");
-    if (node->data.promise.forced)
+    if (node->data.promise.forced && node->data.promise.value != node)
       lizard_fprint_ast(fp, node->data.promise.value, depth + 1);
     else
       lizard_fprint_ast(fp, node->data.promise.expr, depth + 1);
@@ -258,7 +262,11 @@ void lizard_fprint_value(FILE *fp, lizard_ast_node_t *node) {
     fprintf(fp, "()");
     return;
   case AST_NUMBER:
-    gmp_fprintf(fp, "%Zd", node->data.number);
+    if (LIZARD_IS_FIXNUM(node)) {
+      fprintf(fp, "%ld", LIZARD_FIXNUM_VALUE(node));
+    } else {
+      gmp_fprintf(fp, "%Zd", node->data.number);
+    }
     return;
   case AST_RATIONAL:
     gmp_fprintf(fp, "%Qd", node->data.rational);
@@ -291,6 +299,9 @@ void lizard_fprint_value(FILE *fp, lizard_ast_node_t *node) {
   case AST_SYMBOL:
     fprintf(fp, "%s", node->data.variable);
     return;
+  case AST_LOCAL_REF:
+    fprintf(fp, "%s", node->data.local_ref.name);
+    return;
   case AST_QUOTE:
     /* The quote mark is input syntax; the value of '(a b c) is the
        list (a b c). Print the underlying datum directly. */
@@ -1079,7 +1090,10 @@ void lizard_fprint_value(FILE *fp, lizard_ast_node_t *node) {
     fprintf(fp, "<continuation>");
     return;
   case AST_PROMISE:
-    if (node->data.promise.forced) {
+    if (node->data.promise.value == node) {
+      /* A bytecode closure (see make_bc_closure in bytecode.c). */
+      fprintf(fp, "<procedure>");
+    } else if (node->data.promise.forced) {
       lizard_fprint_value(fp, node->data.promise.value);
     } else {
       fprintf(fp, "<promise>");
@@ -1,8 +1,10 @@
 #include "runtime.h"
 
+#include "bytecode.h"
 #include "diagnostics.h"
 #include "env.h"
 #include "mem.h"
+#include "optimize.h"
 #include "parser.h"
 #include "primitives.h"
 #include "printer.h"
@@ -121,7 +123,7 @@ lizard_runtime_t *lizard_runtime_create(const lizard_runtime_options_t *options)
   runtime->last_error[0] = '\0';
   lizard_diagnostic_clear(&runtime->diagnostic);
 
-  mp_set_memory_functions(lizard_heap_alloc, lizard_heap_realloc,
+  mp_set_memory_functions(lizard_heap_alloc_atomic, lizard_heap_realloc_atomic,
                           lizard_heap_free_wrapper);
 
   runtime->heap = lizard_heap_create(runtime->initial_heap_size,
@@ -136,8 +138,8 @@ lizard_runtime_t *lizard_runtime_create(const lizard_runtime_options_t *options)
   /* Phase 0: initialize formerly-global state. */
   runtime->gensym_counter = 0;
   runtime->sr_counter = 0;
-  runtime->callcc_active = 0;
-  runtime->callcc_value = NULL;
+  runtime->escape_top = NULL;
+  runtime->escape_counter = 0;
   /* Phase 0 B.2: logic config, HIT registry, flags start empty. */
   runtime->logic_config_head = NULL;
   runtime->logic_last_set_bundle = NULL;
@@ -151,6 +153,9 @@ lizard_runtime_t *lizard_runtime_create(const lizard_runtime_options_t *options)
   runtime->namespaces_head = NULL;
   runtime->current_module = NULL;
   runtime->module_base_env = NULL;
+  runtime->optimize_state = NULL;
+  runtime->vm_top = NULL;
+  runtime->chunks = NULL;
   {
     lizard_search_path_t *lib_path;
     lib_path = (lizard_search_path_t *)malloc(sizeof(lizard_search_path_t));
@@ -235,6 +240,7 @@ static lizard_status_t eval_parsed_forms(lizard_context_t *context,
   for (iter = ast_list->head; iter != ast_list->nil; iter = iter->next) {
     expanded = lizard_expand_macros(((lizard_ast_list_node_t *)iter)->ast,
                                     context->env, context->runtime->heap);
+    expanded = lizard_optimize(expanded, context->env, context->runtime->heap);
     result = lizard_eval(expanded, context->env, context->runtime->heap,
                          lizard_identity_cont);
     context->last_value = result;
@@ -527,7 +533,8 @@ lizard_value_type_t lizard_value_type(const lizard_value_t *value) {
   case AST_MACRO:
     return LIZARD_VALUE_MACRO;
   case AST_PROMISE:
-    return LIZARD_VALUE_PROMISE;
+    return lizard_vm_is_closure(value) ? LIZARD_VALUE_PROCEDURE
+                                       : LIZARD_VALUE_PROMISE;
   case AST_CONTINUATION:
   case AST_CALLCC:
     return LIZARD_VALUE_CONTINUATION;
@@ -40,6 +40,18 @@ typedef struct lizard_namespace {
   struct lizard_namespace *next;
 } lizard_namespace_t;
 
+/* One live call/cc: continuations it hands out carry `id` and escape by
+ * longjmp to `buf`.  Frames live in the C frame of the call/cc that pushed
+ * them and form a stack, innermost first; a continuation whose frame has
+ * been popped no longer escapes (continuations are one-shot and upward). */
+typedef struct lizard_escape_frame {
+  unsigned long id;
+  jmp_buf buf;
+  lizard_ast_node_t *volatile value; /* set by the escaping caller */
+  struct lizard_vm *vm_top;          /* VMs running when it was pushed */
+  struct lizard_escape_frame *prev;
+} lizard_escape_frame_t;
+
 struct lizard_runtime {
   lizard_heap_t *heap;
   size_t initial_heap_size;
@@ -49,9 +61,8 @@ struct lizard_runtime {
   /* Phase 0 B.1: counters and callcc state. */
   unsigned long gensym_counter;
   unsigned long sr_counter;
-  jmp_buf callcc_buf;
-  int callcc_active;
-  lizard_ast_node_t *callcc_value;
+  lizard_escape_frame_t *escape_top; /* innermost live call/cc */
+  unsigned long escape_counter;      /* last escape frame id handed out */
   /* Phase 0 B.2: logic config, HIT registry, normalization flags. */
   struct logic_rule_entry *logic_config_head;
   const char *logic_last_set_bundle;
@@ -70,6 +81,12 @@ struct lizard_runtime {
   lizard_namespace_t *namespaces_head;
   lizard_namespace_t *current_module;   /* module being evaluated (for export) */
   lizard_env_t *module_base_env;        /* pristine primitive env for hermetic modules */
+  /* Names set! has targeted in forms optimised so far (optimize.c). */
+  struct lizard_optimize_state *optimize_state;
+  /* Innermost running bytecode VM, chained through ->prev (bytecode.c). */
+  struct lizard_vm *vm_top;
+  /* Bytecode chunks not yet freed, newest first (bytecode.c). */
+  struct lizard_bc_chunk *chunks;
 };
 
 struct lizard_context {
@@ -0,0 +1,119 @@
+/* src/symbol.c — interned symbol names (see symbol.h). */
+
+#include "symbol.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LIZARD_SYMBOL_INITIAL_CAPACITY 1024U
+
+/* Open addressing with linear probing; `capacity` is a power of two and the
+ * load factor is kept under 1/2.  The hash of each name is cached next to it so
+ * probing and rehashing only touch the strings on a full hash match. */
+typedef struct lizard_symbol_slot {
+  const char *name;
+  unsigned long hash;
+} lizard_symbol_slot_t;
+
+static lizard_symbol_slot_t *symbol_slots = NULL;
+static size_t symbol_capacity = 0U;
+static size_t symbol_count = 0U;
+
+static unsigned long symbol_hash(const char *name, size_t len) {
+  unsigned long h = 2166136261UL;
+  size_t i;
+  for (i = 0; i < len; i++) {
+    h ^= (unsigned char)name[i];
+    h *= 16777619UL;
+  }
+  return h & 0xffffffffUL;
+}
+
+/* Slot holding `name`, or the empty slot where it would be inserted. */
+static lizard_symbol_slot_t *symbol_probe(const char *name, size_t len,
+                                          unsigned long hash) {
+  size_t mask = symbol_capacity - 1U;
+  size_t i = (size_t)hash & mask;
+  for (;;) {
+    lizard_symbol_slot_t *slot = &symbol_slots[i];
+    if (slot->name == NULL) {
+      return slot;
+    }
+    if (slot->hash == hash && strncmp(slot->name, name, len) == 0 &&
+        slot->name[len] == '\0') {
+      return slot;
+    }
+    i = (i + 1U) & mask;
+  }
+}
+
+static int symbol_grow(void) {
+  lizard_symbol_slot_t *old = symbol_slots;
+  size_t old_capacity = symbol_capacity;
+  size_t next = old_capacity == 0U ? LIZARD_SYMBOL_INITIAL_CAPACITY
+                                   : old_capacity * 2U;
+  size_t i;
+  lizard_symbol_slot_t *slots =
+      (lizard_symbol_slot_t *)calloc(next, sizeof(lizard_symbol_slot_t));
+  if (slots == NULL) {
+    return 0;
+  }
+  symbol_slots = slots;
+  symbol_capacity = next;
+  for (i = 0; i < old_capacity; i++) {
+    if (old[i].name != NULL) {
+      size_t j = (size_t)old[i].hash & (next - 1U);
+      while (slots[j].name != NULL) {
+        j = (j + 1U) & (next - 1U);
+      }
+      slots[j] = old[i];
+    }
+  }
+  free(old);
+  return 1;
+}
+
+const char *lizard_intern(const char *name) {
+  size_t len;
+  unsigned long hash;
+  lizard_symbol_slot_t *slot;
+  char *copy;
+  if (name == NULL) {
+    return NULL;
+  }
+  len = strlen(name);
+  if ((symbol_count + 1U) * 2U > symbol_capacity && !symbol_grow()) {
+    if (symbol_capacity == 0U) {
+      return name;
+    }
+  }
+  hash = symbol_hash(name, len);
+  slot = symbol_probe(name, len, hash);
+  if (slot->name != NULL) {
+    return slot->name;
+  }
+  if (symbol_count + 1U >= symbol_capacity) {
+    return name;
+  }
+  copy = (char *)malloc(len + 1U);
+  if (copy == NULL) {
+    return name;
+  }
+  memcpy(copy, name, len);
+  copy[len] = '\0';
+  slot->name = copy;
+  slot->hash = hash;
+  symbol_count++;
+  return copy;
+}
+
+const char *lizard_symbol_find(const char *name) {
+  size_t len;
+  if (name == NULL || symbol_capacity == 0U) {
+    return NULL;
+  }
+  len = strlen(name);
+  return symbol_probe(name, len, symbol_hash(name, len))->name;
+}
+
+size_t lizard_symbol_count(void) { return symbol_count; }
@@ -0,0 +1,29 @@
+/* src/symbol.h — interned symbol names.
+ *
+ * Every symbol name the reader, the syntax-rules renamer, string->symbol and
+ * the environment produce is canonicalised through this table, so two symbols
+ * with the same spelling share one `const char *`.  Environment lookup can then
+ * compare names by pointer instead of with strcmp.
+ *
+ * The table is C-owned and outlives every heap collection: interned names are
+ * never freed, so the conservative GC can neither reclaim nor move them.  It is
+ * shared by all runtimes in the process (like the global heap); names are
+ * immutable, so sharing them is safe.
+ */
+#ifndef LIZARD_SYMBOL_H
+#define LIZARD_SYMBOL_H
+
+#include <stddef.h>
+
+/* Canonical copy of `name` (NUL-terminated), inserting it on first use.  On
+ * allocation failure `name` itself is returned, so callers never see NULL. */
+const char *lizard_intern(const char *name);
+
+/* Canonical copy of `name` if it has been interned, NULL otherwise.  Never
+ * inserts, so probing for unbound names does not grow the table. */
+const char *lizard_symbol_find(const char *name);
+
+/* Number of distinct interned names. */
+size_t lizard_symbol_count(void);
+
+#endif /* LIZARD_SYMBOL_H */
@@ -185,7 +185,8 @@ lz_list_t *lizard_tokenize(const char *input) {
         return NULL;
       }
       /* Decoded length is at most (i - j - 1); we'll \0-terminate. */
-      buffer = lizard_heap_alloc(sizeof(char) * (long unsigned int)(i - j));
+      buffer =
+          lizard_heap_alloc_atomic(sizeof(char) * (long unsigned int)(i - j));
       k = 0;
       j++; /* step over the opening " */
       while (j < i) {
@@ -250,7 +251,8 @@ lz_list_t *lizard_tokenize(const char *input) {
           }
         }
       }
-      buffer = lizard_heap_alloc(sizeof(char) * (long unsigned int)(i - j + 1));
+      buffer = lizard_heap_alloc_atomic(sizeof(char) *
+                                        (long unsigned int)(i - j + 1));
       for (k = 0; j < i; j++, k++) {
         buffer[k] = input[j];
       }
@@ -266,7 +268,7 @@ lz_list_t *lizard_tokenize(const char *input) {
           input[i] == '&' || input[i] == '[' || input[i] == ']' ||
           (input[i] == ',' && input[i + 1] == '@')) {
         if (input[i] == ',' && input[i + 1] == '@') {
-          buffer = lizard_heap_alloc(sizeof(char) * 3);
+          buffer = lizard_heap_alloc_atomic(sizeof(char) * 3);
           buffer[0] = input[i];
           buffer[1] = input[i + 1];
           buffer[2] = '\0';
@@ -274,7 +276,7 @@ lz_list_t *lizard_tokenize(const char *input) {
           i += 2;
         } else {
 
-          buffer = lizard_heap_alloc(sizeof(char) * 2);
+          buffer = lizard_heap_alloc_atomic(sizeof(char) * 2);
           buffer[0] = input[i];
           buffer[1] = '\0';
           lizard_add_token_at(list, input, token_start, TOKEN_SYMBOL, buffer);
@@ -287,8 +289,8 @@ lz_list_t *lizard_tokenize(const char *input) {
                input[i] != ',' && input[i] != ';') {
           i++;
         }
-        buffer =
-            lizard_heap_alloc(sizeof(char) * (long unsigned int)(i - j + 1));
+        buffer = lizard_heap_alloc_atomic(sizeof(char) *
+                                          (long unsigned int)(i - j + 1));
         for (k = 0; j < i; j++, k++) {
           buffer[k] = input[j];
         }
@@ -0,0 +1,94 @@
+/* tests/analyze_test.c
+ *
+ * Closure-compiled bodies (src/analyze.c): a resolved closure's body is
+ * compiled on its first run and gives the walker's answers afterwards.
+ * Covers each handler — constants, local and global refs, if, cond, begin,
+ * define, set!, lambda, primitive and closure calls — plus forms left to the
+ * walker, errors at every level, and tail calls in both directions.
+ */
+#include "lexical.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  lizard_test_env_init(&e);
+
+  /* Compiled on first run, then reused. */
+  r = lizard_test_eval(&e, "(define (sq x) (* x x)) sq");
+  TEST_ASSERT(r->type == AST_LAMBDA && r->data.lambda.layout->code == NULL);
+  TEST_ASSERT(lizard_test_is_int(lizard_test_eval(&e, "(sq 7)"), 49));
+  TEST_ASSERT(r->data.lambda.layout->code != NULL);
+  TEST_ASSERT(lizard_test_is_int(lizard_test_eval(&e, "(sq -3)"), 9));
+
+  /* Constants, quote and if. */
+  r = lizard_test_eval(&e, "(define (k x) (if x \"yes\" 'no)) (list (k 1) (k #f))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(\"yes\" no)");
+  r = lizard_test_eval(&e, "(define (q) '(a b)) (q)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(a b)");
+
+  /* cond: else, a clause without a body, no match. */
+  r = lizard_test_eval(&e,
+                       "(define (sign n)"
+                       "  (cond ((< n 0) 'neg) ((= n 0)) (else 'pos)))"
+                       "(list (sign -5) (sign 0) (sign 5))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(neg #t pos)");
+  r = lizard_test_eval(&e, "(define (none n) (cond ((= n 1) 'one))) (none 2)");
+  TEST_ASSERT_STR(lizard_test_format(r), "()");
+
+  /* Internal define, set!, let and nested closures. */
+  r = lizard_test_eval(&e,
+                       "(define (counter)"
+                       "  (define n 0)"
+                       "  (lambda () (set! n (+ n 1)) n))"
+                       "(define c (counter)) (c) (c) (c)");
+  TEST_ASSERT(lizard_test_is_int(r, 3));
+  r = lizard_test_eval(&e, "(define (g a) (let ((b (* a 2))) (+ a b))) (g 5)");
+  TEST_ASSERT(lizard_test_is_int(r, 15));
+
+  /* Calls: rest lists, arity errors, list-only primitives and and/or. */
+  r = lizard_test_eval(&e,
+                       "(define (rest a . more) (cons a more))"
+                       "(define (call-rest) (list (rest 1) (rest 1 2 3)))"
+                       "(call-rest)");
+  TEST_ASSERT_STR(lizard_test_format(r), "((1) (1 2 3))");
+  r = lizard_test_eval(&e, "(define (bad) (sq 1 2)) (bad)");
+  TEST_ASSERT(lizard_test_is_error(r));
+  r = lizard_test_eval(&e, "(define (app x) (append x '(9))) (app '(8))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(8 9)");
+  r = lizard_test_eval(&e, "(define (safe x) (and (pair? x) (car x))) (safe 5)");
+  TEST_ASSERT(lizard_test_is_false(r));
+
+  /* Errors: unbound names, in arguments and in non-tail body forms. */
+  r = lizard_test_eval(&e, "(define (unb) no-such-name) (unb)");
+  TEST_ASSERT(lizard_test_is_error(r));
+  r = lizard_test_eval(&e, "(define (early) (car '()) 1) (early)");
+  TEST_ASSERT(lizard_test_is_error(r));
+  r = lizard_test_eval(&e, "(define (bad-set) (set! no-such-name 1)) (bad-set)");
+  TEST_ASSERT(lizard_test_is_error(r));
+
+  /* Deep tail calls through if, cond, begin and a form left to the walker. */
+  r = lizard_test_eval(&e,
+                       "(define (down n) (cond ((= n 0) 'done)"
+                       "                       (else (begin (down (- n 1))))))"
+                       "(down 200000)");
+  TEST_ASSERT(lizard_test_is_symbol(r, "done"));
+  r = lizard_test_eval(&e,
+                       "(define (via-walker n)"
+                       "  (if (= n 0) `(end ,n) ((if #t via-walker #f) (- n 1))))"
+                       "(via-walker 100000)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(end 0)");
+  r = lizard_test_eval(&e,
+                       "(define (ping n) (if (= n 0) 'ping (pong (- n 1))))"
+                       "(define (pong n) (if (= n 0) 'pong (ping (- n 1))))"
+                       "(ping 100001)");
+  TEST_ASSERT(lizard_test_is_symbol(r, "pong"));
+
+  /* apply reaches compiled bodies too. */
+  r = lizard_test_eval(&e, "(apply sq '(12))");
+  TEST_ASSERT(lizard_test_is_int(r, 144));
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
@@ -0,0 +1,62 @@
+/* tests/bc_chunk_test.c
+ *
+ * Bytecode chunks grow with what they hold: a procedure with thousands of
+ * instructions and hundreds of constants compiles and runs, a small
+ * lambda keeps small arrays, and repeated names and literals share one
+ * constant slot.
+ */
+#include "bytecode.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static lizard_bc_chunk_t *compile_src(lizard_test_env_t *e, const char *src) {
+  lz_list_t *asts = lizard_parse(lizard_tokenize(src), e->heap);
+  return lizard_compile(((lizard_ast_list_node_t *)asts->head)->ast, e->heap);
+}
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_bc_chunk_t *c;
+  lizard_bc_chunk_t *sub;
+  static char src[65536];
+  size_t len;
+  int i;
+  lizard_test_env_init(&e);
+
+  /* 2000 forms of three instructions each, past the old 4096 limit. */
+  lizard_test_eval(&e, "(define n 0)");
+  len = (size_t)sprintf(src, "(begin");
+  for (i = 0; i < 2000; i++) {
+    len += (size_t)sprintf(src + len, " (set! n (+ n 1))");
+  }
+  strcpy(src + len, " n)");
+  c = compile_src(&e, src);
+  TEST_ASSERT(c != NULL);
+  TEST_ASSERT(c->code_count > 4096);
+  TEST_ASSERT(c->const_count == 1); /* n; the 1 is an OP_ADD_IMM operand */
+  TEST_ASSERT(lizard_test_is_int(lizard_vm_exec(c, e.env, e.heap), 2000));
+
+  /* 300 distinct literals, past the old 256-constant limit. */
+  len = (size_t)sprintf(src, "(+");
+  for (i = 1; i <= 300; i++) {
+    len += (size_t)sprintf(src + len, " %d", i);
+  }
+  strcpy(src + len, ")");
+  c = compile_src(&e, src);
+  TEST_ASSERT(c != NULL);
+  TEST_ASSERT(c->const_count == 301);
+  TEST_ASSERT(lizard_test_is_int(lizard_vm_exec(c, e.env, e.heap), 45150));
+
+  /* A small lambda stays small. */
+  c = compile_src(&e, "(lambda (x) (+ x x))");
+  TEST_ASSERT(c != NULL && c->code[0].op == OP_CLOSURE);
+  sub = lizard_test_closure_chunk(c, 0);
+  TEST_ASSERT(sub->code_count == 4 && sub->code_cap <= LIZARD_BC_INITIAL_CODE);
+  TEST_ASSERT(sub->const_count == 0); /* x is a frame slot */
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
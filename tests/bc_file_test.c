@@ -0,0 +1,283 @@
+/* tests/bc_file_test.c
+ *
+ * Compiled files: a chunk written with lizard_bc_write reads back and runs
+ * the same, malformed input and operands the VM would index out of range
+ * are refused, and a module built by compile-file is what a later import,
+ * in a fresh runtime, runs while the source is older; its procedures stay
+ * VM closures the evaluator can call.
+ */
+#include "bytecode.h"
+#include "lizard_api.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <utime.h>
+
+#define MODULE "build/tests/bc_file_module.lisp"
+#define MODULE_LZC "build/tests/bc_file_module.lzc"
+
+/* The chunk of the first form of `src`. */
+static lizard_bc_chunk_t *compile_one(lizard_test_env_t *e, const char *src) {
+  lz_list_t *asts = lizard_parse(lizard_tokenize(src), e->heap);
+  return lizard_compile(((lizard_ast_list_node_t *)asts->head)->ast, e->heap);
+}
+
+/* `c` written to a temporary file and read back; NULL if either fails. */
+static lizard_bc_chunk_t *round_trip(lizard_test_env_t *e,
+                                     const lizard_bc_chunk_t *c) {
+  FILE *fp = tmpfile();
+  lizard_bc_chunk_t *back = NULL;
+  if (fp == NULL) {
+    return NULL;
+  }
+  if (lizard_bc_write(fp, c) == 0) {
+    rewind(fp);
+    back = lizard_bc_read(fp, e->heap);
+  }
+  fclose(fp);
+  return back;
+}
+
+/* Whether lizard_bc_read refuses the first `len` bytes of `bytes`. */
+static int read_refuses(lizard_test_env_t *e, const char *bytes, size_t len) {
+  FILE *fp = tmpfile();
+  lizard_bc_chunk_t *c;
+  if (fp == NULL) {
+    return 0;
+  }
+  fwrite(bytes, 1U, len, fp);
+  rewind(fp);
+  c = lizard_bc_read(fp, e->heap);
+  fclose(fp);
+  return c == NULL;
+}
+
+/* Whether lizard_bc_read refuses `c` once written. */
+static int chunk_refused(lizard_test_env_t *e, const lizard_bc_chunk_t *c) {
+  FILE *fp = tmpfile();
+  lizard_bc_chunk_t *back = NULL;
+  int wrote;
+  if (fp == NULL) {
+    return 0;
+  }
+  wrote = lizard_bc_write(fp, c) == 0;
+  if (wrote) {
+    rewind(fp);
+    back = lizard_bc_read(fp, e->heap);
+  }
+  fclose(fp);
+  return wrote && back == NULL;
+}
+
+/* The chunk of the first closure `c` makes. */
+static lizard_bc_chunk_t *closure_chunk(const lizard_bc_chunk_t *c) {
+  int i;
+  for (i = 0; i < c->code_count; i++) {
+    if (c->code[i].op == OP_CLOSURE) {
+      return lizard_test_closure_chunk(c, i);
+    }
+  }
+  return NULL;
+}
+
+/* Index of the first instruction of `c` with operand `op`, or -1. */
+static int find_op(const lizard_bc_chunk_t *c, lizard_opcode_t op) {
+  int i;
+  for (i = 0; i < c->code_count; i++) {
+    if (c->code[i].op == op) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* Set `file`'s modification time to `when`. */
+static int set_mtime(const char *file, time_t when) {
+  struct utimbuf times;
+  times.actime = when;
+  times.modtime = when;
+  return utime(file, &times);
+}
+
+/* The value of `src` in `context`, errors included. */
+static lizard_value_t *run(lizard_context_t *context, const char *src) {
+  lizard_value_t *value = NULL;
+  (void)lizard_context_eval_string(context, src, &value);
+  return value;
+}
+
+static int write_file(const char *path, const char *text) {
+  FILE *fp = fopen(path, "wb");
+  if (fp == NULL) {
+    return -1;
+  }
+  fputs(text, fp);
+  return fclose(fp);
+}
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_bc_chunk_t *c, *back;
+  lizard_ast_node_t *r;
+  FILE *fp;
+  long size;
+  char *bytes;
+  lizard_runtime_t *runtime;
+  lizard_context_t *context;
+  lizard_bc_chunk_t *sub;
+  struct stat st;
+  int at;
+
+  lizard_test_env_init(&e);
+
+  /* Every kind of constant, a rest parameter and a nested closure. */
+  c = compile_one(&e,
+                  "(define (f x . r)"
+                  "  (list x 12345678901234567890123 3/4 2.5 \"s\" 'sym"
+                  "        '(a (b . c)) ((lambda (y) (+ x y)) 1) r #t #f '()))");
+  TEST_ASSERT(c != NULL);
+  back = round_trip(&e, c);
+  TEST_ASSERT(back != NULL);
+  if (back != NULL) {
+    TEST_ASSERT(back->code_count == c->code_count &&
+                back->const_count == c->const_count);
+    lizard_vm_exec(back, e.env, e.heap);
+    r = lizard_test_eval(&e, "(f 1 2 3)");
+    TEST_ASSERT_STR(lizard_test_format(r),
+                    "(1 12345678901234567890123 3/4 2.5 \"s\" sym "
+                    "(a (b . c)) 2 (2 3) #t #f ())");
+  }
+
+  /* Nothing encodes a primitive; the truncated and the foreign are
+   * refused. */
+  c = compile_one(&e, "'x");
+  c->constants[c->code[0].arg] = lizard_test_eval(&e, "car");
+  fp = tmpfile();
+  TEST_ASSERT(fp != NULL);
+  if (fp != NULL) {
+    TEST_ASSERT(lizard_bc_write(fp, c) == -1);
+    TEST_ASSERT(ftell(fp) == 0L);
+    fclose(fp);
+  }
+  c = compile_one(&e, "(lambda (n) (if (< n 2) n (* n 2)))");
+  fp = tmpfile();
+  TEST_ASSERT(fp != NULL);
+  if (fp != NULL) {
+    TEST_ASSERT(lizard_bc_write(fp, c) == 0);
+    size = ftell(fp);
+    bytes = (char *)lizard_heap_alloc((size_t)size);
+    rewind(fp);
+    TEST_ASSERT(fread(bytes, 1U, (size_t)size, fp) == (size_t)size);
+    fclose(fp);
+    TEST_ASSERT(!read_refuses(&e, bytes, (size_t)size));
+    TEST_ASSERT(read_refuses(&e, bytes, (size_t)size - 1U));
+    TEST_ASSERT(read_refuses(&e, bytes, 5U));
+  }
+  TEST_ASSERT(read_refuses(&e, "\x7f\x01garbage", 9U));
+  fp = tmpfile();
+  TEST_ASSERT(fp != NULL);
+  if (fp != NULL) {
+    fputs("(define x 1)", fp);
+    rewind(fp);
+    TEST_ASSERT(lizard_lzc_load(fp, e.env, e.heap) == NULL);
+    fclose(fp);
+  }
+
+  /* Frame slots, upvalues and counts the VM would index out of range. */
+  c = compile_one(&e, "(lambda (a b) (list a b))");
+  sub = closure_chunk(c);
+  TEST_ASSERT(sub != NULL && !chunk_refused(&e, c));
+  at = find_op(sub, OP_LOAD_LOCAL2);
+  TEST_ASSERT(at >= 0 && at + 1 < sub->code_count);
+  if (at >= 0 && at + 1 < sub->code_count) {
+    sub->code[at].arg = sub->nlocals;
+    TEST_ASSERT(chunk_refused(&e, c));
+    sub->code[at].arg = 0;
+    sub->code[at + 1].arg = -1;
+    TEST_ASSERT(chunk_refused(&e, c));
+    sub->code[at + 1].arg = 1;
+    TEST_ASSERT(!chunk_refused(&e, c));
+  }
+  sub->nlocals = -1;
+  TEST_ASSERT(chunk_refused(&e, c));
+  sub->nlocals = 2;
+  sub->arity = -1;
+  TEST_ASSERT(chunk_refused(&e, c));
+  sub->arity = 2;
+  c->nlocals = 1;
+  TEST_ASSERT(chunk_refused(&e, c));
+  c->nlocals = 0;
+  c = compile_one(&e, "(lambda (x) (lambda () x))");
+  sub = closure_chunk(closure_chunk(c));
+  TEST_ASSERT(sub != NULL && sub->upval_count == 1 && !chunk_refused(&e, c));
+  if (sub != NULL && sub->upval_count == 1) {
+    sub->upval_index[0] = 1;
+    TEST_ASSERT(chunk_refused(&e, c));
+    sub->upval_index[0] = 0;
+    at = find_op(sub, OP_LOAD_UPVAL);
+    TEST_ASSERT(at >= 0);
+    if (at >= 0) {
+      sub->code[at].arg = 1;
+      TEST_ASSERT(chunk_refused(&e, c));
+      sub->code[at].arg = 0;
+    }
+    TEST_ASSERT(!chunk_refused(&e, c));
+  }
+  lizard_test_env_destroy(&e);
+
+  /* compile-file writes the .lzc and runs the module. */
+  TEST_ASSERT(write_file(MODULE,
+                         "(define (bcf-fact n) (if (< n 2) 1 (* n (bcf-fact (- n 1)))))\n"
+                         "(define bcf-sum (lambda xs (apply + xs)))\n"
+                         "(define-syntax bcf-twice\n"
+                         "  (syntax-rules () ((_ e) (begin e e))))\n"
+                         "(define bcf-count 0)\n") == 0);
+  runtime = lizard_runtime_create(NULL);
+  context = lizard_context_create(runtime);
+  r = run(context, "(compile-file \"" MODULE "\")");
+  TEST_ASSERT(r->type == AST_STRING && strcmp(r->data.string, MODULE_LZC) == 0);
+  TEST_ASSERT(lizard_test_is_int(run(context, "(bcf-fact 5)"), 120));
+  TEST_ASSERT(lizard_test_is_error(run(context, "(compile-file 1)")));
+  lizard_context_destroy(context);
+  lizard_runtime_destroy(runtime);
+
+  /* A fresh runtime imports the .lzc, once the source is older: the
+   * definitions are VM closures, which the evaluator calls, map and apply
+   * accept, and print as procedures. */
+  TEST_ASSERT(set_mtime(MODULE, time(NULL) - 10) == 0);
+  runtime = lizard_runtime_create(NULL);
+  context = lizard_context_create(runtime);
+  run(context, "(import \"" MODULE "\")");
+  r = run(context, "bcf-fact");
+  TEST_ASSERT(lizard_vm_is_closure(r));
+  TEST_ASSERT(lizard_value_type(r) == LIZARD_VALUE_PROCEDURE);
+  TEST_ASSERT_STR(lizard_test_format(r), "<procedure>");
+  r = run(context, "(bcf-fact 20)");
+  TEST_ASSERT_STR(lizard_test_format(r), "2432902008176640000");
+  r = run(context, "(map bcf-fact '(1 2 3 4))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(1 2 6 24)");
+  TEST_ASSERT(lizard_test_is_int(run(context, "(apply bcf-sum '(1 2 3))"), 6));
+  r = run(context, "(begin (bcf-twice (set! bcf-count (+ bcf-count 1))) bcf-count)");
+  TEST_ASSERT(lizard_test_is_int(r, 2));
+  TEST_ASSERT(lizard_test_is_true(run(context, "(procedure? bcf-fact)")));
+  lizard_context_destroy(context);
+  lizard_runtime_destroy(runtime);
+
+  /* A source saved in the second the .lzc was written may be newer. */
+  TEST_ASSERT(stat(MODULE_LZC, &st) == 0 && set_mtime(MODULE, st.st_mtime) == 0);
+  runtime = lizard_runtime_create(NULL);
+  context = lizard_context_create(runtime);
+  run(context, "(import \"" MODULE "\")");
+  TEST_ASSERT(!lizard_vm_is_closure(run(context, "bcf-fact")));
+  TEST_ASSERT(lizard_test_is_int(run(context, "(bcf-fact 5)"), 120));
+  lizard_context_destroy(context);
+  lizard_runtime_destroy(runtime);
+
+  (void)remove(MODULE);
+  (void)remove(MODULE_LZC);
+  TEST_RETURN();
+}
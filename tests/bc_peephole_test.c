@@ -0,0 +1,68 @@
+/* tests/bc_peephole_test.c
+ *
+ * The peephole pass over finished chunks: jumps are threaded, pushes
+ * popped straight away disappear, frequent pairs become superinstructions,
+ * and nothing merges across a jump target.  The profile counts the
+ * adjacent pairs the superinstructions were chosen from.
+ */
+#include "bytecode.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#include <string.h>
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  lizard_bc_chunk_t *sub;
+  static lizard_vm_profile_t prof;
+  lizard_test_env_init(&e);
+
+  /* Dead pushes, threaded jumps, fused pairs. */
+  sub = lizard_test_lambda_chunk(&e, "(lambda (x) 1 'a x)");
+  TEST_ASSERT(sub->code_count == 1 && sub->code[0].op == OP_RETURN_LOCAL);
+  sub = lizard_test_lambda_chunk(&e, "(lambda (n) (if (< n 2) n (- n 1)))");
+  TEST_ASSERT(lizard_test_count_op(sub, OP_JUMP) == 0 &&
+              lizard_test_count_op(sub, OP_RETURN_LOCAL) == 1);
+  TEST_ASSERT(lizard_test_count_op(sub, OP_LOAD_LOCAL_ADD_IMM) == 1);
+  sub = lizard_test_lambda_chunk(&e, "(lambda (a b) (cons a b))");
+  TEST_ASSERT(sub->code[0].op == OP_LOAD_LOCAL2 && sub->code[1].arg == 1);
+  sub = lizard_test_lambda_chunk(&e, "(lambda (x y) (if (not (< y x)) 1 2))");
+  TEST_ASSERT(lizard_test_count_op(sub, OP_JUMP_IF_TRUE) == 1 &&
+              lizard_test_count_op(sub, OP_NOT) == 0);
+
+  /* Results through the rewritten code. */
+  r = lizard_test_vm_eval(&e,
+                          "(define (classify n)"
+                          "  (if (< n 0) 'neg (if (= n 0) 'zero (if (< n 10) 'small 'big))))"
+                          "(cons (classify -1) (cons (classify 0)"
+                          "  (cons (classify 5) (cons (classify 50) '()))))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(neg zero small big)");
+  r = lizard_test_vm_eval(&e, "((lambda (x) (if x 1 2) x) 5)");
+  TEST_ASSERT(lizard_test_is_int(r, 5));
+  r = lizard_test_vm_eval(&e, "((lambda (x y) (if (not (< y x)) 'le 'gt)) 1 2)");
+  TEST_ASSERT(lizard_test_is_symbol(r, "le"));
+  r = lizard_test_vm_eval(&e,
+                          "(define (count-up n) (define i 0) (define s 0)"
+                          "  (define (go) (if (< i n) (begin (set! s (+ s i)) (set! i (+ i 1)) (go)) s))"
+                          "  (go))"
+                          "(count-up 100)");
+  TEST_ASSERT(lizard_test_is_int(r, 4950));
+  r = lizard_test_vm_eval(&e, "(define (inc n) (+ n 1)) (inc 1/2)");
+  TEST_ASSERT_STR(lizard_test_format(r), "3/2");
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "(inc 'a)")));
+
+  /* Superinstruction counts. */
+  memset(&prof, 0, sizeof(prof));
+  r = lizard_test_vm_eval_profiled(&e,
+                                   "(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))"
+                                   "(fib 15)",
+                                   &prof);
+  TEST_ASSERT(lizard_test_is_int(r, 610));
+  TEST_ASSERT(prof.opcode_counts[OP_LOAD_LOCAL_ADD_IMM] == 1972 &&
+              prof.opcode_counts[OP_CALL_PRIM] == 1973);
+  TEST_ASSERT(prof.opcode_counts[OP_ADD_IMM] == 0);
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
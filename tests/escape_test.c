@@ -0,0 +1,65 @@
+/* tests/escape_test.c
+ *
+ * call/cc as escape continuations: every capture pushes its own frame with
+ * a fresh id, so an escape lands at the call/cc that made the continuation
+ * even when others are live, inner frames are dropped on the way out, and
+ * a capture that returns normally leaves no frame behind.
+ */
+#include "test_harness.h"
+#include "test_helpers.h"
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  lizard_test_env_init(&e);
+
+  /* Escapes land at their own call/cc, inner or outer. */
+  r = lizard_test_eval(&e, "(call/cc (lambda (k) (+ 1 (call/cc (lambda (j) (j 5))))))");
+  TEST_ASSERT(lizard_test_is_int(r, 6));
+  r = lizard_test_eval(&e, "(call/cc (lambda (k) (+ 1 (call/cc (lambda (j) (k 5))))))");
+  TEST_ASSERT(lizard_test_is_int(r, 5));
+  r = lizard_test_eval(&e, "(+ 100 (call/cc (lambda (k) (+ 1 (k 10)))))");
+  TEST_ASSERT(lizard_test_is_int(r, 110));
+  r = lizard_test_eval(&e, "(+ 1 (call/cc (lambda (k) 2)))");
+  TEST_ASSERT(lizard_test_is_int(r, 3));
+
+  /* Early return out of a higher-order primitive, both ways. */
+  r = lizard_test_eval(&e,
+                       "(define (find-first p xs)"
+                       "  (call/cc (lambda (return)"
+                       "    (for-each (lambda (x) (if (p x) (return x) #f)) xs)"
+                       "    #f)))"
+                       "(list (find-first (lambda (x) (> x 2)) '(1 2 3 4))"
+                       "      (find-first (lambda (x) (> x 9)) '(1 2 3 4)))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(3 #f)");
+  r = lizard_test_eval(&e, "(call/cc (lambda (k) (for-each k '(7 8)) 0))");
+  TEST_ASSERT(lizard_test_is_int(r, 7));
+
+  /* An escape from deep inside nested captures skips their frames. */
+  r = lizard_test_eval(&e,
+                       "(define (nest n k)"
+                       "  (if (= n 0) (k 'out)"
+                       "      (+ 1 (call/cc (lambda (j) (nest (- n 1) k))))))"
+                       "(call/cc (lambda (k) (nest 50 k)))");
+  TEST_ASSERT(lizard_test_is_symbol(r, "out"));
+
+  /* Many captures in a loop, each with its own id. */
+  r = lizard_test_eval(&e,
+                       "(define (loop i acc)"
+                       "  (if (= i 0) acc"
+                       "      (loop (- i 1) (+ acc (call/cc (lambda (k) (k i)))))))"
+                       "(loop 10000 0)");
+  TEST_ASSERT(lizard_test_is_int(r, 50005000));
+
+  /* A continuation used after its call/cc returned no longer escapes: its
+   * frame was popped, so there is no dead C frame to jump into. */
+  r = lizard_test_eval(&e,
+                       "(define saved #f)"
+                       "(+ 1 (call/cc (lambda (k) (set! saved k) 1)))");
+  TEST_ASSERT(lizard_test_is_int(r, 2));
+  r = lizard_test_eval(&e, "(saved 41)");
+  TEST_ASSERT(lizard_test_is_int(r, 41));
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
@@ -0,0 +1,124 @@
+/* tests/fixnum_test.c
+ *
+ * Fixnum integers: AST_NUMBER values that fit in a long are built without
+ * GMP and overflow into bignums at the edges of the range.  Covers the
+ * constructors in src/mem.c, the mpz view every existing reader relies on,
+ * overflow in + - * and back, and hashing that agrees across both forms.
+ */
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#include <limits.h>
+#include <stdio.h>
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r, *big;
+  mpz_t z;
+  long out;
+  char src[160];
+  lizard_test_env_init(&e);
+
+  /* Constructors: small values are shared, the mpz view reads correctly. */
+  r = lizard_make_fixnum(e.heap, 42);
+  TEST_ASSERT(LIZARD_IS_FIXNUM(r));
+  TEST_ASSERT(r == lizard_make_fixnum(e.heap, 42));
+  TEST_ASSERT_EQ(LIZARD_FIXNUM_VALUE(r), 42L);
+  TEST_ASSERT(mpz_cmp_si(r->data.number, 42) == 0);
+  r = lizard_make_fixnum(e.heap, LIZARD_FIXNUM_SHARED_MAX);
+  TEST_ASSERT(r == lizard_make_fixnum(e.heap, LIZARD_FIXNUM_SHARED_MAX));
+  TEST_ASSERT_EQ(LIZARD_FIXNUM_VALUE(r), LIZARD_FIXNUM_SHARED_MAX);
+  r = lizard_make_fixnum(e.heap, LIZARD_FIXNUM_SHARED_MIN);
+  TEST_ASSERT(r == lizard_make_fixnum(e.heap, LIZARD_FIXNUM_SHARED_MIN));
+  TEST_ASSERT(mpz_cmp_si(r->data.number, LIZARD_FIXNUM_SHARED_MIN) == 0);
+  r = lizard_make_fixnum(e.heap, LIZARD_FIXNUM_SHARED_MAX + 1L);
+  TEST_ASSERT(r != lizard_make_fixnum(e.heap, LIZARD_FIXNUM_SHARED_MAX + 1L));
+  TEST_ASSERT_EQ(LIZARD_FIXNUM_VALUE(r), LIZARD_FIXNUM_SHARED_MAX + 1L);
+  r = lizard_make_fixnum(e.heap, LONG_MIN);
+  TEST_ASSERT(LIZARD_IS_FIXNUM(r));
+  TEST_ASSERT(mpz_cmp_si(r->data.number, LONG_MIN) == 0);
+  r = lizard_make_fixnum(e.heap, -123456789L);
+  TEST_ASSERT(mpz_sgn(r->data.number) < 0);
+  TEST_ASSERT_STR(lizard_test_format(r), "-123456789");
+
+  mpz_init_set_si(z, LONG_MAX);
+  r = lizard_make_integer(e.heap, z);
+  TEST_ASSERT(LIZARD_IS_FIXNUM(r));
+  mpz_add_ui(z, z, 1U);
+  big = lizard_make_integer(e.heap, z);
+  TEST_ASSERT(big->type == AST_NUMBER && !LIZARD_IS_FIXNUM(big));
+  TEST_ASSERT(mpz_cmp(big->data.number, z) == 0);
+  mpz_clear(z);
+
+  /* Overflow-checked helpers. */
+  TEST_ASSERT(!lizard_fixnum_add(LONG_MAX, 1, &out));
+  TEST_ASSERT(!lizard_fixnum_sub(LONG_MIN, 1, &out));
+  TEST_ASSERT(!lizard_fixnum_mul(LONG_MIN, -1, &out));
+  TEST_ASSERT(!lizard_fixnum_mul(3037000500L, 3037000500L, &out));
+  TEST_ASSERT(lizard_fixnum_mul(-3037000499L, 3037000499L, &out));
+  TEST_ASSERT_EQ(out, -9223372030926249001L);
+
+  /* Literals and arithmetic results are fixnums while they fit. */
+  r = lizard_test_eval(&e, "(+ 1000 2000 3000)");
+  TEST_ASSERT(LIZARD_IS_FIXNUM(r) && lizard_test_is_int(r, 6000));
+  r = lizard_test_eval(&e, "(quotient -7 2)");
+  TEST_ASSERT(lizard_test_is_int(r, -3));
+  r = lizard_test_eval(&e, "(remainder -7 2)");
+  TEST_ASSERT(lizard_test_is_int(r, -1));
+  r = lizard_test_eval(&e, "(% -7 2)");
+  TEST_ASSERT(lizard_test_is_int(r, 1));
+
+  /* So are the integers other primitives build. */
+  r = lizard_test_eval(&e, "(string->number \"123456\")");
+  TEST_ASSERT(LIZARD_IS_FIXNUM(r) && lizard_test_is_int(r, 123456));
+  r = lizard_test_eval(&e, "(string->number \"123456789012345678901234\")");
+  TEST_ASSERT(!LIZARD_IS_FIXNUM(r));
+  r = lizard_test_eval(&e, "(procedure-arity (lambda (a b) a))");
+  TEST_ASSERT(LIZARD_IS_FIXNUM(r) && lizard_test_is_int(r, 2));
+  r = lizard_test_eval(&e, "(logic-config-size)");
+  TEST_ASSERT(LIZARD_IS_FIXNUM(r));
+
+  /* ...overflow into bignums at the edges... */
+  r = lizard_test_eval(&e, "(+ 9223372036854775807 1)");
+  TEST_ASSERT(!LIZARD_IS_FIXNUM(r));
+  TEST_ASSERT_STR(lizard_test_format(r), "9223372036854775808");
+  r = lizard_test_eval(&e, "(- -9223372036854775807 2)");
+  TEST_ASSERT_STR(lizard_test_format(r), "-9223372036854775809");
+  r = lizard_test_eval(&e, "(* 4294967296 4294967296)");
+  TEST_ASSERT_STR(lizard_test_format(r), "18446744073709551616");
+
+  /* ...and come back once the value fits again. */
+  r = lizard_test_eval(&e, "(- (+ 9223372036854775807 1) 1)");
+  TEST_ASSERT(LIZARD_IS_FIXNUM(r));
+  r = lizard_test_eval(&e, "(quotient (* 4294967296 4294967296) 4294967296)");
+  TEST_ASSERT(LIZARD_IS_FIXNUM(r) && lizard_test_is_int(r, 4294967296L));
+
+  /* Comparison and equality across the two forms. */
+  r = lizard_test_eval(&e, "(< 9223372036854775807 (+ 9223372036854775807 1))");
+  TEST_ASSERT(lizard_test_is_true(r));
+  r = lizard_test_eval(&e, "(= 5 (- (+ 9223372036854775807 5) 9223372036854775807))");
+  TEST_ASSERT(lizard_test_is_true(r));
+
+  /* Hash tables find fixnum keys and keys computed through a bignum. */
+  r = lizard_test_eval(&e,
+                       "(define h (make-hash-table))"
+                       "(hash-set! h 7 'seven)"
+                       "(hash-ref h (- (+ 9223372036854775807 7) 9223372036854775807))");
+  TEST_ASSERT(lizard_test_is_symbol(r, "seven"));
+
+  /* A counter loop stays correct across both ends of the shared range. */
+  r = lizard_test_eval(&e,
+                       "(define (count i n) (if (< i n) (count (+ i 1) n) i))"
+                       "(count -200 5000)");
+  TEST_ASSERT(lizard_test_is_int(r, 5000));
+  sprintf(src, "(list (count %ld %ld) (count %ld %ld))",
+          LIZARD_FIXNUM_SHARED_MIN - 300L, LIZARD_FIXNUM_SHARED_MIN + 300L,
+          LIZARD_FIXNUM_SHARED_MAX - 300L, LIZARD_FIXNUM_SHARED_MAX + 300L);
+  r = lizard_test_eval(&e, src);
+  sprintf(src, "(%ld %ld)", LIZARD_FIXNUM_SHARED_MIN + 300L,
+          LIZARD_FIXNUM_SHARED_MAX + 300L);
+  TEST_ASSERT_STR(lizard_test_format(r), src);
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
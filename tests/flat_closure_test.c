@@ -0,0 +1,85 @@
+/* tests/flat_closure_test.c
+ *
+ * Flat closures (lizard_lexical_closure_env): a lambda nested in resolved
+ * ones that only uses unassigned enclosing parameters keeps a capture
+ * frame of just those values, parented on the global env, through any
+ * number of levels.  Lambdas that assign, define or quote an enclosing
+ * variable, and lambdas applied on the spot, keep their defining frame.
+ */
+#include "lexical.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#include <string.h>
+
+static lizard_env_t *closure_env_of(lizard_test_env_t *e, const char *name) {
+  return lizard_env_lookup(e->env, name)->data.lambda.closure_env;
+}
+
+static const lizard_frame_layout_t *layout_of(lizard_test_env_t *e,
+                                              const char *name) {
+  return lizard_env_lookup(e->env, name)->data.lambda.layout;
+}
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  lizard_env_t *c;
+  lizard_test_env_init(&e);
+
+  /* Only the captured value is kept. */
+  r = lizard_test_eval(&e,
+                       "(define (make-adder n) (define unused 9)"
+                       "  (lambda (x) (+ x n)))"
+                       "(define add5 (make-adder 5)) (add5 3)");
+  TEST_ASSERT(lizard_test_is_int(r, 8));
+  c = closure_env_of(&e, "add5");
+  TEST_ASSERT(c->parent == e.env && c->entries == NULL);
+  TEST_ASSERT(c->layout->nslots == 1U && strcmp(c->layout->names[0], "n") == 0);
+  TEST_ASSERT(lizard_test_is_int(c->slots[0], 5));
+  r = lizard_test_eval(&e, "(define (konst n) (lambda (x) x)) (define id (konst 1)) (id 2)");
+  TEST_ASSERT(lizard_test_is_int(r, 2));
+  TEST_ASSERT(closure_env_of(&e, "id")->layout->nslots == 0U);
+
+  /* Through several levels, and a rest parameter. */
+  r = lizard_test_eval(&e,
+                       "(define (a x) (lambda (y) (lambda (z) (list x y z))))"
+                       "(define inner ((a 1) 2)) (inner 3)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(1 2 3)");
+  c = closure_env_of(&e, "inner");
+  TEST_ASSERT(c->parent == e.env && c->layout->nslots == 2U);
+  r = lizard_test_eval(&e, "(define (mk . xs) (lambda () xs)) ((mk 1 2))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(1 2)");
+
+  /* Kept by reference: an assigned parameter, a body define, a quoted
+   * name. */
+  r = lizard_test_eval(&e,
+                       "(define (make-acc total)"
+                       "  (lambda (x) (set! total (+ total x)) total))"
+                       "(define acc (make-acc 10)) (acc 5) (acc 5)");
+  TEST_ASSERT(lizard_test_is_int(r, 20));
+  TEST_ASSERT(closure_env_of(&e, "acc")->layout == layout_of(&e, "make-acc"));
+  r = lizard_test_eval(&e,
+                       "(define (box n) (define (get) n)"
+                       "  (define (bump!) (set! n (+ n 1))) (bump!) get)"
+                       "(define get (box 0)) (get)");
+  TEST_ASSERT(lizard_test_is_int(r, 1));
+  TEST_ASSERT(closure_env_of(&e, "get")->layout == layout_of(&e, "box"));
+  r = lizard_test_eval(&e,
+                       "(define (times n) (define (loop i acc)"
+                       "    (if (= i 0) acc (loop (- i 1) (+ acc n))))"
+                       "  (lambda () (loop n 0)))"
+                       "(define sq4 (times 4)) (sq4)");
+  TEST_ASSERT(lizard_test_is_int(r, 16));
+  TEST_ASSERT(closure_env_of(&e, "sq4")->layout == layout_of(&e, "times"));
+  r = lizard_test_eval(&e, "(define (q n) (lambda () 'n)) (define qn (q 1)) (qn)");
+  TEST_ASSERT(lizard_test_is_symbol(r, "n"));
+  TEST_ASSERT(closure_env_of(&e, "qn")->layout == layout_of(&e, "q"));
+
+  /* Applied on the spot. */
+  r = lizard_test_eval(&e, "(define (f n) ((lambda (y) (+ y n)) 1)) (f 2)");
+  TEST_ASSERT(lizard_test_is_int(r, 3));
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
@@ -0,0 +1,141 @@
+/* tests/gc_generational_test.c
+ *
+ * Generations: what a collection keeps is old, a minor collection frees
+ * young garbage and leaves old garbage to the next full one, and a young
+ * object stored into an old one survives it when the write barrier saw the
+ * store, which remembers slots of old objects only.  A full collection is
+ * wanted while nothing is old, and the mutators the evaluator runs keep
+ * what they store across minor collections.
+ */
+#include "errors.h"
+#include "gc.h"
+#include "mem.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#define N 16
+
+/* Holders live in BSS, which the collector scans; what is to be dropped is
+ * kept only as a hidden address.  An old
+ * object a root points at is traced even by a minor collection, so the
+ * store goes into the pair the holder's car points at. */
+static lizard_ast_node_t *holder;
+static void *olds[N];
+static uintptr_t hidden_young[N];
+static uintptr_t hidden_old[N];
+static uintptr_t hidden_stored;
+
+static void *victim(void) { return lizard_heap_alloc(40U); }
+
+static void fill_old(void) {
+  int i;
+  holder = lizard_make_pair(heap, lizard_make_pair(heap, NULL, NULL), NULL);
+  for (i = 0; i < N; i++) {
+    olds[i] = victim();
+  }
+}
+
+static void fill_young(void) {
+  void *v;
+  int i;
+  for (i = 0; i < N; i++) {
+    v = victim();
+    hidden_young[i] = lizard_test_hide(v);
+    hidden_old[i] = lizard_test_hide(olds[i]);
+    olds[i] = NULL;
+  }
+  v = victim();
+  hidden_stored = lizard_test_hide(v);
+  holder->data.pair.car->data.pair.car = (lizard_ast_node_t *)v;
+  lizard_gc_write_barrier(&holder->data.pair.car->data.pair.car);
+}
+
+int main(void) {
+  lizard_heap_t *local_heap;
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  size_t old;
+  int i;
+
+  local_heap = lizard_heap_create(1024U * 1024U, 16U * 1024U * 1024U);
+  heap = local_heap;
+
+  /* Nothing is old yet, so the first collection is full. */
+  TEST_ASSERT(lizard_gc_wants_full(local_heap));
+  TEST_ASSERT_EQ(lizard_gc_metadata_old_bytes(local_heap->gc_metadata), 0U);
+  lizard_test_call(fill_old);
+  (void)lizard_gc_collect_objects(local_heap, NULL);
+  old = lizard_gc_metadata_old_bytes(local_heap->gc_metadata);
+  TEST_ASSERT(old >= N * 40U);
+  TEST_ASSERT(!lizard_gc_wants_full(local_heap));
+
+  /* Only the store into the old holder is remembered. */
+  lizard_test_call(fill_young);
+  TEST_ASSERT_EQ(local_heap->remembered_count, 1U);
+  lizard_gc_write_barrier(&((lizard_ast_node_t *)victim())->data.pair.car);
+  TEST_ASSERT_EQ(local_heap->remembered_count, 1U);
+
+  lizard_test_clobber_stack();
+  (void)lizard_gc_collect_minor(local_heap, NULL);
+  TEST_ASSERT_EQ(local_heap->remembered_count, 0U);
+  /* Young garbage is gone but for the odd stray on the stack; dropped old
+   * objects and the young one the barrier saw stay. */
+  TEST_ASSERT(lizard_test_count_tracked(local_heap, hidden_young, N) <= 2U);
+  TEST_ASSERT_EQ(lizard_test_count_tracked(local_heap, hidden_old, N),
+                 (size_t)N);
+  TEST_ASSERT(lizard_test_tracked(local_heap, hidden_stored));
+  TEST_ASSERT((void *)holder->data.pair.car->data.pair.car ==
+              lizard_test_unhide(hidden_stored));
+  TEST_ASSERT(lizard_gc_metadata_old_bytes(local_heap->gc_metadata) > old);
+
+  /* A full collection frees the old garbage too. */
+  (void)lizard_gc_collect_objects(local_heap, NULL);
+  TEST_ASSERT(lizard_test_count_tracked(local_heap, hidden_old, N) <= 2U);
+  TEST_ASSERT(lizard_test_tracked(local_heap, hidden_stored));
+
+  /* A lost slot makes the next collection full. */
+  local_heap->remembered_lost = 1;
+  TEST_ASSERT(lizard_gc_wants_full(local_heap));
+  (void)lizard_gc_collect_objects(local_heap, NULL);
+  TEST_ASSERT(!local_heap->remembered_lost);
+
+  lizard_heap_destroy(local_heap);
+  heap = NULL;
+
+  /* Old containers, young contents, minor collections in between. */
+  lizard_test_env_init(&e);
+  lizard_test_eval(&e, "(define v (make-vector 4 0))");
+  lizard_test_eval(&e, "(define h (make-hash-table))");
+  lizard_test_eval(&e, "(define a (atom '()))");
+  lizard_test_eval(&e, "(define g '())");
+  lizard_test_eval(&e, "(define p (delay (list 'p 'forced)))");
+  lizard_test_eval(&e, "(define (burn n) (if (> n 0) (begin (list n n) "
+                       "(burn (- n 1))) 'ok))");
+  (void)lizard_gc_collect_objects(e.heap, e.env);
+  for (i = 0; i < 3; i++) {
+    lizard_test_eval(&e, "(vector-set! v 1 (list 'v (burn 10)))");
+    lizard_test_eval(&e, "(hash-set! h 'k (list 'h (burn 10)))");
+    lizard_test_eval(&e, "(reset! a (list 'a (burn 10)))");
+    lizard_test_eval(&e, "(swap! a (lambda (x) (cons 's x)))");
+    lizard_test_eval(&e, "(set! g (list 'g (burn 10)))");
+    lizard_test_eval(&e, "(define d (list 'd (burn 10)))");
+    lizard_test_eval(&e, "(force p)");
+    lizard_test_eval(&e, "(burn 2000)");
+    (void)lizard_gc_collect_minor(e.heap, e.env);
+    lizard_test_eval(&e, "(burn 2000)");
+  }
+  r = lizard_test_eval(&e, "(list (vector-ref v 1) (hash-ref h 'k) (deref a) "
+                           "g d (force p))");
+  TEST_ASSERT_STR(lizard_test_format(r),
+                  "((v ok) (h ok) (s a ok) (g ok) (d ok) (p forced))");
+  r = lizard_test_eval(&e, "(cdr (assoc 'freed-bytes (gc 'minor)))");
+  TEST_ASSERT(r != NULL && r->type == AST_NUMBER);
+  r = lizard_test_eval(&e, "(gc 'sideways)");
+  TEST_ASSERT(r != NULL && r->type == AST_ERROR &&
+              r->data.error.code == LIZARD_ERROR_GC_ARGT);
+  r = lizard_test_eval(&e, "(gc 'full 'minor)");
+  TEST_ASSERT(r != NULL && r->type == AST_ERROR &&
+              r->data.error.code == LIZARD_ERROR_GC_ARGT);
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
@@ -0,0 +1,112 @@
+/* tests/gc_number_test.c
+ *
+ * Exact numbers: a bignum or rational is tagged as a number where it is
+ * made, by the constructors, the parser and the arithmetic primitives
+ * alike.  Swept, a number is finalised and its limbs go with it, while a
+ * live one keeps its value; limbs GMP frees, or moves away from when it
+ * grows a number, are reused at once rather than left to a collection.
+ */
+#include "gc.h"
+#include "mem.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#define N 16
+
+/* What is to be dropped is kept only as a hidden address. */
+static uintptr_t hidden_nodes[N];
+static uintptr_t hidden_limbs[N];
+static size_t finalized;
+
+static void count_finalized(void *obj, size_t size) {
+  (void)obj;
+  (void)size;
+  finalized++;
+}
+
+static void fill(void) {
+  lizard_ast_node_t *node;
+  mpz_t z;
+  int i;
+  mpz_init(z);
+  for (i = 0; i < N; i++) {
+    mpz_ui_pow_ui(z, 7UL, 200UL + (unsigned long)i);
+    node = lizard_make_integer(heap, z);
+    hidden_nodes[i] = lizard_test_hide(node);
+    hidden_limbs[i] = lizard_test_hide(node->data.number->_mp_d);
+  }
+  mpz_clear(z);
+}
+
+static int is_number(const void *ptr) {
+  lizard_gc_object_kind_t kind;
+  return lizard_gc_metadata_lookup_object(heap, ptr, &kind, NULL, NULL) &&
+         kind == LIZARD_GC_OBJECT_NUMBER;
+}
+
+static int tracked(const void *ptr) {
+  return lizard_test_tracked(heap, lizard_test_hide(ptr));
+}
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  mpz_t z;
+  void *limbs;
+  size_t i;
+
+  lizard_test_env_init(&e);
+
+  /* Tagged wherever they are made. */
+  mpz_init(z);
+  mpz_ui_pow_ui(z, 10UL, 30UL);
+  TEST_ASSERT(is_number(lizard_make_integer(e.heap, z)));
+  TEST_ASSERT(
+      is_number(lizard_make_fixnum(e.heap, LIZARD_FIXNUM_SHARED_MAX + 1L)));
+  r = lizard_test_eval(&e, "(* 100000000000 100000000000)");
+  TEST_ASSERT(is_number(r));
+  r = lizard_test_eval(&e, "(/ 1 3)");
+  TEST_ASSERT(r->type == AST_RATIONAL);
+  TEST_ASSERT(is_number(r));
+  r = lizard_test_eval(&e, "'123456789012345678901234567890");
+  TEST_ASSERT(is_number(r));
+  TEST_ASSERT_STR(lizard_gc_object_kind_name(LIZARD_GC_OBJECT_NUMBER),
+                  "number");
+
+  /* Limbs GMP is done with are reused straight away. */
+  mpz_setbit(z, 4000UL);
+  limbs = z->_mp_d;
+  TEST_ASSERT(tracked(limbs));
+  mpz_setbit(z, 40000UL);
+  TEST_ASSERT(z->_mp_d != limbs && !tracked(limbs));
+  limbs = z->_mp_d;
+  mpz_clear(z);
+  TEST_ASSERT(!tracked(limbs));
+
+  /* Dead numbers go with their limbs; live ones keep their value. */
+  lizard_test_eval(&e, "(define big (expt 3 300))");
+  lizard_test_eval(&e, "(define third (/ (expt 2 100) 3))");
+  lizard_test_call(fill);
+  lizard_test_clobber_stack();
+  (void)lizard_gc_collect_objects(e.heap, e.env);
+  TEST_ASSERT(lizard_test_count_tracked(e.heap, hidden_nodes, N) <= 2U);
+  TEST_ASSERT(lizard_test_count_tracked(e.heap, hidden_limbs, N) <= 2U);
+  r = lizard_test_eval(&e, "(list (= big (expt 3 300)) "
+                           "(= (* third 3) (expt 2 100)))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(#t #t)");
+
+  /* A kind's finaliser runs on each object of it the sweep frees. */
+  lizard_gc_set_finalizer(LIZARD_GC_OBJECT_RAW, count_finalized);
+  for (i = 0U; i < N; i++) {
+    (void)lizard_heap_alloc_tagged(64U, LIZARD_GC_OBJECT_RAW,
+                                   LIZARD_OBJECT_TRACE_NONE);
+  }
+  lizard_test_clobber_stack();
+  finalized = 0U;
+  (void)lizard_gc_collect_objects(e.heap, e.env);
+  lizard_gc_set_finalizer(LIZARD_GC_OBJECT_RAW, NULL);
+  TEST_ASSERT(finalized >= N - 2U);
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
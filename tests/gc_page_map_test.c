@@ -0,0 +1,112 @@
+/* tests/gc_page_map_test.c
+ *
+ * The page map of the GC metadata table: an address anywhere inside a
+ * tracked object finds it, including on the later pages of an object that
+ * runs across pages, addresses between objects find nothing, an object is
+ * marked once, and sweep frees the unmarked ones, forgets them on every
+ * page they covered and clears the survivors' marks.
+ */
+#include "gc_metadata.h"
+#include "mem.h"
+#include "test_harness.h"
+
+#include <string.h>
+
+#define PAGE 4096U
+
+static size_t swept_count;
+static void *swept_ptr;
+
+static void count_swept(void *ptr, size_t size, lizard_gc_object_kind_t kind,
+                        void *ctx) {
+  (void)size;
+  (void)kind;
+  (void)ctx;
+  swept_count++;
+  swept_ptr = ptr;
+}
+
+static int reg(lizard_gc_metadata_table_t *table, char *ptr, size_t size) {
+  return lizard_gc_metadata_register(table, ptr, size, LIZARD_GC_OBJECT_RAW,
+                                     LIZARD_OBJECT_OWNER_HEAP,
+                                     LIZARD_OBJECT_TRACE_NONE);
+}
+
+int main(void) {
+  lizard_heap_t *arena_heap;
+  lizard_gc_metadata_table_t *table;
+  lizard_gc_metadata_stats_t stats;
+  lizard_gc_object_kind_t kind;
+  char *arena, *a, *b, *c, *d;
+  void *base;
+  size_t size;
+
+  /* A heap segment is mmap'd, so it starts on a page. */
+  arena_heap = lizard_heap_create(4U * PAGE, 4U * PAGE);
+  arena = arena_heap->head->start;
+  table = lizard_gc_metadata_table_create();
+  TEST_ASSERT(table != NULL);
+
+  a = arena;                  /* 64 bytes at the start of page 0 */
+  b = arena + PAGE - 32U;     /* 96 bytes across pages 0 and 1 */
+  c = arena + PAGE + 128U;    /* two pages' worth, into page 3 */
+  d = arena + 256U;           /* never marked */
+  TEST_ASSERT(reg(table, a, 64U) && reg(table, b, 96U));
+  TEST_ASSERT(reg(table, c, 2U * PAGE) && reg(table, d, 32U));
+  TEST_ASSERT(reg(table, arena + 512U, 0U));
+  lizard_gc_metadata_collect_stats(table, &stats);
+  TEST_ASSERT_EQ(stats.entries, 4U);
+
+  lizard_gc_metadata_prepare_marking(table);
+  TEST_ASSERT(lizard_gc_metadata_mark_addr(table, a + 40, &base, &size));
+  TEST_ASSERT(base == (void *)a && size == 64U);
+  TEST_ASSERT(!lizard_gc_metadata_mark_addr(table, a, &base, &size));
+  TEST_ASSERT(!lizard_gc_metadata_mark_addr(table, a + 64, &base, &size));
+  TEST_ASSERT(!lizard_gc_metadata_mark_addr(table, arena + 1024U, &base,
+                                            &size));
+  /* The tail of b and the last page of c resolve from their own pages. */
+  TEST_ASSERT(lizard_gc_metadata_mark_addr(table, arena + PAGE + 16U, &base,
+                                           &size));
+  TEST_ASSERT(base == (void *)b && size == 96U);
+  TEST_ASSERT(!lizard_gc_metadata_mark_addr(table, arena + PAGE + 64U, &base,
+                                            &size));
+  TEST_ASSERT(lizard_gc_metadata_mark_addr(table, arena + 3U * PAGE + 8U,
+                                           &base, &size));
+  TEST_ASSERT(base == (void *)c);
+  TEST_ASSERT(!lizard_gc_metadata_mark_addr(table, c, &base, &size));
+  TEST_ASSERT(!lizard_gc_metadata_mark_addr(table, arena + 3U * PAGE + 128U,
+                                            &base, &size));
+
+  swept_count = 0U;
+  TEST_ASSERT_EQ(lizard_gc_metadata_sweep(table, count_swept, NULL), 1U);
+  TEST_ASSERT(swept_count == 1U && swept_ptr == (void *)d);
+  TEST_ASSERT(!lizard_gc_metadata_lookup(table, d, NULL, NULL, NULL));
+  TEST_ASSERT(lizard_gc_metadata_lookup(table, c, NULL, &size, NULL));
+  TEST_ASSERT_EQ(size, 2U * PAGE);
+  lizard_gc_metadata_collect_stats(table, &stats);
+  TEST_ASSERT_EQ(stats.entries, 3U);
+
+  /* Marks do not outlive the sweep; c goes this time, and with it its
+   * claim on pages 2 and 3. */
+  lizard_gc_metadata_prepare_marking(table);
+  TEST_ASSERT(lizard_gc_metadata_mark_addr(table, a, &base, &size));
+  TEST_ASSERT(lizard_gc_metadata_mark_addr(table, b, &base, &size));
+  TEST_ASSERT_EQ(lizard_gc_metadata_sweep(table, NULL, NULL), 1U);
+  lizard_gc_metadata_prepare_marking(table);
+  TEST_ASSERT(!lizard_gc_metadata_mark_addr(table, arena + 3U * PAGE + 8U,
+                                            &base, &size));
+
+  /* Freed memory is registered again, as the allocator reuses it. */
+  TEST_ASSERT(lizard_gc_metadata_register(table, d, 48U,
+                                          LIZARD_GC_OBJECT_ENV,
+                                          LIZARD_OBJECT_OWNER_HEAP,
+                                          LIZARD_OBJECT_TRACE_ENV));
+  TEST_ASSERT(lizard_gc_metadata_lookup(table, d, &kind, &size, NULL));
+  TEST_ASSERT(kind == LIZARD_GC_OBJECT_ENV && size == 48U);
+  TEST_ASSERT(lizard_gc_metadata_mark_addr(table, d + 47, &base, &size));
+  TEST_ASSERT(base == (void *)d);
+
+  lizard_gc_metadata_table_destroy(table);
+  lizard_heap_destroy(arena_heap);
+  TEST_RETURN();
+}
@@ -0,0 +1,147 @@
+/* tests/gc_precise_test.c
+ *
+ * Tracing by trace policy: string bytes, GMP limbs, the bits of a real and
+ * the words a copied node does not use are never taken for pointers, so
+ * what they seem to point at is collected, while a pair keeps its car and
+ * cdr, a kernel term its subterms through the tracer registered for it, and
+ * an object whose kind was inferred from its size is still scanned whole.
+ * Marking reports how an object is to be traced.
+ */
+#include "gc.h"
+#include "kernel.h"
+#include "mem.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#include <string.h>
+
+#define N 16
+
+/* Holders live in BSS, which the collector scans; what they seem to point
+ * at is kept only as a hidden address. */
+static char *strings[N];
+static lizard_ast_node_t *numbers[N];
+static lizard_ast_node_t *reals[N];
+static lizard_ast_node_t *copies[N];
+static void *raws[N];
+static lizard_ast_node_t *pair;
+static kterm_t *app;
+static uintptr_t hidden_atomic[4 * N];
+static uintptr_t hidden_kept[N + 3];
+
+static void *victim(void) { return lizard_heap_alloc(40U); }
+
+static void fill(void) {
+  mpz_t z;
+  void *v;
+  lizard_ast_node_t *node;
+  double d;
+  int i;
+  mpz_init(z);
+  for (i = 0; i < N; i++) {
+    v = victim();
+    strings[i] = (char *)lizard_heap_alloc_atomic(sizeof(v));
+    memcpy(strings[i], &v, sizeof(v));
+    hidden_atomic[i] = lizard_test_hide(v);
+
+    /* Two limbs, each the victim's address. */
+    v = victim();
+    mpz_set_ui(z, (unsigned long)(uintptr_t)v);
+    mpz_mul_2exp(z, z, (mp_bitcnt_t)mp_bits_per_limb);
+    mpz_add_ui(z, z, (unsigned long)(uintptr_t)v);
+    numbers[i] = lizard_make_integer(heap, z);
+    hidden_atomic[N + i] = lizard_test_hide(v);
+
+    v = victim();
+    memcpy(&d, &v, sizeof(v));
+    reals[i] = lizard_make_real(heap, d);
+    hidden_atomic[2 * N + i] = lizard_test_hide(v);
+
+    /* A boolean carrying the victim where a pair's cdr would be, copied
+     * as the optimiser and the resolver copy nodes. */
+    v = victim();
+    node = lizard_make_bool(heap, true);
+    memcpy(&node->data.pair.cdr, &v, sizeof(v));
+    copies[i] = lizard_copy_node(heap, node);
+    hidden_atomic[3 * N + i] = lizard_test_hide(v);
+
+    v = victim();
+    raws[i] = lizard_heap_alloc(sizeof(v));
+    memcpy(raws[i], &v, sizeof(v));
+    hidden_kept[i] = lizard_test_hide(v);
+  }
+  mpz_clear(z);
+  pair = lizard_make_pair(heap, (lizard_ast_node_t *)victim(), NULL);
+  hidden_kept[N] = lizard_test_hide(pair->data.pair.car);
+  app = kt_app(heap, kt_var(heap, 0), kt_nat(heap));
+  hidden_kept[N + 1] = lizard_test_hide(app->data.app.fun);
+  hidden_kept[N + 2] = lizard_test_hide(app->data.app.arg);
+}
+
+int main(void) {
+  lizard_heap_t *local_heap;
+  lizard_gc_metadata_table_t *table;
+  lizard_gc_object_kind_t kind;
+  lizard_object_trace_policy_t trace;
+  char *a, *b;
+  size_t i;
+
+  mp_set_memory_functions(lizard_heap_alloc_atomic, lizard_heap_realloc_atomic,
+                          lizard_heap_free_wrapper);
+  local_heap = lizard_heap_create(1024U * 1024U, 16U * 1024U * 1024U);
+  heap = local_heap;
+
+  lizard_test_call(fill);
+  lizard_test_clobber_stack();
+  (void)lizard_gc_collect_objects(local_heap, NULL);
+
+  /* Nearly everything the payloads seem to point at is gone; a stray
+   * copy on the stack or in a register may keep the odd one. */
+  TEST_ASSERT(lizard_test_count_tracked(local_heap, hidden_atomic, 4U * N) <=
+              4U);
+  /* The holders themselves are live, and so is what they do point at. */
+  for (i = 0U; i < N; i++) {
+    TEST_ASSERT(lizard_test_tracked(local_heap, lizard_test_hide(strings[i])));
+    TEST_ASSERT(lizard_test_tracked(
+        local_heap, lizard_test_hide(numbers[i]->data.number->_mp_d)));
+    TEST_ASSERT(lizard_test_tracked(local_heap, lizard_test_hide(reals[i])));
+    TEST_ASSERT(lizard_test_tracked(local_heap, lizard_test_hide(copies[i])) &&
+                copies[i]->type == AST_BOOL && copies[i]->data.boolean);
+    TEST_ASSERT(*(void **)raws[i] == lizard_test_unhide(hidden_kept[i]));
+  }
+  TEST_ASSERT((void *)pair->data.pair.car ==
+              lizard_test_unhide(hidden_kept[N]));
+  for (i = 0U; i < N + 3U; i++) {
+    TEST_ASSERT(lizard_test_tracked(local_heap, hidden_kept[i]));
+  }
+  TEST_ASSERT(app->data.app.fun->tag == KT_VAR &&
+              app->data.app.arg->tag == KT_NAT);
+
+  /* Marking says how to trace: by policy, or whole if the kind was
+   * inferred (lookups still give the inferred policy). */
+  a = local_heap->head->start;
+  b = a + 128;
+  table = lizard_gc_metadata_table_create();
+  TEST_ASSERT(lizard_gc_metadata_register(
+      table, a, 64U, LIZARD_GC_OBJECT_AST_NODE, LIZARD_OBJECT_OWNER_HEAP,
+      LIZARD_OBJECT_TRACE_AST));
+  TEST_ASSERT(lizard_gc_metadata_register_inferred(
+      table, b, 64U, LIZARD_GC_OBJECT_AST_NODE, LIZARD_OBJECT_OWNER_HEAP,
+      LIZARD_OBJECT_TRACE_AST));
+  lizard_gc_metadata_prepare_marking(table);
+  TEST_ASSERT(lizard_gc_metadata_mark_object(table, a + 8, NULL, NULL, &kind,
+                                             &trace, NULL));
+  TEST_ASSERT(kind == LIZARD_GC_OBJECT_AST_NODE &&
+              trace == LIZARD_OBJECT_TRACE_AST);
+  TEST_ASSERT(lizard_gc_metadata_mark_object(table, b, NULL, NULL, &kind,
+                                             &trace, NULL));
+  TEST_ASSERT(kind == LIZARD_GC_OBJECT_AST_NODE &&
+              trace == LIZARD_OBJECT_TRACE_CONSERVATIVE);
+  TEST_ASSERT(lizard_gc_metadata_lookup(table, b, NULL, NULL, &trace));
+  TEST_ASSERT_EQ(trace, LIZARD_OBJECT_TRACE_AST);
+  lizard_gc_metadata_table_destroy(table);
+
+  lizard_heap_destroy(local_heap);
+  heap = NULL;
+  TEST_RETURN();
+}
@@ -0,0 +1,68 @@
+/* tests/global_cache_test.c
+ *
+ * Inline caches on global references (lizard_env_lookup_site): a cached
+ * reference follows redefinition and set!, sees a binding that appears
+ * later in a frame between the use and the global env, and does not carry
+ * its cell over to another environment.  Both evaluators and the VM.
+ */
+#include "test_harness.h"
+#include "test_helpers.h"
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  lizard_ast_node_t *sym;
+  lizard_env_t *child;
+  lizard_env_t *other;
+  lizard_test_env_init(&e);
+
+  /* Redefinition, set!, and a name bound only after its first use. */
+  r = lizard_test_eval(&e, "(define g 1) (define (get-g) g) (get-g)");
+  TEST_ASSERT(lizard_test_is_int(r, 1));
+  r = lizard_test_eval(&e, "(define g 2) (get-g)");
+  TEST_ASSERT(lizard_test_is_int(r, 2));
+  r = lizard_test_eval(&e, "(set! g 3) (get-g)");
+  TEST_ASSERT(lizard_test_is_int(r, 3));
+  r = lizard_test_eval(&e, "(define (get-late) late) (get-late)");
+  TEST_ASSERT(lizard_test_is_error(r));
+  r = lizard_test_eval(&e, "(define late 4) (get-late)");
+  TEST_ASSERT(lizard_test_is_int(r, 4));
+
+  /* A hot loop through cached references, with a procedure redefined
+   * between runs. */
+  r = lizard_test_eval(&e,
+                       "(define (step x) (+ x 1))"
+                       "(define (run n acc) (if (= n 0) acc (run (- n 1) (step acc))))"
+                       "(run 1000 0)");
+  TEST_ASSERT(lizard_test_is_int(r, 1000));
+  r = lizard_test_eval(&e, "(define (step x) (+ x 2)) (run 1000 0)");
+  TEST_ASSERT(lizard_test_is_int(r, 2000));
+
+  /* The same reference in a child env, which later gains its own binding,
+   * and in an unrelated env. */
+  sym = ((lizard_ast_list_node_t *)lizard_parse(lizard_tokenize("g"), e.heap)
+             ->head)->ast;
+  child = lizard_env_create(e.heap, e.env);
+  r = lizard_eval(sym, child, e.heap, lizard_identity_cont);
+  TEST_ASSERT(lizard_test_is_int(r, 3));
+  lizard_env_define(e.heap, child, "g", lizard_make_fixnum(e.heap, 9));
+  r = lizard_eval(sym, child, e.heap, lizard_identity_cont);
+  TEST_ASSERT(lizard_test_is_int(r, 9));
+  r = lizard_eval(sym, e.env, e.heap, lizard_identity_cont);
+  TEST_ASSERT(lizard_test_is_int(r, 3));
+  other = lizard_env_create(e.heap, NULL);
+  lizard_env_define(e.heap, other, "g", lizard_make_fixnum(e.heap, 7));
+  r = lizard_eval(sym, other, e.heap, lizard_identity_cont);
+  TEST_ASSERT(lizard_test_is_int(r, 7));
+  r = lizard_eval(sym, e.env, e.heap, lizard_identity_cont);
+  TEST_ASSERT(lizard_test_is_int(r, 3));
+
+  /* OP_LOAD. */
+  r = lizard_test_eval(&e, "(define h 5) (vm-eval 'h)");
+  TEST_ASSERT(lizard_test_is_int(r, 5));
+  r = lizard_test_eval(&e, "(set! h 6) (vm-eval 'h)");
+  TEST_ASSERT(lizard_test_is_int(r, 6));
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
@@ -0,0 +1,80 @@
+/* tests/heap_size_class_test.c
+ *
+ * The size-class allocator: a request is rounded up to its class and
+ * registered at that size, a class bump-allocates from a region of its
+ * own, a reclaimed chunk serves any request of its class, realloc grows
+ * in place within the class, and objects past the largest class live in
+ * the large-object space, outside the segments, where reclaimed runs are
+ * reused.
+ */
+#include "gc.h"
+#include "mem.h"
+#include "test_harness.h"
+
+#include <string.h>
+
+static int in_segments(lizard_heap_t *h, const void *ptr) {
+  lizard_heap_segment_t *seg;
+  for (seg = h->head; seg != NULL; seg = seg->next) {
+    if ((const char *)ptr >= seg->start && (const char *)ptr < seg->end) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main(void) {
+  lizard_heap_t *local_heap;
+  lizard_gc_stats_t stats;
+  char *a, *b, *c, *big, *again;
+  size_t size;
+
+  local_heap = lizard_heap_create(1024U * 1024U, 16U * 1024U * 1024U);
+  heap = local_heap;
+
+  /* 41 bytes is in the 48-byte class; 100 in the 112-byte one. */
+  a = (char *)lizard_heap_alloc(41U);
+  b = (char *)lizard_heap_alloc(100U);
+  c = (char *)lizard_heap_alloc(48U);
+  TEST_ASSERT(lizard_gc_metadata_lookup_object(local_heap, a, NULL, &size,
+                                               NULL));
+  TEST_ASSERT_EQ(size, 48U);
+  TEST_ASSERT(lizard_gc_metadata_lookup_object(local_heap, b, NULL, &size,
+                                               NULL));
+  TEST_ASSERT_EQ(size, 112U);
+  /* A class's objects sit side by side whatever else is allocated. */
+  TEST_ASSERT(c == a + 48);
+
+  /* A chunk freed from one size in the class serves another. */
+  lizard_heap_reclaim(c, 48U);
+  TEST_ASSERT((char *)lizard_heap_alloc(44U) == c);
+  lizard_heap_reclaim(a, 48U);
+  a[8] = 'x';
+  TEST_ASSERT((char *)lizard_heap_alloc(48U) == a && a[8] == '\0');
+
+  /* Growing within the class keeps the chunk; past it, copies. */
+  memset(b, 'b', 100U);
+  TEST_ASSERT((char *)lizard_heap_realloc(b, 100U, 112U) == b);
+  c = (char *)lizard_heap_realloc(b, 112U, 200U);
+  TEST_ASSERT(c != b && c[0] == 'b' && c[99] == 'b');
+
+  /* Large objects: apart from the segments, runs reused when reclaimed. */
+  big = (char *)lizard_heap_alloc(LIZARD_HEAP_SMALL_MAX + 1U);
+  TEST_ASSERT(big != NULL && !in_segments(local_heap, big));
+  TEST_ASSERT(lizard_gc_metadata_lookup_object(local_heap, big, NULL, &size,
+                                               NULL));
+  TEST_ASSERT(size > LIZARD_HEAP_SMALL_MAX);
+  TEST_ASSERT((char *)lizard_heap_realloc(big, LIZARD_HEAP_SMALL_MAX + 1U,
+                                          size) == big);
+  big[0] = 'z';
+  lizard_heap_reclaim(big, size);
+  again = (char *)lizard_heap_alloc(LIZARD_HEAP_SMALL_MAX + 64U);
+  TEST_ASSERT(again == big && again[0] == '\0');
+  TEST_ASSERT((char *)lizard_heap_alloc(64U * 1024U) != big);
+  lizard_gc_collect_stats(local_heap, NULL, 0, &stats);
+  TEST_ASSERT(stats.total_bytes_allocated >= 64U * 1024U);
+
+  lizard_heap_destroy(local_heap);
+  heap = NULL;
+  TEST_RETURN();
+}
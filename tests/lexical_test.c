@@ -0,0 +1,106 @@
+/* tests/lexical_test.c
+ *
+ * Lexical addressing (src/lexical.c): lambda bodies resolved to
+ * (depth, slot) references over vector-backed frames.  Checks the frame
+ * layout the resolver produces, then that resolved closures agree with
+ * by-name semantics for parameters, rest lists, internal defines, set!,
+ * shadowing through let, and environments grown past the index threshold.
+ */
+#include "lexical.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#include <stdio.h>
+#include <string.h>
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  lizard_frame_layout_t *layout;
+  char src[128];
+  int i;
+  lizard_test_env_init(&e);
+
+  /* Layout: required parameters, then the rest slot, then body defines. */
+  r = lizard_test_eval(&e, "(define (shape a b . more) (define tmp a) tmp)"
+                           "shape");
+  TEST_ASSERT(r != NULL && r->type == AST_LAMBDA);
+  layout = r->data.lambda.layout;
+  TEST_ASSERT(layout != NULL && layout->resolved);
+  TEST_ASSERT_EQ(layout->nparams, 2U);
+  TEST_ASSERT(layout->rest);
+  TEST_ASSERT_EQ(layout->nslots, 4U);
+  TEST_ASSERT_STR(layout->names[2], "more");
+  TEST_ASSERT_STR(layout->names[3], "tmp");
+  TEST_ASSERT(layout->body != NULL &&
+              layout->body->head != layout->body->nil);
+
+  /* Duplicate parameters stay on the by-name path. */
+  r = lizard_test_eval(&e, "(define (dup x x) x) dup");
+  TEST_ASSERT(r != NULL && r->type == AST_LAMBDA);
+  TEST_ASSERT(r->data.lambda.layout != NULL &&
+              !r->data.lambda.layout->resolved);
+  r = lizard_test_eval(&e, "(dup 1 2)");
+  TEST_ASSERT(lizard_test_is_int(r, 2));
+
+  /* Rest lists and arity. */
+  r = lizard_test_eval(&e, "(shape 1 2 3 4)");
+  TEST_ASSERT(lizard_test_is_int(r, 1));
+  r = lizard_test_eval(&e, "(define (tail a . more) more) (tail 1 2 3)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(2 3)");
+  r = lizard_test_eval(&e, "(tail 1)");
+  TEST_ASSERT_STR(lizard_test_format(r), "()");
+  r = lizard_test_eval(&e, "(shape 1)");
+  TEST_ASSERT(lizard_test_is_error(r));
+  r = lizard_test_eval(&e, "((lambda (x) x) 1 2)");
+  TEST_ASSERT(lizard_test_is_error(r));
+
+  /* Free variables through two closure levels, and set! on a captured
+   * slot seen by a sibling closure. */
+  r = lizard_test_eval(&e,
+                       "(define (outer a)"
+                       "  (lambda (b) (lambda (c) (list a b c))))"
+                       "(((outer 1) 2) 3)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(1 2 3)");
+  r = lizard_test_eval(&e,
+                       "(define (cell v)"
+                       "  (define (get) v)"
+                       "  (define (put! x) (set! v x))"
+                       "  (list get put!))"
+                       "(define p (cell 1))"
+                       "((car (cdr p)) 42)"
+                       "((car p))");
+  TEST_ASSERT(lizard_test_is_int(r, 42));
+
+  /* let introduces by-name frames between resolved ones; shadowing must
+   * still find the innermost binding. */
+  r = lizard_test_eval(&e,
+                       "(define (shadow x)"
+                       "  (let ((x (* x 10)))"
+                       "    (let ((y x)) (+ x y))))"
+                       "(shadow 2)");
+  TEST_ASSERT(lizard_test_is_int(r, 40));
+
+  /* Quoted symbols are data, not references. */
+  r = lizard_test_eval(&e, "(define (q x) '(x y)) (q 1)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(x y)");
+
+  /* Deep tail recursion through a resolved frame. */
+  r = lizard_test_eval(&e,
+                       "(define (sum i acc)"
+                       "  (if (= i 0) acc (sum (- i 1) (+ acc i))))"
+                       "(sum 10000 0)");
+  TEST_ASSERT(lizard_test_is_int(r, 50005000));
+
+  /* Global frame past the index threshold: defines, redefines, set!. */
+  for (i = 0; i < 64; i++) {
+    sprintf(src, "(define lexical-g%d %d)", i, i);
+    lizard_test_eval(&e, src);
+  }
+  r = lizard_test_eval(&e, "(define lexical-g7 700) (set! lexical-g9 900)"
+                           "(+ lexical-g7 lexical-g9 lexical-g63)");
+  TEST_ASSERT(lizard_test_is_int(r, 1663));
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
@@ -0,0 +1,124 @@
+/* tests/macro_memo_test.c
+ *
+ * Macro uses the expander does not reach before evaluation (cond clauses)
+ * are expanded when the evaluator meets them, once per source form: later
+ * passes reuse the expansion until the macro is redefined.  A transformer
+ * that counts its own calls makes the number of expansions visible.  Uses
+ * in resolved bodies expand from the names of their arguments, so macros
+ * may assign and quote them, and the memo lets go of forms no longer
+ * reachable.
+ */
+#include "gc.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#include <stdio.h>
+
+/* Objects tracked after a full collection. */
+static size_t tracked_after_gc(lizard_test_env_t *e) {
+  lizard_gc_metadata_stats_t stats;
+  (void)lizard_gc_collect_objects(e->heap, e->env);
+  lizard_gc_metadata_collect_stats(e->heap->gc_metadata, &stats);
+  return stats.entries;
+}
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  char src[96];
+  size_t before;
+  int i;
+  lizard_test_env_init(&e);
+
+  r = lizard_test_eval(&e,
+                       "(define expansions 0)"
+                       "(define-syntax twice"
+                       "  (lambda (x)"
+                       "    (set! expansions (+ expansions 1))"
+                       "    `(* ,x 2)))"
+                       "(define (f n) (cond ((> n 0) (twice n)) (else 0)))"
+                       "(define (sum i acc) (if (= i 0) acc (sum (- i 1) (+ acc (f i)))))"
+                       "(sum 100 0)");
+  TEST_ASSERT(lizard_test_is_int(r, 10100));
+  r = lizard_test_eval(&e, "expansions");
+  TEST_ASSERT(lizard_test_is_int(r, 1));
+
+  /* A second use site is a second form. */
+  r = lizard_test_eval(&e,
+                       "(define (g n) (cond (else (twice (+ n 1)))))"
+                       "(list (g 1) (g 2) (f 5))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(4 6 10)");
+  r = lizard_test_eval(&e, "expansions");
+  TEST_ASSERT(lizard_test_is_int(r, 2));
+
+  /* Redefining the macro invalidates both entries. */
+  r = lizard_test_eval(&e,
+                       "(define-syntax twice"
+                       "  (lambda (x)"
+                       "    (set! expansions (+ expansions 1))"
+                       "    `(+ ,x ,x 1)))"
+                       "(list (f 5) (f 6) (g 1))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(11 13 5)");
+  r = lizard_test_eval(&e, "expansions");
+  TEST_ASSERT(lizard_test_is_int(r, 4));
+
+  /* syntax-rules uses, and a use no rule matches. */
+  r = lizard_test_eval(&e,
+                       "(define-syntax swap-args"
+                       "  (syntax-rules () ((_ f a b) (f b a))))"
+                       "(define (h a b) (cond (#t (swap-args - a b))))"
+                       "(list (h 1 10) (h 2 10))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(9 8)");
+  r = lizard_test_eval(&e, "(define (bad) (cond (#t (swap-args 1)))) (bad)");
+  TEST_ASSERT(lizard_test_is_error(r));
+
+  /* Enough distinct use sites to grow the table. */
+  for (i = 0; i < 100; i++) {
+    sprintf(src, "(define (site%d) (cond (#t (twice %d)))) (site%d)", i, i, i);
+    r = lizard_test_eval(&e, src);
+    TEST_ASSERT(lizard_test_is_int(r, 2 * i + 1));
+  }
+  r = lizard_test_eval(&e, "(list (site0) (site99) expansions)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(1 199 104)");
+
+  /* Macros that assign their arguments, or quote them. */
+  r = lizard_test_eval(&e,
+                       "(define-syntax inc! (syntax-rules () ((_ v) (set! v (+ v 1)))))"
+                       "(define (bump x) (cond ((> x 0) (inc! x) x) (else 0)))"
+                       "(list (bump 1) (bump 41) (bump 0))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(2 42 0)");
+  r = lizard_test_eval(&e,
+                       "(define-syntax swap!"
+                       "  (syntax-rules ()"
+                       "    ((_ a b) (let ((tmp a)) (set! a b) (set! b tmp)))))"
+                       "(define (flip a b) (cond (#t (swap! a b) (list a b))))"
+                       "(flip 1 2)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(2 1)");
+  r = lizard_test_eval(&e,
+                       "(define-syntax name-of (syntax-rules () ((_ v) 'v)))"
+                       "(define (which x) (cond (#t (name-of x))))"
+                       "(which 3)");
+  TEST_ASSERT(lizard_test_is_symbol(r, "x"));
+  r = lizard_test_eval(&e,
+                       "(define (count-up i acc)"
+                       "  (cond ((= i 0) acc) (else (inc! acc) (count-up (- i 1) acc))))"
+                       "(count-up 1000 0)");
+  TEST_ASSERT(lizard_test_is_int(r, 1000));
+
+  /* Use sites that become garbage take their entries with them. */
+  before = 0U;
+  for (i = 0; i < 400; i++) {
+    if (i == 100) {
+      before = tracked_after_gc(&e);
+    }
+    sprintf(src, "(define (tmp) (cond (#t (twice %d)))) (tmp)", i);
+    r = lizard_test_eval(&e, src);
+    TEST_ASSERT(lizard_test_is_int(r, 2 * i + 1));
+  }
+  TEST_ASSERT(tracked_after_gc(&e) < before + 300U);
+  r = lizard_test_eval(&e, "(list (site0) (site99) (bump 1))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(1 199 2)");
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
@@ -0,0 +1,160 @@
+/* tests/optimize_test.c
+ *
+ * The optimisation pass (src/optimize.c) on expanded forms: pure built-ins
+ * on literals fold, literal if/cond tests pick their branch, and small
+ * procedures defined in a body are inlined at their calls.  Also what it
+ * must leave alone — shadowed and assigned names, errors, quoted data,
+ * macro arguments, recursive procedures, calls that run only after a later
+ * form may have rebound the built-in — and that the source form is never
+ * modified.
+ */
+#include "optimize.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#include <string.h>
+
+/* Expand and optimise the first form of `src`; the parsed form in *orig. */
+static lizard_ast_node_t *optimize_first(lizard_test_env_t *e, const char *src,
+                                         lizard_ast_node_t **orig) {
+  lz_list_t *asts = lizard_parse(lizard_tokenize(src), e->heap);
+  lizard_ast_node_t *form = ((lizard_ast_list_node_t *)asts->head)->ast;
+  form = lizard_expand_macros(form, e->env, e->heap);
+  if (orig != NULL) {
+    *orig = form;
+  }
+  return lizard_optimize(form, e->env, e->heap);
+}
+
+/* Last body form of the lambda a `(define (f ...) ...)` binds. */
+static lizard_ast_node_t *last_body_form(lizard_ast_node_t *def) {
+  lz_list_t *parts = def->data.definition.value->data.lambda.parameters;
+  lz_list_node_t *it = parts->head;
+  while (it->next != parts->nil) {
+    it = it->next;
+  }
+  return ((lizard_ast_list_node_t *)it)->ast;
+}
+
+static int calls(lizard_ast_node_t *node, const char *name) {
+  lizard_ast_node_t *op;
+  if (node == NULL || node->type != AST_APPLICATION) {
+    return 0;
+  }
+  op = ((lizard_ast_list_node_t *)node->data.application_arguments->head)->ast;
+  return op->type == AST_SYMBOL && strcmp(op->data.variable, name) == 0;
+}
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  lizard_ast_node_t *orig;
+  lizard_test_env_init(&e);
+
+  /* Folding, nested and over every numeric tower level. */
+  r = optimize_first(&e, "(* 2 (+ 3 4))", &orig);
+  TEST_ASSERT(lizard_test_is_int(r, 14));
+  TEST_ASSERT(orig->type == AST_APPLICATION);
+  r = optimize_first(&e, "(< (/ 1 3) 0.5)", NULL);
+  TEST_ASSERT(lizard_test_is_true(r));
+  r = optimize_first(&e, "(string=? \"a\" \"a\")", NULL);
+  TEST_ASSERT(lizard_test_is_true(r));
+
+  /* Errors are left to happen at run time. */
+  r = optimize_first(&e, "(/ 1 0)", NULL);
+  TEST_ASSERT(r->type == AST_APPLICATION);
+  TEST_ASSERT(lizard_test_is_error(lizard_test_eval(&e, "(/ 1 0)")));
+
+  /* Dead branches. */
+  r = optimize_first(&e, "(if (> 2 1) 'yes (car '()))", NULL);
+  TEST_ASSERT(r->type == AST_QUOTE);
+  r = optimize_first(&e, "(cond (#f 1) ((= 1 2) 2) ((< 1 2) 3 4) (else 5))", NULL);
+  TEST_ASSERT(r->type == AST_BEGIN);
+  r = optimize_first(&e, "(cond ((= 1 2) 1))", NULL);
+  TEST_ASSERT(r->type == AST_NIL);
+  r = optimize_first(&e, "(define (pick x) (cond (#f 1) ((> x 0) 2) (else 3)))",
+                     NULL);
+  r = last_body_form(r);
+  TEST_ASSERT(r->type == AST_COND &&
+              r->data.cond_clauses->head->next->next == r->data.cond_clauses->nil);
+  TEST_ASSERT_STR(lizard_test_format(lizard_test_eval(
+                      &e, "(define (pick x) (cond ((= 1 2) 1) ((> x 0) 2) (else 3)))"
+                          "(list (pick 1) (pick -1))")),
+                  "(2 3)");
+
+  /* Not folded: shadowed names, quoted data, macro arguments. */
+  r = optimize_first(&e, "(lambda (+) (+ 1 2))", &orig);
+  TEST_ASSERT(r == orig);
+  r = optimize_first(&e, "'(+ 1 2)", &orig);
+  TEST_ASSERT(r == orig);
+  lizard_test_eval(&e, "(define-syntax keep (syntax-rules () ((_ x) 'x)))");
+  r = optimize_first(&e, "(define (k) (cond (#t (keep (+ 1 2)))))", NULL);
+  TEST_ASSERT(calls(last_body_form(r), "keep"));
+  TEST_ASSERT_STR(lizard_test_format(lizard_test_eval(
+                      &e, "(define (k) (cond (#t (keep (+ 1 2))))) (k)")),
+                  "(+ 1 2)");
+
+  /* Inlining a body procedure; what it became is not folded, since the
+   * body runs later. */
+  r = optimize_first(&e, "(define (f n) (define (sq x) (* x x)) (sq n))", NULL);
+  TEST_ASSERT(calls(last_body_form(r), "*"));
+  r = optimize_first(&e, "(define (f) (define (sq x) (* x x)) (+ (sq 3) (sq 4)))",
+                     NULL);
+  TEST_ASSERT(calls(last_body_form(r), "+"));
+  TEST_ASSERT(calls(((lizard_ast_list_node_t *)last_body_form(r)
+                         ->data.application_arguments->head->next)
+                        ->ast,
+                    "*"));
+  r = lizard_test_eval(&e,
+                       "(define (f n) (define (sq x) (* x x))"
+                       "  (define (add1 y) (+ y 1)) (add1 (sq n)))"
+                       "(f 7)");
+  TEST_ASSERT(lizard_test_is_int(r, 50));
+
+  /* Not inlined: recursion, assignment of the procedure or of an
+   * argument, and a free name shadowed at the call. */
+  r = optimize_first(&e,
+                     "(define (f n) (define (down x) (if (= x 0) 0 (down (- x 1))))"
+                     "  (down n))",
+                     NULL);
+  TEST_ASSERT(calls(last_body_form(r), "down"));
+  r = optimize_first(&e,
+                     "(define (f n) (define (id x) x) (set! id car) (id n))", NULL);
+  TEST_ASSERT(calls(last_body_form(r), "id"));
+  r = optimize_first(&e,
+                     "(define (f n) (define (id x) x) (set! n 2) (id n))", NULL);
+  TEST_ASSERT(calls(last_body_form(r), "id"));
+  r = lizard_test_eval(&e,
+                       "(define (f n) (define k 10) (define (addk x) (+ x k))"
+                       "  (lambda (k) (addk k)))"
+                       "((f 0) 1)");
+  TEST_ASSERT(lizard_test_is_int(r, 11));
+
+  /* set! of a built-in anywhere stops folding it from then on. */
+  r = optimize_first(&e, "(abs -5)", NULL);
+  TEST_ASSERT(lizard_test_is_int(r, 5));
+  lizard_test_eval(&e, "(define (break-abs) (set! abs square))");
+  r = optimize_first(&e, "(abs -5)", NULL);
+  TEST_ASSERT(calls(r, "abs"));
+  r = lizard_test_eval(&e, "(break-abs) (abs -5)");
+  TEST_ASSERT(lizard_test_is_int(r, 25));
+  r = lizard_test_eval(&e, "(begin (define (abs x) 0) (abs -5))");
+  TEST_ASSERT(lizard_test_is_int(r, 0));
+
+  /* Built-ins rebound after a procedure using them was defined. */
+  r = optimize_first(&e, "(define (three) (+ 1 2))", NULL);
+  TEST_ASSERT(calls(last_body_form(r), "+"));
+  r = lizard_test_eval(&e,
+                       "(define (three) (+ 1 2))"
+                       "(define (six) (* 2 3))"
+                       "(list (three) (six))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(3 6)");
+  r = lizard_test_eval(&e,
+                       "(set! + -)"
+                       "(define (* a b) 0)"
+                       "(list (three) (six))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(-1 0)");
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
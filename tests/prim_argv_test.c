@@ -0,0 +1,97 @@
+/* tests/prim_argv_test.c
+ *
+ * The (argc, argv) primitive calling convention: hot primitives carry an
+ * argv entry next to their list entry, both give the same answers, and
+ * lizard_primitive_call reaches list-only primitives too.  Also exercises
+ * the evaluator paths that fill a C buffer or a closure frame directly:
+ * more arguments than the buffer holds, error arguments, and arity.
+ */
+#include "primitives.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r, *prim;
+  lizard_ast_node_t *argv[3];
+  lz_list_t *args;
+  lizard_ast_list_node_t n0, n1;
+  lizard_test_env_init(&e);
+
+  /* Installed nodes: hot primitives have both entries, others only one. */
+  prim = lizard_test_eval(&e, "+");
+  TEST_ASSERT(prim->type == AST_PRIMITIVE);
+  TEST_ASSERT(prim->data.primitive.fn == lizard_primitive_plus);
+  TEST_ASSERT(prim->data.primitive.argv == lizard_primitive_plus_argv);
+  r = lizard_test_eval(&e, "vector-ref");
+  TEST_ASSERT(r->data.primitive.argv == lizard_primitive_vec_ref_argv);
+  r = lizard_test_eval(&e, "hash-ref");
+  TEST_ASSERT(r->data.primitive.argv == lizard_primitive_hash_ref_argv);
+  r = lizard_test_eval(&e, "display");
+  TEST_ASSERT(r->data.primitive.argv == NULL);
+
+  /* Calling through a buffer, and through the list twin. */
+  argv[0] = lizard_make_fixnum(e.heap, 40);
+  argv[1] = lizard_make_fixnum(e.heap, 2);
+  r = lizard_primitive_call(prim, 2, argv, e.env, e.heap);
+  TEST_ASSERT(lizard_test_is_int(r, 42));
+  args = list_create_alloc(lizard_heap_alloc, lizard_heap_free);
+  n0.ast = argv[0];
+  n1.ast = argv[1];
+  list_append(args, &n0.node);
+  list_append(args, &n1.node);
+  r = lizard_primitive_minus(args, e.env, e.heap);
+  TEST_ASSERT(lizard_test_is_int(r, 38));
+  r = lizard_primitive_lt_argv(1, argv, e.env, e.heap);
+  TEST_ASSERT(lizard_test_is_error(r));
+
+  /* A list-only primitive still works through lizard_primitive_call. */
+  r = lizard_test_eval(&e, "append");
+  argv[0] = lizard_test_eval(&e, "'(1)");
+  argv[1] = lizard_test_eval(&e, "'(2 3)");
+  r = lizard_primitive_call(r, 2, argv, e.env, e.heap);
+  TEST_ASSERT_STR(lizard_test_format(r), "(1 2 3)");
+
+  /* More arguments than the C buffer holds take the list path. */
+  r = lizard_test_eval(&e, "(+ 1 2 3 4 5 6 7 8 9 10 11 12)");
+  TEST_ASSERT(lizard_test_is_int(r, 78));
+  r = lizard_test_eval(&e, "(list 1 2 3 4 5 6 7 8 9 10)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(1 2 3 4 5 6 7 8 9 10)");
+  r = lizard_test_eval(&e, "(vector 1 \"a\" 'b)");
+  TEST_ASSERT_STR(lizard_test_format(r), "#(1 \"a\" b)");
+
+  /* An argument that errors is the result; later ones are not evaluated. */
+  r = lizard_test_eval(&e, "(define hits 0)"
+                           "(define (bump) (set! hits (+ hits 1)) hits)"
+                           "(+ (car '()) (bump))");
+  TEST_ASSERT(lizard_test_is_error(r));
+  r = lizard_test_eval(&e, "hits");
+  TEST_ASSERT(lizard_test_is_int(r, 0));
+
+  /* Closures called with exactly their arity bind straight into the frame;
+   * other shapes still report arity errors or collect rest arguments. */
+  r = lizard_test_eval(&e, "(define (add3 a b c) (+ a b c)) (add3 1 2 3)");
+  TEST_ASSERT(lizard_test_is_int(r, 6));
+  r = lizard_test_eval(&e, "(add3 1 2)");
+  TEST_ASSERT(lizard_test_is_error(r));
+  r = lizard_test_eval(&e, "(add3 1 2 3 4)");
+  TEST_ASSERT(lizard_test_is_error(r));
+  r = lizard_test_eval(&e, "(define (tail a . more) more) (tail 1 2 3)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(2 3)");
+
+  /* Hot loop over vectors and hash tables. */
+  r = lizard_test_eval(&e,
+                       "(define v (make-vector 100 0))"
+                       "(define h (make-hash-table))"
+                       "(define (fill i)"
+                       "  (if (< i 100)"
+                       "      (begin (vector-set! v i (* i i))"
+                       "             (hash-set! h i (vector-ref v i))"
+                       "             (fill (+ i 1)))"
+                       "      (hash-ref h 99)))"
+                       "(fill 0)");
+  TEST_ASSERT(lizard_test_is_int(r, 9801));
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
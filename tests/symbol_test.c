@@ -0,0 +1,95 @@
+/* tests/symbol_test.c — unit tests for the symbol interning table
+ * (src/symbol.c) and the pointer-equality environment lookup built on it.
+ * Covers canonicalisation, growth past the initial capacity, lookups with
+ * non-interned spellings, and that the reader and string->symbol produce the
+ * canonical pointer. */
+#include "env.h"
+#include "lizard_api.h"
+#include "mem.h"
+#include "symbol.h"
+#include "test_harness.h"
+
+#include <stdio.h>
+#include <string.h>
+
+int main(void) {
+  char buf[64];
+  char spelled[16];
+  const char *a, *b, *first, *again;
+  lizard_env_t *global, *local;
+  lizard_ast_node_t *one, *two;
+  lizard_runtime_options_t options;
+  lizard_runtime_t *runtime;
+  lizard_context_t *context;
+  lizard_value_t *value;
+  lizard_status_t status;
+  size_t before;
+  int i;
+
+  heap = lizard_heap_create(1u << 16, 1u << 16);
+  TEST_ASSERT(heap != NULL);
+
+  /* same spelling, same pointer; distinct storage from the argument */
+  strcpy(spelled, "alpha");
+  a = lizard_intern(spelled);
+  b = lizard_intern("alpha");
+  TEST_ASSERT(a == b);
+  TEST_ASSERT(a != spelled);
+  TEST_ASSERT_STR(a, "alpha");
+  TEST_ASSERT(lizard_intern("beta") != a);
+  TEST_ASSERT(lizard_intern("alphabet") != a);
+  TEST_ASSERT(lizard_symbol_find("alpha") == a);
+  TEST_ASSERT(lizard_symbol_find("never-interned-name") == NULL);
+
+  /* growth keeps previously returned pointers canonical */
+  first = lizard_intern("sym-0");
+  before = lizard_symbol_count();
+  for (i = 0; i < 5000; i++) {
+    sprintf(buf, "sym-%d", i);
+    lizard_intern(buf);
+  }
+  TEST_ASSERT_EQ(lizard_symbol_count(), before + 4999U);
+  again = lizard_intern("sym-0");
+  TEST_ASSERT(again == first);
+  sprintf(buf, "sym-%d", 4321);
+  TEST_ASSERT_STR(lizard_symbol_find(buf), "sym-4321");
+
+  /* environments store interned names and accept any spelling */
+  one = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  one->type = AST_BOOL;
+  one->data.boolean = true;
+  two = lizard_heap_alloc(sizeof(lizard_ast_node_t));
+  two->type = AST_BOOL;
+  two->data.boolean = false;
+  global = lizard_env_create(heap, NULL);
+  local = lizard_env_create(heap, global);
+  strcpy(spelled, "gamma");
+  lizard_env_define(heap, global, spelled, one);
+  TEST_ASSERT(global->entries->symbol == lizard_intern("gamma"));
+  TEST_ASSERT(lizard_env_lookup(local, lizard_intern("gamma")) == one);
+  TEST_ASSERT(lizard_env_lookup(local, "gamma") == one);
+  TEST_ASSERT(lizard_env_lookup(local, "delta") == NULL);
+  TEST_ASSERT(lizard_env_lookup(local, lizard_intern("alpha")) == NULL);
+  TEST_ASSERT_EQ(lizard_env_set(local, "gamma", two), 1);
+  TEST_ASSERT(lizard_env_lookup(global, "gamma") == two);
+  TEST_ASSERT_EQ(lizard_env_set(local, "delta", one), 0);
+
+  /* the reader, string->symbol and define agree on the canonical name */
+  lizard_runtime_options_default(&options);
+  runtime = lizard_runtime_create(&options);
+  TEST_ASSERT(runtime != NULL);
+  context = lizard_context_create(runtime);
+  TEST_ASSERT(context != NULL);
+  value = NULL;
+  status = lizard_context_eval_string(
+      context,
+      "(define interned-x 7) (equal? 'interned-x (string->symbol \"interned-x\"))",
+      &value);
+  TEST_ASSERT_EQ(status, LIZARD_STATUS_OK);
+  TEST_ASSERT(value != NULL && value->type == AST_BOOL && value->data.boolean);
+  TEST_ASSERT(lizard_symbol_find("interned-x") != NULL);
+  lizard_context_destroy(context);
+  lizard_runtime_destroy(runtime);
+
+  TEST_RETURN();
+}
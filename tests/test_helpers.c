@@ -5,13 +5,16 @@
  */
 #include "test_helpers.h"
 
+#include "gc.h"
+#include "optimize.h"
+
 #include <gmp.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 void lizard_test_env_init(lizard_test_env_t *e) {
-  mp_set_memory_functions(lizard_heap_alloc, lizard_heap_realloc,
+  mp_set_memory_functions(lizard_heap_alloc_atomic, lizard_heap_realloc_atomic,
                           lizard_heap_free_wrapper);
   e->heap = lizard_heap_create(1024 * 1024, 16 * 1024 * 1024);
   heap = e->heap; /* publish to the library globals */
@@ -40,6 +43,7 @@ lizard_ast_node_t *lizard_test_eval(lizard_test_env_t *e, const char *src) {
     lizard_ast_node_t *expanded;
     expanded = lizard_expand_macros(((lizard_ast_list_node_t *)iter)->ast,
                                     e->env, e->heap);
+    expanded = lizard_optimize(expanded, e->env, e->heap);
     result = lizard_eval(expanded, e->env, e->heap, lizard_identity_cont);
     if (result && result->type == AST_ERROR) {
       return result;
@@ -48,6 +52,55 @@ lizard_ast_node_t *lizard_test_eval(lizard_test_env_t *e, const char *src) {
   return result;
 }
 
+lizard_ast_node_t *lizard_test_vm_eval(lizard_test_env_t *e, const char *src) {
+  return lizard_test_vm_eval_profiled(e, src, NULL);
+}
+
+lizard_ast_node_t *lizard_test_vm_eval_profiled(lizard_test_env_t *e,
+                                                const char *src,
+                                                lizard_vm_profile_t *prof) {
+  lz_list_t *asts = lizard_parse(lizard_tokenize(src), e->heap);
+  lz_list_node_t *iter;
+  lizard_ast_node_t *result = NULL;
+
+  for (iter = asts->head; iter != asts->nil; iter = iter->next) {
+    lizard_bc_chunk_t *chunk =
+        lizard_compile(((lizard_ast_list_node_t *)iter)->ast, e->heap);
+    if (chunk == NULL) {
+      return NULL;
+    }
+    result = prof != NULL
+                 ? lizard_vm_exec_profiled(chunk, e->env, e->heap, prof)
+                 : lizard_vm_exec(chunk, e->env, e->heap);
+  }
+  return result;
+}
+
+lizard_bc_chunk_t *lizard_test_closure_chunk(const lizard_bc_chunk_t *c,
+                                             int pc) {
+  lizard_bc_chunk_t *sub;
+  memcpy(&sub, &c->constants[c->code[pc].arg]->data.string, sizeof(sub));
+  return sub;
+}
+
+lizard_bc_chunk_t *lizard_test_lambda_chunk(lizard_test_env_t *e,
+                                            const char *src) {
+  lz_list_t *asts = lizard_parse(lizard_tokenize(src), e->heap);
+  lizard_bc_chunk_t *c =
+      lizard_compile(((lizard_ast_list_node_t *)asts->head)->ast, e->heap);
+  return lizard_test_closure_chunk(c, 0);
+}
+
+int lizard_test_count_op(const lizard_bc_chunk_t *c, lizard_opcode_t op) {
+  int i, n = 0;
+  for (i = 0; i < c->code_count; i++) {
+    if (c->code[i].op == op) {
+      n++;
+    }
+  }
+  return n;
+}
+
 /* Format a value using the public pretty printer into a static buffer.
    For really large output we just truncate — tests typically check
    short, predictable shapes. */
@@ -107,3 +160,39 @@ int lizard_test_is_false(lizard_ast_node_t *node) {
 int lizard_test_is_error(lizard_ast_node_t *node) {
   return node && node->type == AST_ERROR;
 }
+
+#define LIZARD_TEST_MASK ((uintptr_t)0x5a5a5a5aUL)
+
+uintptr_t lizard_test_hide(const void *ptr) {
+  return (uintptr_t)ptr ^ LIZARD_TEST_MASK;
+}
+
+void *lizard_test_unhide(uintptr_t hidden) {
+  return (void *)(hidden ^ LIZARD_TEST_MASK);
+}
+
+int lizard_test_tracked(lizard_heap_t *h, uintptr_t hidden) {
+  return lizard_gc_metadata_lookup_object(h, lizard_test_unhide(hidden), NULL,
+                                          NULL, NULL);
+}
+
+size_t lizard_test_count_tracked(lizard_heap_t *h, const uintptr_t *hidden,
+                                 size_t n) {
+  size_t i, count = 0U;
+  for (i = 0U; i < n; i++) {
+    count += (size_t)lizard_test_tracked(h, hidden[i]);
+  }
+  return count;
+}
+
+/* Out of line, so `fn` cannot be inlined into the test and its frame is
+   gone once it returns. */
+void lizard_test_call(void (*fn)(void)) { fn(); }
+
+void lizard_test_clobber_stack(void) {
+  volatile char junk[64 * 1024];
+  size_t i;
+  for (i = 0U; i < sizeof(junk); i++) {
+    junk[i] = 0;
+  }
+}
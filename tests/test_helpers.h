@@ -13,6 +13,7 @@
 #ifndef LIZARD_TEST_HELPERS_H
 #define LIZARD_TEST_HELPERS_H
 
+#include "bytecode.h"
 #include "env.h"
 #include "lang.h"
 #include "lizard_internal.h"
@@ -22,6 +23,8 @@
 #include "printer.h"
 #include "tokenizer.h"
 
+#include <stdint.h>
+
 typedef struct {
   lizard_heap_t *heap;
   lizard_env_t *env;
@@ -37,6 +40,25 @@ void lizard_test_env_destroy(lizard_test_env_t *e);
    the value of the LAST top-level expression. */
 lizard_ast_node_t *lizard_test_eval(lizard_test_env_t *e, const char *src);
 
+/* Tokenize → parse → lizard_compile → run each form on the VM, return
+   the value of the last one, or NULL if a form does not compile.  The
+   _profiled form profiles every run into `prof` (plain runs if NULL). */
+lizard_ast_node_t *lizard_test_vm_eval(lizard_test_env_t *e, const char *src);
+lizard_ast_node_t *lizard_test_vm_eval_profiled(lizard_test_env_t *e,
+                                                const char *src,
+                                                lizard_vm_profile_t *prof);
+
+/* The chunk made by the OP_CLOSURE at `pc` of `c` (its constant holds the
+   chunk pointer in the bytes of a string node), and the chunk of the
+   lambda that is the first form of `src`. */
+lizard_bc_chunk_t *lizard_test_closure_chunk(const lizard_bc_chunk_t *c,
+                                             int pc);
+lizard_bc_chunk_t *lizard_test_lambda_chunk(lizard_test_env_t *e,
+                                            const char *src);
+
+/* Number of instructions of `c` with opcode `op`. */
+int lizard_test_count_op(const lizard_bc_chunk_t *c, lizard_opcode_t op);
+
 /* Format the given value into a static buffer (truncated if needed)
    and return it. Each call overwrites the buffer; not thread-safe. */
 const char *lizard_test_format(lizard_ast_node_t *node);
@@ -54,4 +76,18 @@ int lizard_test_is_false(lizard_ast_node_t *node);
 /* True if the value is an error with the given numeric code. */
 int lizard_test_is_error(lizard_ast_node_t *node);
 
+/* For GC tests.  An object a test wants collected is kept only as a
+   hidden (masked) address, which the conservative scan does not take
+   for a pointer; lizard_test_tracked says whether `h` still holds the
+   object it points into.  Filling holders in a function run through
+   lizard_test_call, then lizard_test_clobber_stack, leaves no stray
+   copy of what was made on the stack. */
+uintptr_t lizard_test_hide(const void *ptr);
+void *lizard_test_unhide(uintptr_t hidden);
+int lizard_test_tracked(lizard_heap_t *h, uintptr_t hidden);
+size_t lizard_test_count_tracked(lizard_heap_t *h, const uintptr_t *hidden,
+                                 size_t n);
+void lizard_test_call(void (*fn)(void));
+void lizard_test_clobber_stack(void);
+
 #endif /* LIZARD_TEST_HELPERS_H */
@@ -0,0 +1,76 @@
+/* tests/vm_arith_test.c
+ *
+ * Arithmetic in the VM: fixnum operands take the inline paths, small
+ * literal addends compile to OP_ADD_IMM and `if` on =, < or > to a
+ * compare-and-branch.  Everything else — overflow, bignums, rationals,
+ * reals, inexact division, bad operands — gives what the primitives give.
+ */
+#include "bytecode.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+/* Whether the lambda `src` compiles to code containing `op`. */
+static int lambda_uses(lizard_test_env_t *e, const char *src,
+                       lizard_opcode_t op) {
+  return lizard_test_count_op(lizard_test_lambda_chunk(e, src), op) > 0;
+}
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  lizard_test_env_init(&e);
+
+  /* What gets emitted. */
+  TEST_ASSERT(lambda_uses(&e, "(lambda (n) (- n 1))", OP_ADD_IMM));
+  TEST_ASSERT(lambda_uses(&e, "(lambda (n) (+ 2 n))", OP_ADD_IMM));
+  TEST_ASSERT(!lambda_uses(&e, "(lambda (n) (- 1 n))", OP_ADD_IMM));
+  TEST_ASSERT(!lambda_uses(&e, "(lambda (+ n) (+ n 1))", OP_ADD_IMM));
+  TEST_ASSERT(lambda_uses(&e, "(lambda (n) (if (< n 2) n 0))", OP_JUMP_UNLESS_LT));
+  TEST_ASSERT(lambda_uses(&e, "(lambda (n) (if (= n 0) 1 n))", OP_JUMP_UNLESS_EQ));
+  TEST_ASSERT(lambda_uses(&e, "(lambda (n) (if (> n 0) 1 n))", OP_JUMP_UNLESS_GT));
+  TEST_ASSERT(lambda_uses(&e, "(lambda (n) (if (< n 1 2) n 0))", OP_JUMP_IF_FALSE));
+
+  /* Fixnums, and overflow into bignums. */
+  r = lizard_test_vm_eval(&e,
+                          "(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))"
+                          "(fib 20)");
+  TEST_ASSERT(lizard_test_is_int(r, 6765));
+  r = lizard_test_vm_eval(&e,
+                          "(define (count n acc) (if (= n 0) acc (count (- n 1) (+ acc 3))))"
+                          "(count 5000 0)");
+  TEST_ASSERT(lizard_test_is_int(r, 15000));
+  r = lizard_test_vm_eval(&e, "(* 4611686018427387904 4)");
+  TEST_ASSERT_STR(lizard_test_format(r), "18446744073709551616");
+  r = lizard_test_vm_eval(&e, "(define (inc n) (+ n 1)) (inc 9223372036854775807)");
+  TEST_ASSERT_STR(lizard_test_format(r), "9223372036854775808");
+  r = lizard_test_vm_eval(&e, "(- (inc 9223372036854775807) 1)");
+  TEST_ASSERT_STR(lizard_test_format(r), "9223372036854775807");
+  r = lizard_test_vm_eval(&e, "(% -7 3)");
+  TEST_ASSERT(lizard_test_is_int(r, 2));
+
+  /* The rest of the numeric tower. */
+  r = lizard_test_vm_eval(&e, "(/ 8 2)");
+  TEST_ASSERT(lizard_test_is_int(r, 4));
+  r = lizard_test_vm_eval(&e, "(/ 7 2)");
+  TEST_ASSERT_STR(lizard_test_format(r), "7/2");
+  r = lizard_test_vm_eval(&e, "(+ 1/2 1/3)");
+  TEST_ASSERT_STR(lizard_test_format(r), "5/6");
+  r = lizard_test_vm_eval(&e, "(inc 1/2)");
+  TEST_ASSERT_STR(lizard_test_format(r), "3/2");
+  r = lizard_test_vm_eval(&e, "(define (small? x) (if (< x 2) 'yes 'no)) (small? 1.5)");
+  TEST_ASSERT(lizard_test_is_symbol(r, "yes"));
+  r = lizard_test_vm_eval(&e, "(small? 5/2)");
+  TEST_ASSERT(lizard_test_is_symbol(r, "no"));
+  r = lizard_test_vm_eval(&e, "(= 1/2 0.5)");
+  TEST_ASSERT(lizard_test_is_true(r));
+
+  /* Errors come back as errors. */
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "(/ 1 0)")));
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "(% 1 0)")));
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "(inc 'a)")));
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "(small? 'a)")));
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "(< 'a 1)")));
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
@@ -0,0 +1,56 @@
+/* tests/vm_call_prim_test.c
+ *
+ * Calls of globals compile to OP_CALL_PRIM: a primitive, list-only or
+ * (argc, argv), runs on the stacked arguments, and a name rebound to a
+ * closure, tail calls included, still calls whatever it is bound to.
+ */
+#include "bytecode.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#include <stdio.h>
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  lizard_bc_chunk_t *sub;
+  lizard_test_env_init(&e);
+
+  /* What gets emitted: the callee is never pushed. */
+  sub = lizard_test_lambda_chunk(&e, "(lambda (x) (max x 1))");
+  TEST_ASSERT(lizard_test_count_op(sub, OP_CALL_PRIM) == 1 &&
+              lizard_test_count_op(sub, OP_LOAD_GLOBAL) == 0);
+  TEST_ASSERT(sub->code[2].op == OP_CALL_PRIM &&
+              sub->code[3].op == OP_TAIL_CALL && sub->code[3].arg == 2);
+  sub = lizard_test_lambda_chunk(&e, "(lambda (x) (abs x) x)");
+  TEST_ASSERT(lizard_test_count_op(sub, OP_CALL_PRIM) == 1 &&
+              lizard_test_count_op(sub, OP_CALL) == 1);
+  sub = lizard_test_lambda_chunk(&e, "(lambda (f) (f 1))");
+  TEST_ASSERT(lizard_test_count_op(sub, OP_CALL_PRIM) == 0);
+  sub = lizard_test_lambda_chunk(&e, "(lambda (x) (car x))");
+  TEST_ASSERT(lizard_test_count_op(sub, OP_CALL_PRIM) == 0 &&
+              lizard_test_count_op(sub, OP_CAR) == 1);
+
+  /* Primitives of both conventions, and none, one or many arguments. */
+  r = lizard_test_vm_eval(&e, "(list (max 3 9) (length '(1 2 3)) (append '(1) '(2 3)))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(9 3 (1 2 3))");
+  r = lizard_test_vm_eval(&e, "(define (f x) (list (abs x) (list) (string-append \"a\" \"b\"))) (f -4)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(4 () \"ab\")");
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "(abs 'a)")));
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "(no-such-procedure 1)")));
+
+  /* A primitive's name bound to a closure later calls the closure, a tail
+   * call of it without growing the frames. */
+  r = lizard_test_vm_eval(&e,
+                          "(define (g x) (abs x))"
+                          "(define (abs x) (if (< x 1) 'done (abs (- x 1))))"
+                          "(g 100000)");
+  TEST_ASSERT(lizard_test_is_symbol(r, "done"));
+  r = lizard_test_vm_eval(&e, "(define (h x) (cons (abs x) '())) (h 3)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(done)");
+  r = lizard_test_vm_eval(&e, "(define two 2) (define (k) (two)) (k)");
+  TEST_ASSERT(lizard_test_is_error(r));
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
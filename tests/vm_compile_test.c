@@ -0,0 +1,102 @@
+/* tests/vm_compile_test.c
+ *
+ * The core forms the bytecode compiler covers beyond the original subset:
+ * cond, and/or, rest parameters, the vector and string accessors and
+ * escaping call/cc.  What it still does not cover (quasiquote) makes
+ * lizard_compile fail.
+ */
+#include "bytecode.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  lizard_bc_chunk_t *sub;
+  lizard_test_env_init(&e);
+
+  /* What gets emitted. */
+  sub = lizard_test_lambda_chunk(&e, "(lambda (a b) (and a b))");
+  TEST_ASSERT(lizard_test_count_op(sub, OP_JUMP_IF_FALSE_OR_POP) == 1);
+  sub = lizard_test_lambda_chunk(&e, "(lambda (v i) (vector-ref v i))");
+  TEST_ASSERT(lizard_test_count_op(sub, OP_VECTOR_REF) == 1 &&
+              lizard_test_count_op(sub, OP_CALL) == 0);
+  sub = lizard_test_lambda_chunk(&e, "(lambda (a . r) r)");
+  TEST_ASSERT(sub->arity == 1 && sub->rest == 1);
+  sub = lizard_test_lambda_chunk(&e,
+                                 "(lambda (vector-ref v) (vector-ref v 0))");
+  TEST_ASSERT(lizard_test_count_op(sub, OP_VECTOR_REF) == 0);
+
+  /* cond. */
+  r = lizard_test_vm_eval(&e,
+                          "(define (sign n) (cond ((< n 0) 'neg) ((= n 0) 'zero) (else 'pos)))"
+                          "(cons (sign -3) (cons (sign 0) (cons (sign 8) '())))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(neg zero pos)");
+  r = lizard_test_vm_eval(&e, "(cond (#f 1) ((+ 2 3)) (else 9))");
+  TEST_ASSERT(lizard_test_is_int(r, 5));
+  r = lizard_test_vm_eval(&e, "(cond ((> 3 1) 'x 'y))");
+  TEST_ASSERT(lizard_test_is_symbol(r, "y"));
+  r = lizard_test_vm_eval(&e, "(cond (#f 1))");
+  TEST_ASSERT_STR(lizard_test_format(r), "()");
+
+  /* and/or give the deciding value and short-circuit. */
+  r = lizard_test_vm_eval(&e, "(cons (and) (cons (or) (cons (and 1 2) (cons (or #f 3) '()))))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(#t #f 2 3)");
+  r = lizard_test_vm_eval(&e, "(and 1 #f (car 1))");
+  TEST_ASSERT(lizard_test_is_false(r));
+  r = lizard_test_vm_eval(&e, "(or #f 4 (car 1))");
+  TEST_ASSERT(lizard_test_is_int(r, 4));
+  r = lizard_test_vm_eval(&e,
+                          "(define (all-pos n) (or (= n 0) (and (> n 0) (all-pos (- n 1)))))"
+                          "(all-pos 10000)");
+  TEST_ASSERT(lizard_test_is_true(r));
+
+  /* Rest parameters. */
+  r = lizard_test_vm_eval(&e, "((lambda args args) 1 2 3)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(1 2 3)");
+  r = lizard_test_vm_eval(&e, "(define (tail a . r) r) (cons (tail 1) (tail 1 2 3))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(() 2 3)");
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "(tail)")));
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "((lambda (a) a) 1 2)")));
+
+  /* Vectors and strings. */
+  r = lizard_test_vm_eval(&e,
+                          "(define v (vector 1 2 3)) (vector-set! v 0 9)"
+                          "(cons (vector-ref v 0) (cons (vector-length v)"
+                          "  (cons (string-ref \"abc\" 1) (cons (string-length \"abc\") '()))))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(9 3 \"b\" 3)");
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "(vector-ref v 5)")));
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "(string-length 1)")));
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "(vector-ref v)")));
+
+  /* call/cc as an escape. */
+  r = lizard_test_vm_eval(&e, "(+ 1 (call/cc (lambda (k) (+ 10 (k 5)))))");
+  TEST_ASSERT(lizard_test_is_int(r, 6));
+  r = lizard_test_vm_eval(&e, "(call/cc (lambda (k) 7))");
+  TEST_ASSERT(lizard_test_is_int(r, 7));
+  r = lizard_test_vm_eval(&e,
+                          "(define (find-first p xs)"
+                          "  (call/cc (lambda (return)"
+                          "    (define (go l) (cond ((null? l) #f)"
+                          "                         ((p (car l)) (return (car l)))"
+                          "                         (else (go (cdr l)))))"
+                          "    (go xs))))"
+                          "(find-first (lambda (x) (> x 2)) '(1 2 3 4))");
+  TEST_ASSERT(lizard_test_is_int(r, 3));
+  r = lizard_test_vm_eval(&e, "(define saved #f) (+ 1 (call/cc (lambda (k) (set! saved k) 1)))");
+  TEST_ASSERT(lizard_test_is_int(r, 2));
+  r = lizard_test_vm_eval(&e, "(saved 10)");
+  TEST_ASSERT(lizard_test_is_int(r, 10));
+
+  /* vm-eval on quoted code; what stays uncompiled. */
+  r = lizard_test_eval(&e, "(vm-eval '(cond ((< 1 2) (and 'a 'b)) (else 'c)))");
+  TEST_ASSERT(lizard_test_is_symbol(r, "b"));
+  r = lizard_test_eval(&e,
+                       "(vm-eval '(define (cnt . xs) (cond ((null? xs) 0) (else 1))))"
+                       "(vm-eval '(cons (cnt) (cnt 1 2)))");
+  TEST_ASSERT_STR(lizard_test_format(r), "(0 . 1)");
+  TEST_ASSERT(lizard_test_vm_eval(&e, "`(1 ,(+ 1 1))") == NULL);
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
@@ -0,0 +1,54 @@
+/* tests/vm_dispatch_test.c
+ *
+ * The plain and profiled dispatch loops (src/bytecode_loop.h) are built
+ * from the same instruction bodies: they give the same values and errors,
+ * and the profiled one counts every instruction it runs.  Holds in either
+ * VM_DISPATCH mode.
+ */
+#include "bytecode.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#include <string.h>
+
+static const char *const programs[] = {
+    "(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2))))) (fib 12)",
+    "(define (loop i acc) (if (= i 0) acc (loop (- i 1) (+ acc i)))) (loop 500 0)",
+    "(define (mk n) (lambda (x) (cons x n))) ((mk 1) 2)",
+    "(define (count n) (define i 0) (define (go) (if (< i n) (begin (set! i (+ i 1)) (go)) i)) (go))"
+    "(count 50)",
+    "(/ 7 2)",
+    "(car 1)",
+    NULL};
+
+int main(void) {
+  lizard_test_env_t e;
+  static lizard_vm_profile_t prof;
+  int i, op;
+  lizard_test_env_init(&e);
+
+  for (i = 0; programs[i] != NULL; i++) {
+    lizard_ast_node_t *plain = lizard_test_vm_eval(&e, programs[i]);
+    lizard_ast_node_t *profiled;
+    size_t sum = 0;
+    memset(&prof, 0, sizeof(prof));
+    profiled = lizard_test_vm_eval_profiled(&e, programs[i], &prof);
+    TEST_ASSERT(plain != NULL && profiled != NULL);
+    TEST_ASSERT(lizard_test_is_error(plain) == lizard_test_is_error(profiled));
+    if (!lizard_test_is_error(plain)) {
+      TEST_ASSERT_STR(lizard_test_format(plain), lizard_test_format(profiled));
+    }
+    for (op = 0; op < LIZARD_OPCODE_COUNT; op++) {
+      sum += prof.opcode_counts[op];
+    }
+    TEST_ASSERT(prof.total_instructions > 0 && sum == prof.total_instructions);
+  }
+
+  /* fib 12: 465 calls, all but the first from inside fib. */
+  memset(&prof, 0, sizeof(prof));
+  lizard_test_vm_eval_profiled(&e, "(fib 12)", &prof);
+  TEST_ASSERT(prof.total_calls == 465 && prof.tail_calls == 0);
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
@@ -0,0 +1,50 @@
+/* tests/vm_frames_test.c
+ *
+ * Calls between bytecode closures run on the VM's own frame stack: deep
+ * non-tail recursion completes without growing the C stack, results come
+ * back to the right caller across nested and tail calls, and an error in
+ * a callee ends the whole run.
+ */
+#include "bytecode.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  lizard_test_env_init(&e);
+
+  /* Deeper than any C stack would allow at one vm_run per call. */
+  r = lizard_test_vm_eval(&e,
+                          "(define (count n) (if (= n 0) 0 (+ 1 (count (- n 1)))))"
+                          "(count 200000)");
+  TEST_ASSERT(lizard_test_is_int(r, 200000));
+
+  /* Nested non-tail calls, arguments that are calls, and tail calls. */
+  r = lizard_test_vm_eval(&e,
+                          "(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))"
+                          "(fib 20)");
+  TEST_ASSERT(lizard_test_is_int(r, 6765));
+  r = lizard_test_vm_eval(&e,
+                          "(define (loop n acc) (if (= n 0) acc (loop (- n 1) (+ acc 1))))"
+                          "(define (twice n) (+ (loop n 0) (loop n 0)))"
+                          "(twice 50000)");
+  TEST_ASSERT(lizard_test_is_int(r, 100000));
+  r = lizard_test_vm_eval(&e, "(define (mk x) (lambda (y) (cons x y))) (car ((mk 1) 2))");
+  TEST_ASSERT(lizard_test_is_int(r, 1));
+
+  /* A primitive called between frames. */
+  r = lizard_test_vm_eval(&e,
+                          "(define (sum-abs n) (if (= n 0) 0 (+ (abs (- 0 n)) (sum-abs (- n 1)))))"
+                          "(sum-abs 1000)");
+  TEST_ASSERT(lizard_test_is_int(r, 500500));
+
+  /* An error deep in the recursion is the result of the run. */
+  r = lizard_test_vm_eval(&e, "(define (bad n) (if (= n 0) (car 1) (+ 1 (bad (- n 1))))) (bad 100)");
+  TEST_ASSERT(lizard_test_is_error(r));
+  r = lizard_test_vm_eval(&e, "(count 3)");
+  TEST_ASSERT(lizard_test_is_int(r, 3));
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
@@ -0,0 +1,73 @@
+/* tests/vm_locals_test.c
+ *
+ * Compile-time variable resolution in lizard_compile: parameters and body
+ * defines are frame slots, variables of enclosing lambdas are upvalues,
+ * and a variable both assigned and captured is shared through a box by
+ * every closure that sees it.  Built-ins are only open-coded when their
+ * name is global.
+ */
+#include "bytecode.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_ast_node_t *r;
+  lizard_bc_chunk_t *sub;
+  lizard_test_env_init(&e);
+
+  /* Slots, upvalues and globals. */
+  sub = lizard_test_lambda_chunk(&e, "(lambda (x) (define y x) (+ y g))");
+  TEST_ASSERT(sub->arity == 1 && sub->nlocals == 2);
+  TEST_ASSERT(sub->code[0].op == OP_LOAD_LOCAL && sub->code[1].op == OP_STORE_LOCAL_POP);
+  sub = lizard_test_lambda_chunk(&e, "(lambda (n) (lambda (x) (+ x n)))");
+  sub = lizard_test_closure_chunk(sub, 0);
+  TEST_ASSERT(sub->upval_count == 1 && sub->upval_is_local[0] && sub->upval_index[0] == 0);
+  TEST_ASSERT(sub->code[1].op == OP_LOAD_UPVAL);
+  r = lizard_test_vm_eval(&e, "(define (make-adder n) (lambda (x) (+ x n))) ((make-adder 5) 3)");
+  TEST_ASSERT(lizard_test_is_int(r, 8));
+  r = lizard_test_vm_eval(&e,
+                          "(define (a x) (lambda (y) (lambda (z) (cons x (cons y z)))))"
+                          "(((a 1) 2) 3)");
+  TEST_ASSERT_STR(lizard_test_format(r), "(1 2 . 3)");
+  r = lizard_test_vm_eval(&e, "(define g 10) (define (getg) g) (getg)");
+  TEST_ASSERT(lizard_test_is_int(r, 10));
+  r = lizard_test_vm_eval(&e, "(define g 11) (getg)");
+  TEST_ASSERT(lizard_test_is_int(r, 11));
+
+  /* Boxes: a counter, a captured parameter, closures sharing a variable,
+   * and a body define that refers to itself. */
+  r = lizard_test_vm_eval(&e,
+                          "(define (make-counter) (define c 0) (lambda () (set! c (+ c 1)) c))"
+                          "(define k1 (make-counter)) (define k2 (make-counter))"
+                          "(k1) (k1) (k2) (k1)");
+  TEST_ASSERT(lizard_test_is_int(r, 3));
+  r = lizard_test_vm_eval(&e,
+                          "(define (acc total) (lambda (x) (set! total (+ total x)) total))"
+                          "(define a1 (acc 10)) (a1 5) (a1 5)");
+  TEST_ASSERT(lizard_test_is_int(r, 20));
+  r = lizard_test_vm_eval(&e,
+                          "(define (shared) (define c 0)"
+                          "  (cons (lambda () (set! c (+ c 1))) (lambda () c)))"
+                          "(define s (shared)) ((car s)) ((car s)) ((cdr s))");
+  TEST_ASSERT(lizard_test_is_int(r, 2));
+  r = lizard_test_vm_eval(&e,
+                          "(define (sum-to n)"
+                          "  (define (loop i a) (if (= i 0) a (loop (- i 1) (+ a i))))"
+                          "  (loop n 0))"
+                          "(sum-to 100)");
+  TEST_ASSERT(lizard_test_is_int(r, 5050));
+  r = lizard_test_vm_eval(&e, "(define (bump x) (set! x (+ x 1)) x) (bump 4)");
+  TEST_ASSERT(lizard_test_is_int(r, 5));
+
+  /* A local named like a built-in is not the built-in. */
+  r = lizard_test_vm_eval(&e, "(define (f car) (car 1)) (f (lambda (v) (+ v 1)))");
+  TEST_ASSERT(lizard_test_is_int(r, 2));
+
+  /* Arity is checked. */
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "((lambda (x) x))")));
+  TEST_ASSERT(lizard_test_is_error(lizard_test_vm_eval(&e, "((lambda (x) x) 1 2)")));
+
+  lizard_test_env_destroy(&e);
+  TEST_RETURN();
+}
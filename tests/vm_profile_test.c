@@ -0,0 +1,182 @@
+/* tests/vm_profile_test.c
+ *
+ * The per-function profile: chunks are named after what defines them and
+ * keep their source position, a profiled run gets self and inclusive
+ * instructions and calls per function, leaves every activation however
+ * frames went, and writes its stacks in collapsed form.  A closure a
+ * primitive calls back is part of the run.
+ */
+#include "bytecode.h"
+#include "lizard_api.h"
+#include "runtime.h"
+#include "symbol.h"
+#include "test_harness.h"
+#include "test_helpers.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Run the forms of `src` on the VM, the last one profiled into `prof`. */
+static lizard_ast_node_t *run_profiled(lizard_env_t *env, lizard_heap_t *heap,
+                                       const char *src,
+                                       lizard_vm_profile_t *prof) {
+  lz_list_t *asts = lizard_parse(lizard_tokenize(src), heap);
+  lz_list_node_t *it;
+  lizard_ast_node_t *r = NULL;
+  for (it = asts->head; it != asts->nil; it = it->next) {
+    lizard_bc_chunk_t *chunk =
+        lizard_compile(((lizard_ast_list_node_t *)it)->ast, heap);
+    if (chunk == NULL) {
+      return NULL;
+    }
+    r = it->next == asts->nil ? lizard_vm_exec_profiled(chunk, env, heap, prof)
+                              : lizard_vm_exec(chunk, env, heap);
+  }
+  return r;
+}
+
+static const lizard_vm_fn_profile_t *fn_named(const lizard_vm_profile_t *prof,
+                                              const char *name) {
+  int i;
+  for (i = 0; i < prof->fn_count; i++) {
+    if (prof->fns[i].name != NULL && strcmp(prof->fns[i].name, name) == 0) {
+      return &prof->fns[i];
+    }
+  }
+  return NULL;
+}
+
+/* Whether every activation was left and every instruction counted once. */
+static int balanced(const lizard_vm_profile_t *prof) {
+  size_t self = 0;
+  int i;
+  for (i = 0; i < prof->fn_count; i++) {
+    if (prof->fns[i].active != 0) {
+      return 0;
+    }
+    self += prof->fns[i].self_instructions;
+  }
+  return prof->depth == 0 && self == prof->total_instructions;
+}
+
+/* The report, or with `collapsed` the collapsed stacks, of `prof` as
+ * printed to a file, at most `size` - 1 bytes of it. */
+static void capture(const lizard_vm_profile_t *prof, int collapsed, char *buf,
+                    size_t size) {
+  FILE *fp = tmpfile();
+  size_t n = 0;
+  buf[0] = '\0';
+  if (fp == NULL) {
+    return;
+  }
+  if (collapsed) {
+    (void)lizard_vm_profile_write_collapsed(fp, prof);
+  } else {
+    lizard_vm_profile_report(fp, prof, 0);
+  }
+  rewind(fp);
+  n = fread(buf, 1, size - 1, fp);
+  buf[n] = '\0';
+  fclose(fp);
+}
+
+int main(void) {
+  lizard_test_env_t e;
+  lizard_vm_profile_t prof;
+  const lizard_vm_fn_profile_t *fib, *top, *f;
+  lizard_ast_node_t *r;
+  lizard_bc_chunk_t *c, *sub;
+  lz_list_t *asts;
+  lizard_runtime_t *runtime;
+  lizard_context_t *context;
+  char out[4096];
+  FILE *fp;
+
+  lizard_test_env_init(&e);
+
+  /* Names and spans, kept by a .lzc. */
+  asts = lizard_parse(lizard_tokenize("\n  (define (sq x) (* x x))"), e.heap);
+  c = lizard_compile(((lizard_ast_list_node_t *)asts->head)->ast, e.heap);
+  TEST_ASSERT(c != NULL && strcmp(c->name, "<toplevel>") == 0);
+  sub = lizard_test_closure_chunk(c, 0);
+  TEST_ASSERT(sub->name != NULL && strcmp(sub->name, "sq") == 0);
+  TEST_ASSERT(sub->span.start_line == 2 && sub->span.start_column == 3);
+  fp = tmpfile();
+  TEST_ASSERT(fp != NULL);
+  if (fp != NULL) {
+    TEST_ASSERT(lizard_bc_write(fp, c) == 0);
+    rewind(fp);
+    c = lizard_bc_read(fp, e.heap);
+    fclose(fp);
+    TEST_ASSERT(c != NULL);
+    if (c != NULL) {
+      sub = lizard_test_closure_chunk(c, 0);
+      TEST_ASSERT(sub->name == lizard_intern("sq") && sub->span.start_line == 2);
+    }
+  }
+
+  /* Self, inclusive and calls; recursion counted once in inclusive. */
+  memset(&prof, 0, sizeof(prof));
+  r = run_profiled(e.env, e.heap,
+                   "(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))"
+                   "(define (twice) (+ (fib 10) (fib 10)))"
+                   "(twice)",
+                   &prof);
+  TEST_ASSERT(lizard_test_is_int(r, 110));
+  fib = fn_named(&prof, "fib");
+  top = fn_named(&prof, "<toplevel>");
+  f = fn_named(&prof, "twice");
+  TEST_ASSERT(fib != NULL && top != NULL && f != NULL);
+  if (fib != NULL && top != NULL && f != NULL) {
+    TEST_ASSERT(fib->calls == 2 * 177 && f->calls == 1);
+    TEST_ASSERT(fib->inclusive_instructions == fib->self_instructions);
+    TEST_ASSERT(f->inclusive_instructions ==
+                f->self_instructions + fib->self_instructions);
+    TEST_ASSERT(top->inclusive_instructions == prof.total_instructions);
+  }
+  TEST_ASSERT(balanced(&prof));
+  capture(&prof, 0, out, sizeof(out));
+  TEST_ASSERT(strstr(out, "self%") != NULL);
+  TEST_ASSERT(strstr(out, "fib") != NULL && strstr(out, "fib") < strstr(out, "twice"));
+  capture(&prof, 1, out, sizeof(out));
+  TEST_ASSERT(strstr(out, "<toplevel>;twice;fib ") != NULL);
+  TEST_ASSERT(strstr(out, "fib;fib") == NULL);
+  lizard_vm_profile_free(&prof);
+  TEST_ASSERT(prof.fns == NULL && prof.fn_count == 0);
+
+  /* Tail calls and escapes leave what they drop. */
+  memset(&prof, 0, sizeof(prof));
+  r = run_profiled(e.env, e.heap,
+                   "(define (down n) (if (= n 0) 'done (down (- n 1))))"
+                   "(define (bounce n) (if (= n 0) (down 5) (bounce (- n 1))))"
+                   "(define (dig k n) (if (= n 0) (k 'out) (+ 1 (dig k (- n 1)))))"
+                   "(list (bounce 3) (call/cc (lambda (k) (dig k 20))))",
+                   &prof);
+  TEST_ASSERT_STR(lizard_test_format(r), "(done out)");
+  f = fn_named(&prof, "down");
+  TEST_ASSERT(f != NULL && f->calls == 6);
+  f = fn_named(&prof, "dig");
+  TEST_ASSERT(f != NULL && f->calls == 21);
+  TEST_ASSERT(balanced(&prof));
+  lizard_vm_profile_free(&prof);
+  lizard_test_env_destroy(&e);
+
+  /* A VM closure map calls back runs under the primitive's trampoline. */
+  runtime = lizard_runtime_create(NULL);
+  context = lizard_context_create(runtime);
+  (void)lizard_context_eval_string(
+      context, "(vm-eval '(define (sq x) (* x x)))", NULL);
+  memset(&prof, 0, sizeof(prof));
+  r = run_profiled(context->env, runtime->heap, "(map sq '(1 2 3))", &prof);
+  TEST_ASSERT_STR(lizard_test_format(r), "(1 4 9)");
+  f = fn_named(&prof, "sq");
+  TEST_ASSERT(f != NULL && f->calls == 3);
+  TEST_ASSERT(balanced(&prof));
+  capture(&prof, 1, out, sizeof(out));
+  TEST_ASSERT(strstr(out, "<toplevel>;<primitive>;sq 9\n") != NULL);
+  lizard_vm_profile_free(&prof);
+  lizard_context_destroy(context);
+  lizard_runtime_destroy(runtime);
+
+  TEST_RETURN();
+}